@@ -0,0 +1,475 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_C_MESH_BUFFER_QUANTIZED_H_INCLUDED
+#define IRR_C_MESH_BUFFER_QUANTIZED_H_INCLUDED
+
+#include "irrArray.h"
+#include "IMeshBuffer.h"
+
+namespace irr
+{
+namespace scene
+{
+	//! Template implementation of the IMeshBuffer interface for quantized 16-bit buffers
+	/** T is video::S3DVertexQuantized or video::S3DVertexQuantizedTangents.
+	The vertices are decoded with Quantization, which applies to all of them.
+	As the vertices don't contain floats, getPosition(), getNormal() and
+	getTCoords() decode the value into one of a few slots and return it.
+	The returned reference stays valid for the next three calls of those
+	functions. Values changed through the non-const versions are encoded
+	into the vertices again by the next call of any of them, or of
+	getVertices(), recalculateBoundingBox(), append(), setDirty() or
+	createClone(). Positions and texture coordinates outside of the
+	ranges of Quantization are clamped. The decoding is not thread safe.
+	Drivers decode the vertices once into their hardware buffer when a
+	hardware mapping hint is set, otherwise for each draw. Burning's Video
+	decodes them while drawing and needs no copy. Mesh writers other than
+	the irrbmesh, ply and b3d writers expect float vertices, so convert
+	quantized meshes with IMeshManipulator::createMeshWith1TCoords() or
+	createMeshWithTangents() before writing them to other formats. */
+	template <class T>
+	class CMeshBufferQuantized : public IMeshBuffer
+	{
+	public:
+		//! Default constructor for empty meshbuffer
+		CMeshBufferQuantized()
+			: ChangedID_Vertex(1), ChangedID_Index(1)
+			, MappingHint_Vertex(EHM_NEVER), MappingHint_Index(EHM_NEVER)
+			, PrimitiveType(EPT_TRIANGLES), NextDecoded(0), WritableDecoded(0)
+		{
+			#ifdef _DEBUG
+			setDebugName("CMeshBufferQuantized");
+			#endif
+		}
+
+
+		//! Get material of this meshbuffer
+		/** \return Material of this buffer */
+		virtual const video::SMaterial& getMaterial() const IRR_OVERRIDE
+		{
+			return Material;
+		}
+
+
+		//! Get material of this meshbuffer
+		/** \return Material of this buffer */
+		virtual video::SMaterial& getMaterial() IRR_OVERRIDE
+		{
+			return Material;
+		}
+
+
+		//! Get pointer to vertices
+		/** \return Pointer to vertices. */
+		virtual const void* getVertices() const IRR_OVERRIDE
+		{
+			storeChanges();
+			return Vertices.const_pointer();
+		}
+
+
+		//! Get pointer to vertices
+		/** \return Pointer to vertices. */
+		virtual void* getVertices() IRR_OVERRIDE
+		{
+			storeChanges();
+			return Vertices.pointer();
+		}
+
+
+		//! Get number of vertices
+		/** \return Number of vertices. */
+		virtual u32 getVertexCount() const IRR_OVERRIDE
+		{
+			return Vertices.size();
+		}
+
+		//! Get type of index data which is stored in this meshbuffer.
+		/** \return Index type of this buffer. */
+		virtual video::E_INDEX_TYPE getIndexType() const IRR_OVERRIDE
+		{
+			return video::EIT_16BIT;
+		}
+
+		//! Get pointer to indices
+		/** \return Pointer to indices. */
+		virtual const u16* getIndices() const IRR_OVERRIDE
+		{
+			return Indices.const_pointer();
+		}
+
+
+		//! Get pointer to indices
+		/** \return Pointer to indices. */
+		virtual u16* getIndices() IRR_OVERRIDE
+		{
+			return Indices.pointer();
+		}
+
+
+		//! Get number of indices
+		/** \return Number of indices. */
+		virtual u32 getIndexCount() const IRR_OVERRIDE
+		{
+			return Indices.size();
+		}
+
+
+		//! Get the axis aligned bounding box
+		/** \return Axis aligned bounding box of this buffer. */
+		virtual const core::aabbox3d<f32>& getBoundingBox() const IRR_OVERRIDE
+		{
+			return BoundingBox;
+		}
+
+
+		//! Set the axis aligned bounding box
+		/** \param box New axis aligned bounding box for this buffer. */
+		virtual void setBoundingBox(const core::aabbox3df& box) IRR_OVERRIDE
+		{
+			BoundingBox = box;
+		}
+
+
+		//! Recalculate the bounding box.
+		/** should be called if the mesh changed. */
+		virtual void recalculateBoundingBox() IRR_OVERRIDE
+		{
+			storeChanges();
+			if (!Vertices.empty())
+			{
+				BoundingBox.reset(Quantization.decodePosition(Vertices[0].Pos));
+				const irr::u32 vsize = Vertices.size();
+				for (u32 i=1; i<vsize; ++i)
+					BoundingBox.addInternalPoint(Quantization.decodePosition(Vertices[i].Pos));
+			}
+			else
+				BoundingBox.reset(0,0,0);
+		}
+
+
+		//! Get type of vertex data stored in this buffer.
+		/** \return Type of vertex data. */
+		virtual video::E_VERTEX_TYPE getVertexType() const IRR_OVERRIDE
+		{
+			return T::getType();
+		}
+
+		//! returns decoded position of vertex i
+		virtual const core::vector3df& getPosition(u32 i) const IRR_OVERRIDE
+		{
+			return decode(i, EDV_POSITION, false).Pos;
+		}
+
+		//! returns decoded position of vertex i, changes are encoded later
+		virtual core::vector3df& getPosition(u32 i) IRR_OVERRIDE
+		{
+			return decode(i, EDV_POSITION, true).Pos;
+		}
+
+		//! returns decoded normal of vertex i
+		virtual const core::vector3df& getNormal(u32 i) const IRR_OVERRIDE
+		{
+			return decode(i, EDV_NORMAL, false).Normal;
+		}
+
+		//! returns decoded normal of vertex i, changes are encoded later
+		virtual core::vector3df& getNormal(u32 i) IRR_OVERRIDE
+		{
+			return decode(i, EDV_NORMAL, true).Normal;
+		}
+
+		//! returns decoded texture coord of vertex i
+		virtual const core::vector2df& getTCoords(u32 i) const IRR_OVERRIDE
+		{
+			return decode(i, EDV_TCOORDS, false).TCoords;
+		}
+
+		//! returns decoded texture coord of vertex i, changes are encoded later
+		virtual core::vector2df& getTCoords(u32 i) IRR_OVERRIDE
+		{
+			return decode(i, EDV_TCOORDS, true).TCoords;
+		}
+
+
+		//! Append the vertices and indices to the current buffer
+		/** Only works for vertices of the same type which use the same
+		quantization. Otherwise, behavior is undefined.
+		*/
+		virtual void append(const void* const vertices, u32 numVertices, const u16* const indices, u32 numIndices) IRR_OVERRIDE
+		{
+			if (vertices == getVertices())
+				return;
+
+			const u32 vertexCount = getVertexCount();
+			u32 i;
+
+			Vertices.reallocate(vertexCount+numVertices);
+			for (i=0; i<numVertices; ++i)
+			{
+				Vertices.push_back(static_cast<const T*>(vertices)[i]);
+				BoundingBox.addInternalPoint(Quantization.decodePosition(static_cast<const T*>(vertices)[i].Pos));
+			}
+
+			Indices.reallocate(getIndexCount()+numIndices);
+			for (i=0; i<numIndices; ++i)
+			{
+				Indices.push_back(indices[i]+vertexCount);
+			}
+		}
+
+
+		//! Append the meshbuffer to the current buffer
+		/** Not supported for quantized buffers, like for CMeshBuffer. */
+		virtual void append(const IMeshBuffer* const other) IRR_OVERRIDE
+		{
+		}
+
+
+		//! get the current hardware mapping hint
+		virtual E_HARDWARE_MAPPING getHardwareMappingHint_Vertex() const IRR_OVERRIDE
+		{
+			return MappingHint_Vertex;
+		}
+
+		//! get the current hardware mapping hint
+		virtual E_HARDWARE_MAPPING getHardwareMappingHint_Index() const IRR_OVERRIDE
+		{
+			return MappingHint_Index;
+		}
+
+		//! set the hardware mapping hint, for driver
+		virtual void setHardwareMappingHint( E_HARDWARE_MAPPING NewMappingHint, E_BUFFER_TYPE Buffer=EBT_VERTEX_AND_INDEX ) IRR_OVERRIDE
+		{
+			if (Buffer==EBT_VERTEX_AND_INDEX || Buffer==EBT_VERTEX)
+				MappingHint_Vertex=NewMappingHint;
+			if (Buffer==EBT_VERTEX_AND_INDEX || Buffer==EBT_INDEX)
+				MappingHint_Index=NewMappingHint;
+		}
+
+		//! Describe what kind of primitive geometry is used by the meshbuffer
+		virtual void setPrimitiveType(E_PRIMITIVE_TYPE type) IRR_OVERRIDE
+		{
+			PrimitiveType = type;
+		}
+
+		//! Get the kind of primitive geometry which is used by the meshbuffer
+		virtual E_PRIMITIVE_TYPE getPrimitiveType() const IRR_OVERRIDE
+		{
+			return PrimitiveType;
+		}
+
+		//! flags the mesh as changed, reloads hardware buffers
+		/** Also encodes values changed through getPosition(), getNormal()
+		and getTCoords(). */
+		virtual void setDirty(E_BUFFER_TYPE Buffer=EBT_VERTEX_AND_INDEX) IRR_OVERRIDE
+		{
+			storeChanges();
+			if (Buffer==EBT_VERTEX_AND_INDEX ||Buffer==EBT_VERTEX)
+				++ChangedID_Vertex;
+			if (Buffer==EBT_VERTEX_AND_INDEX || Buffer==EBT_INDEX)
+				++ChangedID_Index;
+		}
+
+		//! Get the currently used ID for identification of changes.
+		/** This shouldn't be used for anything outside the VideoDriver. */
+		virtual u32 getChangedID_Vertex() const IRR_OVERRIDE {return ChangedID_Vertex;}
+
+		//! Get the currently used ID for identification of changes.
+		/** This shouldn't be used for anything outside the VideoDriver. */
+		virtual u32 getChangedID_Index() const IRR_OVERRIDE {return ChangedID_Index;}
+
+		//! Returns type of the class implementing the IMeshBuffer
+		virtual EMESH_BUFFER_TYPE getType() const  IRR_OVERRIDE
+		{
+			return getTypeT();
+		}
+
+		//! Get the ranges of the quantized vertices
+		virtual const video::SVertexQuantization* getVertexQuantization() const IRR_OVERRIDE
+		{
+			return &Quantization;
+		}
+
+		//! Create copy of the meshbuffer
+		virtual IMeshBuffer* createClone(int cloneFlags) const IRR_OVERRIDE
+		{
+			storeChanges();
+			CMeshBufferQuantized<T> * clone = new CMeshBufferQuantized<T>();
+
+			if (cloneFlags & ECF_VERTICES)
+			{
+				clone->Vertices = Vertices;
+				clone->BoundingBox = BoundingBox;
+			}
+
+			if (cloneFlags & ECF_INDICES)
+			{
+				clone->Indices = Indices;
+			}
+
+			clone->Quantization = Quantization;
+			clone->PrimitiveType = PrimitiveType;
+			clone->Material = getMaterial();
+			clone->MappingHint_Vertex = MappingHint_Vertex;
+			clone->MappingHint_Index = MappingHint_Index;
+
+			return clone;
+		}
+
+		//! Returns type of the class implementing the IMeshBuffer for template specialization
+		EMESH_BUFFER_TYPE getTypeT() const;
+
+		u32 ChangedID_Vertex;
+		u32 ChangedID_Index;
+
+		//! hardware mapping hint
+		E_HARDWARE_MAPPING MappingHint_Vertex;
+		E_HARDWARE_MAPPING MappingHint_Index;
+
+		//! Material for this meshbuffer.
+		video::SMaterial Material;
+		//! Ranges of the vertex positions and texture coordinates
+		video::SVertexQuantization Quantization;
+		//! Vertices of this buffer
+		core::array<T> Vertices;
+		//! Indices into the vertices of this buffer.
+		core::array<u16> Indices;
+		//! Bounding box of this meshbuffer.
+		core::aabbox3d<f32> BoundingBox;
+		//! Primitive type used for rendering (triangles, lines, ...)
+		E_PRIMITIVE_TYPE PrimitiveType;
+
+	private:
+
+		enum E_DECODED_VALUE
+		{
+			EDV_POSITION,
+			EDV_NORMAL,
+			EDV_TCOORDS
+		};
+
+		//! A value decoded by getPosition(), getNormal() or getTCoords()
+		struct SDecoded
+		{
+			SDecoded() : Index(0), Value(EDV_POSITION), Writable(false) {}
+
+			//! Only the member selected by Value is used
+			video::S3DVertex Vertex;
+			//! Vertex as decoded or last encoded, to find changes
+			video::S3DVertex Original;
+			u32 Index;
+			E_DECODED_VALUE Value;
+			bool Writable;
+		};
+
+		enum { DECODED_SLOTS = 4 };
+
+		//! Decodes one value of vertex i into the oldest slot
+		video::S3DVertex& decode(u32 i, E_DECODED_VALUE value, bool writable) const
+		{
+			storeChanges();
+
+			SDecoded& slot = Decoded[NextDecoded];
+			NextDecoded = (NextDecoded + 1) % DECODED_SLOTS;
+			if (slot.Writable)
+				--WritableDecoded;
+			if (writable)
+				++WritableDecoded;
+			slot.Index = i;
+			slot.Value = value;
+			slot.Writable = writable;
+
+			const T& v = Vertices[i];
+			switch (value)
+			{
+			case EDV_POSITION:
+				slot.Vertex.Pos = Quantization.decodePosition(v.Pos);
+				break;
+			case EDV_NORMAL:
+				slot.Vertex.Normal = video::decodeOctahedral(v.Normal);
+				break;
+			case EDV_TCOORDS:
+				slot.Vertex.TCoords = Quantization.decodeTCoords(v.TCoords);
+				break;
+			}
+			slot.Original = slot.Vertex;
+			return slot.Vertex;
+		}
+
+		//! Encodes the values changed through the non-const accessors
+		void storeChanges() const
+		{
+			if (!WritableDecoded)
+				return;
+
+			// only the non-const accessors hand out writable slots, so the buffer isn't const
+			core::array<T>& vertices = const_cast<core::array<T>&>(Vertices);
+			for (u32 i=0; i<DECODED_SLOTS; ++i)
+			{
+				SDecoded& slot = Decoded[i];
+				if (!slot.Writable || slot.Index >= vertices.size())
+					continue;
+
+				T& v = vertices[slot.Index];
+				switch (slot.Value)
+				{
+				case EDV_POSITION:
+					if (!slot.Vertex.Pos.equals(slot.Original.Pos, 0.f))
+						Quantization.encodePosition(slot.Vertex.Pos, v.Pos);
+					break;
+				case EDV_NORMAL:
+					if (!slot.Vertex.Normal.equals(slot.Original.Normal, 0.f))
+						video::encodeOctahedral(slot.Vertex.Normal, v.Normal);
+					break;
+				case EDV_TCOORDS:
+					if (!slot.Vertex.TCoords.equals(slot.Original.TCoords, 0.f))
+						Quantization.encodeTCoords(slot.Vertex.TCoords, v.TCoords);
+					break;
+				}
+				slot.Original = slot.Vertex;
+			}
+		}
+
+		mutable SDecoded Decoded[DECODED_SLOTS];
+		mutable u32 NextDecoded;
+		mutable u32 WritableDecoded;
+	};
+
+	//! Quantized standard meshbuffer
+	typedef CMeshBufferQuantized<video::S3DVertexQuantized> SMeshBufferQuantized;
+	//! Quantized meshbuffer with vertices having tangents stored
+	typedef CMeshBufferQuantized<video::S3DVertexQuantizedTangents> SMeshBufferQuantizedTangents;
+
+	//! partial specialization to return types
+	template <>
+	inline EMESH_BUFFER_TYPE CMeshBufferQuantized<video::S3DVertexQuantized>::getTypeT() const
+	{
+		return EMBT_QUANTIZED;
+	}
+	template <>
+	inline EMESH_BUFFER_TYPE CMeshBufferQuantized<video::S3DVertexQuantizedTangents>::getTypeT() const
+	{
+		return EMBT_QUANTIZED_TANGENTS;
+	}
+
+	//! Decodes vertex i of a meshbuffer with EVT_QUANTIZED or EVT_QUANTIZED_TANGENTS vertices
+	/** Tangent and binormal stay 0 for EVT_QUANTIZED vertices. */
+	inline video::S3DVertexTangents getDecodedVertex(const IMeshBuffer* mb, u32 i)
+	{
+		const video::SVertexQuantization* quantization = mb->getVertexQuantization();
+		video::S3DVertexTangents out;
+		if (mb->getVertexType() == video::EVT_QUANTIZED_TANGENTS)
+			quantization->decode(static_cast<const video::S3DVertexQuantizedTangents*>(mb->getVertices())[i], out);
+		else
+			quantization->decode(static_cast<const video::S3DVertexQuantized*>(mb->getVertices())[i], out);
+		return out;
+	}
+
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
@@ -127,6 +127,13 @@ namespace scene
 					NewVertices=new CSpecificVertexList<video::S3DVertexTangents>;
 					break;
 				}
+				default:
+				{
+					// quantized vertices can't be decoded without the
+					// quantization of their meshbuffer
+					NewVertices=new CSpecificVertexList<video::S3DVertex>;
+					break;
+				}
 			}
 			if (Vertices)
 			{
@@ -34,6 +34,12 @@ namespace scene
 		// SSkinMeshBuffer
 		EMBT_SKIN     = MAKE_IRR_ID('s','k','i','n'),
 
+		//! SMeshBufferQuantized (16 bit buffers)
+		EMBT_QUANTIZED = MAKE_IRR_ID('q','u','a','n'),
+
+		//! SMeshBufferQuantizedTangents (16 bit buffers)
+		EMBT_QUANTIZED_TANGENTS = MAKE_IRR_ID('q','t','a','n'),
+
 		//! Unknown class type
 		EMBT_UNKNOWN  = MAKE_IRR_ID('u','n','k','n')
 	};
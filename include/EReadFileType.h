@@ -24,6 +24,9 @@ namespace io
 		//! CLimitReadFile
 		ERFT_LIMIT_READ_FILE = MAKE_IRR_ID('r','l','i','m'),
 
+		//! CMappedReadFile, a file on disk mapped into memory. Implements IMemoryReadFile.
+		ERFT_MAPPED_READ_FILE = MAKE_IRR_ID('r','m','a','p'),
+
 		//! Unknown type
 		EFIT_UNKNOWN        = MAKE_IRR_ID('u','n','k','n')
 	};
@@ -0,0 +1,140 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_I_ASYNC_LOADER_H_INCLUDED
+#define IRR_I_ASYNC_LOADER_H_INCLUDED
+
+#include "IReferenceCounted.h"
+#include "path.h"
+
+namespace irr
+{
+namespace scene
+{
+	class IAnimatedMesh;
+} // end namespace scene
+namespace video
+{
+	class ITexture;
+} // end namespace video
+
+//! State of a request to IAsyncLoader
+enum E_ASYNC_LOAD_STATE
+{
+	//! Waiting for a worker thread
+	EALS_QUEUED = 0,
+
+	//! Being loaded, or loaded and waiting for IAsyncLoader::update()
+	EALS_LOADING,
+
+	//! Loaded, the mesh or texture is available
+	EALS_DONE,
+
+	//! The file could not be opened or loaded
+	EALS_FAILED,
+
+	//! Canceled before it was done
+	EALS_CANCELED
+};
+
+//! Handle of a mesh or texture requested from IAsyncLoader
+/** All functions are meant to be called from the main thread. */
+class IAsyncLoadRequest : public virtual IReferenceCounted
+{
+public:
+
+	//! Get the state of the request
+	virtual E_ASYNC_LOAD_STATE getState() const = 0;
+
+	//! Check if the request is done, failed or canceled
+	bool isFinished() const
+	{
+		return getState() >= EALS_DONE;
+	}
+
+	//! Get the requested file name
+	virtual const io::path& getFileName() const = 0;
+
+	//! Get the loaded mesh of a mesh request
+	/** \return The mesh when the state is EALS_DONE, otherwise 0. The mesh
+	is in the mesh cache, like after ISceneManager::getMesh(). */
+	virtual scene::IAnimatedMesh* getMesh() const = 0;
+
+	//! Get the loaded texture of a texture request
+	/** \return The texture when the state is EALS_DONE, otherwise 0. The
+	texture is in the texture cache of the driver, like after
+	IVideoDriver::getTexture(). */
+	virtual video::ITexture* getTexture() const = 0;
+
+	//! Set the priority, requests with higher values are loaded first
+	/** Only has an effect while the request is queued. */
+	virtual void setPriority(s32 priority) = 0;
+
+	//! Get the priority
+	virtual s32 getPriority() const = 0;
+
+	//! Cancel the request
+	/** Queued requests are removed from the queue. Requests which are
+	already loading are finished by their worker thread but their result
+	is thrown away. Requests which are done are not changed. */
+	virtual void cancel() = 0;
+};
+
+//! Loads meshes and textures in the background
+/** Files are opened on the calling thread, reading and decoding them
+happens on worker threads. Only the last step, creating the driver texture
+or putting the mesh into the mesh cache, is done in update() which has to be
+called regularly from the main thread, for example once per frame.
+
+Images and meshes are decoded on worker threads when all loaders for their
+extension are thread safe (IImageLoader::isThreadSafe(),
+IMeshLoader::isThreadSafe()). Otherwise only the file is read into memory in
+the background and it's decoded in update(). Mesh loaders on worker threads
+get a copy of ISceneManager::getParameters() taken in loadMesh().
+Log messages of loaders running on worker threads are sent from those
+threads. Don't add or remove loaders while requests are pending.
+
+Without _IRR_COMPILE_WITH_THREADS_ all requests are loaded in update(). */
+class IAsyncLoader : public virtual IReferenceCounted
+{
+public:
+
+	//! Request a mesh
+	/** Same as ISceneManager::getMesh(), but returns before the mesh is
+	loaded. When the mesh is already in the mesh cache, the request is
+	done immediately.
+	\param filename Name of the mesh file, also used as name in the mesh cache.
+	\param priority Requests with higher priority are loaded first.
+	\return Handle to poll. Drop it when no longer needed. */
+	virtual IAsyncLoadRequest* loadMesh(const io::path& filename, s32 priority=0) = 0;
+
+	//! Request a texture
+	/** Same as IVideoDriver::getTexture(), but returns before the
+	texture is loaded. When the texture is already in the texture cache,
+	the request is done immediately.
+	\param filename Name of the image file.
+	\param priority Requests with higher priority are loaded first.
+	\return Handle to poll. Drop it when no longer needed. */
+	virtual IAsyncLoadRequest* loadTexture(const io::path& filename, s32 priority=0) = 0;
+
+	//! Finish loaded requests on the main thread
+	/** Creates the textures and adds the meshes of requests which were
+	loaded by the worker threads to their caches.
+	\param timeLimitMs Stop after about this many milliseconds, so that
+	large batches of requests don't stall a frame. 0 for no limit.
+	\return Number of requests which were finished. */
+	virtual u32 update(u32 timeLimitMs=0) = 0;
+
+	//! Get the number of requests which are not finished yet
+	virtual u32 getPendingCount() const = 0;
+
+	//! Get the number of worker threads
+	/** \return 0 when compiled without _IRR_COMPILE_WITH_THREADS_ */
+	virtual u32 getThreadCount() const = 0;
+};
+
+} // end namespace irr
+
+#endif
+
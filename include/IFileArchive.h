@@ -7,6 +7,7 @@
 
 #include "IReadFile.h"
 #include "IFileList.h"
+#include "irrArray.h"
 
 namespace irr
 {
@@ -78,6 +79,27 @@ public:
 	//! return the name (id) of the file Archive
 	virtual const io::path& getArchiveName() const =0;
 
+	//! Sets how much memory the archive may keep for decompressed files
+	/** Archives with compressed files can keep recently opened files
+	decompressed, so opening them again needs no decompression. The least
+	recently used files are removed first when the limit is reached.
+	Encrypted files are never kept, as they depend on the Password.
+	Archives without such a cache ignore this.
+	\param bytes Size of the cache in bytes, 0 disables it. That's the
+	default, as each archive has a cache of its own. */
+	virtual void setDecompressionCacheSize(u32 bytes) {}
+
+	//! Decompresses files ahead of time
+	/** Useful before loading a level, to decompress the files it needs
+	on several threads at once. The files are kept in the cache set with
+	setDecompressionCacheSize(), so when they don't all fit, the ones
+	prefetched first are lost again. Nothing is kept without setting a
+	cache size first, and encrypted files are skipped.
+	\param filenames Files of the archive to decompress.
+	\return Number of files which are ready to be opened without
+	decompression afterwards. */
+	virtual u32 prefetchFiles(const core::array<path>& filenames) { return 0; }
+
 	//! An optionally used password string
 	/** This variable is publicly accessible from the interface in order to
 	avoid single access patterns to this place, and hence allow some more
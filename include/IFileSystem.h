@@ -34,12 +34,30 @@ class IFileSystem : public virtual IReferenceCounted
 public:
 
 	//! Opens a file for read access.
-	/** \param filename: Name of file to open.
+	/** Can be called from several threads at the same time when the engine
+	is compiled with _IRR_COMPILE_WITH_THREADS_. Files opened from archives
+	should be read by the thread which opened them. Use
+	_IRR_THREAD_SAFE_REFERENCE_COUNTING_ when files are passed to other threads.
+	\param filename: Name of file to open.
 	\return Pointer to the created file interface.
 	The returned pointer should be dropped when no longer needed.
 	See IReferenceCounted::drop() for more information. */
 	virtual IReadFile* createAndOpenFile(const path& filename) =0;
 
+	//! Set from which size on createAndOpenFile() maps files on disk into memory.
+	/** Mapped files are only read from disk where they are accessed, and
+	loaders can parse them in place through IMemoryReadFile::getBuffer()
+	instead of copying them to memory first. Their type is
+	ERFT_MAPPED_READ_FILE. Files inside of archives other than folders are
+	not mapped. Files should not be changed on disk while they are mapped.
+	\param size Minimal file size in bytes. 1 maps all files which can be
+	mapped, 0 disables mapping, which is the default. */
+	virtual void setFileMappingThreshold(long size) =0;
+
+	//! Get from which size on createAndOpenFile() maps files on disk into memory.
+	/** \return Minimal file size in bytes, 0 when no files are mapped. */
+	virtual long getFileMappingThreshold() const =0;
+
 	//! Creates an IReadFile interface for accessing memory like a file.
 	/** This allows you to use a pointer to memory where an IReadFile is requested.
 	\param memory: A pointer to the start of the file in memory
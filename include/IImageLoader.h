@@ -46,6 +46,20 @@ public:
 	\return Pointer to newly created image, or 0 upon error. */
 	virtual IImage* loadImage(io::IReadFile* file) const = 0;
 
+	//! Creates a surface from the file, reduced to fit into a maximal size
+	/** Loaders which can decode at a lower resolution do so, which saves
+	the time and memory of the full size image. The aspect ratio is kept.
+	The default implementation loads the full image.
+	\param file File handle to check.
+	\param maxSize Largest size the image should have.
+	\return Pointer to newly created image, or 0 upon error. The image
+	can still be larger than maxSize, or smaller than the largest size
+	fitting into it as loaders only reduce by the factors they support. */
+	virtual IImage* loadReducedImage(io::IReadFile* file, const core::dimension2d<u32>& maxSize) const
+	{
+		return loadImage(file);
+	}
+
 	//! Creates a multiple surfaces from the file eg. whole cube map.
 	/** \param file File handle to check.
 	\param type Pointer to E_TEXTURE_TYPE where a recommended type of the texture will be stored.
@@ -56,6 +70,18 @@ public:
 
 		return image;
 	}
+
+	//! Returns true if images may be loaded on another thread than the main thread.
+	/** Used by IAsyncLoader to decode textures on worker threads. Several of
+	its threads may call one loader at the same time, and the video driver
+	may call it on the main thread meanwhile. So the loader must not keep
+	any state between calls.
+	\return False by default, then images of this loader are only read on a
+	worker thread and decoded on the main thread. */
+	virtual bool isThreadSafe() const
+	{
+		return false;
+	}
 };
 
 
@@ -190,6 +190,14 @@ namespace scene
 			return EMBT_UNKNOWN;
 		}
 
+		//! Get the ranges of quantized vertices
+		/** \return Quantization of EVT_QUANTIZED and EVT_QUANTIZED_TANGENTS
+		vertices, 0 for buffers with other vertex types. */
+		virtual const video::SVertexQuantization* getVertexQuantization() const
+		{
+			return 0;
+		}
+
 		//! Bitflags with options for cloning
 		enum ECloneFlags
 		{
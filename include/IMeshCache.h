@@ -18,6 +18,24 @@ namespace scene
 	class IAnimatedMeshSceneNode;
 	class IMeshLoader;
 
+	//! Counters and memory use of a mesh cache
+	struct SMeshCacheStatistics
+	{
+		SMeshCacheStatistics() : Hits(0), Misses(0), Evictions(0), MemoryUsed(0) {}
+
+		//! Number of times getMeshByName() found a mesh
+		u32 Hits;
+
+		//! Number of times getMeshByName() found no mesh
+		u32 Misses;
+
+		//! Number of meshes removed to stay within the memory budget
+		u32 Evictions;
+
+		//! Estimated memory of all meshes in the cache in bytes
+		u32 MemoryUsed;
+	};
+
 	//! The mesh cache stores already loaded meshes and provides an interface to them.
 	/** You can access it using ISceneManager::getMeshCache(). All existing
 	scene managers will return a pointer to the same mesh cache, because it
@@ -167,6 +185,25 @@ namespace scene
 		/** Warning: If you have pointers to meshes that were loaded with ISceneManager::getMesh()
 		and you did not grab them, then they may become invalid. */
 		virtual void clearUnusedMeshes() = 0;
+
+		//! Sets how much memory the meshes in the cache may use.
+		/** When adding a mesh takes the cache above the budget, meshes which
+		are not used anywhere else are removed, least recently used first,
+		until it fits again. Meshes which are still in use are never removed,
+		so the cache can stay above the budget. The memory of a mesh is
+		estimated from its vertices, indices and animation data when it is
+		added.
+		Warning: Like with clearUnusedMeshes(), pointers to meshes loaded with
+		ISceneManager::getMesh() become invalid when the mesh is removed, unless
+		you grabbed them or a scene node uses the mesh.
+		\param bytes Budget in bytes, 0 means no limit. This is the default. */
+		virtual void setMemoryBudget(u32 bytes) = 0;
+
+		//! Returns the memory budget set with setMemoryBudget()
+		virtual u32 getMemoryBudget() const = 0;
+
+		//! Returns hit, miss and eviction counters and the memory used
+		virtual const SMeshCacheStatistics& getStatistics() const = 0;
 	};
 
 
@@ -15,6 +15,7 @@ namespace irr
 namespace io
 {
 	class IReadFile;
+	class IAttributes;
 } // end namespace io
 namespace scene
 {
@@ -53,6 +54,34 @@ public:
 	See IReferenceCounted::drop() for more information. */
 	virtual IAnimatedMesh* createMesh(io::IReadFile* file) = 0;
 
+	//! Returns true if createMesh() may be called from another thread than the main thread.
+	/** Used by IAsyncLoader to decode meshes on worker threads. Several of its
+	threads may call one loader at the same time, and ISceneManager::getMesh()
+	may call it on the main thread meanwhile. So the loader has to keep its
+	parse state per call, and it must not use anything else which isn't
+	thread safe, like the video driver, the mesh cache, the scene graph or
+	ISceneManager::getParameters().
+	\return False by default, then meshes of this loader are only read on a
+	worker thread and created on the main thread. */
+	virtual bool isThreadSafe() const
+	{
+		return false;
+	}
+
+	//! Creates/loads an animated mesh from the file with the given scene parameters.
+	/** IAsyncLoader calls this on worker threads with a copy of
+	ISceneManager::getParameters() taken when the mesh was requested, as the
+	application may change the parameters of the scene manager meanwhile.
+	Thread safe loaders which use parameters have to override it and read
+	them from here instead.
+	\param file File handler to load the file from.
+	\param parameters Used instead of ISceneManager::getParameters().
+	\return Like createMesh(). By default it calls createMesh(). */
+	virtual IAnimatedMesh* createMeshWithParameters(io::IReadFile* file, const io::IAttributes* parameters)
+	{
+		return createMesh(file);
+	}
+
 	//! Set a new texture loader which this meshloader can use when searching for textures.
 	/** NOTE: Not all meshloaders do support this interface. Meshloaders which
 	support it will return a non-null value in getMeshTextureLoader from the start. Setting a
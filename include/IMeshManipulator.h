@@ -20,6 +20,53 @@ namespace scene
 
 	struct SMesh;
 
+	//! Steps of IMeshManipulator::createOptimizedMesh()
+	enum E_MESH_OPTIMIZATION_FLAGS
+	{
+		//! Reorder triangles for the post-transform vertex cache
+		EMOF_VERTEX_CACHE = 1,
+
+		//! Reorder groups of triangles so that front faces tend to be drawn first
+		/** Keeps most of the vertex cache order, as only groups which
+		start with a cache flush are moved. */
+		EMOF_OVERDRAW = 2,
+
+		//! Reorder vertices in the order of their first use and remove unused ones
+		EMOF_VERTEX_FETCH = 4,
+
+		//! Merge meshbuffers with the same material and vertex type
+		EMOF_MERGE_BUFFERS = 8,
+
+		//! Split meshbuffers with more than 65536 vertices instead of using 32 bit indices
+		EMOF_SPLIT_BUFFERS = 16,
+
+		//! All steps which keep the meshbuffers as they are
+		EMOF_DEFAULT = EMOF_VERTEX_CACHE | EMOF_OVERDRAW | EMOF_VERTEX_FETCH
+	};
+
+	//! Statistics of IMeshManipulator::createOptimizedMesh()
+	/** Only triangle list meshbuffers are counted. */
+	struct SMeshOptimizationReport
+	{
+		SMeshOptimizationReport()
+			: AcmrBefore(0.f), AcmrAfter(0.f), OverdrawBefore(0.f), OverdrawAfter(0.f)
+		{
+		}
+
+		//! Average cache miss ratio, transformed vertices per triangle
+		/** Simulated with a FIFO cache of 16 vertices, which is cleared for
+		each meshbuffer. Between 0.5 for very large regular grids and 3. */
+		f32 AcmrBefore;
+		f32 AcmrAfter;
+
+		//! Shaded pixels per covered pixel
+		/** Measured by rasterizing the mesh from the 6 axis directions with
+		backface culling and a depth test, in the order the triangles
+		are drawn. 1 means that no pixel is shaded twice. */
+		f32 OverdrawBefore;
+		f32 OverdrawAfter;
+	};
+
 	//! An interface for easy manipulation of meshes.
 	/** Scale, set alpha value, flip surfaces, and so on. This exists for
 	fixing problems with wrong imported or exported meshes quickly after
@@ -281,13 +328,31 @@ namespace scene
 		virtual IMesh* createMeshUniquePrimitives(IMesh* mesh) const = 0;
 
 		//! Creates a copy of a mesh with vertices welded
-		/** \param mesh Input mesh
+		/** Triangles which collapse are removed. Mesh buffers which still
+		have more than 65536 vertices are copied into CDynamicMeshBuffers with
+		32 bit indices. Runs in linear time for usual meshes.
+		\param mesh Input mesh
 		\param tolerance The threshold for vertex comparisons.
 		\return Mesh without redundant vertices. If you no longer need
 		the cloned mesh, you should call IMesh::drop(). See
 		IReferenceCounted::drop() for more information. */
 		virtual IMesh* createMeshWelded(IMesh* mesh, f32 tolerance=core::ROUNDING_ERROR_f32) const = 0;
 
+		//! Creates a copy of a mesh with quantized vertices
+		/** Mesh buffers with S3DVertex and S3DVertexTangents vertices and
+		16 bit indices become SMeshBufferQuantized and
+		SMeshBufferQuantizedTangents, which need about half the memory.
+		Positions and texture coordinates are stored with 16 bits over the
+		range of their buffer, normals, tangents and binormals are octahedral
+		encoded. Other mesh buffers are copied. Set a hardware mapping hint
+		on the result, or the OpenGL and Direct3D drivers decode the vertices
+		for each draw.
+		\param mesh Input mesh
+		\return Mesh with quantized vertices. If you no longer need the
+		mesh, you should call IMesh::drop(). See IReferenceCounted::drop()
+		for more information. */
+		virtual IMesh* createMeshQuantized(IMesh* mesh) const = 0;
+
 		//! Get amount of polygons in mesh.
 		/** \param mesh Input mesh
 		\return Number of polygons in mesh. */
@@ -319,6 +384,26 @@ namespace scene
 		\return A new mesh optimized for the vertex cache. */
 		virtual IMesh* createForsythOptimizedMesh(const IMesh *mesh) const = 0;
 
+		//! Optimizes the order of triangles and vertices for rendering
+		/** Unlike createForsythOptimizedMesh() this works in linear time,
+		accepts 32 bit indices and can also reduce overdraw and improve the
+		locality of vertex fetches. Buffers with more than 65536 vertices get
+		32 bit indices unless EMOF_SPLIT_BUFFERS is set, all others 16 bit
+		indices. Meshbuffers which are no triangle lists are copied as they
+		are.
+
+		The function is thread-safe.
+
+		\param mesh Source mesh for the operation.
+		\param flags Combination of E_MESH_OPTIMIZATION_FLAGS.
+		\param report Receives statistics of the source and the new mesh
+		when not 0.
+		\return A new mesh, or 0 if mesh was 0. If you no longer need the
+		mesh, you should call IMesh::drop(). See IReferenceCounted::drop()
+		for more information. */
+		virtual IMesh* createOptimizedMesh(const IMesh* mesh, u32 flags=EMOF_DEFAULT,
+			SMeshOptimizationReport* report=0) const = 0;
+
 		//! Optimize the mesh with an algorithm tuned for heightmaps.
 		/**
 		This differs from usual simplification methods in two ways:
@@ -421,6 +506,8 @@ protected:
 						func(verts[i]);
 					}
 					break;
+				default:
+					break;
 				}
 				if (boundingBoxUpdate)
 				{
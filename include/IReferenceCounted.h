@@ -11,6 +11,10 @@
 	#include "leakHunter.h"
 #endif
 
+#if defined(_IRR_THREAD_SAFE_REFERENCE_COUNTING_) && defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
 namespace irr
 {
 
@@ -93,7 +97,18 @@ namespace irr
 		You will not have to drop the pointer to the loaded texture,
 		because the name of the method does not start with 'create'.
 		The texture is stored somewhere by the driver. */
-		void grab() const { ++ReferenceCounter; }
+		void grab() const
+		{
+#if defined(_IRR_THREAD_SAFE_REFERENCE_COUNTING_)
+	#if defined(_MSC_VER)
+			_InterlockedIncrement((volatile long*)&ReferenceCounter);
+	#else
+			__sync_add_and_fetch(&ReferenceCounter, 1);
+	#endif
+#else
+			++ReferenceCounter;
+#endif
+		}
 
 		//! Drops the object. Decrements the reference counter by one.
 		/** The IReferenceCounted class provides a basic reference
@@ -128,8 +143,16 @@ namespace irr
 			// someone is doing bad reference counting.
 			IRR_DEBUG_BREAK_IF(ReferenceCounter <= 0)
 
-			--ReferenceCounter;
-			if (!ReferenceCounter)
+#if defined(_IRR_THREAD_SAFE_REFERENCE_COUNTING_)
+	#if defined(_MSC_VER)
+			const s32 count = _InterlockedDecrement((volatile long*)&ReferenceCounter);
+	#else
+			const s32 count = __sync_sub_and_fetch(&ReferenceCounter, 1);
+	#endif
+#else
+			const s32 count = --ReferenceCounter;
+#endif
+			if (!count)
 			{
 				delete this;
 				return true;
@@ -10,6 +10,7 @@
 #include "triangle3d.h"
 #include "position2d.h"
 #include "line3d.h"
+#include "ITriangleSelector.h"
 
 namespace irr
 {
@@ -18,34 +19,12 @@ namespace scene
 {
 	class ISceneNode;
 	class ICameraSceneNode;
-	class ITriangleSelector;
-	class IMeshBuffer;
-
-	struct SCollisionHit
-	{
-		//! Point of collision
-		core::vector3df Intersection;
-
-		//! Triangle with which we collided
-		core::triangle3df Triangle;
-
-		//! Triangle selector which contained the colliding triangle (useful when having MetaTriangleSelector)
-		ITriangleSelector* TriangleSelector;
-
-		//! Node which contained the triangle (is 0 when selector doesn't have that information)
-		ISceneNode* Node;
-
-		//! Meshbuffer which contained the triangle (is 0 when the selector doesn't have that information, only works when selectors are created per meshbuffer)
-		const IMeshBuffer* MeshBuffer;
-
-		//! Index of selected material of the triangle in the SceneNode. Usually only valid when MeshBuffer is also set, otherwise always 0
-		irr::u32 MaterialIndex;
-
-		SCollisionHit() : TriangleSelector(0), Node(0), MeshBuffer(0), MaterialIndex(0)
-		{}
-	};
 
 	//! The Scene Collision Manager provides methods for performing collision tests and picking on scene nodes.
+	/** The collision and picking functions keep no state between calls, so
+	they can be called from several threads at once, as long as the scene
+	and the used triangle selectors aren't changed meanwhile. See
+	ITriangleSelector for selectors of animated nodes. */
 	class ISceneCollisionManager : public virtual IReferenceCounted
 	{
 	public:
@@ -58,6 +37,27 @@ namespace scene
 		virtual bool getCollisionPoint(SCollisionHit& hitResult, const core::line3d<f32>& ray,
 				ITriangleSelector* selector) = 0;
 
+		//! Finds the nearest collision points of many lines with lots of triangles.
+		/** Gives the same results as calling getCollisionPoint() for each
+		line, but selectors like the one created by
+		ISceneManager::createBVHTriangleSelector() trace the lines in
+		small packets which share the traversal of their hierarchy. Lines
+		pointing in similar directions from nearby starts, like line of
+		sight checks of a group, benefit most. Large batches are split
+		into parts which are traced on several threads, after the first
+		line was traced alone to bring selectors of animated nodes up to
+		date.
+		\param hitResults: Array of rayCount elements. Receives the collision
+		results of the lines which hit something.
+		\param hitFound: Array of rayCount elements. Set to true for lines
+		which collided, otherwise false.
+		\param rays: Array of rayCount lines with which collisions are tested.
+		\param rayCount: Number of lines.
+		\param selector: TriangleSelector to be used for the collision check.
+		\return Number of lines which collided with a triangle. */
+		virtual u32 getCollisionPoints(SCollisionHit* hitResults, bool* hitFound,
+				const core::line3d<f32>* rays, u32 rayCount, ITriangleSelector* selector) = 0;
+
 		//! Finds the nearest collision point of a line and lots of triangles, if there is one.
 		/** \param ray: Line with which collisions are tested.
 		\param selector: TriangleSelector containing the triangles. It
@@ -1337,11 +1337,15 @@ namespace scene
 		\param minimalPolysPerNode: Specifies the minimal polygons contained a octree node.
 		If a node gets less polys than this value, it will not be split into
 		smaller nodes.
+		\param accelerationData: Optional file with data written by
+		ITriangleSelector::writeAccelerationData() of a selector created with
+		the same parameters. When it was written for the same triangles, the
+		tree is read from it instead of being built. Otherwise it is ignored.
 		\return The selector, or null if not successful.
 		If you no longer need the selector, you should call ITriangleSelector::drop().
 		See IReferenceCounted::drop() for more information. */
 		virtual ITriangleSelector* createOctreeTriangleSelector(IMesh* mesh,
-			ISceneNode* node, s32 minimalPolysPerNode=32) = 0;
+			ISceneNode* node, s32 minimalPolysPerNode=32, io::IReadFile* accelerationData=0) = 0;
 
 		//! Creates a Triangle Selector for a single meshbuffer, optimized by an octree.
 		/** Triangle selectors
@@ -1364,11 +1368,75 @@ namespace scene
 		\param minimalPolysPerNode: Specifies the minimal polygons contained a octree node.
 		If a node gets less polys than this value, it will not be split into
 		smaller nodes.
+		\param accelerationData: Optional file with data written by
+		ITriangleSelector::writeAccelerationData() of a selector created with
+		the same parameters. When it was written for the same triangles, the
+		tree is read from it instead of being built. Otherwise it is ignored.
 		\return The selector, or null if not successful.
 		If you no longer need the selector, you should call ITriangleSelector::drop().
 		See IReferenceCounted::drop() for more information. */
 		virtual ITriangleSelector* createOctreeTriangleSelector(IMeshBuffer* meshBuffer, irr::u32 materialIndex,
-			ISceneNode* node, s32 minimalPolysPerNode=32) = 0;
+			ISceneNode* node, s32 minimalPolysPerNode=32, io::IReadFile* accelerationData=0) = 0;
+
+		//! Creates a Triangle Selector, optimized by a bounding volume hierarchy.
+		/** Triangle selectors can be used for doing collision detection.
+		This triangle selector sorts the triangles into a binary tree of
+		bounding boxes built with the surface area heuristic. It needs less
+		memory than the octree selector, and collision point queries walk the
+		tree front to back and stop at the nearest hit instead of collecting
+		all candidate triangles first.
+		Please note that the created triangle selector is not automatically attached
+		to the scene node. You will have to call ISceneNode::setTriangleSelector()
+		for this.
+		\param mesh: Mesh of which the triangles are taken.
+		\param node: Scene node of which transformation is used.
+		\param separateMeshbuffers: When true it's possible to get information which meshbuffer
+		got hit in collision tests. But has a slight speed cost.
+		\param maxTrianglesPerLeaf: Nodes with this many triangles or less
+		only get split when that is cheaper according to the heuristic.
+		\param accelerationData: Optional file with data written by
+		ITriangleSelector::writeAccelerationData() of a selector created with
+		the same parameters. When it was written for the same triangles, the
+		tree is read from it instead of being built. Otherwise it is ignored.
+		\return The selector, or null if not successful.
+		If you no longer need the selector, you should call ITriangleSelector::drop().
+		See IReferenceCounted::drop() for more information. */
+		virtual ITriangleSelector* createBVHTriangleSelector(IMesh* mesh,
+			ISceneNode* node, bool separateMeshbuffers=false, u32 maxTrianglesPerLeaf=4,
+			io::IReadFile* accelerationData=0) = 0;
+
+		//! Creates a Triangle Selector for a single meshbuffer, optimized by a bounding volume hierarchy.
+		/** See createBVHTriangleSelector(IMesh*, ISceneNode*, bool, u32, io::IReadFile*)
+		\param meshBuffer: Meshbuffer of which the triangles are taken.
+		\param materialIndex: Setting this value allows the triangle selector to return the material index
+		\param node: Scene node of which transformation is used.
+		\param maxTrianglesPerLeaf: Nodes with this many triangles or less
+		only get split when that is cheaper according to the heuristic.
+		\param accelerationData: Optional file with a hierarchy written by
+		ITriangleSelector::writeAccelerationData(), see above.
+		\return The selector, or null if not successful.
+		If you no longer need the selector, you should call ITriangleSelector::drop().
+		See IReferenceCounted::drop() for more information. */
+		virtual ITriangleSelector* createBVHTriangleSelector(IMeshBuffer* meshBuffer, irr::u32 materialIndex,
+			ISceneNode* node, u32 maxTrianglesPerLeaf=4, io::IReadFile* accelerationData=0) = 0;
+
+		//! Creates a Triangle Selector for an animated mesh scene node, optimized by a bounding volume hierarchy.
+		/** The hierarchy is built once for the frame the node shows on
+		creation. When the node shows another frame, the next query takes
+		the new triangles and only refits the boxes of the hierarchy to them.
+		That makes hits against animated characters cheap, as long as the
+		animation doesn't move triangles too far from where they were on
+		creation.
+		\param node The animated mesh scene node from which to build the selector
+		\param separateMeshbuffers: When true it's possible to get information which meshbuffer
+		got hit in collision tests. But has a slight speed cost.
+		\param maxTrianglesPerLeaf: Nodes with this many triangles or less
+		only get split when that is cheaper according to the heuristic.
+		\return The selector, or null if not successful.
+		If you no longer need the selector, you should call ITriangleSelector::drop().
+		See IReferenceCounted::drop() for more information. */
+		virtual ITriangleSelector* createBVHTriangleSelector(IAnimatedMeshSceneNode* node,
+			bool separateMeshbuffers=false, u32 maxTrianglesPerLeaf=4) = 0;
 
 		//! //! Creates a Triangle Selector, optimized by an octree.
 		/** \deprecated Use createOctreeTriangleSelector instead. This method may be removed by Irrlicht 1.9. */
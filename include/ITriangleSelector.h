@@ -14,6 +14,10 @@
 
 namespace irr
 {
+namespace io
+{
+	class IWriteFile;
+} // end namespace io
 namespace scene
 {
 
@@ -62,13 +66,46 @@ struct SCollisionTriangleRange
 	irr::u32 MaterialIndex;
 };
 
+//! Result of a collision test of a line with the triangles of an ITriangleSelector
+struct SCollisionHit
+{
+	//! Point of collision
+	core::vector3df Intersection;
+
+	//! Triangle with which we collided
+	core::triangle3df Triangle;
+
+	//! Triangle selector which contained the colliding triangle (useful when having MetaTriangleSelector)
+	ITriangleSelector* TriangleSelector;
+
+	//! Node which contained the triangle (is 0 when selector doesn't have that information)
+	ISceneNode* Node;
+
+	//! Meshbuffer which contained the triangle (is 0 when the selector doesn't have that information, only works when selectors are created per meshbuffer)
+	const IMeshBuffer* MeshBuffer;
+
+	//! Index of selected material of the triangle in the SceneNode. Usually only valid when MeshBuffer is also set, otherwise always 0
+	irr::u32 MaterialIndex;
+
+	SCollisionHit() : TriangleSelector(0), Node(0), MeshBuffer(0), MaterialIndex(0)
+	{}
+};
+
 //! Interface to return triangles with specific properties.
 /** Every ISceneNode may have a triangle selector, available with
 ISceneNode::getTriangleSelector() or ISceneManager::createTriangleSelector.
 This is used for doing collision detection: For example if you know, that a
 collision may have happened in the area between (1,1,1) and (10,10,10), you
 can get all triangles of the scene node in this area with the
-ITriangleSelector easily and check every triangle if it collided. */
+ITriangleSelector easily and check every triangle if it collided.
+The const query functions of the selectors created by the engine don't change
+the selector, so several threads can query the same selector at once. The
+exception are selectors of animated scene nodes, which rebuild their triangles
+in the first query after the frame of the node changed, and meta selectors,
+which update the bounds of their selectors in the first query after those
+moved. Query those from one thread after the animation advanced or the nodes
+moved before querying them from several threads.
+The scene itself must not change while other threads query it. */
 class ITriangleSelector : public virtual IReferenceCounted
 {
 public:
@@ -162,6 +199,150 @@ public:
 		const core::matrix4* transform=0, bool useNodeTransform=true,
 		irr::core::array<SCollisionTriangleRange>* outTriangleInfo=0) const = 0;
 
+	//! Gets the nearest intersection of a 3d line with the triangles of this selector.
+	/** Selectors which organize their triangles in a spatial structure
+	override this to find the hit without copying out any triangles. The
+	default implementation fetches all candidates with getTriangles() and
+	tests each of them.
+	\param hitResult Receives the nearest hit. Intersection and Triangle are
+	transformed in the same way as the triangles returned by getTriangles().
+	\param line Line to test. Only hits between start and end are reported.
+	\param useNodeTransform When the selector has a node then transform the
+	triangles by that node's transformation matrix.
+	\return True if a triangle was hit, otherwise false. */
+	virtual bool getCollisionPoint(SCollisionHit& hitResult, const core::line3d<f32>& line,
+		bool useNodeTransform=true) const
+	{
+		const s32 totalcnt = getTriangleCount();
+		if ( totalcnt <= 0 )
+			return false;
+
+		core::array<core::triangle3df> triangles((u32)totalcnt);
+		triangles.set_used((u32)totalcnt);
+
+		s32 cnt = 0;
+		core::array<SCollisionTriangleRange> outTriangleInfo;
+		getTriangles(triangles.pointer(), totalcnt, cnt, line, 0, useNodeTransform, &outTriangleInfo);
+
+		const core::vector3df linevect = line.getVector().normalize();
+		core::vector3df intersection;
+		f32 nearest = FLT_MAX;
+		s32 foundIndex = -1;
+		const f32 raylength = line.getLengthSQ();
+
+		const f32 minX = core::min_(line.start.X, line.end.X);
+		const f32 maxX = core::max_(line.start.X, line.end.X);
+		const f32 minY = core::min_(line.start.Y, line.end.Y);
+		const f32 maxY = core::max_(line.start.Y, line.end.Y);
+		const f32 minZ = core::min_(line.start.Z, line.end.Z);
+		const f32 maxZ = core::max_(line.start.Z, line.end.Z);
+
+		for (s32 i=0; i<cnt; ++i)
+		{
+			const core::triangle3df & triangle = triangles[i];
+
+			if(minX > triangle.pointA.X && minX > triangle.pointB.X && minX > triangle.pointC.X)
+				continue;
+			if(maxX < triangle.pointA.X && maxX < triangle.pointB.X && maxX < triangle.pointC.X)
+				continue;
+			if(minY > triangle.pointA.Y && minY > triangle.pointB.Y && minY > triangle.pointC.Y)
+				continue;
+			if(maxY < triangle.pointA.Y && maxY < triangle.pointB.Y && maxY < triangle.pointC.Y)
+				continue;
+			if(minZ > triangle.pointA.Z && minZ > triangle.pointB.Z && minZ > triangle.pointC.Z)
+				continue;
+			if(maxZ < triangle.pointA.Z && maxZ < triangle.pointB.Z && maxZ < triangle.pointC.Z)
+				continue;
+
+			if (triangle.getIntersectionWithLine(line.start, linevect, intersection))
+			{
+				const f32 tmp = intersection.getDistanceFromSQ(line.start);
+				const f32 tmp2 = intersection.getDistanceFromSQ(line.end);
+
+				if (tmp < raylength && tmp2 < raylength && tmp < nearest)
+				{
+					nearest = tmp;
+
+					hitResult.Triangle = triangle;
+					hitResult.Intersection = intersection;
+					foundIndex = i;
+				}
+			}
+		}
+
+		if ( foundIndex < 0 )
+			return false;
+
+		for ( u32 t=0; t<outTriangleInfo.size(); ++t )
+		{
+			if ( outTriangleInfo[t].isIndexInRange(foundIndex) )
+			{
+				hitResult.Node = outTriangleInfo[t].SceneNode;
+				hitResult.MeshBuffer = outTriangleInfo[t].MeshBuffer;
+				hitResult.MaterialIndex = outTriangleInfo[t].MaterialIndex;
+				hitResult.TriangleSelector = outTriangleInfo[t].Selector;
+				break;
+			}
+		}
+
+		return true;
+	}
+
+	//! Gets the nearest intersections of several 3d lines with the triangles of this selector.
+	/** Selectors which can trace several lines at once override this.
+	The default implementation calls getCollisionPoint() for each line.
+	\param hitResults Array of lineCount elements. Receives the nearest hit
+	of each line which hit a triangle, other elements are left unchanged.
+	\param hitFound Array of lineCount elements. Set to true for lines
+	which hit a triangle, otherwise false.
+	\param lines Array of lineCount lines to test.
+	\param lineCount Number of lines.
+	\param useNodeTransform When the selector has a node then transform the
+	triangles by that node's transformation matrix.
+	\return Number of lines which hit a triangle. */
+	virtual u32 getCollisionPoints(SCollisionHit* hitResults, bool* hitFound,
+		const core::line3d<f32>* lines, u32 lineCount, bool useNodeTransform=true) const
+	{
+		u32 hits = 0;
+		for (u32 i=0; i<lineCount; ++i)
+		{
+			hitFound[i] = getCollisionPoint(hitResults[i], lines[i], useNodeTransform);
+			if (hitFound[i])
+				++hits;
+		}
+		return hits;
+	}
+
+	//! Get a box around all triangles of this selector
+	/** Meta selectors use this to skip selectors which can't be touched
+	by a query.
+	\param outBox Receives the box. It is transformed in the same way as the
+	triangles returned by getTriangles() without a transform matrix.
+	\param useNodeTransform When the selector has a node then transform the
+	box by that node's transformation matrix.
+	\return True if the box is known. The default implementation returns
+	false, such selectors are checked by every query. */
+	virtual bool getBoundingBox(core::aabbox3d<f32>& outBox, bool useNodeTransform=true) const
+	{
+		return false;
+	}
+
+	//! Writes the spatial structure this selector built over its triangles
+	/** Selectors which sort their triangles into a tree can save it, so
+	it doesn't have to be built again the next time the same mesh is loaded.
+	Pass the file to ISceneManager::createOctreeTriangleSelector() or
+	ISceneManager::createBVHTriangleSelector() to use the data.
+	The data is a versioned binary block in the byte order of the machine.
+	It contains a hash of the triangles, data written for another mesh or by
+	another kind of selector is ignored on loading.
+	\param file File to write to.
+	\return True if the selector has such a structure and it was written.
+	The default implementation returns false. */
+	virtual bool writeAccelerationData(io::IWriteFile* file) const
+	{
+		return false;
+	}
+
 	//! Get number of TriangleSelectors that are part of this one
 	/** Only useful for MetaTriangleSelector, others return 1
 	*/
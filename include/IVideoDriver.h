@@ -140,6 +140,21 @@ namespace video
 		0
 	};
 
+	//! Memory use of the textures of a driver
+	struct STextureStatistics
+	{
+		STextureStatistics() : MemoryUsed(0), Evictions(0), Reloads(0) {}
+
+		//! Estimated memory of all resident textures in bytes
+		u32 MemoryUsed;
+
+		//! Number of textures whose data was released to stay within the memory budget
+		u32 Evictions;
+
+		//! Number of evicted textures loaded again from their file
+		u32 Reloads;
+	};
+
 	//! Interface to driver which is able to perform 2d and 3d graphics functions.
 	/** This interface is one of the most important interfaces of
 	the Irrlicht Engine: All rendering and texture manipulation is done with
@@ -419,6 +434,25 @@ namespace video
 		0 or another texture first. */
 		virtual void removeAllTextures() =0;
 
+		//! Sets the memory budget for textures loaded from files
+		/** At the end of each frame, textures which were loaded with
+		getTexture() and weren't used longest release their data until the
+		memory of all textures fits into the budget again. The texture objects
+		stay valid, their data is loaded again from the same file the next time
+		they are used. Textures used in the current frame, render targets,
+		textures created from images and textures which were locked for
+		writing are never released, as the file doesn't have their data.
+		Releasing texture data is only supported by the Burning's Video
+		driver so far, the other drivers only count the memory.
+		\param bytes Budget in bytes, 0 means no limit. This is the default. */
+		virtual void setTextureMemoryBudget(u32 bytes) =0;
+
+		//! Returns the budget set with setTextureMemoryBudget()
+		virtual u32 getTextureMemoryBudget() const =0;
+
+		//! Returns the memory used by textures and the eviction and reload counters
+		virtual const STextureStatistics& getTextureStatistics() const =0;
+
 		//! Remove hardware buffer
 		virtual void removeHardwareBuffer(const scene::IMeshBuffer* mb) =0;
 
@@ -1201,6 +1235,30 @@ namespace video
 			return (imageArray.size() > 0) ? imageArray[0] : 0;
 		}
 
+		//! Creates a software image from a file, reduced to fit into a maximal size.
+		/** The aspect ratio of the image is kept. JPEG and PNG files
+		are decoded at the lower resolution right away, which is much
+		faster and needs far less memory than loading the full image.
+		Images of other formats are scaled down after loading, compressed
+		images are not reduced at all. This method is useful for example
+		for thumbnails or, together with getMaxTextureSize(), to load
+		huge photos as textures.
+		\param filename Name of the file from which the image is created.
+		\param maxSize Largest size the image may have.
+		\return The created image.
+		If you no longer need the image, you should call IImage::drop().
+		See IReferenceCounted::drop() for more information. */
+		virtual IImage* createReducedImageFromFile(const io::path& filename, const core::dimension2du& maxSize) = 0;
+
+		//! Creates a software image from a file, reduced to fit into a maximal size.
+		/** See createReducedImageFromFile(const io::path&, const core::dimension2du&).
+		\param file File from which the image is created.
+		\param maxSize Largest size the image may have.
+		\return The created image.
+		If you no longer need the image, you should call IImage::drop().
+		See IReferenceCounted::drop() for more information. */
+		virtual IImage* createReducedImageFromFile(io::IReadFile* file, const core::dimension2du& maxSize) = 0;
+
 		//! Writes the provided image to a file.
 		/** Requires that there is a suitable image writer registered
 		for writing the image.
@@ -109,6 +109,30 @@
 #endif
 
 
+//! Define _IRR_COMPILE_WITH_THREADS_ if the engine may start worker threads.
+/** Used by IAsyncLoader to load files in the background. Without it
+requests are loaded on the main thread in IAsyncLoader::update().
+NOTE: On Linux applications then have to link with -lpthread.
+*/
+#if defined(_IRR_WINDOWS_API_) || defined(_IRR_POSIX_API_) || defined(_IRR_OSX_PLATFORM_)
+#define _IRR_COMPILE_WITH_THREADS_
+#endif
+#ifdef NO_IRR_COMPILE_WITH_THREADS_
+#undef _IRR_COMPILE_WITH_THREADS_
+#endif
+
+//! Define _IRR_THREAD_SAFE_REFERENCE_COUNTING_ to make IReferenceCounted::grab() and drop() atomic.
+/** Needed when reference counted objects are shared between threads, for
+example when own threads load meshes or open files. It makes grab() and drop()
+slower, so it's disabled by default. As grab() and drop() are inline, the
+engine and the application have to be compiled with the same setting.
+*/
+//#define _IRR_THREAD_SAFE_REFERENCE_COUNTING_
+#ifdef NO_IRR_THREAD_SAFE_REFERENCE_COUNTING_
+#undef _IRR_THREAD_SAFE_REFERENCE_COUNTING_
+#endif
+
+
 //! Maximum number of texture an SMaterial can have, up to 8 are supported by Irrlicht.
 #define _IRR_MATERIAL_MAX_TEXTURES_ 8
 
@@ -451,6 +475,11 @@ B3D, MS3D or X meshes */
 #ifdef NO_IRR_COMPILE_WITH_IRR_MESH_LOADER_
 #undef _IRR_COMPILE_WITH_IRR_MESH_LOADER_
 #endif
+//! Define _IRR_COMPILE_WITH_IRR_BINARY_MESH_LOADER_ if you want to load binary Irrlicht Engine .irrbmesh files
+#define _IRR_COMPILE_WITH_IRR_BINARY_MESH_LOADER_
+#ifdef NO_IRR_COMPILE_WITH_IRR_BINARY_MESH_LOADER_
+#undef _IRR_COMPILE_WITH_IRR_BINARY_MESH_LOADER_
+#endif
 //! Define _IRR_COMPILE_WITH_HALFLIFE_LOADER_ if you want to load Halflife animated files
 #define _IRR_COMPILE_WITH_HALFLIFE_LOADER_
 #ifdef NO_IRR_COMPILE_WITH_HALFLIFE_LOADER_
@@ -537,6 +566,11 @@ B3D, MS3D or X meshes */
 #ifdef NO_IRR_COMPILE_WITH_IRR_WRITER_
 #undef _IRR_COMPILE_WITH_IRR_WRITER_
 #endif
+//! Define _IRR_COMPILE_WITH_IRR_BINARY_MESH_WRITER_ if you want to write binary .irrbmesh files
+#define _IRR_COMPILE_WITH_IRR_BINARY_MESH_WRITER_
+#ifdef NO_IRR_COMPILE_WITH_IRR_BINARY_MESH_WRITER_
+#undef _IRR_COMPILE_WITH_IRR_BINARY_MESH_WRITER_
+#endif
 //! Define _IRR_COMPILE_WITH_COLLADA_WRITER_ if you want to write Collada files
 #define _IRR_COMPILE_WITH_COLLADA_WRITER_
 #ifdef NO_IRR_COMPILE_WITH_COLLADA_WRITER_
@@ -21,6 +21,7 @@ namespace irr
 	class ILogger;
 	class IEventReceiver;
 	class IRandomizer;
+	class IAsyncLoader;
 
 	namespace io {
 		class IFileSystem;
@@ -152,6 +153,13 @@ namespace irr
 		\return Pointer to the default IRandomizer object. */
 		virtual IRandomizer* createDefaultRandomizer() const =0;
 
+		//! Provides access to the loader for meshes and textures in the background.
+		/** The loader is created on the first call. Its update() function
+		has to be called regularly from the main thread, for example once per
+		frame, to get the loaded meshes and textures.
+		\return Pointer to the IAsyncLoader object. */
+		virtual IAsyncLoader* getAsyncLoader() = 0;
+
 		//! Sets the caption of the window.
 		/** \param text: New text of the window caption. */
 		virtual void setWindowCaption(const wchar_t* text) = 0;
@@ -28,7 +28,17 @@ enum E_VERTEX_TYPE
 	/** Usually used for tangent space normal mapping. 
 		Usually tangent and binormal get send to shaders as texture coordinate sets 1 and 2.
 	*/
-	EVT_TANGENTS
+	EVT_TANGENTS,
+
+	//! Vertex with 16 bit position, normal and texture coordinates, video::S3DVertexQuantized.
+	/** Positions and texture coordinates are decoded with the
+		video::SVertexQuantization of the meshbuffer, see
+		scene::IMeshBuffer::getVertexQuantization().
+	*/
+	EVT_QUANTIZED,
+
+	//! Quantized vertex with a tangent and binormal vector, video::S3DVertexQuantizedTangents.
+	EVT_QUANTIZED_TANGENTS
 };
 
 //! Array holding the built in vertex type names
@@ -37,6 +47,8 @@ const char* const sBuiltInVertexTypeNames[] =
 	"standard",
 	"2tcoords",
 	"tangents",
+	"quantized",
+	"quantizedTangents",
 	0
 };
 
@@ -259,6 +271,182 @@ struct S3DVertexTangents : public S3DVertex
 };
 
 
+//! Encodes a direction in two values with the octahedral mapping
+/** The direction is projected onto an octahedron, whose lower half is folded
+up onto the square of the upper half. Zero vectors become (0,0,1). */
+inline void encodeOctahedral(const core::vector3df& dir, s16* oct)
+{
+	const f32 length = core::abs_(dir.X) + core::abs_(dir.Y) + core::abs_(dir.Z);
+	f32 x = 0.f;
+	f32 y = 0.f;
+	if (length > 0.f)
+	{
+		x = dir.X / length;
+		y = dir.Y / length;
+		if (dir.Z < 0.f)
+		{
+			const f32 foldX = (1.f - core::abs_(y)) * (x < 0.f ? -1.f : 1.f);
+			y = (1.f - core::abs_(x)) * (y < 0.f ? -1.f : 1.f);
+			x = foldX;
+		}
+	}
+	oct[0] = (s16)core::round32(x * 32767.f);
+	oct[1] = (s16)core::round32(y * 32767.f);
+}
+
+//! Decodes a direction encoded with encodeOctahedral()
+/** \return Normalized direction. */
+inline core::vector3df decodeOctahedral(const s16* oct)
+{
+	core::vector3df dir(oct[0] / 32767.f, oct[1] / 32767.f, 0.f);
+	dir.Z = 1.f - core::abs_(dir.X) - core::abs_(dir.Y);
+	if (dir.Z < 0.f)
+	{
+		const f32 foldX = (1.f - core::abs_(dir.Y)) * (dir.X < 0.f ? -1.f : 1.f);
+		dir.Y = (1.f - core::abs_(dir.X)) * (dir.Y < 0.f ? -1.f : 1.f);
+		dir.X = foldX;
+	}
+	return dir.normalize();
+}
+
+//! Quantized version of S3DVertex with about half its size.
+/** Positions and texture coordinates are 16 bit values which
+	SVertexQuantization maps to a range, the normal is octahedral encoded.
+*/
+struct S3DVertexQuantized
+{
+	//! Color
+	SColor Color;
+
+	//! Position, decoded by SVertexQuantization::decodePosition()
+	u16 Pos[3];
+
+	//! Normal, decoded by decodeOctahedral()
+	s16 Normal[2];
+
+	//! Texture coordinates, decoded by SVertexQuantization::decodeTCoords()
+	u16 TCoords[2];
+
+	static E_VERTEX_TYPE getType()
+	{
+		return EVT_QUANTIZED;
+	}
+};
+
+//! Quantized version of S3DVertexTangents.
+struct S3DVertexQuantizedTangents : public S3DVertexQuantized
+{
+	//! Tangent, decoded by decodeOctahedral()
+	s16 Tangent[2];
+
+	//! Binormal, decoded by decodeOctahedral()
+	s16 Binormal[2];
+
+	static E_VERTEX_TYPE getType()
+	{
+		return EVT_QUANTIZED_TANGENTS;
+	}
+};
+
+//! Ranges of the positions and texture coordinates of quantized vertices
+/** A value v is stored as round((v - Offset) / Scale) and decoded as
+Offset + stored * Scale, so the 65536 steps cover Offset to Offset + 65535 * Scale. */
+struct SVertexQuantization
+{
+	//! Default constructor, decodes the stored values unchanged
+	SVertexQuantization()
+		: PositionOffset(0.f, 0.f, 0.f), PositionScale(1.f, 1.f, 1.f),
+		TCoordsOffset(0.f, 0.f), TCoordsScale(1.f, 1.f) {}
+
+	//! Sets offsets and scales so that the given ranges use all 16 bits
+	void setRanges(const core::vector3df& minPosition, const core::vector3df& maxPosition,
+		const core::vector2df& minTCoords, const core::vector2df& maxTCoords)
+	{
+		PositionOffset = minPosition;
+		PositionScale.set(getScale(minPosition.X, maxPosition.X), getScale(minPosition.Y, maxPosition.Y),
+			getScale(minPosition.Z, maxPosition.Z));
+		TCoordsOffset = minTCoords;
+		TCoordsScale.set(getScale(minTCoords.X, maxTCoords.X), getScale(minTCoords.Y, maxTCoords.Y));
+	}
+
+	core::vector3df decodePosition(const u16* pos) const
+	{
+		return core::vector3df(PositionOffset.X + pos[0] * PositionScale.X,
+			PositionOffset.Y + pos[1] * PositionScale.Y,
+			PositionOffset.Z + pos[2] * PositionScale.Z);
+	}
+
+	void encodePosition(const core::vector3df& position, u16* pos) const
+	{
+		pos[0] = encode(position.X, PositionOffset.X, PositionScale.X);
+		pos[1] = encode(position.Y, PositionOffset.Y, PositionScale.Y);
+		pos[2] = encode(position.Z, PositionOffset.Z, PositionScale.Z);
+	}
+
+	core::vector2df decodeTCoords(const u16* tcoords) const
+	{
+		return core::vector2df(TCoordsOffset.X + tcoords[0] * TCoordsScale.X,
+			TCoordsOffset.Y + tcoords[1] * TCoordsScale.Y);
+	}
+
+	void encodeTCoords(const core::vector2df& texCoords, u16* tcoords) const
+	{
+		tcoords[0] = encode(texCoords.X, TCoordsOffset.X, TCoordsScale.X);
+		tcoords[1] = encode(texCoords.Y, TCoordsOffset.Y, TCoordsScale.Y);
+	}
+
+	//! Decodes a quantized vertex
+	void decode(const S3DVertexQuantized& v, S3DVertex& out) const
+	{
+		out.Pos = decodePosition(v.Pos);
+		out.Normal = decodeOctahedral(v.Normal);
+		out.Color = v.Color;
+		out.TCoords = decodeTCoords(v.TCoords);
+	}
+
+	//! Decodes a quantized vertex with tangents
+	void decode(const S3DVertexQuantizedTangents& v, S3DVertexTangents& out) const
+	{
+		decode(static_cast<const S3DVertexQuantized&>(v), static_cast<S3DVertex&>(out));
+		out.Tangent = decodeOctahedral(v.Tangent);
+		out.Binormal = decodeOctahedral(v.Binormal);
+	}
+
+	//! Quantizes a vertex, values outside of the ranges are clamped
+	void encode(const S3DVertex& v, S3DVertexQuantized& out) const
+	{
+		encodePosition(v.Pos, out.Pos);
+		encodeOctahedral(v.Normal, out.Normal);
+		out.Color = v.Color;
+		encodeTCoords(v.TCoords, out.TCoords);
+	}
+
+	//! Quantizes a vertex with tangents, values outside of the ranges are clamped
+	void encode(const S3DVertexTangents& v, S3DVertexQuantizedTangents& out) const
+	{
+		encode(static_cast<const S3DVertex&>(v), static_cast<S3DVertexQuantized&>(out));
+		encodeOctahedral(v.Tangent, out.Tangent);
+		encodeOctahedral(v.Binormal, out.Binormal);
+	}
+
+	core::vector3df PositionOffset;
+	core::vector3df PositionScale;
+	core::vector2df TCoordsOffset;
+	core::vector2df TCoordsScale;
+
+private:
+
+	static f32 getScale(f32 minValue, f32 maxValue)
+	{
+		return maxValue > minValue ? (maxValue - minValue) / 65535.f : 1.f;
+	}
+
+	static u16 encode(f32 value, f32 offset, f32 scale)
+	{
+		return (u16)core::round32(core::clamp((value - offset) / scale, 0.f, 65535.f));
+	}
+};
+
 
 inline u32 getVertexPitchFromType(E_VERTEX_TYPE vertexType)
 {
@@ -268,6 +456,10 @@ inline u32 getVertexPitchFromType(E_VERTEX_TYPE vertexType)
 		return sizeof(video::S3DVertex2TCoords);
 	case video::EVT_TANGENTS:
 		return sizeof(video::S3DVertexTangents);
+	case video::EVT_QUANTIZED:
+		return sizeof(video::S3DVertexQuantized);
+	case video::EVT_QUANTIZED_TANGENTS:
+		return sizeof(video::S3DVertexQuantizedTangents);
 	default:
 		return sizeof(video::S3DVertex);
 	}
@@ -139,6 +139,30 @@ namespace scene
 	const c8* const OBJ_LOADER_IGNORE_MATERIAL_FILES = "OBJ_IgnoreMaterialFiles";
 
 
+	//! Name of the parameter limiting the threads used to parse large text meshes
+	/** The .obj and ascii .ply loaders split big files into chunks which are
+	parsed at the same time. The result is the same for any value. 0 (the
+	default) uses one thread per processor, 1 parses on the loading thread only.
+	Use it like this:
+	\code
+	SceneManager->getParameters()->setAttribute(scene::MESH_LOADER_PARSE_THREADS, 2);
+	\endcode
+	**/
+	const c8* const MESH_LOADER_PARSE_THREADS = "MeshLoader_ParseThreads";
+
+
+	//! Flag to weld equal vertices of .stl files while loading
+	/** STL files store each triangle with its own 3 vertices. With this flag
+	the loader merges them like IMeshManipulator::createMeshWelded() with the
+	default tolerance, so they can be shared by the indices, and drops the
+	triangles which collapse. Use it like this:
+	\code
+	SceneManager->getParameters()->setAttribute(scene::STL_LOADER_WELD_VERTICES, true);
+	\endcode
+	**/
+	const c8* const STL_LOADER_WELD_VERTICES = "STL_WeldVertices";
+
+
 	//! Flag to ignore the b3d file's mipmapping flag
 	/** Instead Irrlicht's texture creation flag is used. Use it like this:
 	\code
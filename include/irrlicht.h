@@ -34,6 +34,7 @@
 #include "CDynamicMeshBuffer.h"
 #include "CIndexBuffer.h"
 #include "CMeshBuffer.h"
+#include "CMeshBufferQuantized.h"
 #include "coreutil.h"
 #include "CVertexBuffer.h"
 #include "IProfiler.h"
@@ -58,6 +59,7 @@
 #include "IAnimatedMeshMD2.h"
 #include "IAnimatedMeshMD3.h"
 #include "IAnimatedMeshSceneNode.h"
+#include "IAsyncLoader.h"
 #include "IAttributeExchangingObject.h"
 #include "IAttributes.h"
 #include "IBillboardSceneNode.h"
@@ -115,6 +117,7 @@
 #include "IMeshManipulator.h"
 #include "IMeshSceneNode.h"
 #include "IMeshWriter.h"
+#include "IMemoryReadFile.h"
 #include "IOctreeSceneNode.h"
 #include "IColladaMeshWriter.h"
 #include "IMetaTriangleSelector.h"
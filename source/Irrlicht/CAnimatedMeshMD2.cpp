@@ -327,39 +327,52 @@ void CAnimatedMeshMD2::updateInterpolationBuffer(s32 frame, s32 startFrameLoop,
 		InterpolationSecondFrame = secondFrame;
 		InterpolationFrameDiv = div;
 
-		video::S3DVertex* target = static_cast<video::S3DVertex*>(InterpolationBuffer->getVertices());
-		SMD2Vert* first = FrameList[firstFrame].pointer();
-		SMD2Vert* second = FrameList[secondFrame].pointer();
-
 		// interpolate both frames
-		const u32 count = FrameList[firstFrame].size();
+		const f32* data = KeyFrames.interpolate(firstFrame, secondFrame, div);
+		KeyFrames.copyTo(static_cast<video::S3DVertex*>(InterpolationBuffer->getVertices()),
+			data, 0, KeyFrames.getVertexCount());
+
+		//update bounding box, blended like the vertices
+		InterpolationBuffer->setBoundingBox(BoxList[secondFrame].getInterpolated(BoxList[firstFrame],
+			CKeyFrameInterpolator::getQuantizedBlend(div)));
+		InterpolationBuffer->setDirty();
+	}
+}
+
+
+//! unpacks FrameList into float data used for interpolation
+void CAnimatedMeshMD2::prepareKeyFrames()
+{
+	if (!FrameList)
+		return;
+
+	const u32 count = FrameCount ? FrameList[0].size() : 0;
+	KeyFrames.setup(FrameCount, count);
+
+	for (u32 f=0; f<FrameCount; ++f)
+	{
+		const SKeyFrameTransform& t = FrameTransforms[f];
+		const SMD2Vert* v = FrameList[f].const_pointer();
 		for (u32 i=0; i<count; ++i)
 		{
-			const core::vector3df one = core::vector3df(f32(first->Pos.X) * FrameTransforms[firstFrame].scale.X + FrameTransforms[firstFrame].translate.X,
-					f32(first->Pos.Y) * FrameTransforms[firstFrame].scale.Y + FrameTransforms[firstFrame].translate.Y,
-					f32(first->Pos.Z) * FrameTransforms[firstFrame].scale.Z + FrameTransforms[firstFrame].translate.Z);
-			const core::vector3df two = core::vector3df(f32(second->Pos.X) * FrameTransforms[secondFrame].scale.X + FrameTransforms[secondFrame].translate.X,
-					f32(second->Pos.Y) * FrameTransforms[secondFrame].scale.Y + FrameTransforms[secondFrame].translate.Y,
-					f32(second->Pos.Z) * FrameTransforms[secondFrame].scale.Z + FrameTransforms[secondFrame].translate.Z);
-			target->Pos = two.getInterpolated(one, div);
-			const core::vector3df n1(
-					Q2_VERTEX_NORMAL_TABLE[first->NormalIdx][0],
-					Q2_VERTEX_NORMAL_TABLE[first->NormalIdx][2],
-					Q2_VERTEX_NORMAL_TABLE[first->NormalIdx][1]);
-			const core::vector3df n2(
-					Q2_VERTEX_NORMAL_TABLE[second->NormalIdx][0],
-					Q2_VERTEX_NORMAL_TABLE[second->NormalIdx][2],
-					Q2_VERTEX_NORMAL_TABLE[second->NormalIdx][1]);
-			target->Normal = n2.getInterpolated(n1, div);
-			++target;
-			++first;
-			++second;
+			const core::vector3df pos(f32(v[i].Pos.X) * t.scale.X + t.translate.X,
+					f32(v[i].Pos.Y) * t.scale.Y + t.translate.Y,
+					f32(v[i].Pos.Z) * t.scale.Z + t.translate.Z);
+			const core::vector3df normal(
+					Q2_VERTEX_NORMAL_TABLE[v[i].NormalIdx][0],
+					Q2_VERTEX_NORMAL_TABLE[v[i].NormalIdx][2],
+					Q2_VERTEX_NORMAL_TABLE[v[i].NormalIdx][1]);
+			KeyFrames.setVertex(f, i, pos, normal);
 		}
-
-		//update bounding box
-		InterpolationBuffer->setBoundingBox(BoxList[secondFrame].getInterpolated(BoxList[firstFrame], div));
-		InterpolationBuffer->setDirty();
 	}
+
+	// only the unpacked frames are used from now on
+	delete [] FrameList;
+	FrameList = 0;
+
+	// force update of interpolation buffer
+	InterpolationFirstFrame = -1;
+	InterpolationSecondFrame = -1;
 }
 
 
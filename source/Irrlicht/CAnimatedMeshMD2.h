@@ -8,6 +8,7 @@
 #include "IAnimatedMeshMD2.h"
 #include "IMesh.h"
 #include "CMeshBuffer.h"
+#include "CKeyFrameInterpolator.h"
 #include "IReadFile.h"
 #include "S3DVertex.h"
 #include "irrArray.h"
@@ -132,7 +133,7 @@ namespace scene
 		//! keyframe transformations
 		core::array<SKeyFrameTransform> FrameTransforms;
 
-		//! keyframe vertex data
+		//! keyframe vertex data, dropped by prepareKeyFrames()
 		core::array<SMD2Vert> *FrameList;
 
 		//! bounding boxes for each keyframe
@@ -143,12 +144,19 @@ namespace scene
 
 		u32 FrameCount;
 
+		//! unpacks FrameList into float data used for interpolation
+		/** Has to be called by the loader after all keyframes are set. */
+		void prepareKeyFrames();
+
 	private:
 
 		//! updates the interpolation buffer
 		void updateInterpolationBuffer(s32 frame, s32 startFrame, s32 endFrame);
 
 		f32 FramesPerSecond;
+
+		//! unpacked keyframes and cache of recent interpolations
+		CKeyFrameInterpolator KeyFrames;
 	};
 
 } // end namespace scene
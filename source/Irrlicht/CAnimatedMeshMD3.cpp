@@ -193,10 +193,10 @@ IMesh* CAnimatedMeshMD3::getMesh(s32 frame, s32 detailLevel, s32 startFrameLoop,
 	}
 
 	// build current vertex
+	const f32* keyFrameData = KeyFrames.interpolate(frameA, frameB, iPol);
 	for (u32 i = 0; i!= Mesh->Buffer.size(); ++i)
 	{
-		buildVertexArray(frameA, frameB, iPol,
-					Mesh->Buffer[i],
+		buildVertexArray(keyFrameData, i,
 					(SMeshBufferLightMap*) MeshIPol->getMeshBuffer(i));
 	}
 	MeshIPol->recalculateBoundingBox();
@@ -250,35 +250,48 @@ IMeshBuffer * CAnimatedMeshMD3::createMeshBuffer(const SMD3MeshBuffer* source,
 }
 
 
-//! build final mesh's vertices from frames frameA and frameB with linear interpolation.
-void CAnimatedMeshMD3::buildVertexArray(u32 frameA, u32 frameB, f32 interpolate,
-					const SMD3MeshBuffer* source,
-					SMeshBufferLightMap* dest)
+//! unpacks the vertices of all buffers into KeyFrames
+void CAnimatedMeshMD3::prepareKeyFrames()
 {
-	const u32 frameOffsetA = frameA * source->MeshHeader.numVertices;
-	const u32 frameOffsetB = frameB * source->MeshHeader.numVertices;
 	const f32 scale = (1.f/ 64.f);
+	const u32 frameCount = Mesh->MD3Header.numFrames;
 
-	for (s32 i = 0; i != source->MeshHeader.numVertices; ++i)
+	u32 vertexCount = 0;
+	BufferOffsets.set_used(Mesh->Buffer.size());
+	for (u32 i = 0; i != Mesh->Buffer.size(); ++i)
 	{
-		video::S3DVertex2TCoords &v = dest->Vertices [ i ];
-
-		const SMD3Vertex &vA = source->Vertices [ frameOffsetA + i ];
-		const SMD3Vertex &vB = source->Vertices [ frameOffsetB + i ];
+		BufferOffsets[i] = vertexCount;
+		vertexCount += Mesh->Buffer[i]->MeshHeader.numVertices;
+	}
 
-		// position
-		v.Pos.X = scale * (vA.position[0] + interpolate * (vB.position[0] - vA.position[0]));
-		v.Pos.Y = scale * (vA.position[2] + interpolate * (vB.position[2] - vA.position[2]));
-		v.Pos.Z = scale * (vA.position[1] + interpolate * (vB.position[1] - vA.position[1]));
+	KeyFrames.setup(frameCount, vertexCount);
 
-		// normal
-		const core::vector3df nA(quake3::getMD3Normal(vA.normal[0], vA.normal[1]));
-		const core::vector3df nB(quake3::getMD3Normal(vB.normal[0], vB.normal[1]));
+	for (u32 i = 0; i != Mesh->Buffer.size(); ++i)
+	{
+		const SMD3MeshBuffer* source = Mesh->Buffer[i];
+		const u32 numVertices = source->MeshHeader.numVertices;
 
-		v.Normal.X = nA.X + interpolate * (nB.X - nA.X);
-		v.Normal.Y = nA.Z + interpolate * (nB.Z - nA.Z);
-		v.Normal.Z = nA.Y + interpolate * (nB.Y - nA.Y);
+		for (u32 f = 0; f != frameCount; ++f)
+		{
+			const SMD3Vertex* v = source->Vertices.const_pointer() + f * numVertices;
+			for (u32 k = 0; k != numVertices; ++k)
+			{
+				const core::vector3df n(quake3::getMD3Normal(v[k].normal[0], v[k].normal[1]));
+				KeyFrames.setVertex(f, BufferOffsets[i] + k,
+						core::vector3df(v[k].position[0], v[k].position[2], v[k].position[1]) * scale,
+						core::vector3df(n.X, n.Z, n.Y));
+			}
+		}
 	}
+}
+
+
+//! build final mesh's vertices from interpolated keyframe data
+void CAnimatedMeshMD3::buildVertexArray(const f32* keyFrameData, u32 buffer,
+					SMeshBufferLightMap* dest)
+{
+	KeyFrames.copyTo(dest->Vertices.pointer(), keyFrameData,
+			BufferOffsets[buffer], Mesh->Buffer[buffer]->MeshHeader.numVertices);
 
 	dest->recalculateBoundingBox();
 }
@@ -424,6 +437,7 @@ bool CAnimatedMeshMD3::loadModelFile(u32 modelIndex, io::IReadFile* file,
 	}
 
 	// Init Mesh Interpolation
+	prepareKeyFrames();
 	for (i = 0; i != Mesh->Buffer.size(); ++i)
 	{
 		IMeshBuffer * buffer = createMeshBuffer(Mesh->Buffer[i], fs, driver);
@@ -13,6 +13,7 @@
 #include "SMesh.h"
 #include "SMeshBuffer.h"
 #include "IQ3Shader.h"
+#include "CKeyFrameInterpolator.h"
 
 namespace irr
 {
@@ -119,12 +120,20 @@ namespace scene
 		IMeshBuffer* createMeshBuffer(const SMD3MeshBuffer* source,
 				io::IFileSystem* fs, video::IVideoDriver* driver);
 
-		void buildVertexArray(u32 frameA, u32 frameB, f32 interpolate,
-					const SMD3MeshBuffer* source,
+		//! unpacks the vertices of all buffers into KeyFrames
+		void prepareKeyFrames();
+
+		void buildVertexArray(const f32* keyFrameData, u32 buffer,
 					SMeshBufferLightMap* dest);
 
 		void buildTagArray(u32 frameA, u32 frameB, f32 interpolate);
 		f32 FramesPerSecond;
+
+		//! unpacked vertices of all buffers and cache of recent interpolations
+		CKeyFrameInterpolator KeyFrames;
+
+		//! first vertex of each buffer in KeyFrames
+		core::array<u32> BufferOffsets;
 	};
 
 
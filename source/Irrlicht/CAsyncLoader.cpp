@@ -0,0 +1,751 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CAsyncLoader.h"
+#include "ISceneManager.h"
+#include "IMeshCache.h"
+#include "IMeshLoader.h"
+#include "IAnimatedMesh.h"
+#include "IVideoDriver.h"
+#include "IImageLoader.h"
+#include "IFileSystem.h"
+#include "IAttributes.h"
+#include "CMemoryFile.h"
+#include "os.h"
+
+namespace irr
+{
+
+namespace
+{
+	//! Checks if a file can be read on another thread than the one opening it
+	/** Files of archives share the file handle of their archive. */
+	bool hasOwnData(io::IReadFile* file)
+	{
+		const io::EREAD_FILE_TYPE type = file->getType();
+		return type == io::ERFT_READ_FILE || type == io::ERFT_MAPPED_READ_FILE
+			|| type == io::ERFT_MEMORY_READ_FILE;
+	}
+
+	//! Replaces a file by a copy of its content in memory
+	io::IReadFile* createMemoryCopy(io::IReadFile* file)
+	{
+		const long size = file->getSize();
+		c8* data = new c8[size > 0 ? size : 1];
+		file->seek(0);
+		const size_t read = size > 0 ? file->read(data, (size_t)size) : 0;
+		io::IReadFile* copy = new io::CMemoryReadFile(data, (long)read, file->getFileName(), true);
+		file->drop();
+		return copy;
+	}
+
+	//! Copies the scene parameters for mesh loaders on worker threads
+	/** Numbers, bools and user pointers keep their type, all other
+	attributes are copied as strings. */
+	io::IAttributes* createParametersCopy(io::IFileSystem* fs, const io::IAttributes* parameters)
+	{
+		io::IAttributes* copy = fs->createEmptyAttributes();
+		for (u32 i=0; i<parameters->getAttributeCount(); ++i)
+		{
+			const s32 index = (s32)i;
+			const c8* name = parameters->getAttributeName(index);
+			switch (parameters->getAttributeType(index))
+			{
+			case io::EAT_INT:
+				copy->addInt(name, parameters->getAttributeAsInt(index));
+				break;
+			case io::EAT_FLOAT:
+				copy->addFloat(name, parameters->getAttributeAsFloat(index));
+				break;
+			case io::EAT_BOOL:
+				copy->addBool(name, parameters->getAttributeAsBool(index));
+				break;
+			case io::EAT_USER_POINTER:
+				copy->addUserPointer(name, parameters->getAttributeAsUserPointer(index));
+				break;
+			default:
+				copy->addString(name, parameters->getAttributeAsStringW(index).c_str());
+				break;
+			}
+		}
+		return copy;
+	}
+
+	//! Checks if a loads before b
+	bool loadsBefore(s32 priorityA, u32 sequenceA, s32 priorityB, u32 sequenceB)
+	{
+		return priorityA > priorityB || (priorityA == priorityB && sequenceA < sequenceB);
+	}
+}
+
+
+CAsyncLoadRequest::CAsyncLoadRequest(CAsyncLoader* owner, const io::path& filename, bool texture, s32 priority, u32 sequence)
+	: Owner(owner), FileName(filename), IsTexture(texture), Priority(priority), Sequence(sequence),
+	State(EALS_QUEUED), File(0), Decode(true), Parameters(0), TextureType(video::ETT_2D), LoadedMesh(0),
+	Mesh(0), Texture(0)
+{
+	#ifdef _DEBUG
+	setDebugName("CAsyncLoadRequest");
+	#endif
+}
+
+
+CAsyncLoadRequest::~CAsyncLoadRequest()
+{
+	releaseData();
+
+	if (Mesh)
+		Mesh->drop();
+	if (Texture)
+		Texture->drop();
+}
+
+
+void CAsyncLoadRequest::releaseData()
+{
+	if (File)
+	{
+		File->drop();
+		File = 0;
+	}
+
+	for (u32 i=0; i<MeshLoaders.size(); ++i)
+		MeshLoaders[i]->drop();
+	MeshLoaders.clear();
+
+	for (u32 i=0; i<ImageLoaders.size(); ++i)
+		ImageLoaders[i]->drop();
+	ImageLoaders.clear();
+
+	if (Parameters)
+	{
+		Parameters->drop();
+		Parameters = 0;
+	}
+
+	for (u32 i=0; i<Images.size(); ++i)
+	{
+		if (Images[i])
+			Images[i]->drop();
+	}
+	Images.clear();
+
+	if (LoadedMesh)
+	{
+		LoadedMesh->drop();
+		LoadedMesh = 0;
+	}
+}
+
+
+E_ASYNC_LOAD_STATE CAsyncLoadRequest::getState() const
+{
+	// Owner is only set while the request is pending
+	if (!Owner)
+		return State;
+
+	Owner->lockQueue();
+	const E_ASYNC_LOAD_STATE state = State;
+	Owner->unlockQueue();
+	return state;
+}
+
+
+const io::path& CAsyncLoadRequest::getFileName() const
+{
+	return FileName;
+}
+
+
+scene::IAnimatedMesh* CAsyncLoadRequest::getMesh() const
+{
+	return Mesh;
+}
+
+
+video::ITexture* CAsyncLoadRequest::getTexture() const
+{
+	return Texture;
+}
+
+
+void CAsyncLoadRequest::setPriority(s32 priority)
+{
+	if (Owner)
+		Owner->reorder(this, priority);
+	else
+		Priority = priority;
+}
+
+
+s32 CAsyncLoadRequest::getPriority() const
+{
+	return Priority;
+}
+
+
+void CAsyncLoadRequest::cancel()
+{
+	if (Owner)
+		Owner->cancel(this);
+}
+
+
+CAsyncLoader::CAsyncLoader(scene::ISceneManager* smgr, video::IVideoDriver* driver, io::IFileSystem* fs)
+	: SceneManager(smgr), Driver(driver), FileSystem(fs), Pending(0), Sequence(0), Running(true)
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	, ThreadCount(0)
+#endif
+{
+	#ifdef _DEBUG
+	setDebugName("CAsyncLoader");
+	#endif
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	// leave one core to the main thread
+	const u32 cores = CThread::getHardwareConcurrency();
+	const u32 count = core::min_(cores > 1 ? cores - 1 : 1, (u32)MAX_THREADS);
+
+	for (u32 i=0; i<count; ++i)
+	{
+		Threads[ThreadCount] = new CThread();
+		if (!Threads[ThreadCount]->start(runWorker, this))
+		{
+			delete Threads[ThreadCount];
+			break;
+		}
+		++ThreadCount;
+	}
+
+	if (!ThreadCount)
+		os::Printer::log("Could not start threads for loading, loading on the main thread.", ELL_WARNING);
+#endif
+}
+
+
+CAsyncLoader::~CAsyncLoader()
+{
+	shutdown();
+}
+
+
+void CAsyncLoader::shutdown()
+{
+	if (!Running)
+		return;
+
+	lockQueue();
+	Running = false;
+	unlockQueue();
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	for (u32 i=0; i<ThreadCount; ++i)
+		WorkAvailable.post();
+	for (u32 i=0; i<ThreadCount; ++i)
+		delete Threads[i];
+	ThreadCount = 0;
+#endif
+
+	// no more workers, so no more locking needed
+	for (u32 i=0; i<Queue.size(); ++i)
+		release(Queue[i], EALS_CANCELED);
+	Queue.clear();
+
+	for (u32 i=0; i<Loaded.size(); ++i)
+	{
+		if (Loaded[i]->State == EALS_CANCELED)
+		{
+			Loaded[i]->releaseData();
+			Loaded[i]->drop();
+		}
+		else
+			release(Loaded[i], EALS_CANCELED);
+	}
+	Loaded.clear();
+
+	SceneManager = 0;
+	Driver = 0;
+	FileSystem = 0;
+}
+
+
+IAsyncLoadRequest* CAsyncLoader::loadMesh(const io::path& filename, s32 priority)
+{
+	CAsyncLoadRequest* request = new CAsyncLoadRequest(0, filename, false, priority, Sequence++);
+
+	if (!Running)
+	{
+		request->State = EALS_FAILED;
+		return request;
+	}
+
+	scene::IAnimatedMesh* mesh = SceneManager->getMeshCache()->getMeshByName(filename);
+	if (mesh)
+	{
+		mesh->grab();
+		request->Mesh = mesh;
+		request->State = EALS_DONE;
+		return request;
+	}
+
+	// iterate the list in reverse order so user-added loaders can override the built-in ones
+	for (s32 i=(s32)SceneManager->getMeshLoaderCount()-1; i>=0; --i)
+	{
+		scene::IMeshLoader* loader = SceneManager->getMeshLoader(i);
+		if (loader->isALoadableFileExtension(filename))
+		{
+			loader->grab();
+			request->MeshLoaders.push_back(loader);
+			if (!loader->isThreadSafe())
+				request->Decode = false;
+		}
+	}
+
+	if (request->MeshLoaders.empty())
+	{
+		os::Printer::log("Could not load mesh, file format seems to be unsupported", filename, ELL_ERROR);
+		request->State = EALS_FAILED;
+		return request;
+	}
+
+	// the application may change the parameters while workers read them
+	if (request->Decode)
+		request->Parameters = createParametersCopy(FileSystem, SceneManager->getParameters());
+
+	request->File = FileSystem->createAndOpenFile(filename);
+	if (!request->File)
+	{
+		os::Printer::log("Could not load mesh, because file could not be opened: ", filename, ELL_ERROR);
+		request->releaseData();
+		request->State = EALS_FAILED;
+		return request;
+	}
+
+	enqueue(request);
+	return request;
+}
+
+
+IAsyncLoadRequest* CAsyncLoader::loadTexture(const io::path& filename, s32 priority)
+{
+	CAsyncLoadRequest* request = new CAsyncLoadRequest(0, filename, true, priority, Sequence++);
+
+	if (!Running)
+	{
+		request->State = EALS_FAILED;
+		return request;
+	}
+
+	// same lookup as IVideoDriver::getTexture()
+	const io::path absolutePath = FileSystem->getAbsolutePath(filename);
+
+	video::ITexture* texture = Driver->findTexture(absolutePath);
+	if (!texture)
+		texture = Driver->findTexture(filename);
+
+	if (!texture)
+	{
+		request->File = FileSystem->createAndOpenFile(absolutePath);
+		if (!request->File)
+			request->File = FileSystem->createAndOpenFile(filename);
+
+		if (!request->File)
+		{
+			os::Printer::log("Could not open file of texture", filename, ELL_WARNING);
+			request->State = EALS_FAILED;
+			return request;
+		}
+
+		texture = Driver->findTexture(request->File->getFileName());
+	}
+
+	if (texture)
+	{
+		texture->updateSource(video::ETS_FROM_CACHE);
+		texture->grab();
+		request->Texture = texture;
+		request->releaseData();
+		request->State = EALS_DONE;
+		return request;
+	}
+
+	// same order as IVideoDriver::createImagesFromFile(), images are only
+	// decoded on workers when all loaders for the extension allow it
+	for (s32 i=(s32)Driver->getImageLoaderCount()-1; i>=0; --i)
+	{
+		video::IImageLoader* loader = Driver->getImageLoader(i);
+		if (loader->isALoadableFileExtension(request->File->getFileName()))
+		{
+			loader->grab();
+			request->ImageLoaders.push_back(loader);
+			if (!loader->isThreadSafe())
+				request->Decode = false;
+		}
+	}
+	if (request->ImageLoaders.empty())
+		request->Decode = false;
+
+	enqueue(request);
+	return request;
+}
+
+
+void CAsyncLoader::enqueue(CAsyncLoadRequest* request)
+{
+	// archives share their file handle with the files read from them
+	if (!hasOwnData(request->File))
+		request->File = createMemoryCopy(request->File);
+
+	request->Owner = this;
+	request->grab();
+	++Pending;
+
+	lockQueue();
+	u32 i = 0;
+	while (i < Queue.size() && !loadsBefore(Queue[i]->Priority, Queue[i]->Sequence, request->Priority, request->Sequence))
+		++i;
+	Queue.insert(request, i);
+	unlockQueue();
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	if (ThreadCount)
+		WorkAvailable.post();
+#endif
+}
+
+
+void CAsyncLoader::reorder(CAsyncLoadRequest* request, s32 priority)
+{
+	lockQueue();
+	request->Priority = priority;
+	const s32 index = findQueued(request);
+	if (index >= 0)
+	{
+		Queue.erase(index);
+		u32 i = 0;
+		while (i < Queue.size() && !loadsBefore(Queue[i]->Priority, Queue[i]->Sequence, request->Priority, request->Sequence))
+			++i;
+		Queue.insert(request, i);
+	}
+	unlockQueue();
+}
+
+
+void CAsyncLoader::cancel(CAsyncLoadRequest* request)
+{
+	lockQueue();
+	const s32 index = findQueued(request);
+	if (index >= 0)
+	{
+		Queue.erase(index);
+		unlockQueue();
+		release(request, EALS_CANCELED);
+		return;
+	}
+
+	// A worker has it, update() throws the result away
+	request->State = EALS_CANCELED;
+	request->Owner = 0;
+	unlockQueue();
+	--Pending;
+}
+
+
+u32 CAsyncLoader::update(u32 timeLimitMs)
+{
+	const u32 start = os::Timer::getRealTime();
+	u32 finished = 0;
+
+	for (;;)
+	{
+		CAsyncLoadRequest* request = 0;
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+		if (ThreadCount)
+		{
+			lockQueue();
+			if (!Loaded.empty())
+			{
+				request = Loaded[0];
+				Loaded.erase(0);
+			}
+			unlockQueue();
+		}
+		else
+#endif
+		if (!Queue.empty())
+		{
+			// no worker threads, load on the main thread
+			request = Queue.getLast();
+			Queue.erase(Queue.size()-1);
+			request->State = EALS_LOADING;
+			load(request);
+		}
+
+		if (!request)
+			break;
+
+		if (request->State == EALS_CANCELED)
+		{
+			request->releaseData();
+			request->drop();
+			continue;
+		}
+
+		finish(request);
+		++finished;
+
+		if (timeLimitMs && os::Timer::getRealTime() - start >= timeLimitMs)
+			break;
+	}
+
+	return finished;
+}
+
+
+u32 CAsyncLoader::getPendingCount() const
+{
+	return Pending;
+}
+
+
+u32 CAsyncLoader::getThreadCount() const
+{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	return ThreadCount;
+#else
+	return 0;
+#endif
+}
+
+
+void CAsyncLoader::load(CAsyncLoadRequest* request)
+{
+	if (request->Decode)
+	{
+		if (request->IsTexture)
+			createImages(request);
+		else
+			request->LoadedMesh = createMesh(request, request->File);
+	}
+	else if (request->File->getType() != io::ERFT_MEMORY_READ_FILE)
+	{
+		// the loaders have to run on the main thread, at least read the file here
+		request->File = createMemoryCopy(request->File);
+	}
+}
+
+
+void CAsyncLoader::finish(CAsyncLoadRequest* request)
+{
+	if (request->IsTexture)
+	{
+		// loaders which aren't thread safe, and loaders found by the content
+		// of the file instead of its extension, run here
+		if (request->Images.empty())
+		{
+			request->File->seek(0);
+			request->Images = Driver->createImagesFromFile(request->File, &request->TextureType);
+		}
+
+		const core::array<video::IImage*>& images = request->Images;
+		const io::path& name = request->File->getFileName();
+
+		video::ITexture* texture = 0;
+		if (images.size() && images[0])
+		{
+			// might have been loaded by another request meanwhile
+			texture = Driver->findTexture(name);
+			if (texture)
+				texture->updateSource(video::ETS_FROM_CACHE);
+			else
+			{
+				if (request->TextureType == video::ETT_2D)
+					texture = Driver->addTexture(name, images[0]);
+				else if (request->TextureType == video::ETT_CUBEMAP && images.size() >= 6 &&
+					images[1] && images[2] && images[3] && images[4] && images[5])
+					texture = Driver->addTextureCubemap(name, images[0], images[1], images[2], images[3], images[4], images[5]);
+
+				if (texture)
+				{
+					texture->updateSource(video::ETS_FROM_FILE);
+					os::Printer::log("Loaded texture", name, ELL_DEBUG);
+				}
+			}
+		}
+
+		if (texture)
+		{
+			texture->grab();
+			request->Texture = texture;
+			release(request, EALS_DONE);
+		}
+		else
+		{
+			os::Printer::log("Could not load texture", request->FileName, ELL_ERROR);
+			release(request, EALS_FAILED);
+		}
+		return;
+	}
+
+	scene::IAnimatedMesh* mesh = request->LoadedMesh;
+	request->LoadedMesh = 0;
+	if (!request->Decode)
+		mesh = createMesh(request, request->File);
+
+	if (mesh)
+	{
+		scene::IMeshCache* cache = SceneManager->getMeshCache();
+		scene::IAnimatedMesh* cached = cache->getMeshByName(request->FileName);
+		if (cached)
+		{
+			mesh->drop();
+			mesh = cached;
+			mesh->grab();
+		}
+		else
+		{
+			cache->addMesh(request->FileName, mesh);
+			os::Printer::log("Loaded mesh", request->FileName, ELL_DEBUG);
+		}
+
+		request->Mesh = mesh;
+		release(request, EALS_DONE);
+	}
+	else
+	{
+		os::Printer::log("Could not load mesh, file format seems to be unsupported", request->FileName, ELL_ERROR);
+		release(request, EALS_FAILED);
+	}
+}
+
+
+void CAsyncLoader::release(CAsyncLoadRequest* request, E_ASYNC_LOAD_STATE state)
+{
+	lockQueue();
+	request->State = state;
+	request->Owner = 0;
+	unlockQueue();
+
+	--Pending;
+	request->releaseData();
+	request->drop();
+}
+
+
+scene::IAnimatedMesh* CAsyncLoader::createMesh(CAsyncLoadRequest* request, io::IReadFile* file)
+{
+	for (u32 i=0; i<request->MeshLoaders.size(); ++i)
+	{
+		scene::IMeshLoader* loader = request->MeshLoaders[i];
+
+		// reset file to avoid side effects of previous calls to createMesh
+		file->seek(0);
+		scene::IAnimatedMesh* mesh = request->Parameters ?
+			loader->createMeshWithParameters(file, request->Parameters) : loader->createMesh(file);
+		if (mesh)
+			return mesh;
+	}
+
+	return 0;
+}
+
+
+void CAsyncLoader::createImages(CAsyncLoadRequest* request)
+{
+	io::IReadFile* file = request->File;
+	for (u32 i=0; i<request->ImageLoaders.size(); ++i)
+	{
+		video::IImageLoader* loader = request->ImageLoaders[i];
+
+		// reset file position which might have changed due to previous loadImage calls
+		file->seek(0);
+		request->Images = loader->loadImages(file, &request->TextureType);
+
+		if (request->Images.empty())
+		{
+			file->seek(0);
+			video::IImage* image = loader->loadImage(file);
+			if (image)
+				request->Images.push_back(image);
+		}
+
+		if (!request->Images.empty())
+			return;
+	}
+}
+
+
+s32 CAsyncLoader::findQueued(const CAsyncLoadRequest* request) const
+{
+	for (u32 i=0; i<Queue.size(); ++i)
+	{
+		if (Queue[i] == request)
+			return (s32)i;
+	}
+	return -1;
+}
+
+
+void CAsyncLoader::lockQueue() const
+{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	QueueMutex.lock();
+#endif
+}
+
+
+void CAsyncLoader::unlockQueue() const
+{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	QueueMutex.unlock();
+#endif
+}
+
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+
+void CAsyncLoader::runWorker(void* loader)
+{
+	((CAsyncLoader*)loader)->work();
+}
+
+
+void CAsyncLoader::work()
+{
+	for (;;)
+	{
+		WorkAvailable.wait();
+
+		lockQueue();
+		if (!Running)
+		{
+			unlockQueue();
+			return;
+		}
+
+		// canceled requests leave their count in the semaphore
+		if (Queue.empty())
+		{
+			unlockQueue();
+			continue;
+		}
+
+		CAsyncLoadRequest* request = Queue.getLast();
+		Queue.erase(Queue.size()-1);
+		request->State = EALS_LOADING;
+		unlockQueue();
+
+		load(request);
+
+		lockQueue();
+		Loaded.push_back(request);
+		unlockQueue();
+	}
+}
+
+#endif // _IRR_COMPILE_WITH_THREADS_
+
+} // end namespace irr
+
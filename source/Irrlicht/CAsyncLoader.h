@@ -0,0 +1,182 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_C_ASYNC_LOADER_H_INCLUDED
+#define IRR_C_ASYNC_LOADER_H_INCLUDED
+
+#include "IAsyncLoader.h"
+#include "irrArray.h"
+#include "ITexture.h"
+#include "CThread.h"
+
+namespace irr
+{
+namespace io
+{
+	class IFileSystem;
+	class IReadFile;
+	class IAttributes;
+} // end namespace io
+namespace scene
+{
+	class ISceneManager;
+	class IMeshLoader;
+} // end namespace scene
+namespace video
+{
+	class IVideoDriver;
+	class IImage;
+	class IImageLoader;
+} // end namespace video
+
+class CAsyncLoader;
+
+//! Request handled by CAsyncLoader
+class CAsyncLoadRequest : public IAsyncLoadRequest
+{
+public:
+
+	CAsyncLoadRequest(CAsyncLoader* owner, const io::path& filename, bool texture, s32 priority, u32 sequence);
+
+	virtual ~CAsyncLoadRequest();
+
+	virtual E_ASYNC_LOAD_STATE getState() const IRR_OVERRIDE;
+	virtual const io::path& getFileName() const IRR_OVERRIDE;
+	virtual scene::IAnimatedMesh* getMesh() const IRR_OVERRIDE;
+	virtual video::ITexture* getTexture() const IRR_OVERRIDE;
+	virtual void setPriority(s32 priority) IRR_OVERRIDE;
+	virtual s32 getPriority() const IRR_OVERRIDE;
+	virtual void cancel() IRR_OVERRIDE;
+
+private:
+
+	friend class CAsyncLoader;
+
+	//! Drops the file and everything loaded from it
+	void releaseData();
+
+	CAsyncLoader* Owner;
+	io::path FileName;
+	bool IsTexture;
+	s32 Priority;
+	u32 Sequence;
+	E_ASYNC_LOAD_STATE State;
+
+	//! File opened on the main thread, read by a worker
+	io::IReadFile* File;
+
+	//! Loaders for the file extension of a mesh, in the order to try them
+	core::array<scene::IMeshLoader*> MeshLoaders;
+
+	//! Loaders for the file extension of a texture, in the order to try them
+	core::array<video::IImageLoader*> ImageLoaders;
+
+	//! True when the loaders may run on a worker thread
+	bool Decode;
+
+	//! Copy of the scene parameters for mesh loaders on worker threads
+	io::IAttributes* Parameters;
+
+	//! Worker results, finished in CAsyncLoader::update()
+	core::array<video::IImage*> Images;
+	video::E_TEXTURE_TYPE TextureType;
+	scene::IAnimatedMesh* LoadedMesh;
+
+	//! Final results
+	scene::IAnimatedMesh* Mesh;
+	video::ITexture* Texture;
+};
+
+//! Loads meshes and textures on worker threads
+class CAsyncLoader : public IAsyncLoader
+{
+public:
+
+	CAsyncLoader(scene::ISceneManager* smgr, video::IVideoDriver* driver, io::IFileSystem* fs);
+
+	virtual ~CAsyncLoader();
+
+	virtual IAsyncLoadRequest* loadMesh(const io::path& filename, s32 priority=0) IRR_OVERRIDE;
+	virtual IAsyncLoadRequest* loadTexture(const io::path& filename, s32 priority=0) IRR_OVERRIDE;
+	virtual u32 update(u32 timeLimitMs=0) IRR_OVERRIDE;
+	virtual u32 getPendingCount() const IRR_OVERRIDE;
+	virtual u32 getThreadCount() const IRR_OVERRIDE;
+
+	//! Stops the worker threads and cancels all requests
+	/** Has to be called by the device before the scene manager and the
+	video driver are released. The loader does not take new requests after it. */
+	void shutdown();
+
+private:
+
+	friend class CAsyncLoadRequest;
+
+	//! Maximal number of worker threads
+	enum { MAX_THREADS = 4 };
+
+	//! Puts a request into the queue, or finishes it when there is nothing to load
+	void enqueue(CAsyncLoadRequest* request);
+
+	//! Changes the priority of a request and keeps the queue ordered
+	void reorder(CAsyncLoadRequest* request, s32 priority);
+
+	//! Removes a request from the queue or from the loading ones
+	void cancel(CAsyncLoadRequest* request);
+
+	//! The part of the loading done on worker threads
+	void load(CAsyncLoadRequest* request);
+
+	//! Creates the texture or caches the mesh on the main thread
+	void finish(CAsyncLoadRequest* request);
+
+	//! Marks a request as finished and releases the reference of the loader
+	void release(CAsyncLoadRequest* request, E_ASYNC_LOAD_STATE state);
+
+	//! Tries the mesh loaders of a request on a file
+	scene::IAnimatedMesh* createMesh(CAsyncLoadRequest* request, io::IReadFile* file);
+
+	//! Tries the image loaders of a request on its file
+	void createImages(CAsyncLoadRequest* request);
+
+	//! Finds the position of a request in the queue, -1 if it is not queued
+	s32 findQueued(const CAsyncLoadRequest* request) const;
+
+	void lockQueue() const;
+	void unlockQueue() const;
+
+	scene::ISceneManager* SceneManager;
+	video::IVideoDriver* Driver;
+	io::IFileSystem* FileSystem;
+
+	//! Requests waiting for a worker, the last one is loaded next
+	core::array<CAsyncLoadRequest*> Queue;
+
+	//! Requests loaded by a worker, waiting for update()
+	core::array<CAsyncLoadRequest*> Loaded;
+
+	u32 Pending;
+	u32 Sequence;
+	bool Running;
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	static void runWorker(void* loader);
+
+	//! Worker loop, returns when Running is false
+	void work();
+
+	//! Guards the queues and the state of all requests
+	mutable CMutex QueueMutex;
+
+	//! Counts the queued requests, workers wait on it
+	CSemaphore WorkAvailable;
+
+	CThread* Threads[MAX_THREADS];
+	u32 ThreadCount;
+#endif
+};
+
+} // end namespace irr
+
+#endif
+
@@ -11,7 +11,7 @@
 #include "CB3DMeshWriter.h"
 #include "os.h"
 #include "ISkinnedMesh.h"
-#include "IMeshBuffer.h"
+#include "CMeshBufferQuantized.h"
 #include "IWriteFile.h"
 #include "ITexture.h"
 #include "irrMap.h"
@@ -237,6 +237,20 @@ bool CB3DMeshWriter::writeMesh(io::IWriteFile* file, IMesh* const mesh, s32 flag
                     }
                 }
                 break;
+                case EVT_QUANTIZED:
+                case EVT_QUANTIZED_TANGENTS:
+                {
+                    const S3DVertexTangents v = getDecodedVertex(mb, j);
+                    const SColorf col(v.Color);
+                    writeColor(file, col);
+
+                    writeVector2(file, v.TCoords);
+                    if (texcoordsCount == 2)
+                    {
+                        writeVector2(file, core::vector2df(0.f, 0.f));
+                    }
+                }
+                break;
             }
         }
     }
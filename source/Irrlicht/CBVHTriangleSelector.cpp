@@ -0,0 +1,1063 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CBVHTriangleSelector.h"
+#include "ISceneNode.h"
+#include "IAnimatedMeshSceneNode.h"
+#include "SSkinMeshBuffer.h"
+
+#include "os.h"
+
+namespace irr
+{
+namespace scene
+{
+
+namespace
+{
+	//! Number of bins used to evaluate split candidates along each axis
+	const u32 BVH_BIN_COUNT = 16;
+
+	//! Cost of visiting a node relative to intersecting one triangle
+	const f32 BVH_TRAVERSAL_COST = 1.f;
+
+	//! Möller-Trumbore test of a line segment against a triangle, both sides
+	inline bool intersectTriangle(const core::triangle3df& tri, const core::vector3df& start,
+		const core::vector3df& dir, f32 maxT, f32& outT)
+	{
+		const core::vector3df e1 = tri.pointB - tri.pointA;
+		const core::vector3df e2 = tri.pointC - tri.pointA;
+		const core::vector3df p = dir.crossProduct(e2);
+		const f32 det = e1.dotProduct(p);
+		if (det == 0.f)
+			return false;
+
+		const f32 invDet = 1.f / det;
+		const core::vector3df s = start - tri.pointA;
+		const f32 u = s.dotProduct(p) * invDet;
+		if (u < 0.f || u > 1.f)
+			return false;
+
+		const core::vector3df q = s.crossProduct(e1);
+		const f32 v = dir.dotProduct(q) * invDet;
+		if (v < 0.f || u + v > 1.f)
+			return false;
+
+		const f32 t = e2.dotProduct(q) * invDet;
+		if (t < 0.f || t > maxT)
+			return false;
+
+		outT = t;
+		return true;
+	}
+
+	inline f32 getInverse(f32 v)
+	{
+		return v != 0.f ? 1.f / v : FLT_MAX;
+	}
+
+	//! Id of the hierarchy in acceleration data
+	const u32 BVH_DATA_TYPE = MAKE_IRR_ID('b','v','h','s');
+}
+
+
+//! constructor
+CBVHTriangleSelector::CBVHTriangleSelector(const IMesh* mesh,
+		ISceneNode* node, bool separateMeshbuffers, u32 maxTrianglesPerLeaf,
+		io::IReadFile* accelerationData)
+	: CTriangleSelector(mesh, node, separateMeshbuffers)
+	, MaxTrianglesPerLeaf(core::max_(maxTrianglesPerLeaf, 1u)), LastAnimatedMesh(0)
+{
+	#ifdef _DEBUG
+	setDebugName("CBVHTriangleSelector");
+	#endif
+
+	if (!accelerationData || !readHierarchy(accelerationData))
+		buildHierarchy();
+}
+
+
+CBVHTriangleSelector::CBVHTriangleSelector(const IMeshBuffer* meshBuffer, irr::u32 materialIndex,
+		ISceneNode* node, u32 maxTrianglesPerLeaf, io::IReadFile* accelerationData)
+	: CTriangleSelector(meshBuffer, materialIndex, node)
+	, MaxTrianglesPerLeaf(core::max_(maxTrianglesPerLeaf, 1u)), LastAnimatedMesh(0)
+{
+	#ifdef _DEBUG
+	setDebugName("CBVHTriangleSelector");
+	#endif
+
+	if (!accelerationData || !readHierarchy(accelerationData))
+		buildHierarchy();
+}
+
+
+CBVHTriangleSelector::CBVHTriangleSelector(IAnimatedMeshSceneNode* node,
+		bool separateMeshbuffers, u32 maxTrianglesPerLeaf)
+	: CTriangleSelector(node, separateMeshbuffers)
+	, MaxTrianglesPerLeaf(core::max_(maxTrianglesPerLeaf, 1u)), LastAnimatedMesh(0)
+{
+	#ifdef _DEBUG
+	setDebugName("CBVHTriangleSelector");
+	#endif
+
+	if (node)
+		LastAnimatedMesh = node->getMesh();
+
+	buildHierarchy();
+}
+
+
+void CBVHTriangleSelector::buildHierarchy()
+{
+	Nodes.clear();
+	TriangleIndices.clear();
+	TriangleLeaves.clear();
+
+	const u32 cnt = Triangles.size();
+	if (!cnt)
+		return;
+
+	const u32 start = os::Timer::getRealTime();
+
+	core::array<core::aabbox3df> triangleBoxes(cnt);
+	core::array<core::vector3df> centers(cnt);
+	triangleBoxes.set_used(cnt);
+	centers.set_used(cnt);
+	TriangleIndices.set_used(cnt);
+
+	for (u32 i=0; i<cnt; ++i)
+	{
+		const core::triangle3df& tri = Triangles[i];
+		triangleBoxes[i].reset(tri.pointA);
+		triangleBoxes[i].addInternalPoint(tri.pointB);
+		triangleBoxes[i].addInternalPoint(tri.pointC);
+		centers[i] = triangleBoxes[i].getCenter();
+		TriangleIndices[i] = i;
+	}
+
+	Nodes.reallocate(2*cnt);
+	Nodes.set_used(1);
+	buildNode(0, 0, cnt, 0, triangleBoxes, centers);
+	Nodes.reallocate(Nodes.size(), true);
+
+	// animated nodes refit the leaves while reading the triangles of a new frame
+	if (AnimatedNode)
+	{
+		TriangleLeaves.set_used(cnt);
+		for (u32 i=0; i<Nodes.size(); ++i)
+		{
+			for (u32 t=Nodes[i].Index; t<Nodes[i].Index+Nodes[i].Count; ++t)
+				TriangleLeaves[TriangleIndices[t]] = i;
+		}
+	}
+
+	c8 tmp[256];
+	sprintf(tmp, "Needed %ums to create BVHTriangleSelector.(%u nodes, %u polys)",
+		os::Timer::getRealTime() - start, Nodes.size(), cnt);
+	os::Printer::log(tmp, ELL_INFORMATION);
+}
+
+
+void CBVHTriangleSelector::buildNode(u32 nodeIndex, u32 first, u32 count, u32 depth,
+		const core::array<core::aabbox3df>& triangleBoxes,
+		const core::array<core::vector3df>& centers)
+{
+	core::aabbox3df box(triangleBoxes[TriangleIndices[first]]);
+	core::aabbox3df centerBox(centers[TriangleIndices[first]]);
+	for (u32 i=first+1; i<first+count; ++i)
+	{
+		box.addInternalBox(triangleBoxes[TriangleIndices[i]]);
+		centerBox.addInternalPoint(centers[TriangleIndices[i]]);
+	}
+
+	Nodes[nodeIndex].Box = box;
+	Nodes[nodeIndex].Index = first;
+	Nodes[nodeIndex].Count = count;
+
+	if (count <= 1 || depth >= MAX_DEPTH)
+		return;
+
+	// find best split with the surface area heuristic over binned centers
+	const f32 leafCost = (f32)count * box.getArea();
+	f32 bestCost = FLT_MAX;
+	s32 bestAxis = -1;
+	u32 bestBin = 0;
+
+	const core::vector3df extent = centerBox.getExtent();
+	for (s32 axis=0; axis<3; ++axis)
+	{
+		const f32 size = (&extent.X)[axis];
+		if (size <= 0.f)
+			continue;
+
+		const f32 binScale = BVH_BIN_COUNT / size;
+		const f32 axisMin = (&centerBox.MinEdge.X)[axis];
+
+		u32 binCounts[BVH_BIN_COUNT];
+		core::aabbox3df binBoxes[BVH_BIN_COUNT];
+		for (u32 b=0; b<BVH_BIN_COUNT; ++b)
+			binCounts[b] = 0;
+
+		for (u32 i=first; i<first+count; ++i)
+		{
+			const u32 tri = TriangleIndices[i];
+			const u32 b = core::min_((u32)(((&centers[tri].X)[axis] - axisMin) * binScale), BVH_BIN_COUNT-1);
+			if (binCounts[b]++)
+				binBoxes[b].addInternalBox(triangleBoxes[tri]);
+			else
+				binBoxes[b] = triangleBoxes[tri];
+		}
+
+		// area and count of everything right of each split plane
+		f32 rightArea[BVH_BIN_COUNT];
+		u32 rightCount[BVH_BIN_COUNT];
+		core::aabbox3df accum;
+		u32 accumCount = 0;
+		for (u32 b=BVH_BIN_COUNT-1; b>0; --b)
+		{
+			if (binCounts[b])
+			{
+				if (accumCount)
+					accum.addInternalBox(binBoxes[b]);
+				else
+					accum = binBoxes[b];
+				accumCount += binCounts[b];
+			}
+			rightArea[b] = accumCount ? accum.getArea() : 0.f;
+			rightCount[b] = accumCount;
+		}
+
+		accumCount = 0;
+		for (u32 b=0; b<BVH_BIN_COUNT-1; ++b)
+		{
+			if (binCounts[b])
+			{
+				if (accumCount)
+					accum.addInternalBox(binBoxes[b]);
+				else
+					accum = binBoxes[b];
+				accumCount += binCounts[b];
+			}
+			if (!accumCount || !rightCount[b+1])
+				continue;
+
+			const f32 cost = accum.getArea() * accumCount + rightArea[b+1] * rightCount[b+1];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = b;
+			}
+		}
+	}
+
+	const f32 splitCost = BVH_TRAVERSAL_COST * box.getArea() + bestCost;
+	if (count <= MaxTrianglesPerLeaf && (bestAxis < 0 || splitCost >= leafCost))
+		return;
+
+	// partition the triangle indices
+	u32 leftCount = count / 2;
+	if (bestAxis >= 0)
+	{
+		const f32 binScale = BVH_BIN_COUNT / (&extent.X)[bestAxis];
+		const f32 axisMin = (&centerBox.MinEdge.X)[bestAxis];
+
+		u32 i = first;
+		u32 j = first + count;
+		while (i < j)
+		{
+			const u32 tri = TriangleIndices[i];
+			const u32 b = core::min_((u32)(((&centers[tri].X)[bestAxis] - axisMin) * binScale), BVH_BIN_COUNT-1);
+			if (b <= bestBin)
+				++i;
+			else
+				core::swap(TriangleIndices[i], TriangleIndices[--j]);
+		}
+		leftCount = i - first;
+	}
+
+	// all centers in one place, just split the list
+	if (leftCount == 0 || leftCount == count)
+		leftCount = count / 2;
+
+	const u32 left = Nodes.size();
+	Nodes.set_used(left + 2);
+	Nodes[nodeIndex].Index = left;
+	Nodes[nodeIndex].Count = 0;
+
+	buildNode(left, first, leftCount, depth+1, triangleBoxes, centers);
+	buildNode(left+1, first+leftCount, count-leftCount, depth+1, triangleBoxes, centers);
+}
+
+
+bool CBVHTriangleSelector::writeAccelerationData(io::IWriteFile* file) const
+{
+	if (Nodes.empty())
+		return false;
+
+	// animated nodes write the hierarchy fitted to the current frame
+	update();
+	return writeTreeData(file, BVH_DATA_TYPE, MaxTrianglesPerLeaf, Nodes, TriangleIndices);
+}
+
+
+bool CBVHTriangleSelector::readHierarchy(io::IReadFile* file)
+{
+	if (Triangles.empty())
+		return false;
+
+	const u32 start = os::Timer::getRealTime();
+
+	if (!readTreeData(file, BVH_DATA_TYPE, MaxTrianglesPerLeaf, Nodes, TriangleIndices))
+		return false;
+
+	// check the references, so broken files can't make queries read outside
+	// the arrays or overflow the traversal stacks. Children always come after
+	// their parent, so each node must have been reached exactly once from an
+	// earlier node when it's checked, which also means the depth is known.
+	const u32 NOT_REACHED = 0xffffffff;
+	const u32 nodeCount = Nodes.size();
+	const u32 indexCount = TriangleIndices.size();
+	core::array<u32> depth;
+	depth.set_used(nodeCount);
+	for (u32 i=0; i<nodeCount; ++i)
+		depth[i] = NOT_REACHED;
+	bool valid = nodeCount > 0;
+	if (valid)
+		depth[0] = 0;
+	for (u32 i=0; i<nodeCount && valid; ++i)
+	{
+		const SBVHNode& node = Nodes[i];
+		if (depth[i] == NOT_REACHED)
+		{
+			valid = false;
+		}
+		else if (node.Count)
+		{
+			valid = node.Index <= indexCount && node.Count <= indexCount - node.Index;
+		}
+		else
+		{
+			valid = node.Index > i && node.Index < nodeCount-1 && depth[i] < MAX_DEPTH &&
+				depth[node.Index] == NOT_REACHED && depth[node.Index+1] == NOT_REACHED;
+			if (valid)
+				depth[node.Index] = depth[node.Index+1] = depth[i]+1;
+		}
+	}
+
+	if (!valid)
+	{
+		os::Printer::log("Invalid acceleration data for BVHTriangleSelector", ELL_WARNING);
+		Nodes.clear();
+		TriangleIndices.clear();
+		return false;
+	}
+
+	c8 tmp[256];
+	sprintf(tmp, "Needed %ums to load BVHTriangleSelector.(%u nodes, %u polys)",
+		os::Timer::getRealTime() - start, Nodes.size(), Triangles.size());
+	os::Printer::log(tmp, ELL_INFORMATION);
+	return true;
+}
+
+
+bool CBVHTriangleSelector::isHierarchyBuiltFor(const IMesh* mesh) const
+{
+	if (TriangleLeaves.size() != Triangles.size())
+		return false;
+
+	const u32 bufferCount = mesh->getMeshBufferCount();
+	if (!BufferRanges.empty() && BufferRanges.size() != bufferCount)
+		return false;
+
+	u32 triangleCount = 0;
+	for (u32 i=0; i<bufferCount; ++i)
+	{
+		const u32 bufferTriangles = mesh->getMeshBuffer(i)->getIndexCount() / 3;
+		if (!BufferRanges.empty() && BufferRanges[i].RangeSize != bufferTriangles)
+			return false;
+		triangleCount += bufferTriangles;
+	}
+
+	return triangleCount == Triangles.size();
+}
+
+
+template <typename TIndex>
+void CBVHTriangleSelector::refitTriangles(u32& triangleIndex, u32 idxCnt, const TIndex* indices,
+		const SVertexPositions& positions, const core::matrix4* bufferTransform) const
+{
+	for (u32 index = 2; index < idxCnt; index += 3)
+	{
+		core::triangle3df& tri = Triangles[triangleIndex];
+		tri.pointA = positions[indices[index - 2]];
+		tri.pointB = positions[indices[index - 1]];
+		tri.pointC = positions[indices[index - 0]];
+		if (bufferTransform)
+		{
+			bufferTransform->transformVect(tri.pointA);
+			bufferTransform->transformVect(tri.pointB);
+			bufferTransform->transformVect(tri.pointC);
+		}
+
+		core::aabbox3df& box = Nodes[TriangleLeaves[triangleIndex]].Box;
+		box.addInternalPoint(tri.pointA);
+		box.addInternalPoint(tri.pointB);
+		box.addInternalPoint(tri.pointC);
+		++triangleIndex;
+	}
+}
+
+
+void CBVHTriangleSelector::refitHierarchy(const IMesh* mesh) const
+{
+	// Leaves start inverted, so the first point added sets both edges
+	for (u32 i=0; i<Nodes.size(); ++i)
+	{
+		if (Nodes[i].Count)
+		{
+			Nodes[i].Box.MinEdge.set(FLT_MAX, FLT_MAX, FLT_MAX);
+			Nodes[i].Box.MaxEdge.set(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		}
+	}
+
+	// One pass over the mesh writes the triangles and grows their leaves
+	const bool skinnedMesh = mesh->getMeshType() == EAMT_SKINNED;
+	u32 triangleIndex = 0;
+	for (u32 i=0; i<mesh->getMeshBufferCount(); ++i)
+	{
+		IMeshBuffer* buf = mesh->getMeshBuffer(i);
+		const u32 idxCnt = buf->getIndexCount();
+		const SVertexPositions positions(buf);
+
+		const core::matrix4* bufferTransform = 0;
+		if (skinnedMesh)
+		{
+			bufferTransform = &(((scene::SSkinMeshBuffer*)buf)->Transformation);
+			if (bufferTransform->isIdentity())
+				bufferTransform = 0;
+		}
+
+		if (buf->getIndexType() == video::EIT_32BIT)
+			refitTriangles(triangleIndex, idxCnt, (const u32*)buf->getIndices(), positions, bufferTransform);
+		else
+			refitTriangles(triangleIndex, idxCnt, buf->getIndices(), positions, bufferTransform);
+	}
+
+	// children are always stored behind their parent
+	for (s32 i=(s32)Nodes.size()-1; i>=0; --i)
+	{
+		SBVHNode& node = Nodes[i];
+		if (!node.Count)
+		{
+			node.Box = Nodes[node.Index].Box;
+			node.Box.addInternalBox(Nodes[node.Index+1].Box);
+		}
+	}
+
+	BoundingBox = Nodes[0].Box;
+}
+
+
+void CBVHTriangleSelector::update(void) const
+{
+	if (!AnimatedNode)
+		return;
+
+	// another mesh set on the node can be at the same frame number
+	const u32 currentFrame = (u32)AnimatedNode->getFrameNr();
+	IAnimatedMesh* animatedMesh = AnimatedNode->getMesh();
+	if (currentFrame == LastMeshFrame && animatedMesh == LastAnimatedMesh)
+		return;
+
+	LastMeshFrame = currentFrame;
+	LastAnimatedMesh = animatedMesh;
+	IMesh* mesh = animatedMesh ? animatedMesh->getMesh(LastMeshFrame) : 0;
+	if (!mesh)
+		return;
+
+	// The triangles have moved, but an animation keeps their count. Fitting
+	// the boxes is far cheaper than a new build and good enough while
+	// the mesh doesn't deform too far from the pose it was built for.
+	// Another mesh set on the node needs a new hierarchy.
+	if (Nodes.empty() || !isHierarchyBuiltFor(mesh))
+	{
+		CBVHTriangleSelector* self = const_cast<CBVHTriangleSelector*>(this);
+		self->createFromMesh(mesh, !BufferRanges.empty());
+		self->buildHierarchy();
+	}
+	else
+		refitHierarchy(mesh);
+}
+
+
+bool CBVHTriangleSelector::intersectsBox(const core::aabbox3d<f32>& box,
+		const core::vector3df& start, const core::vector3df& invDir, f32 maxT, f32& outT)
+{
+	f32 t1 = (box.MinEdge.X - start.X) * invDir.X;
+	f32 t2 = (box.MaxEdge.X - start.X) * invDir.X;
+	f32 tmin = core::min_(t1, t2);
+	f32 tmax = core::max_(t1, t2);
+
+	t1 = (box.MinEdge.Y - start.Y) * invDir.Y;
+	t2 = (box.MaxEdge.Y - start.Y) * invDir.Y;
+	tmin = core::max_(tmin, core::min_(t1, t2));
+	tmax = core::min_(tmax, core::max_(t1, t2));
+
+	t1 = (box.MinEdge.Z - start.Z) * invDir.Z;
+	t2 = (box.MaxEdge.Z - start.Z) * invDir.Z;
+	tmin = core::max_(tmin, core::min_(t1, t2));
+	tmax = core::min_(tmax, core::max_(t1, t2));
+
+	outT = tmin;
+	return tmax >= core::max_(tmin, 0.f) && tmin <= maxT;
+}
+
+
+const SCollisionTriangleRange* CBVHTriangleSelector::getBufferRange(u32 triangleIndex) const
+{
+	if (BufferRanges.empty())
+		return 0;
+
+	// last range starting at or before the triangle
+	s32 lo = 0;
+	s32 hi = (s32)BufferRanges.size() - 1;
+	while (lo < hi)
+	{
+		const s32 mid = (lo + hi + 1) / 2;
+		if (BufferRanges[mid].RangeStart <= triangleIndex)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	return &BufferRanges[lo];
+}
+
+
+void CBVHTriangleSelector::addTriangle(u32 triangleIndex, core::triangle3df* triangles,
+		s32& trianglesWritten, const core::matrix4& mat,
+		irr::core::array<SCollisionTriangleRange>* outTriangleInfo) const
+{
+	const core::triangle3df& srcTri = Triangles[triangleIndex];
+	core::triangle3df& dstTri = triangles[trianglesWritten];
+	mat.transformVect(dstTri.pointA, srcTri.pointA);
+	mat.transformVect(dstTri.pointB, srcTri.pointB);
+	mat.transformVect(dstTri.pointC, srcTri.pointC);
+
+	if (outTriangleInfo && !BufferRanges.empty())
+	{
+		const SCollisionTriangleRange* range = getBufferRange(triangleIndex);
+
+		// Triangles come in tree order, so continue the last range while the meshbuffer stays the same
+		if (trianglesWritten > 0 && !outTriangleInfo->empty())
+		{
+			SCollisionTriangleRange& last = outTriangleInfo->getLast();
+			if (last.Selector == this && last.MeshBuffer == range->MeshBuffer &&
+				last.RangeStart + last.RangeSize == (u32)trianglesWritten)
+			{
+				++last.RangeSize;
+				++trianglesWritten;
+				return;
+			}
+		}
+
+		SCollisionTriangleRange triRange;
+		triRange.RangeStart = trianglesWritten;
+		triRange.RangeSize = 1;
+		triRange.Selector = const_cast<CBVHTriangleSelector*>(this);
+		triRange.SceneNode = SceneNode;
+		triRange.MeshBuffer = range->MeshBuffer;
+		triRange.MaterialIndex = range->MaterialIndex;
+		outTriangleInfo->push_back(triRange);
+	}
+
+	++trianglesWritten;
+}
+
+
+//! Gets all triangles which lie within a specific bounding box.
+void CBVHTriangleSelector::getTriangles(core::triangle3df* triangles,
+					s32 arraySize, s32& outTriangleCount,
+					const core::aabbox3d<f32>& box,
+					const core::matrix4* transform, bool useNodeTransform,
+					irr::core::array<SCollisionTriangleRange>* outTriangleInfo) const
+{
+	// Update my triangles if necessary
+	update();
+
+	core::matrix4 mat(core::matrix4::EM4CONST_NOTHING);
+	core::aabbox3d<f32> invbox = box;
+
+	if (SceneNode && useNodeTransform)
+	{
+		if ( SceneNode->getAbsoluteTransformation().getInverse(mat) )
+			mat.transformBoxEx(invbox);
+		else
+			// a node scaled to zero has no inverse, so the box can't be moved into
+			// mesh space. All triangles are candidates then
+			return CTriangleSelector::getTriangles(triangles, arraySize, outTriangleCount, transform, useNodeTransform, outTriangleInfo);
+	}
+
+	if (transform)
+		mat = *transform;
+	else
+		mat.makeIdentity();
+
+	if (SceneNode && useNodeTransform)
+		mat *= SceneNode->getAbsoluteTransformation();
+
+	s32 trianglesWritten = 0;
+
+	if (!Nodes.empty() && arraySize > 0)
+	{
+		u32 stack[MAX_DEPTH+2];
+		u32 stackSize = 0;
+		stack[stackSize++] = 0;
+
+		while (stackSize && trianglesWritten < arraySize)
+		{
+			const SBVHNode& node = Nodes[stack[--stackSize]];
+			if (!invbox.intersectsWithBox(node.Box))
+				continue;
+
+			if (node.Count)
+			{
+				for (u32 i=node.Index; i<node.Index+node.Count; ++i)
+				{
+					// This isn't an accurate test, but it's fast, and the
+					// API contract doesn't guarantee complete accuracy.
+					if (Triangles[TriangleIndices[i]].isTotalOutsideBox(invbox))
+						continue;
+
+					addTriangle(TriangleIndices[i], triangles, trianglesWritten, mat, outTriangleInfo);
+
+					// Halt when the out array is full.
+					if (trianglesWritten == arraySize)
+						break;
+				}
+			}
+			else
+			{
+				stack[stackSize++] = node.Index+1;
+				stack[stackSize++] = node.Index;
+			}
+		}
+	}
+
+	if ( outTriangleInfo && BufferRanges.empty() )
+	{
+		SCollisionTriangleRange triRange;
+		triRange.RangeSize = trianglesWritten;
+		triRange.Selector = const_cast<CBVHTriangleSelector*>(this);
+		triRange.SceneNode = SceneNode;
+		triRange.MeshBuffer = MeshBuffer;
+		triRange.MaterialIndex = MaterialIndex;
+		outTriangleInfo->push_back(triRange);
+	}
+
+	outTriangleCount = trianglesWritten;
+}
+
+
+//! Gets all triangles which have or may have contact with a 3d line.
+void CBVHTriangleSelector::getTriangles(core::triangle3df* triangles, s32 arraySize,
+		s32& outTriangleCount, const core::line3d<f32>& line,
+		const core::matrix4* transform, bool useNodeTransform,
+		irr::core::array<SCollisionTriangleRange>* outTriangleInfo) const
+{
+	// Update my triangles if necessary
+	update();
+
+	core::matrix4 mat(core::matrix4::EM4CONST_NOTHING);
+	core::line3d<f32> invline(line);
+
+	if (SceneNode && useNodeTransform)
+	{
+		if ( SceneNode->getAbsoluteTransformation().getInverse(mat) )
+		{
+			mat.transformVect(invline.start);
+			mat.transformVect(invline.end);
+		}
+		else
+			return CTriangleSelector::getTriangles(triangles, arraySize, outTriangleCount, transform, useNodeTransform, outTriangleInfo);
+	}
+
+	if (transform)
+		mat = *transform;
+	else
+		mat.makeIdentity();
+
+	if (SceneNode && useNodeTransform)
+		mat *= SceneNode->getAbsoluteTransformation();
+
+	const core::vector3df dir = invline.getVector();
+	const core::vector3df invDir(getInverse(dir.X), getInverse(dir.Y), getInverse(dir.Z));
+
+	s32 trianglesWritten = 0;
+
+	if (!Nodes.empty() && arraySize > 0)
+	{
+		u32 stack[MAX_DEPTH+2];
+		u32 stackSize = 0;
+		stack[stackSize++] = 0;
+
+		while (stackSize && trianglesWritten < arraySize)
+		{
+			const SBVHNode& node = Nodes[stack[--stackSize]];
+			f32 t;
+			if (!intersectsBox(node.Box, invline.start, invDir, 1.f, t))
+				continue;
+
+			if (node.Count)
+			{
+				for (u32 i=node.Index; i<node.Index+node.Count; ++i)
+				{
+					addTriangle(TriangleIndices[i], triangles, trianglesWritten, mat, outTriangleInfo);
+
+					if (trianglesWritten == arraySize)
+						break;
+				}
+			}
+			else
+			{
+				stack[stackSize++] = node.Index+1;
+				stack[stackSize++] = node.Index;
+			}
+		}
+	}
+
+	if ( outTriangleInfo && BufferRanges.empty() )
+	{
+		SCollisionTriangleRange triRange;
+		triRange.RangeSize = trianglesWritten;
+		triRange.Selector = const_cast<CBVHTriangleSelector*>(this);
+		triRange.SceneNode = SceneNode;
+		triRange.MeshBuffer = MeshBuffer;
+		triRange.MaterialIndex = MaterialIndex;
+		outTriangleInfo->push_back(triRange);
+	}
+
+	outTriangleCount = trianglesWritten;
+}
+
+
+//! Gets the nearest intersection of a 3d line with the triangles.
+bool CBVHTriangleSelector::getCollisionPoint(SCollisionHit& hitResult,
+		const core::line3d<f32>& line, bool useNodeTransform) const
+{
+	// Update my triangles if necessary
+	update();
+
+	if (Nodes.empty())
+		return false;
+
+	const bool nodeTransform = SceneNode && useNodeTransform;
+	core::line3d<f32> invline(line);
+
+	if (nodeTransform)
+	{
+		core::matrix4 mat(core::matrix4::EM4CONST_NOTHING);
+		if (!SceneNode->getAbsoluteTransformation().getInverse(mat))
+			return CTriangleSelector::getCollisionPoint(hitResult, line, useNodeTransform);
+
+		mat.transformVect(invline.start);
+		mat.transformVect(invline.end);
+	}
+
+	// Lines are tested as start + dir*t with t in [0,1]. Affine transformations
+	// keep t, so the nearest hit in object space is also the nearest in world space.
+	const core::vector3df& start = invline.start;
+	const core::vector3df dir = invline.getVector();
+	const core::vector3df invDir(getInverse(dir.X), getInverse(dir.Y), getInverse(dir.Z));
+
+	struct SStackEntry
+	{
+		u32 Node;
+		f32 T;
+	};
+	SStackEntry stack[MAX_DEPTH+2];
+	u32 stackSize = 0;
+
+	f32 nearest = 1.f;
+	s32 found = -1;
+
+	f32 t;
+	if (!intersectsBox(Nodes[0].Box, start, invDir, nearest, t))
+		return false;
+	stack[0].Node = 0;
+	stack[0].T = t;
+	stackSize = 1;
+
+	while (stackSize)
+	{
+		const SStackEntry& entry = stack[--stackSize];
+		if (entry.T > nearest)
+			continue;
+
+		const SBVHNode& node = Nodes[entry.Node];
+		if (node.Count)
+		{
+			for (u32 i=node.Index; i<node.Index+node.Count; ++i)
+			{
+				if (intersectTriangle(Triangles[TriangleIndices[i]], start, dir, nearest, t))
+				{
+					nearest = t;
+					found = (s32)TriangleIndices[i];
+				}
+			}
+			continue;
+		}
+
+		// visit the nearer child first
+		f32 tLeft, tRight;
+		const bool hitLeft = intersectsBox(Nodes[node.Index].Box, start, invDir, nearest, tLeft);
+		const bool hitRight = intersectsBox(Nodes[node.Index+1].Box, start, invDir, nearest, tRight);
+
+		if (hitLeft && hitRight)
+		{
+			const bool leftFirst = tLeft <= tRight;
+			stack[stackSize].Node = leftFirst ? node.Index+1 : node.Index;
+			stack[stackSize].T = leftFirst ? tRight : tLeft;
+			++stackSize;
+			stack[stackSize].Node = leftFirst ? node.Index : node.Index+1;
+			stack[stackSize].T = leftFirst ? tLeft : tRight;
+			++stackSize;
+		}
+		else if (hitLeft || hitRight)
+		{
+			stack[stackSize].Node = hitLeft ? node.Index : node.Index+1;
+			stack[stackSize].T = hitLeft ? tLeft : tRight;
+			++stackSize;
+		}
+	}
+
+	if (found < 0)
+		return false;
+
+	fillCollisionHit(hitResult, start + dir * nearest, (u32)found, nodeTransform);
+	return true;
+}
+
+
+//! Gets the nearest intersections of several 3d lines, traced in packets.
+u32 CBVHTriangleSelector::getCollisionPoints(SCollisionHit* hitResults, bool* hitFound,
+		const core::line3d<f32>* lines, u32 lineCount, bool useNodeTransform) const
+{
+	// Update my triangles if necessary
+	update();
+
+	const bool nodeTransform = SceneNode && useNodeTransform;
+	core::matrix4 mat(core::matrix4::EM4CONST_NOTHING);
+
+	if (nodeTransform && !SceneNode->getAbsoluteTransformation().getInverse(mat))
+		return CTriangleSelector::getCollisionPoints(hitResults, hitFound, lines, lineCount, useNodeTransform);
+
+	u32 hits = 0;
+	for (u32 first=0; first<lineCount; first+=PACKET_SIZE)
+	{
+		const u32 count = core::min_(lineCount-first, (u32)PACKET_SIZE);
+
+		// lanes of an incomplete packet repeat the last line
+		SRayPacket packet;
+		for (u32 lane=0; lane<PACKET_SIZE; ++lane)
+		{
+			core::line3d<f32> line(lines[first + core::min_(lane, count-1)]);
+			if (nodeTransform)
+			{
+				mat.transformVect(line.start);
+				mat.transformVect(line.end);
+			}
+
+			const core::vector3df dir = line.getVector();
+			packet.StartX[lane] = line.start.X;
+			packet.StartY[lane] = line.start.Y;
+			packet.StartZ[lane] = line.start.Z;
+			packet.DirX[lane] = dir.X;
+			packet.DirY[lane] = dir.Y;
+			packet.DirZ[lane] = dir.Z;
+			packet.InvDirX[lane] = getInverse(dir.X);
+			packet.InvDirY[lane] = getInverse(dir.Y);
+			packet.InvDirZ[lane] = getInverse(dir.Z);
+			packet.Nearest[lane] = 1.f;
+			packet.Found[lane] = -1;
+		}
+
+		if (!Nodes.empty())
+			tracePacket(packet);
+
+		for (u32 lane=0; lane<count; ++lane)
+		{
+			hitFound[first+lane] = packet.Found[lane] >= 0;
+			if (!hitFound[first+lane])
+				continue;
+
+			const f32 t = packet.Nearest[lane];
+			const core::vector3df intersection(
+				packet.StartX[lane] + packet.DirX[lane] * t,
+				packet.StartY[lane] + packet.DirY[lane] * t,
+				packet.StartZ[lane] + packet.DirZ[lane] * t);
+			fillCollisionHit(hitResults[first+lane], intersection, (u32)packet.Found[lane], nodeTransform);
+			++hits;
+		}
+	}
+
+	return hits;
+}
+
+
+void CBVHTriangleSelector::tracePacket(SRayPacket& packet) const
+{
+	struct SStackEntry
+	{
+		u32 Node;
+		f32 T;
+	};
+	SStackEntry stack[MAX_DEPTH+2];
+	u32 stackSize = 0;
+
+	f32 t;
+	if (!intersectsBox(Nodes[0].Box, packet, t))
+		return;
+	stack[0].Node = 0;
+	stack[0].T = t;
+	stackSize = 1;
+
+	while (stackSize)
+	{
+		const SStackEntry& entry = stack[--stackSize];
+
+		// skip nodes behind the nearest hit of every lane
+		f32 farthest = packet.Nearest[0];
+		for (u32 lane=1; lane<PACKET_SIZE; ++lane)
+			farthest = core::max_(farthest, packet.Nearest[lane]);
+		if (entry.T > farthest)
+			continue;
+
+		const SBVHNode& node = Nodes[entry.Node];
+		if (node.Count)
+		{
+			for (u32 i=node.Index; i<node.Index+node.Count; ++i)
+				intersectTrianglePacket(Triangles[TriangleIndices[i]], (s32)TriangleIndices[i], packet);
+			continue;
+		}
+
+		f32 tLeft, tRight;
+		const bool hitLeft = intersectsBox(Nodes[node.Index].Box, packet, tLeft);
+		const bool hitRight = intersectsBox(Nodes[node.Index+1].Box, packet, tRight);
+
+		if (hitLeft && hitRight)
+		{
+			const bool leftFirst = tLeft <= tRight;
+			stack[stackSize].Node = leftFirst ? node.Index+1 : node.Index;
+			stack[stackSize].T = leftFirst ? tRight : tLeft;
+			++stackSize;
+			stack[stackSize].Node = leftFirst ? node.Index : node.Index+1;
+			stack[stackSize].T = leftFirst ? tLeft : tRight;
+			++stackSize;
+		}
+		else if (hitLeft || hitRight)
+		{
+			stack[stackSize].Node = hitLeft ? node.Index : node.Index+1;
+			stack[stackSize].T = hitLeft ? tLeft : tRight;
+			++stackSize;
+		}
+	}
+}
+
+
+bool CBVHTriangleSelector::intersectsBox(const core::aabbox3d<f32>& box, const SRayPacket& packet, f32& outT)
+{
+	f32 entry[PACKET_SIZE];
+	bool hit[PACKET_SIZE];
+
+	// no early outs, so compilers can process all lanes at once
+	for (u32 lane=0; lane<PACKET_SIZE; ++lane)
+	{
+		f32 t1 = (box.MinEdge.X - packet.StartX[lane]) * packet.InvDirX[lane];
+		f32 t2 = (box.MaxEdge.X - packet.StartX[lane]) * packet.InvDirX[lane];
+		f32 tmin = core::min_(t1, t2);
+		f32 tmax = core::max_(t1, t2);
+
+		t1 = (box.MinEdge.Y - packet.StartY[lane]) * packet.InvDirY[lane];
+		t2 = (box.MaxEdge.Y - packet.StartY[lane]) * packet.InvDirY[lane];
+		tmin = core::max_(tmin, core::min_(t1, t2));
+		tmax = core::min_(tmax, core::max_(t1, t2));
+
+		t1 = (box.MinEdge.Z - packet.StartZ[lane]) * packet.InvDirZ[lane];
+		t2 = (box.MaxEdge.Z - packet.StartZ[lane]) * packet.InvDirZ[lane];
+		tmin = core::max_(tmin, core::min_(t1, t2));
+		tmax = core::min_(tmax, core::max_(t1, t2));
+
+		hit[lane] = (tmax >= core::max_(tmin, 0.f)) & (tmin <= packet.Nearest[lane]);
+		entry[lane] = hit[lane] ? tmin : FLT_MAX;
+	}
+
+	bool anyHit = hit[0];
+	outT = entry[0];
+	for (u32 lane=1; lane<PACKET_SIZE; ++lane)
+	{
+		anyHit |= hit[lane];
+		outT = core::min_(outT, entry[lane]);
+	}
+	return anyHit;
+}
+
+
+void CBVHTriangleSelector::intersectTrianglePacket(const core::triangle3df& tri, s32 triangleIndex, SRayPacket& packet)
+{
+	const core::vector3df e1 = tri.pointB - tri.pointA;
+	const core::vector3df e2 = tri.pointC - tri.pointA;
+
+	// Möller-Trumbore for each lane, without early outs
+	for (u32 lane=0; lane<PACKET_SIZE; ++lane)
+	{
+		const f32 px = packet.DirY[lane] * e2.Z - packet.DirZ[lane] * e2.Y;
+		const f32 py = packet.DirZ[lane] * e2.X - packet.DirX[lane] * e2.Z;
+		const f32 pz = packet.DirX[lane] * e2.Y - packet.DirY[lane] * e2.X;
+		const f32 det = e1.X * px + e1.Y * py + e1.Z * pz;
+		const f32 invDet = det != 0.f ? 1.f / det : 0.f;
+
+		const f32 sx = packet.StartX[lane] - tri.pointA.X;
+		const f32 sy = packet.StartY[lane] - tri.pointA.Y;
+		const f32 sz = packet.StartZ[lane] - tri.pointA.Z;
+		const f32 u = (sx * px + sy * py + sz * pz) * invDet;
+
+		const f32 qx = sy * e1.Z - sz * e1.Y;
+		const f32 qy = sz * e1.X - sx * e1.Z;
+		const f32 qz = sx * e1.Y - sy * e1.X;
+		const f32 v = (packet.DirX[lane] * qx + packet.DirY[lane] * qy + packet.DirZ[lane] * qz) * invDet;
+		const f32 t = (e2.X * qx + e2.Y * qy + e2.Z * qz) * invDet;
+
+		const bool hit = (det != 0.f) & (u >= 0.f) & (v >= 0.f) & (u + v <= 1.f)
+			& (t >= 0.f) & (t <= packet.Nearest[lane]);
+		packet.Nearest[lane] = hit ? t : packet.Nearest[lane];
+		packet.Found[lane] = hit ? triangleIndex : packet.Found[lane];
+	}
+}
+
+
+void CBVHTriangleSelector::fillCollisionHit(SCollisionHit& hitResult, const core::vector3df& intersection,
+		u32 triangleIndex, bool nodeTransform) const
+{
+	hitResult.Intersection = intersection;
+	hitResult.Triangle = Triangles[triangleIndex];
+	if (nodeTransform)
+	{
+		const core::matrix4& mat = SceneNode->getAbsoluteTransformation();
+		mat.transformVect(hitResult.Intersection);
+		mat.transformVect(hitResult.Triangle.pointA);
+		mat.transformVect(hitResult.Triangle.pointB);
+		mat.transformVect(hitResult.Triangle.pointC);
+	}
+
+	const SCollisionTriangleRange* range = getBufferRange(triangleIndex);
+	hitResult.TriangleSelector = const_cast<CBVHTriangleSelector*>(this);
+	hitResult.Node = SceneNode;
+	hitResult.MeshBuffer = range ? range->MeshBuffer : MeshBuffer;
+	hitResult.MaterialIndex = range ? range->MaterialIndex : MaterialIndex;
+}
+
+
+} // end namespace scene
+} // end namespace irr
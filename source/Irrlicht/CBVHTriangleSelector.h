@@ -0,0 +1,160 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_C_BVH_TRIANGLE_SELECTOR_H_INCLUDED
+#define IRR_C_BVH_TRIANGLE_SELECTOR_H_INCLUDED
+
+#include "CTriangleSelector.h"
+#include "IAnimatedMesh.h"
+
+namespace irr
+{
+namespace scene
+{
+
+class ISceneNode;
+
+//! Triangle selector organizing the triangles in a bounding volume hierarchy
+/** The hierarchy is built with the surface area heuristic. Ray queries walk
+the tree front to back and return the nearest hit directly, box and line
+queries only visit nodes overlapping the query. */
+class CBVHTriangleSelector : public CTriangleSelector
+{
+public:
+
+	//! Constructs a selector based on a mesh
+	/** \param accelerationData When it contains a hierarchy written for
+	the same triangles, that hierarchy is used instead of building a new one. */
+	CBVHTriangleSelector(const IMesh* mesh, ISceneNode* node, bool separateMeshbuffers, u32 maxTrianglesPerLeaf,
+		io::IReadFile* accelerationData=0);
+
+	//! Constructs a selector based on a meshbuffer
+	CBVHTriangleSelector(const IMeshBuffer* meshBuffer, irr::u32 materialIndex, ISceneNode* node, u32 maxTrianglesPerLeaf,
+		io::IReadFile* accelerationData=0);
+
+	//! Constructs a selector based on an animated mesh scene node
+	/** The hierarchy is built for the current frame. When the frame
+	changes, the boxes are refitted to the new triangles on the next query
+	and the tree itself is kept. */
+	CBVHTriangleSelector(IAnimatedMeshSceneNode* node, bool separateMeshbuffers, u32 maxTrianglesPerLeaf);
+
+	//! Gets all triangles which lie within a specific bounding box.
+	virtual void getTriangles(core::triangle3df* triangles, s32 arraySize, s32& outTriangleCount,
+		const core::aabbox3d<f32>& box, const core::matrix4* transform, bool useNodeTransform,
+		irr::core::array<SCollisionTriangleRange>* outTriangleInfo) const IRR_OVERRIDE;
+
+	//! Gets all triangles which have or may have contact with a 3d line.
+	virtual void getTriangles(core::triangle3df* triangles, s32 arraySize,
+		s32& outTriangleCount, const core::line3d<f32>& line,
+		const core::matrix4* transform, bool useNodeTransform,
+		irr::core::array<SCollisionTriangleRange>* outTriangleInfo) const IRR_OVERRIDE;
+
+	//! Gets the nearest intersection of a 3d line with the triangles.
+	virtual bool getCollisionPoint(SCollisionHit& hitResult, const core::line3d<f32>& line,
+		bool useNodeTransform) const IRR_OVERRIDE;
+
+	//! Gets the nearest intersections of several 3d lines, traced in packets.
+	virtual u32 getCollisionPoints(SCollisionHit* hitResults, bool* hitFound,
+		const core::line3d<f32>* lines, u32 lineCount, bool useNodeTransform) const IRR_OVERRIDE;
+
+	//! Writes the hierarchy
+	virtual bool writeAccelerationData(io::IWriteFile* file) const IRR_OVERRIDE;
+
+protected:
+
+	//! Node of the hierarchy
+	/** Inner nodes have Count 0 and their children at Index and Index+1.
+	Leaves reference Count entries of TriangleIndices starting at Index. */
+	struct SBVHNode
+	{
+		core::aabbox3d<f32> Box;
+		u32 Index;
+		u32 Count;
+	};
+
+	//! Maximal depth of the hierarchy, deeper nodes become leaves
+	enum { MAX_DEPTH = 64 };
+
+	//! Number of lines traced together by getCollisionPoints()
+	enum { PACKET_SIZE = 4 };
+
+	//! Lines traced together, stored per component so each test is a loop over the lanes
+	struct SRayPacket
+	{
+		f32 StartX[PACKET_SIZE], StartY[PACKET_SIZE], StartZ[PACKET_SIZE];
+		f32 DirX[PACKET_SIZE], DirY[PACKET_SIZE], DirZ[PACKET_SIZE];
+		f32 InvDirX[PACKET_SIZE], InvDirY[PACKET_SIZE], InvDirZ[PACKET_SIZE];
+
+		//! Line parameter of the nearest hit, starts at 1 (the line end)
+		f32 Nearest[PACKET_SIZE];
+
+		//! Index of the nearest hit triangle, -1 when none was found
+		s32 Found[PACKET_SIZE];
+	};
+
+	//! (Re)builds the hierarchy over Triangles
+	void buildHierarchy();
+
+	//! Reads a hierarchy written by writeAccelerationData()
+	bool readHierarchy(io::IReadFile* file);
+
+	//! Checks if the hierarchy was built for a mesh with the triangle counts of this one
+	bool isHierarchyBuiltFor(const IMesh* mesh) const;
+
+	//! Reads the triangles of an animated mesh and fits the boxes of all nodes to them
+	void refitHierarchy(const IMesh* mesh) const;
+
+	//! Reads the triangles of a meshbuffer and grows the boxes of their leaves
+	template <typename TIndex>
+	void refitTriangles(u32& triangleIndex, u32 idxCnt, const TIndex* indices,
+		const SVertexPositions& positions, const core::matrix4* bufferTransform) const;
+
+	//! Updates the triangles of animated nodes and refits the hierarchy to them
+	/** Rebuilds the hierarchy instead when the node's mesh has other
+	triangle counts than the one it was built for. */
+	virtual void update(void) const IRR_OVERRIDE;
+
+	//! Returns the buffer range a triangle belongs to, 0 if there are none
+	const SCollisionTriangleRange* getBufferRange(u32 triangleIndex) const;
+
+	mutable core::array<SBVHNode> Nodes; // (mutable for refitting in update)
+	core::array<u32> TriangleIndices;
+	core::array<u32> TriangleLeaves; // leaf of each triangle, only for animated nodes
+	u32 MaxTrianglesPerLeaf;
+	mutable IAnimatedMesh* LastAnimatedMesh; // only compared, to notice a new mesh on the node
+
+private:
+
+	void buildNode(u32 nodeIndex, u32 first, u32 count, u32 depth,
+		const core::array<core::aabbox3df>& triangleBoxes,
+		const core::array<core::vector3df>& centers);
+
+	//! Checks if a line hits a box between the parameters 0 and maxT
+	static bool intersectsBox(const core::aabbox3d<f32>& box, const core::vector3df& start,
+		const core::vector3df& invDir, f32 maxT, f32& outT);
+
+	//! Checks the lines of a packet against a box
+	/** \param outT Smallest entry parameter of the lines hitting the box
+	\return True if any line hits the box before its nearest hit */
+	static bool intersectsBox(const core::aabbox3d<f32>& box, const SRayPacket& packet, f32& outT);
+
+	//! Tests the lines of a packet against a triangle and keeps the nearest hits
+	static void intersectTrianglePacket(const core::triangle3df& tri, s32 triangleIndex, SRayPacket& packet);
+
+	//! Finds the nearest hits of all lines in a packet
+	void tracePacket(SRayPacket& packet) const;
+
+	//! Fills the result of a hit found in object space
+	void fillCollisionHit(SCollisionHit& hitResult, const core::vector3df& intersection,
+		u32 triangleIndex, bool nodeTransform) const;
+
+	//! Writes a triangle to the output and keeps track of the buffer ranges
+	void addTriangle(u32 triangleIndex, core::triangle3df* triangles, s32& trianglesWritten,
+		const core::matrix4& mat, irr::core::array<SCollisionTriangleRange>* outTriangleInfo) const;
+};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
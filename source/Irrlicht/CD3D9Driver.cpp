@@ -916,9 +916,9 @@ bool CD3D9Driver::updateVertexHardwareBuffer(SHWBufferLink_d3d9 *hwBuffer)
 		return false;
 
 	const scene::IMeshBuffer* mb = hwBuffer->MeshBuffer;
-	const void* vertices=mb->getVertices();
+	const void* vertices=isQuantized(mb->getVertexType()) ? decodeQuantizedVertices(mb) : mb->getVertices();
 	const u32 vertexCount=mb->getVertexCount();
-	const E_VERTEX_TYPE vType=mb->getVertexType();
+	const E_VERTEX_TYPE vType=getDecodedVertexType(mb->getVertexType());
 	const u32 vertexSize = getVertexPitchFromType(vType);
 	const u32 bufSize = vertexSize * vertexCount;
 
@@ -1147,7 +1147,7 @@ void CD3D9Driver::drawHardwareBuffer(SHWBufferLink *_HWBuffer)
 	HWBuffer->LastUsed=0;//reset count
 
 	const scene::IMeshBuffer* mb = HWBuffer->MeshBuffer;
-	const E_VERTEX_TYPE vType = mb->getVertexType();
+	const E_VERTEX_TYPE vType = getDecodedVertexType(mb->getVertexType());
 	const u32 stride = getVertexPitchFromType(vType);
 	const void* vPtr = mb->getVertices();
 	const void* iPtr = mb->getIndices();
@@ -1156,13 +1156,15 @@ void CD3D9Driver::drawHardwareBuffer(SHWBufferLink *_HWBuffer)
 		pID3DDevice->SetStreamSource(0, HWBuffer->vertexBuffer, 0, stride);
 		vPtr=0;
 	}
+	else if (isQuantized(mb->getVertexType()))
+		vPtr=decodeQuantizedVertices(mb);
 	if (HWBuffer->indexBuffer)
 	{
 		pID3DDevice->SetIndices(HWBuffer->indexBuffer);
 		iPtr=0;
 	}
 
-	drawVertexPrimitiveList(vPtr, mb->getVertexCount(), iPtr, mb->getPrimitiveCount(), mb->getVertexType(), mb->getPrimitiveType(), mb->getIndexType());
+	drawVertexPrimitiveList(vPtr, mb->getVertexCount(), iPtr, mb->getPrimitiveCount(), vType, mb->getPrimitiveType(), mb->getIndexType());
 
 	if (HWBuffer->vertexBuffer)
 		pID3DDevice->SetStreamSource(0, 0, 0, 0);
@@ -0,0 +1,225 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CFileIndex.h"
+#include "coreutil.h"
+
+namespace irr
+{
+namespace io
+{
+
+CFileIndex::CFileIndex()
+	: FreeEntries(-1), EntryCount(0), ArchiveCount(0)
+{
+	Buckets.set_used(64);
+	for (u32 i=0; i<Buckets.size(); ++i)
+		Buckets[i] = -1;
+}
+
+
+//! Adds the files of an archive
+void CFileIndex::addArchive(IFileArchive* archive, bool ignoreCase, bool ignorePaths)
+{
+	u32 slot = 0;
+	while (slot < Archives.size() && Archives[slot].Archive)
+		++slot;
+	if (slot == Archives.size())
+		Archives.push_back(SArchive());
+
+	Archives[slot].Archive = archive;
+	Archives[slot].Priority = 0xffffffff;
+	Archives[slot].IgnoreCase = ignoreCase;
+	Archives[slot].IgnorePaths = ignorePaths;
+	++ArchiveCount;
+
+	const IFileList* list = archive->getFileList();
+	for (u32 i=0; i<list->getFileCount(); ++i)
+	{
+		if (list->isDirectory(i))
+			continue;
+
+		// names in the list are normalized already, lower case with ignoreCase
+		insertEntry(list->getFullFileName(i), slot, i);
+	}
+}
+
+
+//! Removes the files of an archive
+void CFileIndex::removeArchive(const IFileArchive* archive)
+{
+	u32 slot = 0;
+	while (slot < Archives.size() && Archives[slot].Archive != archive)
+		++slot;
+	if (!archive || slot == Archives.size())
+		return;
+
+	const IFileList* list = archive->getFileList();
+	for (u32 i=0; i<list->getFileCount(); ++i)
+	{
+		if (list->isDirectory(i))
+			continue;
+
+		const path& key = list->getFullFileName(i);
+		s32* link = &Buckets[hash(key) & (Buckets.size()-1)];
+		while (*link != -1)
+		{
+			SEntry& e = Entries[*link];
+			if (e.Archive == slot && e.Index == i)
+			{
+				const s32 removed = *link;
+				*link = e.Next;
+				e.Key = "";
+				e.Next = FreeEntries;
+				FreeEntries = removed;
+				--EntryCount;
+				break;
+			}
+			link = &e.Next;
+		}
+	}
+
+	Archives[slot].Archive = 0;
+	--ArchiveCount;
+}
+
+
+//! Returns the number of added archives
+u32 CFileIndex::getArchiveCount() const
+{
+	return ArchiveCount;
+}
+
+
+//! Sets the priority of the added archives
+void CFileIndex::setPriorities(const core::array<IFileArchive*>& archives)
+{
+	for (u32 i=0; i<Archives.size(); ++i)
+	{
+		if (!Archives[i].Archive)
+			continue;
+		const s32 priority = archives.linear_search(Archives[i].Archive);
+		Archives[i].Priority = priority < 0 ? 0xffffffff : (u32)priority;
+	}
+}
+
+
+//! Finds the archive with the highest priority containing a file
+bool CFileIndex::findFile(const path& filename, IFileArchive*& outArchive, u32& outIndex) const
+{
+	outArchive = 0;
+	outIndex = 0;
+
+	// same normalization as CFileList::findFile
+	path key(filename);
+	key.replace('\\', '/');
+	if (key.lastChar() == '/')
+		return false;
+	path lowerKey(key);
+	lowerKey.make_lower();
+
+	const SEntry* best = 0;
+	findKey(key, false, false, best);
+	findKey(lowerKey, true, false, best);
+	core::deletePathFromFilename(key);
+	core::deletePathFromFilename(lowerKey);
+	findKey(key, false, true, best);
+	findKey(lowerKey, true, true, best);
+
+	if (best)
+	{
+		outArchive = Archives[best->Archive].Archive;
+		outIndex = best->Index;
+	}
+	return true;
+}
+
+
+u32 CFileIndex::hash(const path& key)
+{
+	// FNV-1a
+	u32 h = 2166136261u;
+	for (u32 i=0; i<key.size(); ++i)
+	{
+		h ^= (u32)key[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+
+//! Looks up one key, keeps the match with the highest priority
+void CFileIndex::findKey(const path& key, bool ignoreCase, bool ignorePaths, const SEntry*& best) const
+{
+	const u32 h = hash(key);
+	for (s32 i = Buckets[h & (Buckets.size()-1)]; i != -1; i = Entries[i].Next)
+	{
+		const SEntry& e = Entries[i];
+		const SArchive& a = Archives[e.Archive];
+		if (e.Hash != h || a.IgnoreCase != ignoreCase || a.IgnorePaths != ignorePaths || e.Key != key)
+			continue;
+		if (!best || a.Priority < Archives[best->Archive].Priority)
+			best = &e;
+	}
+}
+
+
+void CFileIndex::insertEntry(const path& key, u32 archive, u32 index)
+{
+	if (EntryCount >= Buckets.size())
+		rehash();
+
+	s32 slot = FreeEntries;
+	if (slot != -1)
+		FreeEntries = Entries[slot].Next;
+	else
+	{
+		slot = Entries.size();
+		Entries.push_back(SEntry());
+	}
+
+	SEntry& e = Entries[slot];
+	e.Key = key;
+	e.Hash = hash(key);
+	e.Archive = archive;
+	e.Index = index;
+
+	// append, so the first of equal names in an archive is found first
+	s32* link = &Buckets[e.Hash & (Buckets.size()-1)];
+	while (*link != -1)
+		link = &Entries[*link].Next;
+	*link = slot;
+	e.Next = -1;
+	++EntryCount;
+}
+
+
+//! Doubles the bucket count and distributes the entries again
+void CFileIndex::rehash()
+{
+	core::array<s32> old(Buckets);
+	Buckets.set_used(Buckets.size() * 2);
+	for (u32 i=0; i<Buckets.size(); ++i)
+		Buckets[i] = -1;
+
+	// walk the old chains in order to keep the order of equal names
+	for (u32 b=0; b<old.size(); ++b)
+	{
+		s32 i = old[b];
+		while (i != -1)
+		{
+			SEntry& e = Entries[i];
+			const s32 next = e.Next;
+			s32* link = &Buckets[e.Hash & (Buckets.size()-1)];
+			while (*link != -1)
+				link = &Entries[*link].Next;
+			*link = i;
+			e.Next = -1;
+			i = next;
+		}
+	}
+}
+
+} // end namespace io
+} // end namespace irr
@@ -0,0 +1,98 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_C_FILE_INDEX_H_INCLUDED
+#define IRR_C_FILE_INDEX_H_INCLUDED
+
+#include "IFileArchive.h"
+#include "irrArray.h"
+
+namespace irr
+{
+namespace io
+{
+
+//! Hash index over the files of several archives
+/** Maps file names to the archive and file list index which
+IFileArchive::createAndOpenFile(const path&) would find, so the file system
+doesn't have to search each archive in turn. Like CFileList does, names are
+compared case insensitive for archives created with ignoreCase and exactly
+for the others. Archives created with ignorePaths are searched by file name
+only. */
+class CFileIndex
+{
+public:
+
+	CFileIndex();
+
+	//! Adds the files of an archive
+	/** \param archive Archive to add. Its file list must not change
+	afterwards.
+	\param ignoreCase The archive was created with ignoreCase
+	\param ignorePaths The archive was created with ignorePaths */
+	void addArchive(IFileArchive* archive, bool ignoreCase, bool ignorePaths);
+
+	//! Removes the files of an archive, does nothing if it wasn't added
+	void removeArchive(const IFileArchive* archive);
+
+	//! Returns the number of added archives
+	u32 getArchiveCount() const;
+
+	//! Sets the priority of the added archives
+	/** \param archives All archives of the file system, the first has the
+	highest priority */
+	void setPriorities(const core::array<IFileArchive*>& archives);
+
+	//! Finds the archive with the highest priority containing a file
+	/** \param filename Name of the file like passed to
+	IFileArchive::createAndOpenFile().
+	\param outArchive Receives the archive, or 0 when the file is not in any
+	added archive.
+	\param outIndex Receives the index of the file in the file list of
+	outArchive.
+	\return False if the index can't answer this, which is the case for
+	names of directories. */
+	bool findFile(const path& filename, IFileArchive*& outArchive, u32& outIndex) const;
+
+private:
+
+	struct SArchive
+	{
+		IFileArchive* Archive; // 0 for unused slots
+		u32 Priority;
+		bool IgnoreCase;
+		bool IgnorePaths;
+	};
+
+	struct SEntry
+	{
+		path Key;
+		u32 Hash;
+		u32 Archive; // slot in Archives
+		u32 Index;
+		s32 Next; // next entry in the bucket or in the free list, -1 ends it
+	};
+
+	static u32 hash(const path& key);
+
+	//! Looks up one key in the archives with these flags, keeps the match with the highest priority
+	void findKey(const path& key, bool ignoreCase, bool ignorePaths, const SEntry*& best) const;
+
+	void insertEntry(const path& key, u32 archive, u32 index);
+
+	//! Doubles the bucket count and distributes the entries again
+	void rehash();
+
+	core::array<SArchive> Archives;
+	core::array<SEntry> Entries;
+	core::array<s32> Buckets;
+	s32 FreeEntries;
+	u32 EntryCount;
+	u32 ArchiveCount;
+};
+
+} // end namespace io
+} // end namespace irr
+
+#endif
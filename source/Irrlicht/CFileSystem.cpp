@@ -20,6 +20,7 @@
 #include "os.h"
 #include "CAttributes.h"
 #include "CReadFile.h"
+#include "CMappedReadFile.h"
 #include "CMemoryFile.h"
 #include "CLimitReadFile.h"
 #include "CWriteFile.h"
@@ -55,6 +56,7 @@ namespace io
 
 //! constructor
 CFileSystem::CFileSystem()
+: FileMappingThreshold(0)
 {
 	#ifdef _DEBUG
 	setDebugName("CFileSystem");
@@ -114,19 +116,76 @@ IReadFile* CFileSystem::createAndOpenFile(const io::path& filename)
 	if ( filename.empty() )
 		return 0;
 
-	IReadFile* file = 0;
-	u32 i;
+	// Archives are grabbed while they open the file, so that other
+	// threads can still add and remove archives meanwhile.
+	core::array<IFileArchive*> archives;
+	Mutex.lock();
 
-	for (i=0; i< FileArchives.size(); ++i)
+	// When all archives are indexed, only the one containing the file is asked
+	IFileArchive* archive = 0;
+	u32 index = 0;
+	if (ArchiveIndex.getArchiveCount() == FileArchives.size() &&
+		ArchiveIndex.findFile(filename, archive, index))
 	{
-		file = FileArchives[i]->createAndOpenFile(filename);
+		if (archive)
+			archive->grab();
+		Mutex.unlock();
+
+		IReadFile* file = archive ? archive->createAndOpenFile(index) : 0;
+
+		if (archive)
+		{
+			Mutex.lock();
+			archive->drop();
+			Mutex.unlock();
+		}
+
 		if (file)
 			return file;
+		if (!archive)
+			return CMappedReadFile::createReadFile(getAbsolutePath(filename), FileMappingThreshold);
+
+		// the archive failed (e.g. a wrong password), so try the others like before
+		Mutex.lock();
 	}
 
+	archives.reallocate(FileArchives.size());
+	for (u32 i=0; i< FileArchives.size(); ++i)
+	{
+		FileArchives[i]->grab();
+		archives.push_back(FileArchives[i]);
+	}
+	Mutex.unlock();
+
+	IReadFile* file = 0;
+	for (u32 i=0; i< archives.size() && !file; ++i)
+		file = archives[i]->createAndOpenFile(filename);
+
+	Mutex.lock();
+	for (u32 i=0; i< archives.size(); ++i)
+		archives[i]->drop();
+	Mutex.unlock();
+
+	if (file)
+		return file;
+
 	// Create the file using an absolute path so that it matches
 	// the scheme used by CNullDriver::getTexture().
-	return CReadFile::createReadFile(getAbsolutePath(filename));
+	return CMappedReadFile::createReadFile(getAbsolutePath(filename), FileMappingThreshold);
+}
+
+
+//! Set from which size on createAndOpenFile() maps files on disk into memory.
+void CFileSystem::setFileMappingThreshold(long size)
+{
+	FileMappingThreshold = core::max_(size, 0L);
+}
+
+
+//! Get from which size on createAndOpenFile() maps files on disk into memory.
+long CFileSystem::getFileMappingThreshold() const
+{
+	return FileMappingThreshold;
 }
 
 
@@ -173,6 +232,8 @@ IWriteFile* CFileSystem::createAndWriteFile(const io::path& filename, bool appen
 //! Adds an external archive loader to the engine.
 void CFileSystem::addArchiveLoader(IArchiveLoader* loader)
 {
+	CMutexLock lock(Mutex);
+
 	if (!loader)
 		return;
 
@@ -183,12 +244,16 @@ void CFileSystem::addArchiveLoader(IArchiveLoader* loader)
 //! Returns the total number of archive loaders added.
 u32 CFileSystem::getArchiveLoaderCount() const
 {
+	CMutexLock lock(Mutex);
+
 	return ArchiveLoader.size();
 }
 
 //! Gets the archive loader by index.
 IArchiveLoader* CFileSystem::getArchiveLoader(u32 index) const
 {
+	CMutexLock lock(Mutex);
+
 	if (index < ArchiveLoader.size())
 		return ArchiveLoader[index];
 	else
@@ -198,6 +263,8 @@ IArchiveLoader* CFileSystem::getArchiveLoader(u32 index) const
 //! move the hirarchy of the filesystem. moves sourceIndex relative up or down
 bool CFileSystem::moveFileArchive(u32 sourceIndex, s32 relative)
 {
+	CMutexLock lock(Mutex);
+
 	bool r = false;
 	const s32 dest = (s32) sourceIndex + relative;
 	const s32 dir = relative < 0 ? -1 : 1;
@@ -214,6 +281,8 @@ bool CFileSystem::moveFileArchive(u32 sourceIndex, s32 relative)
 		FileArchives[s] = t;
 		r = true;
 	}
+	if (r)
+		ArchiveIndex.setPriorities(FileArchives);
 	return r;
 }
 
@@ -224,6 +293,8 @@ bool CFileSystem::addFileArchive(const io::path& filename, bool ignoreCase,
 			  const core::stringc& password,
 			  IFileArchive** retArchive)
 {
+	CMutexLock lock(Mutex);
+
 	IFileArchive* archive = 0;
 	bool ret = false;
 
@@ -311,6 +382,7 @@ bool CFileSystem::addFileArchive(const io::path& filename, bool ignoreCase,
 	if (archive)
 	{
 		FileArchives.push_back(archive);
+		indexArchive(archive, ignoreCase, ignorePaths);
 		if (password.size())
 			archive->Password=password;
 		if (retArchive)
@@ -325,11 +397,34 @@ bool CFileSystem::addFileArchive(const io::path& filename, bool ignoreCase,
 	return ret;
 }
 
+//! Adds a newly added archive to ArchiveIndex if it is one of ours
+void CFileSystem::indexArchive(IFileArchive* archive, bool ignoreCase, bool ignorePaths)
+{
+	// Archives of other loaders may search their files differently
+	switch (archive->getType())
+	{
+	case EFAT_ZIP:
+	case EFAT_GZIP:
+	case EFAT_FOLDER:
+	case EFAT_PAK:
+	case EFAT_NPK:
+	case EFAT_TAR:
+	case EFAT_WAD:
+		ArchiveIndex.addArchive(archive, ignoreCase, ignorePaths);
+		ArchiveIndex.setPriorities(FileArchives);
+		break;
+	default:
+		break;
+	}
+}
+
 // don't expose!
 bool CFileSystem::changeArchivePassword(const path& filename,
 		const core::stringc& password,
 		IFileArchive** archive)
 {
+	CMutexLock lock(Mutex);
+
 	for (s32 idx = 0; idx < (s32)FileArchives.size(); ++idx)
 	{
 		// TODO: This should go into a path normalization method
@@ -353,6 +448,8 @@ bool CFileSystem::addFileArchive(IReadFile* file, bool ignoreCase,
 		bool ignorePaths, E_FILE_ARCHIVE_TYPE archiveType,
 		const core::stringc& password, IFileArchive** retArchive)
 {
+	CMutexLock lock(Mutex);
+
 	if (!file || archiveType == EFAT_FOLDER)
 		return false;
 
@@ -416,6 +513,7 @@ bool CFileSystem::addFileArchive(IReadFile* file, bool ignoreCase,
 		if (archive)
 		{
 			FileArchives.push_back(archive);
+			indexArchive(archive, ignoreCase, ignorePaths);
 			if (password.size())
 				archive->Password=password;
 			if (retArchive)
@@ -435,6 +533,8 @@ bool CFileSystem::addFileArchive(IReadFile* file, bool ignoreCase,
 //! Adds an archive to the file system.
 bool CFileSystem::addFileArchive(IFileArchive* archive)
 {
+	CMutexLock lock(Mutex);
+
 	if ( archive )
 	{
 		for (u32 i=0; i < FileArchives.size(); ++i)
@@ -457,11 +557,15 @@ bool CFileSystem::addFileArchive(IFileArchive* archive)
 //! removes an archive from the file system.
 bool CFileSystem::removeFileArchive(u32 index)
 {
+	CMutexLock lock(Mutex);
+
 	bool ret = false;
 	if (index < FileArchives.size())
 	{
+		ArchiveIndex.removeArchive(FileArchives[index]);
 		FileArchives[index]->drop();
 		FileArchives.erase(index);
+		ArchiveIndex.setPriorities(FileArchives);
 		ret = true;
 	}
 	return ret;
@@ -471,6 +575,8 @@ bool CFileSystem::removeFileArchive(u32 index)
 //! removes an archive from the file system.
 bool CFileSystem::removeFileArchive(const io::path& filename)
 {
+	CMutexLock lock(Mutex);
+
 	const path absPath = getAbsolutePath(filename);
 	for (u32 i=0; i < FileArchives.size(); ++i)
 	{
@@ -484,6 +590,8 @@ bool CFileSystem::removeFileArchive(const io::path& filename)
 //! Removes an archive from the file system.
 bool CFileSystem::removeFileArchive(const IFileArchive* archive)
 {
+	CMutexLock lock(Mutex);
+
 	for (u32 i=0; i < FileArchives.size(); ++i)
 	{
 		if (archive == FileArchives[i])
@@ -498,12 +606,16 @@ bool CFileSystem::removeFileArchive(const IFileArchive* archive)
 //! gets an archive
 u32 CFileSystem::getFileArchiveCount() const
 {
+	CMutexLock lock(Mutex);
+
 	return FileArchives.size();
 }
 
 
 IFileArchive* CFileSystem::getFileArchive(u32 index)
 {
+	CMutexLock lock(Mutex);
+
 	return index < getFileArchiveCount() ? FileArchives[index] : 0;
 }
 
@@ -511,6 +623,8 @@ IFileArchive* CFileSystem::getFileArchive(u32 index)
 //! Returns the string of the current working directory
 const io::path& CFileSystem::getWorkingDirectory()
 {
+	CMutexLock lock(Mutex);
+
 	EFileSystemType type = FileSystemType;
 
 	if (type != FILESYSTEM_NATIVE)
@@ -579,6 +693,8 @@ const io::path& CFileSystem::getWorkingDirectory()
 //! Changes the current Working Directory to the given string.
 bool CFileSystem::changeWorkingDirectoryTo(const io::path& newDirectory)
 {
+	CMutexLock lock(Mutex);
+
 	bool success=false;
 
 	if (FileSystemType != FILESYSTEM_NATIVE)
@@ -819,6 +935,8 @@ path CFileSystem::getRelativeFilename(const path& filename, const path& director
 //! Sets the current file systen type
 EFileSystemType CFileSystem::setFileListSystem(EFileSystemType listType)
 {
+	CMutexLock lock(Mutex);
+
 	EFileSystemType current = FileSystemType;
 	FileSystemType = listType;
 	return current;
@@ -828,6 +946,8 @@ EFileSystemType CFileSystem::setFileListSystem(EFileSystemType listType)
 //! Creates a list of files and directories in the current working directory
 IFileList* CFileSystem::createFileList()
 {
+	CMutexLock lock(Mutex);
+
 	CFileList* r = 0;
 	io::path Path = getWorkingDirectory();
 	Path.replace('\\', '/');
@@ -959,9 +1079,22 @@ IFileList* CFileSystem::createEmptyFileList(const io::path& path, bool ignoreCas
 //! determines if a file exists and would be able to be opened.
 bool CFileSystem::existFile(const io::path& filename) const
 {
-	for (u32 i=0; i < FileArchives.size(); ++i)
-		if (FileArchives[i]->getFileList()->findFile(filename)!=-1)
+	CMutexLock lock(Mutex);
+
+	IFileArchive* archive = 0;
+	u32 index = 0;
+	if (ArchiveIndex.getArchiveCount() == FileArchives.size() &&
+		ArchiveIndex.findFile(filename, archive, index))
+	{
+		if (archive)
 			return true;
+	}
+	else
+	{
+		for (u32 i=0; i < FileArchives.size(); ++i)
+			if (FileArchives[i]->getFileList()->findFile(filename)!=-1)
+				return true;
+	}
 
 #if defined(_MSC_VER)
 	#if defined(_IRR_WCHAR_FILESYSTEM)
@@ -7,6 +7,8 @@
 
 #include "IFileSystem.h"
 #include "irrArray.h"
+#include "CThread.h"
+#include "CFileIndex.h"
 
 namespace irr
 {
@@ -33,6 +35,12 @@ public:
 	//! opens a file for read access
 	virtual IReadFile* createAndOpenFile(const io::path& filename) IRR_OVERRIDE;
 
+	//! Set from which size on createAndOpenFile() maps files on disk into memory.
+	virtual void setFileMappingThreshold(long size) IRR_OVERRIDE;
+
+	//! Get from which size on createAndOpenFile() maps files on disk into memory.
+	virtual long getFileMappingThreshold() const IRR_OVERRIDE;
+
 	//! Creates an IReadFile interface for accessing memory like a file.
 	virtual IReadFile* createMemoryReadFile(const void* memory, s32 len, const io::path& fileName, bool deleteMemoryWhenDropped = false) IRR_OVERRIDE;
 
@@ -161,6 +169,9 @@ private:
 			const core::stringc& password,
 			IFileArchive** archive = 0);
 
+	//! Adds a newly added archive to ArchiveIndex if it is one of ours
+	void indexArchive(IFileArchive* archive, bool ignoreCase, bool ignorePaths);
+
 	//! Currently used FileSystemType
 	EFileSystemType FileSystemType;
 	//! WorkingDirectory for Native and Virtual filesystems
@@ -169,6 +180,12 @@ private:
 	core::array<IArchiveLoader*> ArchiveLoader;
 	//! currently attached Archives
 	core::array<IFileArchive*> FileArchives;
+	//! Files of the archives which createAndOpenFile() can find without asking each archive
+	CFileIndex ArchiveIndex;
+	//! Files on disk with at least this size are mapped, 0 for none
+	long FileMappingThreshold;
+	//! Guards the archives, archive loaders and working directories
+	mutable CMutex Mutex;
 };
 
 
@@ -0,0 +1,108 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_C_IMAGE_DATA_READER_H_INCLUDED
+#define IRR_C_IMAGE_DATA_READER_H_INCLUDED
+
+#include "IMemoryReadFile.h"
+#include "irrMath.h"
+#include <string.h>
+
+namespace irr
+{
+namespace video
+{
+
+//! Reads the pixel data of an image file for loaders which decode while reading
+/** Memory and mapped files are read in place, other files in blocks. So the
+loaders can decode into the image directly without a copy of the whole file. */
+class CImageDataReader
+{
+public:
+
+	//! Constructor, starts at the current position of the file
+	explicit CImageDataReader(io::IReadFile* file)
+		: File(file), Buffer(0), BufferSize(0), Pos(0), End(0)
+	{
+		if (file->getType() == io::ERFT_MEMORY_READ_FILE || file->getType() == io::ERFT_MAPPED_READ_FILE)
+		{
+			const long pos = file->getPos();
+			const long size = file->getSize();
+			Pos = (const u8*)static_cast<io::IMemoryReadFile*>(file)->getBuffer() + pos;
+			End = Pos + (size > pos ? size - pos : 0);
+			File = 0; // all data is available
+		}
+	}
+
+	//! Destructor
+	~CImageDataReader()
+	{
+		delete [] Buffer;
+	}
+
+	//! Returns the next count bytes
+	/** The pointer is valid until the next call.
+	\return 0 if the file has less than count bytes left. */
+	const u8* read(u32 count)
+	{
+		if ((u32)(End - Pos) < count && !fill(count))
+			return 0;
+		const u8* p = Pos;
+		Pos += count;
+		return p;
+	}
+
+	//! Reads the next byte
+	/** \return false at the end of the file. */
+	bool read(u8& value)
+	{
+		if (Pos == End && !fill(1))
+			return false;
+		value = *Pos++;
+		return true;
+	}
+
+private:
+
+	//! Size of the blocks read from files which are not in memory
+	enum { BlockSize = 64*1024 };
+
+	//! Moves the unread bytes to the start of the buffer and reads more
+	bool fill(u32 count)
+	{
+		if (!File)
+			return false;
+
+		const u32 left = (u32)(End - Pos);
+		const u32 size = core::max_((u32)BlockSize, count);
+		if (size > BufferSize)
+		{
+			u8* buffer = new u8[size];
+			memcpy(buffer, Pos, left);
+			delete [] Buffer;
+			Buffer = buffer;
+			BufferSize = size;
+		}
+		else
+			memmove(Buffer, Pos, left);
+
+		const size_t bytesRead = File->read(Buffer + left, BufferSize - left);
+		if (bytesRead < BufferSize - left)
+			File = 0; // end of the file
+		Pos = Buffer;
+		End = Buffer + left + bytesRead;
+		return (u32)(End - Pos) >= count;
+	}
+
+	io::IReadFile* File; // 0 when there is nothing more to read
+	u8* Buffer;
+	u32 BufferSize;
+	const u8* Pos;
+	const u8* End;
+};
+
+} // end namespace video
+} // end namespace irr
+
+#endif
@@ -12,208 +12,177 @@
 #include "CImage.h"
 #include "os.h"
 #include "irrString.h"
+#include "CImageDataReader.h"
 
 namespace irr
 {
 namespace video
 {
 
-
-//! constructor
-CImageLoaderBMP::CImageLoaderBMP()
+namespace
 {
-	#ifdef _DEBUG
-	setDebugName("CImageLoaderBMP");
-	#endif
-}
-
 
-//! returns true if the file maybe is able to be loaded by this class
-//! based on the file extension (e.g. ".tga")
-bool CImageLoaderBMP::isALoadableFileExtension(const io::path& filename) const
+//! Converts one row of uncompressed pixels into the format of the image
+void convertRow(const u8* in, u8* out, u32 width, u32 bpp, const s32* palette)
 {
-	return core::hasFileExtension ( filename, "bmp" );
+	switch(bpp)
+	{
+	case 1:
+		CColorConverter::convert1BitTo16Bit(in, (s16*)out, width, 1);
+		break;
+	case 4:
+		CColorConverter::convert4BitTo16Bit(in, (s16*)out, width, 1, palette);
+		break;
+	case 8:
+		CColorConverter::convert8BitTo16Bit(in, (s16*)out, width, 1, palette);
+		break;
+	case 16:
+		CColorConverter::convert16BitTo16Bit((const s16*)in, (s16*)out, width, 1);
+		break;
+	case 24:
+		CColorConverter::convert24BitTo24Bit(in, out, width, 1, 0, false, true);
+		break;
+	case 32: // thx to Reinhard Ostermeier
+		CColorConverter::convert32BitTo32Bit((const s32*)in, (s32*)out, width, 1, 0);
+		break;
+	}
 }
 
-
-//! returns true if the file maybe is able to be loaded by this class
-bool CImageLoaderBMP::isALoadableFileFormat(io::IReadFile* file) const
+//! Sets the pixels from x,y up to toX,toY of a A1R5G5B5 image to a color
+/** Used for the pixels skipped by run length encoded bitmaps. */
+void fillGap(u8* const* rows, u32 width, u32 height, u32 x, u32 y, u32 toX, u32 toY, u16 color)
 {
-	u16 headerID;
-	file->read(&headerID, sizeof(u16));
-#ifdef __BIG_ENDIAN__
-	headerID = os::Byteswap::byteswap(headerID);
-#endif
-	return headerID == 0x4d42;
+	for (; y<=toY && y<height; ++y, x=0)
+	{
+		const u32 end = y < toY ? width : core::min_(toX, width);
+		u16* out = (u16*)rows[y];
+		for (; x<end; ++x)
+			out[x] = color;
+	}
 }
 
-
-void CImageLoaderBMP::decompress8BitRLE(u8*& bmpData, s32 size, s32 width, s32 height, s32 pitch) const
+//! Decodes 4 or 8 bit run length encoded indices straight into a A1R5G5B5 image
+/** \param rows Image rows in the order of the file.
+\return false if the file ended before the end of the bitmap. */
+bool decompressRLE(CImageDataReader& reader, u8* const* rows, u32 width, u32 height, u32 bpp, const u16* palette)
 {
-	u8* p = bmpData;
-	u8* newBmp = new u8[(width+pitch)*height];
-	u8* d = newBmp;
-	u8* destEnd = newBmp + (width+pitch)*height;
-	s32 line = 0;
-
-	while (bmpData - p < size && d < destEnd)
+	// skipped pixels get the first color
+	u32 x = 0;
+	u32 y = 0;
+	while (y < height)
 	{
-		if (*p == 0)
+		const u8* p = reader.read(2);
+		if (!p)
 		{
-			++p;
-
-			switch(*p)
-			{
-			case 0: // end of line
-				++p;
-				++line;
-				d = newBmp + (line*(width+pitch));
-				break;
-			case 1: // end of bmp
-				delete [] bmpData;
-				bmpData = newBmp;
-				return;
-			case 2:
-				++p; d +=(u8)*p;  // delta
-				++p; d += ((u8)*p)*(width+pitch);
-				++p;
-				break;
-			default:
-				{
-					// absolute mode
-					s32 count = (u8)*p; ++p;
-					s32 readAdditional = ((2-(count%2))%2);
-					s32 i;
-
-					for (i=0; i<count; ++i)
-					{
-						*d = *p;
-						++p;
-						++d;
-					}
-
-					for (i=0; i<readAdditional; ++i)
-						++p;
-				}
-			}
+			fillGap(rows, width, height, x, y, 0, height, palette[0]);
+			return false;
 		}
-		else
+
+		if (p[0])
 		{
-			s32 count = (u8)*p; ++p;
-			u8 color = *p; ++p;
-			for (s32 i=0; i<count; ++i)
+			// run of 1 or 2 alternating colors
+			const u32 count = core::min_((u32)p[0], width > x ? width - x : 0);
+			const u16 color1 = palette[bpp == 8 ? p[1] : p[1] >> 4];
+			const u16 color2 = palette[bpp == 8 ? p[1] : p[1] & 0x0f];
+			u16* out = (u16*)rows[y] + x;
+			for (u32 i=0; i+1<count; i+=2)
 			{
-				*d = color;
-				++d;
+				out[i] = color1;
+				out[i+1] = color2;
 			}
+			if (count & 1)
+				out[count-1] = color1;
+			x += p[0];
+			continue;
 		}
-	}
-
-	delete [] bmpData;
-	bmpData = newBmp;
-}
 
-
-void CImageLoaderBMP::decompress4BitRLE(u8*& bmpData, s32 size, s32 width, s32 height, s32 pitch) const
-{
-	s32 lineWidth = (width+1)/2+pitch;
-	u8* p = bmpData;
-	u8* newBmp = new u8[lineWidth*height];
-	u8* d = newBmp;
-	u8* destEnd = newBmp + lineWidth*height;
-	s32 line = 0;
-	s32 shift = 4;
-
-	while (bmpData - p < size && d < destEnd)
-	{
-		if (*p == 0)
+		switch(p[1])
 		{
-			++p;
-
-			switch(*p)
+		case 0: // end of line
+			fillGap(rows, width, height, x, y, 0, y+1, palette[0]);
+			x = 0;
+			++y;
+			break;
+		case 1: // end of bmp
+			fillGap(rows, width, height, x, y, 0, height, palette[0]);
+			return true;
+		case 2: // delta
 			{
-			case 0: // end of line
-				++p;
-				++line;
-				d = newBmp + (line*lineWidth);
-				shift = 4;
-				break;
-			case 1: // end of bmp
-				delete [] bmpData;
-				bmpData = newBmp;
-				return;
-			case 2:
+				const u8* delta = reader.read(2);
+				if (!delta)
 				{
-					++p;
-					s32 x = (u8)*p; ++p;
-					s32 y = (u8)*p; ++p;
-					d += x/2 + y*lineWidth;
-					shift = x%2==0 ? 4 : 0;
-				}
-				break;
-			default:
-				{
-					// absolute mode
-					s32 count = (u8)*p; ++p;
-					s32 readAdditional = ((2-((count)%2))%2);
-					s32 readShift = 4;
-					s32 i;
-
-					for (i=0; i<count; ++i)
-					{
-						s32 color = (((u8)*p) >> readShift) & 0x0f;
-						readShift -= 4;
-						if (readShift < 0)
-						{
-							++*p;
-							readShift = 4;
-						}
-
-						u8 mask = 0x0f << shift;
-						*d = (*d & (~mask)) | ((color << shift) & mask);
-
-						shift -= 4;
-						if (shift < 0)
-						{
-							shift = 4;
-							++d;
-						}
-
-					}
-
-					for (i=0; i<readAdditional; ++i)
-						++p;
+					fillGap(rows, width, height, x, y, 0, height, palette[0]);
+					return false;
 				}
+				fillGap(rows, width, height, x, y, x + delta[0], y + delta[1], palette[0]);
+				x += delta[0];
+				y += delta[1];
 			}
-		}
-		else
-		{
-			s32 count = (u8)*p; ++p;
-			s32 color1 = (u8)*p; color1 = color1 & 0x0f;
-			s32 color2 = (u8)*p; color2 = (color2 >> 4) & 0x0f;
-			++p;
-
-			for (s32 i=0; i<count; ++i)
+			break;
+		default:
 			{
-				u8 mask = 0x0f << shift;
-				u8 toSet = (shift==0 ? color1 : color2) << shift;
-				*d = (*d & (~mask)) | (toSet & mask);
+				// absolute mode, padded to 2 bytes
+				const u32 count = p[1];
+				const u32 bytes = bpp == 8 ? count : (count+1)/2;
+				const u8* in = reader.read((bytes+1) & ~1);
+				if (!in)
+				{
+					fillGap(rows, width, height, x, y, 0, height, palette[0]);
+					return false;
+				}
 
-				shift -= 4;
-				if (shift < 0)
+				const u32 visible = core::min_(count, width > x ? width - x : 0);
+				u16* out = (u16*)rows[y] + x;
+				if (bpp == 8)
+				{
+					for (u32 i=0; i<visible; ++i)
+						out[i] = palette[in[i]];
+				}
+				else
 				{
-					shift = 4;
-					++d;
+					for (u32 i=0; i<visible; ++i)
+						out[i] = palette[(in[i/2] >> (i&1 ? 0 : 4)) & 0x0f];
 				}
+				x += count;
 			}
+			break;
 		}
 	}
+	return true;
+}
+
+} // end anonymous namespace
+
 
-	delete [] bmpData;
-	bmpData = newBmp;
+
+//! constructor
+CImageLoaderBMP::CImageLoaderBMP()
+{
+	#ifdef _DEBUG
+	setDebugName("CImageLoaderBMP");
+	#endif
+}
+
+
+//! returns true if the file maybe is able to be loaded by this class
+//! based on the file extension (e.g. ".tga")
+bool CImageLoaderBMP::isALoadableFileExtension(const io::path& filename) const
+{
+	return core::hasFileExtension ( filename, "bmp" );
 }
 
 
+//! returns true if the file maybe is able to be loaded by this class
+bool CImageLoaderBMP::isALoadableFileFormat(io::IReadFile* file) const
+{
+	u16 headerID;
+	file->read(&headerID, sizeof(u16));
+#ifdef __BIG_ENDIAN__
+	headerID = os::Byteswap::byteswap(headerID);
+#endif
+	return headerID == 0x4d42;
+}
+
 
 //! creates a surface from the file
 IImage* CImageLoaderBMP::loadImage(io::IReadFile* file) const
@@ -239,8 +208,6 @@ IImage* CImageLoaderBMP::loadImage(io::IReadFile* file) const
 	header.ImportantColors = os::Byteswap::byteswap(header.ImportantColors);
 #endif
 
-	s32 pitch = 0;
-
 	//! return if the header is false
 
 	if (header.Id != 0x4d42)
@@ -252,105 +219,99 @@ IImage* CImageLoaderBMP::loadImage(io::IReadFile* file) const
 		return 0;
 	}
 
-	// adjust bitmap data size to dword boundary
-	header.BitmapDataSize += (4-(header.BitmapDataSize%4))%4;
+	ECOLOR_FORMAT format;
+	switch(header.BPP)
+	{
+	case 1:
+	case 4:
+	case 8:
+	case 16:
+		format = ECF_A1R5G5B5;
+		break;
+	case 24:
+		format = ECF_R8G8B8;
+		break;
+	case 32:
+		format = ECF_A8R8G8B8;
+		break;
+	default:
+		os::Printer::log("Unsupported bits per pixel in BMP file.", file->getFileName(), ELL_ERROR);
+		return 0;
+	}
+
+	if ((header.Compression == 1 && header.BPP != 8) || (header.Compression == 2 && header.BPP != 4))
+	{
+		os::Printer::log("Unsupported bits per pixel for RLE in BMP file.", file->getFileName(), ELL_ERROR);
+		return 0;
+	}
 
-	// read palette
+	// read palette, indices outside of it are black
 
-	long pos = file->getPos();
-	s32 paletteSize = (header.BitmapDataOffset - pos) / 4;
+	s32 paletteData[256];
+	memset(paletteData, 0, sizeof(paletteData));
 
-	s32* paletteData = 0;
+	const long pos = file->getPos();
+	const s32 paletteSize = header.BitmapDataOffset > pos ? (s32)(header.BitmapDataOffset - pos) / 4 : 0;
 	if (paletteSize)
 	{
-		paletteData = new s32[paletteSize];
-		file->read(paletteData, paletteSize * sizeof(s32));
+		file->read(paletteData, core::min_(paletteSize, 256) * sizeof(s32));
 #ifdef __BIG_ENDIAN__
-		for (s32 i=0; i<paletteSize; ++i)
+		for (s32 i=0; i<256; ++i)
 			paletteData[i] = os::Byteswap::byteswap(paletteData[i]);
 #endif
 	}
 
-	// read image data
-
-	if (!header.BitmapDataSize)
-	{
-		// okay, lets guess the size
-		// some tools simply don't set it
-		header.BitmapDataSize = static_cast<u32>(file->getSize()) - header.BitmapDataOffset;
-	}
+	// decode the rows straight into the image, they are stored from the bottom up
 
 	file->seek(header.BitmapDataOffset);
 
-	f32 t = (header.Width) * (header.BPP / 8.0f);
-	s32 widthInBytes = (s32)t;
-	t -= widthInBytes;
-	if (t!=0.0f)
-		++widthInBytes;
-
-	s32 lineData = widthInBytes + ((4-(widthInBytes%4)))%4;
-	pitch = lineData - widthInBytes;
-
-	u8* bmpData = new u8[header.BitmapDataSize];
-	file->read(bmpData, header.BitmapDataSize);
-
-	// decompress data if needed
-	switch(header.Compression)
-	{
-	case 1: // 8 bit rle
-		decompress8BitRLE(bmpData, header.BitmapDataSize, header.Width, header.Height, pitch);
-		break;
-	case 2: // 4 bit rle
-		decompress4BitRLE(bmpData, header.BitmapDataSize, header.Width, header.Height, pitch);
-		break;
-	}
-
-	// create surface
-
 	// no default constructor from packed area! ARM problem!
 	core::dimension2d<u32> dim;
 	dim.Width = header.Width;
 	dim.Height = header.Height;
 
-	IImage* image = 0;
-	switch(header.BPP)
+	IImage* image = new CImage(format, dim);
+	u8* data = (u8*)image->getData();
+	const u32 pitch = image->getPitch();
+
+	core::array<u8*> rows;
+	rows.set_used(dim.Height);
+	for (u32 y=0; y<dim.Height; ++y)
+		rows[y] = data + (dim.Height-1-y) * pitch;
+
+	CImageDataReader reader(file);
+	bool complete = true;
+	if (header.Compression)
 	{
-	case 1:
-		image = new CImage(ECF_A1R5G5B5, dim);
-		if (image)
-			CColorConverter::convert1BitTo16Bit(bmpData, (s16*)image->getData(), header.Width, header.Height, pitch, true);
-		break;
-	case 4:
-		image = new CImage(ECF_A1R5G5B5, dim);
-		if (image)
-			CColorConverter::convert4BitTo16Bit(bmpData, (s16*)image->getData(), header.Width, header.Height, paletteData, pitch, true);
-		break;
-	case 8:
-		image = new CImage(ECF_A1R5G5B5, dim);
-		if (image)
-			CColorConverter::convert8BitTo16Bit(bmpData, (s16*)image->getData(), header.Width, header.Height, paletteData, pitch, true);
-		break;
-	case 16:
-		image = new CImage(ECF_A1R5G5B5, dim);
-		if (image)
-			CColorConverter::convert16BitTo16Bit((s16*)bmpData, (s16*)image->getData(), header.Width, header.Height, pitch, true);
-		break;
-	case 24:
-		image = new CImage(ECF_R8G8B8, dim);
-		if (image)
-			CColorConverter::convert24BitTo24Bit(bmpData, (u8*)image->getData(), header.Width, header.Height, pitch, true, true);
-		break;
-	case 32: // thx to Reinhard Ostermeier
-		image = new CImage(ECF_A8R8G8B8, dim);
-		if (image)
-			CColorConverter::convert32BitTo32Bit((s32*)bmpData, (s32*)image->getData(), header.Width, header.Height, pitch, true);
-		break;
-	};
+		u16 palette[256];
+		for (u32 i=0; i<256; ++i)
+			palette[i] = X8R8G8B8toA1R5G5B5(paletteData[i]);
 
-	// clean up
+		complete = decompressRLE(reader, rows.pointer(), dim.Width, dim.Height, header.BPP, palette);
+	}
+	else
+	{
+		// lines are padded to 4 bytes
+		const u32 widthInBytes = (dim.Width * header.BPP + 7) / 8;
+		const u32 lineData = (widthInBytes + 3) & ~3;
+
+		for (u32 y=0; y<dim.Height; ++y)
+		{
+			// the last line may miss its padding
+			const u8* in = reader.read(y+1 < dim.Height ? lineData : widthInBytes);
+			if (!in)
+			{
+				for (; y<dim.Height; ++y)
+					memset(rows[y], 0, pitch);
+				complete = false;
+				break;
+			}
+			convertRow(in, rows[y], dim.Width, header.BPP, paletteData);
+		}
+	}
 
-	delete [] paletteData;
-	delete [] bmpData;
+	if (!complete)
+		os::Printer::log("BMP file is too short", file->getFileName(), ELL_WARNING);
 
 	return image;
 }
@@ -83,11 +83,11 @@ public:
 	//! creates a surface from the file
 	virtual IImage* loadImage(io::IReadFile* file) const IRR_OVERRIDE;
 
-private:
-
-	void decompress8BitRLE(u8*& BmpData, s32 size, s32 width, s32 height, s32 pitch) const;
-
-	void decompress4BitRLE(u8*& BmpData, s32 size, s32 width, s32 height, s32 pitch) const;
+	//! Images can be loaded on worker threads, the loader has no state
+	virtual bool isThreadSafe() const IRR_OVERRIDE
+	{
+		return true;
+	}
 };
 
 
@@ -6,7 +6,7 @@
 
 #ifdef _IRR_COMPILE_WITH_JPG_LOADER_
 
-#include "IReadFile.h"
+#include "IMemoryReadFile.h"
 #include "CImage.h"
 #include "os.h"
 #include "irrString.h"
@@ -135,6 +135,20 @@ bool CImageLoaderJPG::isALoadableFileFormat(io::IReadFile* file) const
 
 //! creates a surface from the file
 IImage* CImageLoaderJPG::loadImage(io::IReadFile* file) const
+{
+	return decode(file, 0);
+}
+
+
+//! creates a surface from the file, reduced by the scaling of libjpeg
+IImage* CImageLoaderJPG::loadReducedImage(io::IReadFile* file, const core::dimension2d<u32>& maxSize) const
+{
+	return decode(file, &maxSize);
+}
+
+
+//! decodes the file, reduced to fit into maxSize if it isn't 0
+IImage* CImageLoaderJPG::decode(io::IReadFile* file, const core::dimension2d<u32>* maxSize) const
 {
 	#ifndef _IRR_COMPILE_WITH_LIBJPEG_
 	os::Printer::log("Can't load as not compiled with _IRR_COMPILE_WITH_LIBJPEG_:", file->getFileName(), ELL_DEBUG);
@@ -147,8 +161,24 @@ IImage* CImageLoaderJPG::loadImage(io::IReadFile* file) const
 	core::stringc filename = file->getFileName();
 
 	u8 **rowPtr=0;
-	u8* input = new u8[file->getSize()];
-	file->read(input, file->getSize());
+	u8* cmykRow=0;
+	IImage* image=0;
+
+	// files in memory are decoded in place
+	long inputSize = file->getSize();
+	u8* inputCopy = 0;
+	const u8* input = 0;
+	if (file->getType() == io::ERFT_MEMORY_READ_FILE || file->getType() == io::ERFT_MAPPED_READ_FILE)
+	{
+		input = (const u8*)static_cast<io::IMemoryReadFile*>(file)->getBuffer() + file->getPos();
+		inputSize -= file->getPos();
+	}
+	else
+	{
+		inputCopy = new u8[inputSize];
+		file->read(inputCopy, inputSize);
+		input = inputCopy;
+	}
 
 	// allocate and initialize JPEG decompression object
 	struct jpeg_decompress_struct cinfo;
@@ -174,8 +204,11 @@ IImage* CImageLoaderJPG::loadImage(io::IReadFile* file) const
 
 		jpeg_destroy_decompress(&cinfo);
 
-		delete [] input;
+		delete [] inputCopy;
 		delete [] rowPtr;
+		delete [] cmykRow;
+		if (image)
+			image->drop();
 
 		// return null pointer
 		return 0;
@@ -188,8 +221,8 @@ IImage* CImageLoaderJPG::loadImage(io::IReadFile* file) const
 	jpeg_source_mgr jsrc;
 
 	// Set up data pointer
-	jsrc.bytes_in_buffer = file->getSize();
-	jsrc.next_input_byte = (JOCTET*)input;
+	jsrc.bytes_in_buffer = inputSize;
+	jsrc.next_input_byte = (const JOCTET*)input;
 	cinfo.src = &jsrc;
 
 	jsrc.init_source = init_source;
@@ -221,31 +254,76 @@ IImage* CImageLoaderJPG::loadImage(io::IReadFile* file) const
 	cinfo.output_gamma=2.2;
 	cinfo.do_fancy_upsampling=FALSE;
 
+	// The inverse DCT can scale by n/8, libjpeg before version 7 only by
+	// 1/1, 1/2, 1/4 and 1/8. Take the largest scale which makes the image fit.
+	if (maxSize)
+	{
+#if JPEG_LIB_VERSION >= 70
+		cinfo.scale_denom = DCTSIZE;
+		for (cinfo.scale_num = DCTSIZE; cinfo.scale_num > 1; --cinfo.scale_num)
+#else
+		cinfo.scale_num = 1;
+		for (cinfo.scale_denom = 1; cinfo.scale_denom < 8; cinfo.scale_denom *= 2)
+#endif
+		{
+			jpeg_calc_output_dimensions(&cinfo);
+			if (cinfo.output_width <= maxSize->Width && cinfo.output_height <= maxSize->Height)
+				break;
+		}
+	}
+
 	// Start decompressor
 	jpeg_start_decompress(&cinfo);
 
 	// Get image data
-	u16 rowspan = cinfo.image_width * cinfo.out_color_components;
-	u32 width = cinfo.image_width;
-	u32 height = cinfo.image_height;
+	const u32 width = cinfo.output_width;
+	const u32 height = cinfo.output_height;
 
-	// Allocate memory for buffer
-	u8* output = new u8[rowspan * height];
+	// decode straight into the image
+	image = new CImage(ECF_R8G8B8, core::dimension2d<u32>(width, height));
+	u8* data = (u8*)image->getData();
+
+	if (useCMYK)
+	{
+		// convert one row at a time
+		cmykRow = new u8[4*width];
+		while( cinfo.output_scanline < cinfo.output_height )
+		{
+			u8* out = data + cinfo.output_scanline * 3*width;
+			jpeg_read_scanlines( &cinfo, &cmykRow, 1 );
+			for (u32 i=0,j=0; i<3*width; i+=3, j+=4)
+			{
+				// Also works without K, but has more contrast with K multiplied in
+//				out[i+0] = cmykRow[j+2];
+//				out[i+1] = cmykRow[j+1];
+//				out[i+2] = cmykRow[j+0];
+				out[i+0] = (char)(cmykRow[j+2]*(cmykRow[j+3]/255.f));
+				out[i+1] = (char)(cmykRow[j+1]*(cmykRow[j+3]/255.f));
+				out[i+2] = (char)(cmykRow[j+0]*(cmykRow[j+3]/255.f));
+			}
+		}
+		delete [] cmykRow;
+		cmykRow = 0;
+	}
+	else
+	{
+		// Here we use the library's state variable cinfo.output_scanline as the
+		// loop counter, so that we don't have to keep track ourselves.
+		// Create array of row pointers for lib
+		rowPtr = new u8* [height];
 
-	// Here we use the library's state variable cinfo.output_scanline as the
-	// loop counter, so that we don't have to keep track ourselves.
-	// Create array of row pointers for lib
-	rowPtr = new u8* [height];
+		for( u32 i = 0; i < height; i++ )
+			rowPtr[i] = &data[ i * 3*width ];
 
-	for( u32 i = 0; i < height; i++ )
-		rowPtr[i] = &output[ i * rowspan ];
+		u32 rowsRead = 0;
 
-	u32 rowsRead = 0;
+		while( cinfo.output_scanline < cinfo.output_height )
+			rowsRead += jpeg_read_scanlines( &cinfo, &rowPtr[rowsRead], cinfo.output_height - rowsRead );
 
-	while( cinfo.output_scanline < cinfo.output_height )
-		rowsRead += jpeg_read_scanlines( &cinfo, &rowPtr[rowsRead], cinfo.output_height - rowsRead );
+		delete [] rowPtr;
+		rowPtr = 0;
+	}
 
-	delete [] rowPtr;
 	// Finish decompression
 
 	jpeg_finish_decompress(&cinfo);
@@ -254,34 +332,7 @@ IImage* CImageLoaderJPG::loadImage(io::IReadFile* file) const
 	// This is an important step since it will release a good deal of memory.
 	jpeg_destroy_decompress(&cinfo);
 
-	// convert image
-	IImage* image = 0;
-	if (useCMYK)
-	{
-		image = new CImage(ECF_R8G8B8,
-				core::dimension2d<u32>(width, height));
-		const u32 size = 3*width*height;
-		u8* data = (u8*)image->getData();
-		if (data)
-		{
-			for (u32 i=0,j=0; i<size; i+=3, j+=4)
-			{
-				// Also works without K, but has more contrast with K multiplied in
-//				data[i+0] = output[j+2];
-//				data[i+1] = output[j+1];
-//				data[i+2] = output[j+0];
-				data[i+0] = (char)(output[j+2]*(output[j+3]/255.f));
-				data[i+1] = (char)(output[j+1]*(output[j+3]/255.f));
-				data[i+2] = (char)(output[j+0]*(output[j+3]/255.f));
-			}
-		}
-		delete [] output;
-	}
-	else
-		image = new CImage(ECF_R8G8B8,
-				core::dimension2d<u32>(width, height), output);
-
-	delete [] input;
+	delete [] inputCopy;
 
 	return image;
 
@@ -51,8 +51,20 @@ public:
 	//! creates a surface from the file
 	virtual IImage* loadImage(io::IReadFile* file) const IRR_OVERRIDE;
 
+	//! creates a surface from the file, reduced by the scaling of libjpeg
+	virtual IImage* loadReducedImage(io::IReadFile* file, const core::dimension2d<u32>& maxSize) const IRR_OVERRIDE;
+
+	//! Images can be loaded on worker threads, the decoder state and the error handler jump buffer are local to each call
+	virtual bool isThreadSafe() const IRR_OVERRIDE
+	{
+		return true;
+	}
+
 private:
 
+	//! decodes the file, reduced to fit into maxSize if it isn't 0
+	IImage* decode(io::IReadFile* file, const core::dimension2d<u32>* maxSize) const;
+
 #ifdef _IRR_COMPILE_WITH_LIBJPEG_
 	// several methods used via function pointers by jpeglib
 
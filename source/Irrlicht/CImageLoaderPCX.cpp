@@ -12,6 +12,7 @@
 #include "CImage.h"
 #include "os.h"
 #include "irrString.h"
+#include "CImageDataReader.h"
 
 
 namespace irr
@@ -51,7 +52,6 @@ bool CImageLoaderPCX::isALoadableFileFormat(io::IReadFile* file) const
 IImage* CImageLoaderPCX::loadImage(io::IReadFile* file) const
 {
 	SPCXHeader header;
-	s32* paletteData = 0;
 
 	file->read(&header, sizeof(header));
 	#ifdef __BIG_ENDIAN__
@@ -72,15 +72,28 @@ IImage* CImageLoaderPCX::loadImage(io::IReadFile* file) const
 		return 0;
 
 	// return if this isn't a supported type
-	if ((header.BitsPerPixel != 8) && (header.BitsPerPixel != 4) && (header.BitsPerPixel != 1))
+	const u32 bpp = header.BitsPerPixel;
+	if (!((bpp == 8 && (header.Planes == 1 || header.Planes == 3)) ||
+		(bpp == 4 && header.Planes == 1) ||
+		(bpp == 1 && (header.Planes == 1 || header.Planes == 4))))
 	{
 		os::Printer::log("Unsupported bits per pixel in PCX file.",
 			file->getFileName(), irr::ELL_WARNING);
 		return 0;
 	}
 
-	// read palette
-	if( (header.BitsPerPixel == 8) && (header.Planes == 1) )
+	const s32 width = header.XMax - header.XMin + 1;
+	const s32 height = header.YMax - header.YMin + 1;
+	if (width <= 0 || height <= 0 || header.BytesPerLine * 8 < width * bpp)
+	{
+		os::Printer::log("Invalid size in PCX file.", file->getFileName(), irr::ELL_WARNING);
+		return 0;
+	}
+
+	// read palette, indices outside of it are black
+	s32 paletteData[256];
+	memset(paletteData, 0, sizeof(paletteData));
+	if( (bpp == 8) && (header.Planes == 1) )
 	{
 		// the palette indicator (usually a 0x0c is found infront of the actual palette data)
 		// is ignored because some exporters seem to forget to write it. This would result in
@@ -88,8 +101,7 @@ IImage* CImageLoaderPCX::loadImage(io::IReadFile* file) const
 		const long pos = file->getPos();
 		file->seek( file->getSize()-256*3, false );
 
-		u8 *tempPalette = new u8[768];
-		paletteData = new s32[256];
+		u8 tempPalette[768];
 		file->read( tempPalette, 768 );
 
 		for( s32 i=0; i<256; i++ )
@@ -100,13 +112,10 @@ IImage* CImageLoaderPCX::loadImage(io::IReadFile* file) const
 					(tempPalette[i*3+2]));
 		}
 
-		delete [] tempPalette;
-
 		file->seek(pos);
 	}
-	else if( header.BitsPerPixel == 4 )
+	else if( bpp*header.Planes == 4 )
 	{
-		paletteData = new s32[16];
 		for( s32 i=0; i<16; i++ )
 		{
 			paletteData[i] = (0xff000000 |
@@ -116,99 +125,92 @@ IImage* CImageLoaderPCX::loadImage(io::IReadFile* file) const
 		}
 	}
 
-	// read image data
-	const s32 width = header.XMax - header.XMin + 1;
-	const s32 height = header.YMax - header.YMin + 1;
-	const s32 imagebytes = header.BytesPerLine * header.Planes * header.BitsPerPixel * height / 8;
-	u8* PCXData = new u8[imagebytes];
+	u16 palette16[256];
+	for (u32 i=0; i<256; ++i)
+		palette16[i] = X8R8G8B8toA1R5G5B5(paletteData[i]);
 
-	u8 cnt, value;
-	s32 lineoffset=0, linestart=0, nextmode=1;
-	for(s32 offset = 0; offset < imagebytes; offset += cnt)
+	// create image
+	video::IImage* image = new CImage(header.Planes == 3 ? ECF_R8G8B8 : ECF_A1R5G5B5,
+		core::dimension2d<u32>(width, height));
+	u8* data = (u8*)image->getData();
+	const u32 pitch = image->getPitch();
+
+	// decode one line with all of its planes at a time and convert it into the image
+	const u32 bytesPerLine = header.BytesPerLine;
+	core::array<u8> line;
+	line.set_used(bytesPerLine * header.Planes);
+
+	CImageDataReader reader(file);
+	u8 cnt = 0, value = 0;
+	s32 y = 0;
+	for (; y<height; ++y)
 	{
-		file->read(&cnt, 1);
-		if( !((cnt & 0xc0) == 0xc0) )
+		// runs can go on in the next line
+		u8* p = line.pointer();
+		u8* const lineEnd = p + line.size();
+		while (p != lineEnd)
 		{
-			value = cnt;
-			cnt = 1;
-		}
-		else
-		{
-			cnt &= 0x3f;
-			file->read(&value, 1);
-		}
-		if (header.Planes==1)
-			memset(PCXData+offset, value, cnt);
-		else
-		{
-			for (u8 i=0; i<cnt; ++i)
+			if (!cnt)
 			{
-				PCXData[linestart+lineoffset]=value;
-				lineoffset += 3;
-				if (lineoffset>=3*header.BytesPerLine)
+				if (!reader.read(value))
+					break;
+				if ( (value & 0xc0) != 0xc0 )
 				{
-					lineoffset=nextmode;
-					if (++nextmode==3)
-						nextmode=0;
-					if (lineoffset==0)
-						linestart += 3*header.BytesPerLine;
+					*p++ = value;
+					continue;
 				}
+				cnt = value & 0x3f;
+				if (!reader.read(value))
+					break;
 			}
+			for (; cnt && p != lineEnd; --cnt)
+				*p++ = value;
 		}
-	}
-
-	// create image
-	video::IImage* image = 0;
-	s32 pad = (header.BytesPerLine - width * header.BitsPerPixel / 8) * header.Planes;
-
-	if (pad < 0)
-		pad = -pad;
-
-	if (header.BitsPerPixel==8)
-	{
-		switch(header.Planes) // TODO: Other formats
-		{
-		case 1:
-			image = new CImage(ECF_A1R5G5B5, core::dimension2d<u32>(width, height));
-			if (image)
-				CColorConverter::convert8BitTo16Bit(PCXData, (s16*)image->getData(), width, height, paletteData, pad);
-			break;
-		case 3:
-			image = new CImage(ECF_R8G8B8, core::dimension2d<u32>(width, height));
-			if (image)
-				CColorConverter::convert24BitTo24Bit(PCXData, (u8*)image->getData(), width, height, pad);
+		if (p != lineEnd)
 			break;
-		}
-	}
-	else if (header.BitsPerPixel==4)
-	{
-		if (header.Planes==1)
+
+		u8* out = data + y * pitch;
+		if (bpp == 8 && header.Planes == 3)
 		{
-			image = new CImage(ECF_A1R5G5B5, core::dimension2d<u32>(width, height));
-			if (image)
-				CColorConverter::convert4BitTo16Bit(PCXData, (s16*)image->getData(), width, height, paletteData, pad);
+			const u8* in = line.const_pointer();
+			for (s32 x=0; x<width; ++x, out += 3)
+			{
+				out[0] = in[x];
+				out[1] = in[x + bytesPerLine];
+				out[2] = in[x + 2*bytesPerLine];
+			}
 		}
-	}
-	else if (header.BitsPerPixel==1)
-	{
-		if (header.Planes==4)
+		else if (bpp == 8)
 		{
-			image = new CImage(ECF_A1R5G5B5, core::dimension2d<u32>(width, height));
-			if (image)
-				CColorConverter::convert4BitTo16Bit(PCXData, (s16*)image->getData(), width, height, paletteData, pad);
+			const u8* in = line.const_pointer();
+			for (s32 x=0; x<width; ++x)
+				((u16*)out)[x] = palette16[in[x]];
 		}
-		else if (header.Planes==1)
+		else if (bpp == 4)
+			CColorConverter::convert4BitTo16Bit(line.const_pointer(), (s16*)out, width, 1, paletteData);
+		else if (header.Planes == 4)
 		{
-			image = new CImage(ECF_A1R5G5B5, core::dimension2d<u32>(width, height));
-			if (image)
-				CColorConverter::convert1BitTo16Bit(PCXData, (s16*)image->getData(), width, height, pad);
+			// each plane holds one bit of the palette index
+			const u8* in = line.const_pointer();
+			for (s32 x=0; x<width; ++x)
+			{
+				const u32 shift = 7 - (x & 7);
+				const u32 index = ((in[x/8] >> shift) & 1) |
+					((in[x/8 + bytesPerLine] >> shift) & 1) << 1 |
+					((in[x/8 + 2*bytesPerLine] >> shift) & 1) << 2 |
+					((in[x/8 + 3*bytesPerLine] >> shift) & 1) << 3;
+				((u16*)out)[x] = palette16[index];
+			}
 		}
+		else
+			CColorConverter::convert1BitTo16Bit(line.const_pointer(), (s16*)out, width, 1);
 	}
 
-	// clean up
-
-	delete [] paletteData;
-	delete [] PCXData;
+	if (y < height)
+	{
+		os::Printer::log("PCX file is too short", file->getFileName(), irr::ELL_WARNING);
+		memset(data + y * pitch, 0, (height - y) * pitch);
+	}
 
 	return image;
 }
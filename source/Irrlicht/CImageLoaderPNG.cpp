@@ -87,6 +87,20 @@ bool CImageLoaderPng::isALoadableFileFormat(io::IReadFile* file) const
 
 // load in the image data
 IImage* CImageLoaderPng::loadImage(io::IReadFile* file) const
+{
+	return decode(file, 0);
+}
+
+
+//! creates a surface from the file, reduced while reading the rows
+IImage* CImageLoaderPng::loadReducedImage(io::IReadFile* file, const core::dimension2d<u32>& maxSize) const
+{
+	return decode(file, &maxSize);
+}
+
+
+//! decodes the file, reduced to fit into maxSize if it isn't 0
+IImage* CImageLoaderPng::decode(io::IReadFile* file, const core::dimension2d<u32>* maxSize) const
 {
 #ifdef _IRR_COMPILE_WITH_LIBPNG_
 	if (!file)
@@ -95,6 +109,10 @@ IImage* CImageLoaderPng::loadImage(io::IReadFile* file) const
 	//Used to point to image rows
 	u8** RowPointers = 0;
 
+	//Used to reduce the image while reading
+	u8* Row = 0;
+	u64* Sums = 0;
+
 	png_byte buffer[8];
 	// Read the first few bytes of the PNG file
 	if( file->read(buffer, 8) != 8 )
@@ -220,12 +238,24 @@ IImage* CImageLoaderPng::loadImage(io::IReadFile* file) const
 #endif
 	}
 
+	// Images which are too large are reduced by averaging blocks of
+	// factor x factor pixels, so they are never in memory at full size.
+	// Interlaced images are spread over several passes and can't be.
+	u32 factor = 1;
+	if (maxSize && png_get_interlace_type(png_ptr, info_ptr) == PNG_INTERLACE_NONE)
+	{
+		const u32 maxWidth = core::max_(maxSize->Width, 1u);
+		const u32 maxHeight = core::max_(maxSize->Height, 1u);
+		factor = core::max_((Width + maxWidth - 1) / maxWidth, (Height + maxHeight - 1) / maxHeight);
+	}
+	const core::dimension2d<u32> size((Width + factor - 1) / factor, (Height + factor - 1) / factor);
+
 	// Create the image structure to be filled by png data
 	video::IImage* image = 0;
 	if (ColorType==PNG_COLOR_TYPE_RGB_ALPHA)
-		image = new CImage(ECF_A8R8G8B8, core::dimension2d<u32>(Width, Height));
+		image = new CImage(ECF_A8R8G8B8, size);
 	else
-		image = new CImage(ECF_R8G8B8, core::dimension2d<u32>(Width, Height));
+		image = new CImage(ECF_R8G8B8, size);
 	if (!image)
 	{
 		os::Printer::log("LOAD PNG: Internal PNG create image struct failure\n", file->getFileName(), ELL_ERROR);
@@ -233,22 +263,22 @@ IImage* CImageLoaderPng::loadImage(io::IReadFile* file) const
 		return 0;
 	}
 
-	// Create array of pointers to rows in image data
-	RowPointers = new png_bytep[Height];
-	if (!RowPointers)
+	const u32 channels = ColorType==PNG_COLOR_TYPE_RGB_ALPHA ? 4 : 3;
+	unsigned char* data = (unsigned char*)image->getData();
+	if (factor == 1)
 	{
-		os::Printer::log("LOAD PNG: Internal PNG create row pointers failure\n", file->getFileName(), ELL_ERROR);
-		png_destroy_read_struct(&png_ptr, NULL, NULL);
-		delete image;
-		return 0;
-	}
+		// Create array of pointers to rows in image data
+		RowPointers = new png_bytep[Height];
 
-	// Fill array of pointers to rows in image data
-	unsigned char* data = (unsigned char*)image->getData();
-	for (u32 i=0; i<Height; ++i)
+		// Fill array of pointers to rows in image data
+		for (u32 i=0; i<Height; ++i)
+			RowPointers[i] = data + i * image->getPitch();
+	}
+	else
 	{
-		RowPointers[i]=data;
-		data += image->getPitch();
+		// one row of the file and the sums of the blocks it goes into
+		Row = new u8[Width * channels];
+		Sums = new u64[size.Width * channels];
 	}
 
 	// for proper error handling
@@ -256,15 +286,55 @@ IImage* CImageLoaderPng::loadImage(io::IReadFile* file) const
 	{
 		png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
 		delete [] RowPointers;
+		delete [] Row;
+		delete [] Sums;
 		delete image;
 		return 0;
 	}
 
-	// Read data using the library function that handles all transformations including interlacing
-	png_read_image(png_ptr, RowPointers);
+	if (factor == 1)
+	{
+		// Read data using the library function that handles all transformations including interlacing
+		png_read_image(png_ptr, RowPointers);
+	}
+	else
+	{
+		for (u32 y=0; y<Height; y+=factor)
+		{
+			const u32 rows = core::min_(factor, Height - y);
+			memset(Sums, 0, size.Width * channels * sizeof(u64));
+			for (u32 r=0; r<rows; ++r)
+			{
+				png_read_row(png_ptr, Row, NULL);
+
+				const u8* in = Row;
+				u64* sum = Sums;
+				for (u32 x=0; x<Width; x+=factor, sum+=channels)
+				{
+					const u32 columns = core::min_(factor, Width - x);
+					for (u32 i=0; i<columns; ++i, in+=channels)
+					{
+						for (u32 c=0; c<channels; ++c)
+							sum[c] += in[c];
+					}
+				}
+			}
+
+			// blocks at the right and bottom border can be smaller
+			u8* out = data + (y / factor) * image->getPitch();
+			for (u32 x=0; x<size.Width; ++x)
+			{
+				const u64 count = rows * core::min_(factor, Width - x*factor);
+				for (u32 c=0; c<channels; ++c, ++out)
+					*out = (u8)((Sums[x*channels + c] + count/2) / count);
+			}
+		}
+	}
 
 	png_read_end(png_ptr, NULL);
 	delete [] RowPointers;
+	delete [] Row;
+	delete [] Sums;
 	png_destroy_read_struct(&png_ptr,&info_ptr, 0); // Clean up memory
 
 	return image;
@@ -34,6 +34,20 @@ public:
 
 	//! creates a surface from the file
 	virtual IImage* loadImage(io::IReadFile* file) const IRR_OVERRIDE;
+
+	//! creates a surface from the file, reduced while reading the rows
+	virtual IImage* loadReducedImage(io::IReadFile* file, const core::dimension2d<u32>& maxSize) const IRR_OVERRIDE;
+
+	//! Images can be loaded on worker threads, libpng keeps its state per call
+	virtual bool isThreadSafe() const IRR_OVERRIDE
+	{
+		return true;
+	}
+
+private:
+
+	//! decodes the file, reduced to fit into maxSize if it isn't 0
+	IImage* decode(io::IReadFile* file, const core::dimension2d<u32>* maxSize) const;
 };
 
 
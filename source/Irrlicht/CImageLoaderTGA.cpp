@@ -11,6 +11,7 @@
 #include "CColorConverter.h"
 #include "CImage.h"
 #include "irrString.h"
+#include "CImageDataReader.h"
 
 
 namespace irr
@@ -18,65 +19,134 @@ namespace irr
 namespace video
 {
 
-
-//! returns true if the file maybe is able to be loaded by this class
-//! based on the file extension (e.g. ".tga")
-bool CImageLoaderTGA::isALoadableFileExtension(const io::path& filename) const
+namespace
 {
-	return core::hasFileExtension ( filename, "tga" );
-}
-
 
-//! loads a compressed tga.
-u8 *CImageLoaderTGA::loadCompressedImage(io::IReadFile *file, const STGAHeader& header) const
+//! Decodes the pixels of a tga directly into the image
+struct STGADecoder
 {
-	// This was written and sent in by Jon Pry, thank you very much!
-	// I only changed the formatting a little bit.
-
-	s32 bytesPerPixel = header.PixelDepth/8;
-	s32 imageSize =  header.ImageHeight * header.ImageWidth * bytesPerPixel;
-	u8* data = new u8[imageSize];
-	s32 currentByte = 0;
+	//! Converts count pixels into the format of the image
+	void convert(const u8* in, u8* out, u32 count) const
+	{
+		switch (PixelDepth)
+		{
+		case 8:
+			if (Grey)
+				CColorConverter::convert8BitTo24Bit(in, out, count, 1, 0);
+			else
+				CColorConverter::convert8BitTo16Bit(in, (s16*)out, count, 1, Palette);
+			break;
+		case 16:
+			CColorConverter::convert16BitTo16Bit((const s16*)in, (s16*)out, count, 1);
+			break;
+		case 24:
+			CColorConverter::convert24BitTo24Bit(in, out, count, 1, 0, false, true);
+			break;
+		case 32:
+			CColorConverter::convert32BitTo32Bit((const s32*)in, (s32*)out, count, 1, 0);
+			break;
+		}
+	}
 
-	while(currentByte < imageSize)
+	//! Sets count pixels of the image to the pixel of the current run
+	void fill(u8* out, u32 count) const
 	{
-		u8 chunkheader = 0;
-		file->read(&chunkheader, sizeof(u8)); // Read The Chunk's Header
+		switch (OutSize)
+		{
+		case 2:
+			{
+				u16 value;
+				memcpy(&value, RunPixel, 2);
+				for (u32 i=0; i<count; ++i)
+					((u16*)out)[i] = value;
+			}
+			break;
+		case 4:
+			{
+				u32 value;
+				memcpy(&value, RunPixel, 4);
+				for (u32 i=0; i<count; ++i)
+					((u32*)out)[i] = value;
+			}
+			break;
+		default:
+			for (u32 i=0; i<count; ++i, out += 3)
+			{
+				out[0] = RunPixel[0];
+				out[1] = RunPixel[1];
+				out[2] = RunPixel[2];
+			}
+			break;
+		}
+	}
 
-		if(chunkheader < 128) // If The Chunk Is A 'RAW' Chunk
+	//! Decodes one row of run length encoded pixels
+	/** Originally written and sent in by Jon Pry, thank you very much!
+	\return false if the file ended too early. */
+	bool decodeRLE(CImageDataReader& reader, u8* out, u32 width)
+	{
+		u32 x = 0;
+		while (x < width)
 		{
-			chunkheader++; // Add 1 To The Value To Get Total Number Of Raw Pixels
+			if (!PacketLeft)
+			{
+				u8 chunkheader;
+				if (!reader.read(chunkheader))
+					return false;
+
+				// packets with the high bit set repeat a single pixel
+				PacketLeft = (chunkheader & 0x7f) + 1;
+				Run = (chunkheader & 0x80) != 0;
+				if (Run)
+				{
+					const u8* in = reader.read(InSize);
+					if (!in)
+						return false;
+					convert(in, RunPixel, 1);
+				}
+			}
 
-			file->read(&data[currentByte], bytesPerPixel * chunkheader);
-			currentByte += bytesPerPixel * chunkheader;
+			// packets can go on in the next row
+			const u32 count = core::min_(PacketLeft, width - x);
+			if (Run)
+				fill(out + x*OutSize, count);
+			else
+			{
+				const u8* in = reader.read(count*InSize);
+				if (!in)
+					return false;
+				convert(in, out + x*OutSize, count);
+			}
+			x += count;
+			PacketLeft -= count;
 		}
-		else
-		{
-			// thnx to neojzs for some fixes with this code
+		return true;
+	}
 
-			// If It's An RLE Header
-			chunkheader -= 127; // Subtract 127 To Get Rid Of The ID Bit
+	u32 PixelDepth;
+	u32 InSize; // bytes per pixel in the file
+	u32 OutSize; // bytes per pixel in the image
+	bool Grey;
+	s32 Palette[256];
 
-			s32 dataOffset = currentByte;
-			file->read(&data[dataOffset], bytesPerPixel);
+	// current run length packet
+	u32 PacketLeft;
+	bool Run;
+	u8 RunPixel[4];
+};
 
-			currentByte += bytesPerPixel;
+} // end anonymous namespace
 
-			for(s32 counter = 1; counter < chunkheader; counter++)
-			{
-				for(s32 elementCounter=0; elementCounter < bytesPerPixel; elementCounter++)
-					data[currentByte + elementCounter] = data[dataOffset + elementCounter];
 
-				currentByte += bytesPerPixel;
-			}
-		}
-	}
 
-	return data;
+//! returns true if the file maybe is able to be loaded by this class
+//! based on the file extension (e.g. ".tga")
+bool CImageLoaderTGA::isALoadableFileExtension(const io::path& filename) const
+{
+	return core::hasFileExtension ( filename, "tga" );
 }
 
 
-
 //! returns true if the file maybe is able to be loaded by this class
 bool CImageLoaderTGA::isALoadableFileFormat(io::IReadFile* file) const
 {
@@ -96,7 +166,6 @@ bool CImageLoaderTGA::isALoadableFileFormat(io::IReadFile* file) const
 IImage* CImageLoaderTGA::loadImage(io::IReadFile* file) const
 {
 	STGAHeader header;
-	u32 *palette = 0;
 
 	file->read(&header, sizeof(STGAHeader));
 
@@ -110,10 +179,49 @@ IImage* CImageLoaderTGA::loadImage(io::IReadFile* file) const
 	if (header.IdLength)
 		file->seek(header.IdLength, true);
 
+	// 1 to 3 are uncompressed color-mapped, RGB and black and white
+	// images, 9 to 11 the same run length encoded
+	const u32 baseType = header.ImageType & 7;
+	if (baseType < 1 || baseType > 3 || header.ImageType > 11)
+	{
+		os::Printer::log("Unsupported TGA file type", file->getFileName(), ELL_ERROR);
+		return 0;
+	}
+
+	STGADecoder decoder;
+	decoder.PixelDepth = header.PixelDepth;
+	decoder.InSize = header.PixelDepth/8;
+	decoder.Grey = baseType == 3;
+	decoder.PacketLeft = 0;
+	decoder.Run = false;
+
+	ECOLOR_FORMAT format;
+	switch(header.PixelDepth)
+	{
+	case 8:
+		format = decoder.Grey ? ECF_R8G8B8 : ECF_A1R5G5B5;
+		break;
+	case 16:
+		format = ECF_A1R5G5B5;
+		break;
+	case 24:
+		format = ECF_R8G8B8;
+		break;
+	case 32:
+		format = ECF_A8R8G8B8;
+		break;
+	default:
+		os::Printer::log("Unsupported TGA format", file->getFileName(), ELL_ERROR);
+		return 0;
+	}
+	decoder.OutSize = IImage::getBitsPerPixelFromFormat(format)/8;
+
+	// indices outside of the color map are black
+	memset(decoder.Palette, 0, sizeof(decoder.Palette));
 	if (header.ColorMapType)
 	{
 		// create 32 bit palette
-		palette = new u32[ header.ColorMapLength];
+		u32 * palette = new u32[header.ColorMapLength];
 
 		// read color map
 		u8 * colorMap = new u8[header.ColorMapEntrySize/8 * header.ColorMapLength];
@@ -131,93 +239,47 @@ IImage* CImageLoaderTGA::loadImage(io::IReadFile* file) const
 			case 32:
 				CColorConverter::convert_B8G8R8A8toA8R8G8B8(colorMap, header.ColorMapLength, palette);
 				break;
+			default:
+				memset(palette, 0, header.ColorMapLength*sizeof(u32));
+				break;
 		}
+		memcpy(decoder.Palette, palette, core::min_((u32)header.ColorMapLength, 256u)*sizeof(u32));
 		delete [] colorMap;
-	}
-
-	// read image
-
-	u8* data = 0;
-
-	if (	header.ImageType == 1 || // Uncompressed, color-mapped images.
-			header.ImageType == 2 || // Uncompressed, RGB images
-			header.ImageType == 3 // Uncompressed, black and white images
-		)
-	{
-		const s32 imageSize = header.ImageHeight * header.ImageWidth * header.PixelDepth/8;
-		data = new u8[imageSize];
-	  	file->read(data, imageSize);
-	}
-	else
-	if(header.ImageType == 10)
-	{
-		// Runlength encoded RGB images
-		data = loadCompressedImage(file, header);
-	}
-	else
-	{
-		os::Printer::log("Unsupported TGA file type", file->getFileName(), ELL_ERROR);
 		delete [] palette;
-		return 0;
 	}
 
-	IImage* image = 0;
+	// decode the rows straight into the image
+	IImage* image = new CImage(format,
+		core::dimension2d<u32>(header.ImageWidth, header.ImageHeight));
+	u8* data = (u8*)image->getData();
+	const u32 pitch = image->getPitch();
+	const bool flip = (header.ImageDescriptor&0x20)==0;
 
-	switch(header.PixelDepth)
+	CImageDataReader reader(file);
+	u32 y = 0;
+	for (; y<header.ImageHeight; ++y)
 	{
-	case 8:
+		u8* out = data + (flip ? header.ImageHeight-1-y : y) * pitch;
+		if (header.ImageType & 8)
 		{
-			if (header.ImageType==3) // grey image
-			{
-				image = new CImage(ECF_R8G8B8,
-					core::dimension2d<u32>(header.ImageWidth, header.ImageHeight));
-				if (image)
-					CColorConverter::convert8BitTo24Bit((u8*)data,
-						(u8*)image->getData(),
-						header.ImageWidth,header.ImageHeight,
-						0, 0, (header.ImageDescriptor&0x20)==0);
-			}
-			else
-			{
-				image = new CImage(ECF_A1R5G5B5,
-					core::dimension2d<u32>(header.ImageWidth, header.ImageHeight));
-				if (image)
-					CColorConverter::convert8BitTo16Bit((u8*)data,
-						(s16*)image->getData(),
-						header.ImageWidth,header.ImageHeight,
-						(s32*) palette, 0,
-						(header.ImageDescriptor&0x20)==0);
-			}
+			if (!decoder.decodeRLE(reader, out, header.ImageWidth))
+				break;
+		}
+		else
+		{
+			const u8* in = reader.read(header.ImageWidth*decoder.InSize);
+			if (!in)
+				break;
+			decoder.convert(in, out, header.ImageWidth);
 		}
-		break;
-	case 16:
-		image = new CImage(ECF_A1R5G5B5,
-			core::dimension2d<u32>(header.ImageWidth, header.ImageHeight));
-		if (image)
-			CColorConverter::convert16BitTo16Bit((s16*)data,
-				(s16*)image->getData(), header.ImageWidth,	header.ImageHeight, 0, (header.ImageDescriptor&0x20)==0);
-		break;
-	case 24:
-			image = new CImage(ECF_R8G8B8,
-				core::dimension2d<u32>(header.ImageWidth, header.ImageHeight));
-			if (image)
-				CColorConverter::convert24BitTo24Bit(
-					(u8*)data, (u8*)image->getData(), header.ImageWidth, header.ImageHeight, 0, (header.ImageDescriptor&0x20)==0, true);
-		break;
-	case 32:
-			image = new CImage(ECF_A8R8G8B8,
-				core::dimension2d<u32>(header.ImageWidth, header.ImageHeight));
-			if (image)
-				CColorConverter::convert32BitTo32Bit((s32*)data,
-					(s32*)image->getData(), header.ImageWidth, header.ImageHeight, 0, (header.ImageDescriptor&0x20)==0);
-		break;
-	default:
-		os::Printer::log("Unsupported TGA format", file->getFileName(), ELL_ERROR);
-		break;
 	}
 
-	delete [] data;
-	delete [] palette;
+	if (y < header.ImageHeight)
+	{
+		os::Printer::log("TGA file is too short", file->getFileName(), ELL_WARNING);
+		for (; y<header.ImageHeight; ++y)
+			memset(data + (flip ? header.ImageHeight-1-y : y) * pitch, 0, pitch);
+	}
 
 	return image;
 }
@@ -67,10 +67,11 @@ public:
 	//! creates a surface from the file
 	virtual IImage* loadImage(io::IReadFile* file) const IRR_OVERRIDE;
 
-private:
-
-	//! loads a compressed tga. Was written and sent in by Jon Pry, thank you very much!
-	u8* loadCompressedImage(io::IReadFile *file, const STGAHeader& header) const;
+	//! Images can be loaded on worker threads, the loader has no state
+	virtual bool isThreadSafe() const IRR_OVERRIDE
+	{
+		return true;
+	}
 };
 
 #endif // compiled with loader
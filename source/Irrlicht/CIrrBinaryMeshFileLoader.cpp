@@ -0,0 +1,517 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "IrrCompileConfig.h"
+
+#ifdef _IRR_COMPILE_WITH_IRR_BINARY_MESH_LOADER_
+
+#include "CIrrBinaryMeshFileLoader.h"
+#include "SIrrBinaryMeshStructs.h"
+#include "CMeshTextureLoader.h"
+#include "CDynamicMeshBuffer.h"
+#include "SAnimatedMesh.h"
+#include "SMesh.h"
+#include "ISkinnedMesh.h"
+#include "IReadFile.h"
+#include "os.h"
+
+namespace irr
+{
+namespace scene
+{
+
+namespace
+{
+	bool readU32(io::IReadFile* file, u32& value)
+	{
+		if (file->read(&value, 4) != 4)
+			return false;
+#ifdef __BIG_ENDIAN__
+		value = os::Byteswap::byteswap(value);
+#endif
+		return true;
+	}
+
+	bool readF32(io::IReadFile* file, f32& value)
+	{
+		u32 v;
+		if (!readU32(file, v))
+			return false;
+		value = core::FR(v);
+		return true;
+	}
+
+	bool skipPadding(io::IReadFile* file, u32 alignment)
+	{
+		const u32 rest = (alignment - (u32)file->getPos() % alignment) % alignment;
+		return !rest || file->seek(rest, true);
+	}
+
+	//! checks that count values of the given size can still be read, to reject broken files before allocating memory
+	bool canRead(io::IReadFile* file, u32 count, u32 size)
+	{
+		const long left = file->getSize() - file->getPos();
+		return left >= 0 && count <= (u32)left / size;
+	}
+
+	bool readString(io::IReadFile* file, core::stringc& str)
+	{
+		u32 size;
+		if (!readU32(file, size) || !canRead(file, size, 1))
+			return false;
+
+		core::array<c8> chars(size+1);
+		chars.set_used(size+1);
+		if (file->read(chars.pointer(), size) != (size_t)size)
+			return false;
+		chars[size] = 0;
+		str = chars.const_pointer();
+		return skipPadding(file, 4);
+	}
+
+	bool readFloats(io::IReadFile* file, f32* values, u32 count)
+	{
+		for (u32 i=0; i<count; ++i)
+		{
+			if (!readF32(file, values[i]))
+				return false;
+		}
+		return true;
+	}
+
+	bool readMatrix(io::IReadFile* file, core::matrix4& matrix)
+	{
+		f32 m[16];
+		if (!readFloats(file, m, 16))
+			return false;
+		matrix.setM(m);
+		return true;
+	}
+
+	core::aabbox3df toBox(const f32* box)
+	{
+		return core::aabbox3df(box[0], box[1], box[2], box[3], box[4], box[5]);
+	}
+
+	//! checks that all indices reference one of the vertexCount vertices
+	template <class T>
+	bool indicesInRange(const T* indices, u32 indexCount, u32 vertexCount)
+	{
+		for (u32 i=0; i<indexCount; ++i)
+		{
+			if (indices[i] >= vertexCount)
+				return false;
+		}
+		return true;
+	}
+
+	void swapData(void* data, u32 size, u32 valueSize)
+	{
+#ifdef __BIG_ENDIAN__
+		u8* p = (u8*)data;
+		if (valueSize == 2)
+		{
+			for (u32 i=0; i<size; i+=2)
+				*(u16*)(p+i) = os::Byteswap::byteswap(*(u16*)(p+i));
+		}
+		else
+		{
+			for (u32 i=0; i<size; i+=4)
+				*(u32*)(p+i) = os::Byteswap::byteswap(*(u32*)(p+i));
+		}
+#endif
+	}
+}
+
+
+//! Constructor
+CIrrBinaryMeshFileLoader::CIrrBinaryMeshFileLoader(scene::ISceneManager* smgr, io::IFileSystem* fs)
+	: SceneManager(smgr), FileSystem(fs)
+{
+	#ifdef _DEBUG
+	setDebugName("CIrrBinaryMeshFileLoader");
+	#endif
+
+	TextureLoader = new CMeshTextureLoader(FileSystem, SceneManager->getVideoDriver());
+}
+
+
+//! Returns true if the file maybe is able to be loaded by this class.
+/** This decision should be based only on the file extension (e.g. ".cob") */
+bool CIrrBinaryMeshFileLoader::isALoadableFileExtension(const io::path& filename) const
+{
+	return core::hasFileExtension(filename, "irrbmesh");
+}
+
+
+//! creates/loads an animated mesh from the file.
+IAnimatedMesh* CIrrBinaryMeshFileLoader::createMesh(io::IReadFile* file)
+{
+	if (!file)
+		return 0;
+
+	SIrrBinaryMeshHeader header;
+	if (file->read(&header, sizeof(header)) != sizeof(header) || memcmp(header.Magic, "IRRB", 4))
+	{
+		os::Printer::log("Not a binary Irrlicht mesh", file->getFileName(), ELL_ERROR);
+		return 0;
+	}
+	swapData(&header.Version, sizeof(header) - 4, 4);
+
+	if (header.Version != IRR_BINARY_MESH_VERSION)
+	{
+		os::Printer::log("Unsupported version of binary Irrlicht mesh", file->getFileName(), ELL_ERROR);
+		return 0;
+	}
+
+	if (getMeshTextureLoader())
+		getMeshTextureLoader()->setMeshFile(file);
+
+	IAnimatedMesh* mesh = 0;
+	if (header.Flags & EIBMF_SKINNED)
+		mesh = readSkinnedMesh(file, header);
+	else
+		mesh = readStaticMesh(file, header);
+
+	if (!mesh)
+		os::Printer::log("Could not read binary Irrlicht mesh", file->getFileName(), ELL_ERROR);
+
+	return mesh;
+}
+
+
+//! reads a static mesh
+IAnimatedMesh* CIrrBinaryMeshFileLoader::readStaticMesh(io::IReadFile* file, const SIrrBinaryMeshHeader& header)
+{
+	SMesh* mesh = new SMesh();
+
+	for (u32 i=0; i<header.BufferCount; ++i)
+	{
+		SIrrBinaryMeshBuffer info;
+		video::SMaterial material;
+		if (!readMeshBufferInfo(file, info, material))
+		{
+			mesh->drop();
+			return 0;
+		}
+
+		CDynamicMeshBuffer* buffer = new CDynamicMeshBuffer((video::E_VERTEX_TYPE)info.VertexType, (video::E_INDEX_TYPE)info.IndexType);
+		mesh->addMeshBuffer(buffer);
+		buffer->drop();
+		setupMeshBuffer(buffer, info, material);
+
+		IVertexBuffer& vertices = buffer->getVertexBuffer();
+		IIndexBuffer& indices = buffer->getIndexBuffer();
+		bool ok = skipPadding(file, IRR_BINARY_MESH_DATA_ALIGNMENT) && canRead(file, info.VertexCount, vertices.stride());
+		if (ok)
+		{
+			vertices.set_used(info.VertexCount);
+			ok = readData(file, vertices.getData(), info.VertexCount * vertices.stride(), 4) &&
+				skipPadding(file, IRR_BINARY_MESH_DATA_ALIGNMENT) && canRead(file, info.IndexCount, indices.stride());
+		}
+		if (ok)
+		{
+			indices.set_used(info.IndexCount);
+			ok = readData(file, indices.getData(), info.IndexCount * indices.stride(), indices.stride()) &&
+				skipPadding(file, 4);
+			if (ok && indices.getType() == video::EIT_16BIT)
+				ok = indicesInRange((const u16*)indices.getData(), info.IndexCount, info.VertexCount);
+			else if (ok)
+				ok = indicesInRange((const u32*)indices.getData(), info.IndexCount, info.VertexCount);
+		}
+		if (!ok)
+		{
+			mesh->drop();
+			return 0;
+		}
+	}
+
+	mesh->setBoundingBox(toBox(header.BoundingBox));
+
+	SAnimatedMesh* animatedMesh = new SAnimatedMesh(mesh);
+	mesh->drop();
+	return animatedMesh;
+}
+
+
+//! reads a skinned mesh with its joints
+IAnimatedMesh* CIrrBinaryMeshFileLoader::readSkinnedMesh(io::IReadFile* file, const SIrrBinaryMeshHeader& header)
+{
+#ifdef _IRR_COMPILE_WITH_SKINNED_MESH_SUPPORT_
+	ISkinnedMesh* mesh = SceneManager->createSkinnedMesh();
+
+	for (u32 i=0; i<header.BufferCount; ++i)
+	{
+		SIrrBinaryMeshBuffer info;
+		video::SMaterial material;
+		if (!readMeshBufferInfo(file, info, material) || info.IndexType != video::EIT_16BIT)
+		{
+			mesh->drop();
+			return 0;
+		}
+
+		SSkinMeshBuffer* buffer = mesh->addMeshBuffer();
+		buffer->VertexType = (video::E_VERTEX_TYPE)info.VertexType;
+		setupMeshBuffer(buffer, info, material);
+
+		const u32 stride = video::getVertexPitchFromType(buffer->VertexType);
+		bool ok = skipPadding(file, IRR_BINARY_MESH_DATA_ALIGNMENT) && canRead(file, info.VertexCount, stride);
+		if (ok)
+		{
+			switch (buffer->VertexType)
+			{
+			case video::EVT_2TCOORDS:
+				buffer->Vertices_2TCoords.set_used(info.VertexCount);
+				break;
+			case video::EVT_TANGENTS:
+				buffer->Vertices_Tangents.set_used(info.VertexCount);
+				break;
+			default:
+				buffer->Vertices_Standard.set_used(info.VertexCount);
+				break;
+			}
+			ok = readData(file, buffer->getVertices(), info.VertexCount * stride, 4) &&
+				skipPadding(file, IRR_BINARY_MESH_DATA_ALIGNMENT) && canRead(file, info.IndexCount, 2);
+		}
+		if (ok)
+		{
+			buffer->Indices.set_used(info.IndexCount);
+			ok = readData(file, buffer->Indices.pointer(), info.IndexCount * 2, 2) && skipPadding(file, 4) &&
+				indicesInRange(buffer->Indices.const_pointer(), info.IndexCount, info.VertexCount);
+		}
+		if (!ok)
+		{
+			mesh->drop();
+			return 0;
+		}
+	}
+
+	// create all joints first, so children can be linked by index
+	if (!canRead(file, header.JointCount, 4))
+	{
+		mesh->drop();
+		return 0;
+	}
+	for (u32 i=0; i<header.JointCount; ++i)
+		mesh->addJoint();
+
+	core::array<ISkinnedMesh::SJoint*>& joints = mesh->getAllJoints();
+	core::array<SSkinMeshBuffer*>& buffers = mesh->getMeshBuffers();
+	bool ok = true;
+	for (u32 i=0; i<header.JointCount && ok; ++i)
+	{
+		ISkinnedMesh::SJoint* joint = joints[i];
+		u32 count;
+
+		ok = readString(file, joint->Name) &&
+			readMatrix(file, joint->LocalMatrix) &&
+			readMatrix(file, joint->GlobalInversedMatrix) &&
+			readU32(file, count) && canRead(file, count, 4);
+		for (u32 j=0; j<count && ok; ++j)
+		{
+			u32 child;
+			ok = readU32(file, child) && child < joints.size() && child != i;
+			if (ok)
+				joint->Children.push_back(joints[child]);
+		}
+
+		ok = ok && readU32(file, count) && canRead(file, count, 4);
+		if (ok)
+		{
+			joint->AttachedMeshes.set_used(count);
+			ok = readData(file, joint->AttachedMeshes.pointer(), count * 4, 4);
+			for (u32 j=0; j<count && ok; ++j)
+				ok = joint->AttachedMeshes[j] < buffers.size();
+		}
+
+		f32 values[5];
+		ok = ok && readU32(file, count) && canRead(file, count, 16);
+		if (ok)
+			joint->PositionKeys.set_used(count);
+		for (u32 j=0; j<count && ok; ++j)
+		{
+			ok = readFloats(file, values, 4);
+			ISkinnedMesh::SPositionKey& key = joint->PositionKeys[j];
+			key.frame = values[0];
+			key.position.set(values[1], values[2], values[3]);
+		}
+
+		ok = ok && readU32(file, count) && canRead(file, count, 16);
+		if (ok)
+			joint->ScaleKeys.set_used(count);
+		for (u32 j=0; j<count && ok; ++j)
+		{
+			ok = readFloats(file, values, 4);
+			ISkinnedMesh::SScaleKey& key = joint->ScaleKeys[j];
+			key.frame = values[0];
+			key.scale.set(values[1], values[2], values[3]);
+		}
+
+		ok = ok && readU32(file, count) && canRead(file, count, 20);
+		if (ok)
+			joint->RotationKeys.set_used(count);
+		for (u32 j=0; j<count && ok; ++j)
+		{
+			ok = readFloats(file, values, 5);
+			ISkinnedMesh::SRotationKey& key = joint->RotationKeys[j];
+			key.frame = values[0];
+			key.rotation.set(values[1], values[2], values[3], values[4]);
+		}
+
+		ok = ok && readU32(file, count) && canRead(file, count, 12);
+		if (ok)
+			joint->Weights.reallocate(count);
+		for (u32 j=0; j<count && ok; ++j)
+		{
+			u32 bufferId, vertexId;
+			f32 strength;
+			ok = readU32(file, bufferId) && readU32(file, vertexId) && readF32(file, strength) &&
+				bufferId < buffers.size() && vertexId < buffers[bufferId]->getVertexCount();
+			if (ok)
+			{
+				ISkinnedMesh::SWeight* weight = mesh->addWeight(joint);
+				weight->buffer_id = (u16)bufferId;
+				weight->vertex_id = vertexId;
+				weight->strength = strength;
+			}
+		}
+	}
+
+	if (!ok)
+	{
+		mesh->drop();
+		return 0;
+	}
+
+	mesh->setAnimationSpeed(header.AnimationSpeed);
+	mesh->finalize();
+	return mesh;
+#else
+	os::Printer::log("Skinned meshes are not supported in this build", file->getFileName(), ELL_ERROR);
+	return 0;
+#endif
+}
+
+
+//! reads the description and material of a mesh buffer
+bool CIrrBinaryMeshFileLoader::readMeshBufferInfo(io::IReadFile* file, SIrrBinaryMeshBuffer& info, video::SMaterial& material)
+{
+	if (file->read(&info, sizeof(info)) != sizeof(info))
+		return false;
+	swapData(&info, sizeof(info), 4);
+
+	if (info.VertexType > video::EVT_TANGENTS || info.IndexType > video::EIT_32BIT ||
+		info.PrimitiveType > EPT_POINT_SPRITES)
+		return false;
+
+	return readMaterial(file, material);
+}
+
+
+//! sets the material and the values of the description to a mesh buffer
+void CIrrBinaryMeshFileLoader::setupMeshBuffer(IMeshBuffer* buffer, const SIrrBinaryMeshBuffer& info, const video::SMaterial& material)
+{
+	buffer->getMaterial() = material;
+	buffer->setBoundingBox(toBox(info.BoundingBox));
+	buffer->setPrimitiveType((E_PRIMITIVE_TYPE)info.PrimitiveType);
+	buffer->setHardwareMappingHint((E_HARDWARE_MAPPING)info.MappingHintVertex, EBT_VERTEX);
+	buffer->setHardwareMappingHint((E_HARDWARE_MAPPING)info.MappingHintIndex, EBT_INDEX);
+}
+
+
+bool CIrrBinaryMeshFileLoader::readMaterial(io::IReadFile* file, video::SMaterial& material)
+{
+	u32 values[5];
+	for (u32 i=0; i<5; ++i)
+	{
+		if (!readU32(file, values[i]))
+			return false;
+	}
+	material.MaterialType = (video::E_MATERIAL_TYPE)values[0];
+	material.AmbientColor.color = values[1];
+	material.DiffuseColor.color = values[2];
+	material.EmissiveColor.color = values[3];
+	material.SpecularColor.color = values[4];
+
+	f32 params[7];
+	if (!readFloats(file, params, 7))
+		return false;
+	material.Shininess = params[0];
+	material.MaterialTypeParam = params[1];
+	material.MaterialTypeParam2 = params[2];
+	material.Thickness = params[3];
+	material.BlendFactor = params[4];
+	material.PolygonOffsetDepthBias = params[5];
+	material.PolygonOffsetSlopeScale = params[6];
+
+	u8 bytes[8];
+	if (file->read(bytes, 8) != 8)
+		return false;
+	material.ZBuffer = bytes[0];
+	material.AntiAliasing = bytes[1];
+	material.ColorMask = bytes[2];
+	material.ColorMaterial = bytes[3];
+	material.BlendOperation = (video::E_BLEND_OPERATION)bytes[4];
+	material.PolygonOffsetFactor = bytes[5];
+	material.PolygonOffsetDirection = (video::E_POLYGON_OFFSET)bytes[6];
+	material.ZWriteEnable = (video::E_ZWRITE)bytes[7];
+
+	u32 flags, layerCount;
+	if (!readU32(file, flags) || !readU32(file, layerCount))
+		return false;
+	material.Wireframe = (flags & 1) != 0;
+	material.PointCloud = (flags & 2) != 0;
+	material.GouraudShading = (flags & 4) != 0;
+	material.Lighting = (flags & 8) != 0;
+	material.BackfaceCulling = (flags & 16) != 0;
+	material.FrontfaceCulling = (flags & 32) != 0;
+	material.FogEnable = (flags & 64) != 0;
+	material.NormalizeNormals = (flags & 128) != 0;
+	material.UseMipMaps = (flags & 256) != 0;
+
+	for (u32 i=0; i<layerCount; ++i)
+	{
+		core::stringc textureName;
+		if (!readString(file, textureName) || file->read(bytes, 8) != 8)
+			return false;
+
+		core::matrix4 textureMatrix;
+		if (bytes[7] && !readMatrix(file, textureMatrix))
+			return false;
+
+		// layers which this build doesn't support are skipped
+		if (i >= video::MATERIAL_MAX_TEXTURES)
+			continue;
+
+		video::SMaterialLayer& layer = material.TextureLayer[i];
+		if (textureName.size() && getMeshTextureLoader())
+			layer.Texture = getMeshTextureLoader()->getTexture(textureName);
+		layer.TextureWrapU = bytes[0];
+		layer.TextureWrapV = bytes[1];
+		layer.TextureWrapW = bytes[2];
+		layer.AnisotropicFilter = bytes[3];
+		layer.LODBias = (s8)bytes[4];
+		layer.BilinearFilter = bytes[5] != 0;
+		layer.TrilinearFilter = bytes[6] != 0;
+		if (bytes[7])
+			layer.setTextureMatrix(textureMatrix);
+	}
+
+	return true;
+}
+
+
+//! reads vertex or index data into memory of the mesh buffer
+bool CIrrBinaryMeshFileLoader::readData(io::IReadFile* file, void* data, u32 size, u32 valueSize)
+{
+	if (size && file->read(data, size) != (size_t)size)
+		return false;
+	swapData(data, size, valueSize);
+	return true;
+}
+
+} // end namespace scene
+} // end namespace irr
+
+#endif // _IRR_COMPILE_WITH_IRR_BINARY_MESH_LOADER_
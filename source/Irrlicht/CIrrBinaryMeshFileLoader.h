@@ -0,0 +1,67 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_C_IRR_BINARY_MESH_FILE_LOADER_H_INCLUDED
+#define IRR_C_IRR_BINARY_MESH_FILE_LOADER_H_INCLUDED
+
+#include "IMeshLoader.h"
+#include "IFileSystem.h"
+#include "ISceneManager.h"
+#include "SMaterial.h"
+
+namespace irr
+{
+namespace scene
+{
+
+struct SIrrBinaryMeshHeader;
+struct SIrrBinaryMeshBuffer;
+
+//! Meshloader capable of loading binary .irrbmesh meshes written by CIrrBinaryMeshWriter
+/** Vertices and indices are read directly into the mesh buffers. */
+class CIrrBinaryMeshFileLoader : public IMeshLoader
+{
+public:
+
+	//! Constructor
+	CIrrBinaryMeshFileLoader(scene::ISceneManager* smgr, io::IFileSystem* fs);
+
+	//! returns true if the file maybe is able to be loaded by this class
+	//! based on the file extension (e.g. ".cob")
+	virtual bool isALoadableFileExtension(const io::path& filename) const IRR_OVERRIDE;
+
+	//! creates/loads an animated mesh from the file.
+	//! \return Pointer to the created mesh. Returns 0 if loading failed.
+	//! If you no longer need the mesh, you should call IAnimatedMesh::drop().
+	//! See IReferenceCounted::drop() for more information.
+	virtual IAnimatedMesh* createMesh(io::IReadFile* file) IRR_OVERRIDE;
+
+private:
+
+	//! reads a static mesh
+	IAnimatedMesh* readStaticMesh(io::IReadFile* file, const SIrrBinaryMeshHeader& header);
+
+	//! reads a skinned mesh with its joints
+	IAnimatedMesh* readSkinnedMesh(io::IReadFile* file, const SIrrBinaryMeshHeader& header);
+
+	//! reads the description and material of a mesh buffer
+	bool readMeshBufferInfo(io::IReadFile* file, SIrrBinaryMeshBuffer& info, video::SMaterial& material);
+
+	//! sets the material and the values of the description to a mesh buffer
+	void setupMeshBuffer(IMeshBuffer* buffer, const SIrrBinaryMeshBuffer& info, const video::SMaterial& material);
+
+	bool readMaterial(io::IReadFile* file, video::SMaterial& material);
+
+	//! reads vertex or index data into memory of the mesh buffer
+	/** \param valueSize Size of the values to swap on big endian systems */
+	bool readData(io::IReadFile* file, void* data, u32 size, u32 valueSize);
+
+	scene::ISceneManager* SceneManager;
+	io::IFileSystem* FileSystem;
+};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
@@ -0,0 +1,328 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "IrrCompileConfig.h"
+
+#ifdef _IRR_COMPILE_WITH_IRR_BINARY_MESH_WRITER_
+
+#include "CIrrBinaryMeshWriter.h"
+#include "SIrrBinaryMeshStructs.h"
+#include "ISkinnedMesh.h"
+#include "CMeshBufferQuantized.h"
+#include "ITexture.h"
+#include "os.h"
+
+namespace irr
+{
+namespace scene
+{
+
+namespace
+{
+	bool writeBytes(io::IWriteFile* file, const void* data, u32 size)
+	{
+		return file->write(data, size) == (size_t)size;
+	}
+
+	bool writeU32(io::IWriteFile* file, u32 value)
+	{
+#ifdef __BIG_ENDIAN__
+		value = os::Byteswap::byteswap(value);
+#endif
+		return writeBytes(file, &value, 4);
+	}
+
+	bool writeF32(io::IWriteFile* file, f32 value)
+	{
+		return writeU32(file, core::IR(value));
+	}
+
+	bool writeU8(io::IWriteFile* file, u32 value)
+	{
+		const u8 v = (u8)value;
+		return writeBytes(file, &v, 1);
+	}
+
+	bool writePadding(io::IWriteFile* file, u32 alignment)
+	{
+		static const c8 zeros[IRR_BINARY_MESH_DATA_ALIGNMENT] = { 0 };
+		const u32 rest = (alignment - (u32)file->getPos() % alignment) % alignment;
+		return !rest || writeBytes(file, zeros, rest);
+	}
+
+	bool writeString(io::IWriteFile* file, const core::stringc& str)
+	{
+		return writeU32(file, str.size()) &&
+			writeBytes(file, str.c_str(), str.size()) &&
+			writePadding(file, 4);
+	}
+
+	bool writeMatrix(io::IWriteFile* file, const core::matrix4& matrix)
+	{
+		for (u32 i=0; i<16; ++i)
+		{
+			if (!writeF32(file, matrix[i]))
+				return false;
+		}
+		return true;
+	}
+
+	void writeBox(f32* out, const core::aabbox3df& box)
+	{
+		out[0] = box.MinEdge.X;
+		out[1] = box.MinEdge.Y;
+		out[2] = box.MinEdge.Z;
+		out[3] = box.MaxEdge.X;
+		out[4] = box.MaxEdge.Y;
+		out[5] = box.MaxEdge.Z;
+	}
+
+	//! writes an array of 2 or 4 byte values
+	bool writeData(io::IWriteFile* file, const void* data, u32 size, u32 valueSize)
+	{
+#ifdef __BIG_ENDIAN__
+		// swap in small pieces instead of copying everything
+		u8 tmp[1024];
+		const u8* p = (const u8*)data;
+		while (size)
+		{
+			const u32 n = core::min_(size, (u32)sizeof(tmp));
+			memcpy(tmp, p, n);
+			if (valueSize == 2)
+			{
+				for (u32 i=0; i<n; i+=2)
+					*(u16*)(tmp+i) = os::Byteswap::byteswap(*(u16*)(tmp+i));
+			}
+			else
+			{
+				for (u32 i=0; i<n; i+=4)
+					*(u32*)(tmp+i) = os::Byteswap::byteswap(*(u32*)(tmp+i));
+			}
+			if (!writeBytes(file, tmp, n))
+				return false;
+			p += n;
+			size -= n;
+		}
+		return true;
+#else
+		return writeBytes(file, data, size);
+#endif
+	}
+}
+
+
+CIrrBinaryMeshWriter::CIrrBinaryMeshWriter()
+{
+	#ifdef _DEBUG
+	setDebugName("CIrrBinaryMeshWriter");
+	#endif
+}
+
+
+//! Returns the type of the mesh writer
+EMESH_WRITER_TYPE CIrrBinaryMeshWriter::getType() const
+{
+	return EMWT_IRR_BINARY_MESH;
+}
+
+
+//! writes a mesh
+bool CIrrBinaryMeshWriter::writeMesh(io::IWriteFile* file, scene::IMesh* mesh, s32 flags)
+{
+	if (!file || !mesh)
+		return false;
+
+	os::Printer::log("Writing mesh", file->getFileName());
+
+	ISkinnedMesh* skinnedMesh = 0;
+	if (mesh->getMeshType() == EAMT_SKINNED)
+		skinnedMesh = static_cast<ISkinnedMesh*>(mesh);
+
+	SIrrBinaryMeshHeader header;
+	memcpy(header.Magic, "IRRB", 4);
+	header.Version = IRR_BINARY_MESH_VERSION;
+	header.Flags = skinnedMesh ? EIBMF_SKINNED : 0;
+	header.BufferCount = mesh->getMeshBufferCount();
+	header.JointCount = skinnedMesh ? skinnedMesh->getJointCount() : 0;
+	header.AnimationSpeed = skinnedMesh ? skinnedMesh->getAnimationSpeed() : 0.f;
+	writeBox(header.BoundingBox, mesh->getBoundingBox());
+
+	bool ok = writeBytes(file, header.Magic, 4) &&
+		writeData(file, &header.Version, sizeof(header) - 4, 4);
+
+	for (u32 i=0; i<mesh->getMeshBufferCount() && ok; ++i)
+		ok = writeMeshBuffer(file, mesh->getMeshBuffer(i));
+
+	if (ok && skinnedMesh)
+		ok = writeJoints(file, skinnedMesh);
+
+	if (!ok)
+		os::Printer::log("Could not write mesh", file->getFileName(), ELL_ERROR);
+	return ok;
+}
+
+
+bool CIrrBinaryMeshWriter::writeMeshBuffer(io::IWriteFile* file, const IMeshBuffer* buffer)
+{
+	SIrrBinaryMeshBuffer info;
+	info.VertexType = buffer->getVertexType();
+	info.IndexType = buffer->getIndexType();
+	info.PrimitiveType = buffer->getPrimitiveType();
+	info.VertexCount = buffer->getVertexCount();
+	info.IndexCount = buffer->getIndexCount();
+	info.MappingHintVertex = buffer->getHardwareMappingHint_Vertex();
+	info.MappingHintIndex = buffer->getHardwareMappingHint_Index();
+	writeBox(info.BoundingBox, buffer->getBoundingBox());
+
+	// the format only stores float vertices, quantized ones are written decoded
+	const void* vertices = buffer->getVertices();
+	core::array<video::S3DVertex> decoded;
+	core::array<video::S3DVertexTangents> decodedTangents;
+	if (info.VertexType == video::EVT_QUANTIZED)
+	{
+		decoded.set_used(info.VertexCount);
+		for (u32 i=0; i<info.VertexCount; ++i)
+			decoded[i] = getDecodedVertex(buffer, i);
+		vertices = decoded.const_pointer();
+		info.VertexType = video::EVT_STANDARD;
+	}
+	else if (info.VertexType == video::EVT_QUANTIZED_TANGENTS)
+	{
+		decodedTangents.set_used(info.VertexCount);
+		for (u32 i=0; i<info.VertexCount; ++i)
+			decodedTangents[i] = getDecodedVertex(buffer, i);
+		vertices = decodedTangents.const_pointer();
+		info.VertexType = video::EVT_TANGENTS;
+	}
+
+	const u32 indexSize = buffer->getIndexType() == video::EIT_16BIT ? 2 : 4;
+	return writeData(file, &info, sizeof(info), 4) &&
+		writeMaterial(file, buffer->getMaterial()) &&
+		writePadding(file, IRR_BINARY_MESH_DATA_ALIGNMENT) &&
+		writeData(file, vertices, info.VertexCount * video::getVertexPitchFromType((video::E_VERTEX_TYPE)info.VertexType), 4) &&
+		writePadding(file, IRR_BINARY_MESH_DATA_ALIGNMENT) &&
+		writeData(file, buffer->getIndices(), info.IndexCount * indexSize, indexSize) &&
+		writePadding(file, 4);
+}
+
+
+bool CIrrBinaryMeshWriter::writeMaterial(io::IWriteFile* file, const video::SMaterial& material)
+{
+	bool ok = writeU32(file, material.MaterialType) &&
+		writeU32(file, material.AmbientColor.color) &&
+		writeU32(file, material.DiffuseColor.color) &&
+		writeU32(file, material.EmissiveColor.color) &&
+		writeU32(file, material.SpecularColor.color) &&
+
+		writeF32(file, material.Shininess) &&
+		writeF32(file, material.MaterialTypeParam) &&
+		writeF32(file, material.MaterialTypeParam2) &&
+		writeF32(file, material.Thickness) &&
+		writeF32(file, material.BlendFactor) &&
+		writeF32(file, material.PolygonOffsetDepthBias) &&
+		writeF32(file, material.PolygonOffsetSlopeScale) &&
+
+		writeU8(file, material.ZBuffer) &&
+		writeU8(file, material.AntiAliasing) &&
+		writeU8(file, material.ColorMask) &&
+		writeU8(file, material.ColorMaterial) &&
+		writeU8(file, material.BlendOperation) &&
+		writeU8(file, material.PolygonOffsetFactor) &&
+		writeU8(file, material.PolygonOffsetDirection) &&
+		writeU8(file, material.ZWriteEnable);
+
+	const u32 flags = (material.Wireframe ? 1 : 0) |
+		(material.PointCloud ? 2 : 0) |
+		(material.GouraudShading ? 4 : 0) |
+		(material.Lighting ? 8 : 0) |
+		(material.BackfaceCulling ? 16 : 0) |
+		(material.FrontfaceCulling ? 32 : 0) |
+		(material.FogEnable ? 64 : 0) |
+		(material.NormalizeNormals ? 128 : 0) |
+		(material.UseMipMaps ? 256 : 0);
+	ok = ok && writeU32(file, flags) &&
+		writeU32(file, video::MATERIAL_MAX_TEXTURES);
+
+	for (u32 i=0; i<video::MATERIAL_MAX_TEXTURES && ok; ++i)
+	{
+		const video::SMaterialLayer& layer = material.TextureLayer[i];
+		const bool hasMatrix = !layer.getTextureMatrix().isIdentity();
+		ok = writeString(file, layer.Texture ? core::stringc(layer.Texture->getName().getPath()) : core::stringc()) &&
+			writeU8(file, layer.TextureWrapU) &&
+			writeU8(file, layer.TextureWrapV) &&
+			writeU8(file, layer.TextureWrapW) &&
+			writeU8(file, layer.AnisotropicFilter) &&
+			writeU8(file, (u8)layer.LODBias) &&
+			writeU8(file, layer.BilinearFilter) &&
+			writeU8(file, layer.TrilinearFilter) &&
+			writeU8(file, hasMatrix) &&
+			(!hasMatrix || writeMatrix(file, layer.getTextureMatrix()));
+	}
+	return ok;
+}
+
+
+bool CIrrBinaryMeshWriter::writeJoints(io::IWriteFile* file, ISkinnedMesh* mesh)
+{
+	const core::array<ISkinnedMesh::SJoint*>& joints = mesh->getAllJoints();
+	bool ok = true;
+	for (u32 i=0; i<joints.size() && ok; ++i)
+	{
+		const ISkinnedMesh::SJoint* joint = joints[i];
+		ok = writeString(file, joint->Name) &&
+			writeMatrix(file, joint->LocalMatrix) &&
+			writeMatrix(file, joint->GlobalInversedMatrix) &&
+			writeU32(file, joint->Children.size());
+		for (u32 j=0; j<joint->Children.size() && ok; ++j)
+			ok = writeU32(file, (u32)joints.linear_search(joint->Children[j]));
+
+		ok = ok && writeU32(file, joint->AttachedMeshes.size()) &&
+			writeData(file, joint->AttachedMeshes.const_pointer(), joint->AttachedMeshes.size()*4, 4) &&
+			writeU32(file, joint->PositionKeys.size());
+		for (u32 j=0; j<joint->PositionKeys.size() && ok; ++j)
+		{
+			const ISkinnedMesh::SPositionKey& key = joint->PositionKeys[j];
+			ok = writeF32(file, key.frame) &&
+				writeF32(file, key.position.X) &&
+				writeF32(file, key.position.Y) &&
+				writeF32(file, key.position.Z);
+		}
+
+		ok = ok && writeU32(file, joint->ScaleKeys.size());
+		for (u32 j=0; j<joint->ScaleKeys.size() && ok; ++j)
+		{
+			const ISkinnedMesh::SScaleKey& key = joint->ScaleKeys[j];
+			ok = writeF32(file, key.frame) &&
+				writeF32(file, key.scale.X) &&
+				writeF32(file, key.scale.Y) &&
+				writeF32(file, key.scale.Z);
+		}
+
+		ok = ok && writeU32(file, joint->RotationKeys.size());
+		for (u32 j=0; j<joint->RotationKeys.size() && ok; ++j)
+		{
+			const ISkinnedMesh::SRotationKey& key = joint->RotationKeys[j];
+			ok = writeF32(file, key.frame) &&
+				writeF32(file, key.rotation.X) &&
+				writeF32(file, key.rotation.Y) &&
+				writeF32(file, key.rotation.Z) &&
+				writeF32(file, key.rotation.W);
+		}
+
+		ok = ok && writeU32(file, joint->Weights.size());
+		for (u32 j=0; j<joint->Weights.size() && ok; ++j)
+		{
+			const ISkinnedMesh::SWeight& weight = joint->Weights[j];
+			ok = writeU32(file, weight.buffer_id) &&
+				writeU32(file, weight.vertex_id) &&
+				writeF32(file, weight.strength);
+		}
+	}
+	return ok;
+}
+
+} // end namespace
+} // end namespace
+
+#endif // _IRR_COMPILE_WITH_IRR_BINARY_MESH_WRITER_
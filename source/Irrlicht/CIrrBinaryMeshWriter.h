@@ -0,0 +1,45 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_C_IRR_BINARY_MESH_WRITER_H_INCLUDED
+#define IRR_C_IRR_BINARY_MESH_WRITER_H_INCLUDED
+
+#include "IMeshWriter.h"
+#include "IWriteFile.h"
+#include "SMaterial.h"
+
+namespace irr
+{
+namespace scene
+{
+	class IMeshBuffer;
+	class ISkinnedMesh;
+
+	//! class to write binary .irrbmesh files
+	/** Vertices and indices are stored like in memory, so the loader can
+	read them without parsing. Static meshes and skinned meshes with their
+	joints and animation are supported. */
+	class CIrrBinaryMeshWriter : public IMeshWriter
+	{
+	public:
+
+		CIrrBinaryMeshWriter();
+
+		//! Returns the type of the mesh writer
+		virtual EMESH_WRITER_TYPE getType() const IRR_OVERRIDE;
+
+		//! writes a mesh
+		virtual bool writeMesh(io::IWriteFile* file, scene::IMesh* mesh, s32 flags=EMWF_NONE) IRR_OVERRIDE;
+
+	private:
+
+		bool writeMeshBuffer(io::IWriteFile* file, const IMeshBuffer* buffer);
+		bool writeMaterial(io::IWriteFile* file, const video::SMaterial& material);
+		bool writeJoints(io::IWriteFile* file, ISkinnedMesh* mesh);
+	};
+
+} // end namespace
+} // end namespace
+
+#endif
@@ -168,6 +168,7 @@ CIrrDeviceLinux::~CIrrDeviceLinux()
 	}
 
 	// Must free OpenGL textures etc before destroying context, so can't wait for stub destructor
+	releaseAsyncLoader();
 	if ( GUIEnvironment )
 	{
 		GUIEnvironment->drop();
@@ -13,6 +13,7 @@
 #include "CLogger.h"
 #include "irrString.h"
 #include "IRandomizer.h"
+#include "CAsyncLoader.h"
 
 namespace irr
 {
@@ -20,7 +21,7 @@ namespace irr
 CIrrDeviceStub::CIrrDeviceStub(const SIrrlichtCreationParameters& params)
 : IrrlichtDevice(), VideoDriver(0), GUIEnvironment(0), SceneManager(0),
 	Timer(0), CursorControl(0), UserReceiver(params.EventReceiver),
-	Logger(0), Operator(0), Randomizer(0), FileSystem(0),
+	Logger(0), Operator(0), Randomizer(0), AsyncLoader(0), FileSystem(0),
 	InputReceivingSceneManager(0), VideoModeList(0), ContextManager(0),
 	CreationParams(params), Close(false)
 {
@@ -54,6 +55,8 @@ CIrrDeviceStub::CIrrDeviceStub(const SIrrlichtCreationParameters& params)
 
 CIrrDeviceStub::~CIrrDeviceStub()
 {
+	releaseAsyncLoader();
+
 	VideoModeList->drop();
 
 	if (GUIEnvironment)
@@ -146,6 +149,28 @@ ITimer* CIrrDeviceStub::getTimer()
 }
 
 
+//! Returns the loader for meshes and textures in the background.
+IAsyncLoader* CIrrDeviceStub::getAsyncLoader()
+{
+	if (!AsyncLoader && SceneManager && VideoDriver)
+		AsyncLoader = new CAsyncLoader(SceneManager, VideoDriver, FileSystem);
+
+	return AsyncLoader;
+}
+
+
+//! Stops the worker threads of the async loader
+void CIrrDeviceStub::releaseAsyncLoader()
+{
+	if (AsyncLoader)
+	{
+		AsyncLoader->shutdown();
+		AsyncLoader->drop();
+		AsyncLoader = 0;
+	}
+}
+
+
 //! Returns the version of the engine.
 const char* CIrrDeviceStub::getVersion() const
 {
@@ -17,6 +17,7 @@ namespace irr
 	class ILogger;
 	class CLogger;
 	class IRandomizer;
+	class CAsyncLoader;
 
 	namespace gui
 	{
@@ -111,6 +112,9 @@ namespace irr
 		//! Creates a new default randomizer.
 		virtual IRandomizer* createDefaultRandomizer() const IRR_OVERRIDE;
 
+		//! Returns the loader for meshes and textures in the background.
+		virtual IAsyncLoader* getAsyncLoader() IRR_OVERRIDE;
+
 		//! Returns the operation system opertator object.
 		virtual IOSOperator* getOSOperator() IRR_OVERRIDE;
 
@@ -146,6 +150,9 @@ namespace irr
 
 		void createGUIAndScene();
 
+		//! Stops the async loader, must happen before driver and scene manager are released
+		void releaseAsyncLoader();
+
 		//! checks version of SDK and prints warning if there might be a problem
 		bool checkVersion(const char* version);
 
@@ -167,6 +174,7 @@ namespace irr
 		CLogger* Logger;
 		IOSOperator* Operator;
 		IRandomizer* Randomizer;
+		CAsyncLoader* AsyncLoader;
 		io::IFileSystem* FileSystem;
 		scene::ISceneManager* InputReceivingSceneManager;
 
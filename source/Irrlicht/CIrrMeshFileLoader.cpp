@@ -430,6 +430,9 @@ void CIrrMeshFileLoader::readMeshBuffer(io::IXMLReader* reader, int vertexCount,
 				Vertices.push_back(vtx);
 			}
 			break;
+
+			default:
+			break;
 			};
 
 		}
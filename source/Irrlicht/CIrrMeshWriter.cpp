@@ -11,6 +11,7 @@
 #include "IWriteFile.h"
 #include "IXMLWriter.h"
 #include "IMesh.h"
+#include "CMeshBufferQuantized.h"
 #include "IAttributes.h"
 
 namespace irr
@@ -161,7 +162,14 @@ void CIrrMeshWriter::writeMeshBuffer(const scene::IMeshBuffer* buffer)
 
 	// write vertices
 
-	const core::stringw vertexTypeStr = video::sBuiltInVertexTypeNames[buffer->getVertexType()];
+	// quantized vertices are written decoded as standard or tangent vertices
+	video::E_VERTEX_TYPE vertexType = buffer->getVertexType();
+	if (vertexType == video::EVT_QUANTIZED)
+		vertexType = video::EVT_STANDARD;
+	else if (vertexType == video::EVT_QUANTIZED_TANGENTS)
+		vertexType = video::EVT_TANGENTS;
+
+	const core::stringw vertexTypeStr = video::sBuiltInVertexTypeNames[vertexType];
 
 	Writer->writeElement(L"vertices", false,
 		L"type", vertexTypeStr.c_str(),
@@ -239,6 +247,34 @@ void CIrrMeshWriter::writeMeshBuffer(const scene::IMeshBuffer* buffer)
 			}
 		}
 		break;
+	case video::EVT_QUANTIZED:
+	case video::EVT_QUANTIZED_TANGENTS:
+		{
+			for (u32 j=0; j<vertexCount; ++j)
+			{
+				const video::S3DVertexTangents vtx = getDecodedVertex(buffer, j);
+				core::stringw str = getVectorAsStringLine(vtx.Pos);
+				str += L" ";
+				str += getVectorAsStringLine(vtx.Normal);
+
+				char tmp[12];
+				sprintf(tmp, " %02x%02x%02x%02x ", vtx.Color.getAlpha(), vtx.Color.getRed(), vtx.Color.getGreen(), vtx.Color.getBlue());
+				str += tmp;
+
+				str += getVectorAsStringLine(vtx.TCoords);
+				if (vertexType == video::EVT_TANGENTS)
+				{
+					str += L" ";
+					str += getVectorAsStringLine(vtx.Tangent);
+					str += L" ";
+					str += getVectorAsStringLine(vtx.Binormal);
+				}
+
+				Writer->writeText(str.c_str());
+				Writer->writeLineBreak();
+			}
+		}
+		break;
 	}
 
 	Writer->writeClosingTag(L"vertices");
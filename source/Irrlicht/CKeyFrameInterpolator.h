@@ -0,0 +1,199 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_C_KEY_FRAME_INTERPOLATOR_H_INCLUDED
+#define IRR_C_KEY_FRAME_INTERPOLATOR_H_INCLUDED
+
+#include "irrArray.h"
+#include "irrMath.h"
+#include "vector3d.h"
+
+namespace irr
+{
+namespace scene
+{
+
+//! Interpolates vertex keyframes of morph target meshes like MD2 and MD3.
+/** Keyframes are stored unpacked as structure of arrays. Each frame is a
+block of six component streams (position x, y, z and normal x, y, z) with
+one float per vertex each, so blending two frames is a straight loop over
+contiguous floats which compilers turn into SIMD code.
+Compared to the packed frames of the files this takes more memory, 24 bytes
+per vertex and frame, so meshes drop their packed frames after unpacking.
+The last few blended frames are kept in a small cache. Scene nodes sharing
+one mesh usually play the same animations, so they often ask for a frame pair
+and blend factor which has been calculated just before. */
+class CKeyFrameInterpolator
+{
+public:
+
+	//! Number of components stored per vertex
+	enum { COMPONENT_COUNT = 6 };
+
+	//! Number of interpolated frames which are cached
+	enum { CACHE_SIZE = 4 };
+
+	//! Blend factors are quantized to this many steps
+	enum { BLEND_STEPS = 256 };
+
+	CKeyFrameInterpolator() : FrameCount(0), VertexCount(0), Tick(0)
+	{
+	}
+
+	//! Allocates memory for the given amount of frames and vertices
+	void setup(u32 frameCount, u32 vertexCount)
+	{
+		FrameCount = frameCount;
+		VertexCount = vertexCount;
+		Frames.set_used(frameCount * vertexCount * COMPONENT_COUNT);
+		for (u32 i=0; i<CACHE_SIZE; ++i)
+		{
+			Cache[i].Data.clear();
+			Cache[i].FrameA = -1;
+			Cache[i].FrameB = -1;
+			Cache[i].Blend = -1;
+			Cache[i].LastUsed = 0;
+		}
+		Tick = 0;
+	}
+
+	u32 getFrameCount() const
+	{
+		return FrameCount;
+	}
+
+	u32 getVertexCount() const
+	{
+		return VertexCount;
+	}
+
+	//! Stores position and normal of one vertex in a frame
+	void setVertex(u32 frame, u32 vertex, const core::vector3df& pos, const core::vector3df& normal)
+	{
+		f32* dst = getFrame(frame) + vertex;
+		dst[0] = pos.X;
+		dst[VertexCount] = pos.Y;
+		dst[VertexCount*2] = pos.Z;
+		dst[VertexCount*3] = normal.X;
+		dst[VertexCount*4] = normal.Y;
+		dst[VertexCount*5] = normal.Z;
+	}
+
+	//! Returns the unpacked data of a frame
+	f32* getFrame(u32 frame)
+	{
+		return Frames.pointer() + frame * VertexCount * COMPONENT_COUNT;
+	}
+
+	const f32* getFrame(u32 frame) const
+	{
+		return Frames.const_pointer() + frame * VertexCount * COMPONENT_COUNT;
+	}
+
+	//! Blends frameA towards frameB.
+	/** \param blend 0 returns frameA, 1 returns frameB. Quantized to
+	BLEND_STEPS.
+	\return Pointer to the interpolated data, laid out like a frame. Valid
+	until the next call. */
+	const f32* interpolate(u32 frameA, u32 frameB, f32 blend)
+	{
+		const s32 step = blendStep(blend);
+		if (frameA == frameB || step == 0)
+			return getFrame(frameA);
+		if (step == BLEND_STEPS)
+			return getFrame(frameB);
+
+		++Tick;
+
+		SCacheEntry* slot = &Cache[0];
+		for (u32 i=0; i<CACHE_SIZE; ++i)
+		{
+			SCacheEntry& e = Cache[i];
+			if (e.FrameA == (s32)frameA && e.FrameB == (s32)frameB && e.Blend == step)
+			{
+				e.LastUsed = Tick;
+				return e.Data.const_pointer();
+			}
+			if (e.LastUsed < slot->LastUsed)
+				slot = &e;
+		}
+
+		slot->FrameA = frameA;
+		slot->FrameB = frameB;
+		slot->Blend = step;
+		slot->LastUsed = Tick;
+		slot->Data.set_used(VertexCount * COMPONENT_COUNT);
+
+		lerp(slot->Data.pointer(), getFrame(frameA), getFrame(frameB),
+			VertexCount * COMPONENT_COUNT, getQuantizedBlend(blend));
+
+		return slot->Data.const_pointer();
+	}
+
+	//! Returns the blend factor interpolate() uses instead of blend
+	/** Use it for everything which has to match the interpolated vertices,
+	like bounding boxes. */
+	static f32 getQuantizedBlend(f32 blend)
+	{
+		return (f32)blendStep(blend) * core::reciprocal((f32)BLEND_STEPS);
+	}
+
+	//! Writes interpolated data into a vertex array
+	/** \param vertices Vertex type with Pos and Normal members.
+	\param data Result of interpolate() or getFrame()
+	\param first Index of first vertex of data to copy
+	\param count Number of vertices to copy */
+	template <class T>
+	void copyTo(T* vertices, const f32* data, u32 first, u32 count) const
+	{
+		const f32* px = data + first;
+		const f32* py = px + VertexCount;
+		const f32* pz = py + VertexCount;
+		const f32* nx = pz + VertexCount;
+		const f32* ny = nx + VertexCount;
+		const f32* nz = ny + VertexCount;
+
+		for (u32 i=0; i<count; ++i)
+		{
+			vertices[i].Pos.set(px[i], py[i], pz[i]);
+			vertices[i].Normal.set(nx[i], ny[i], nz[i]);
+		}
+	}
+
+private:
+
+	static s32 blendStep(f32 blend)
+	{
+		return core::s32_clamp(core::round32(blend * BLEND_STEPS), 0, BLEND_STEPS);
+	}
+
+	//! out = a + (b - a) * t
+	static void lerp(f32* out, const f32* a, const f32* b, u32 count, f32 t)
+	{
+		for (u32 i=0; i<count; ++i)
+			out[i] = a[i] + (b[i] - a[i]) * t;
+	}
+
+	struct SCacheEntry
+	{
+		SCacheEntry() : FrameA(-1), FrameB(-1), Blend(-1), LastUsed(0) {}
+
+		core::array<f32> Data;
+		s32 FrameA;
+		s32 FrameB;
+		s32 Blend;
+		u32 LastUsed;
+	};
+
+	core::array<f32> Frames;
+	SCacheEntry Cache[CACHE_SIZE];
+	u32 FrameCount;
+	u32 VertexCount;
+	u32 Tick;
+};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
@@ -358,7 +358,8 @@ bool CMD2MeshFileLoader::loadFile(io::IReadFile* file, CAnimatedMeshMD2* mesh)
 	delete [] triangles;
 	delete [] textureCoords;
 
-	// init buffer with start frame.
+	// unpack keyframes and init buffer with start frame.
+	mesh->prepareKeyFrames();
 	mesh->getMesh(0);
 	return true;
 }
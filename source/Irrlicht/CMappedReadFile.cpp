@@ -0,0 +1,214 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CMappedReadFile.h"
+#include "CReadFile.h"
+
+#if defined(_IRR_WINDOWS_API_) && !defined(_IRR_XBOX_PLATFORM_)
+	#define IRR_MAP_FILES_WIN32
+	#include <windows.h>
+#elif defined(_IRR_POSIX_API_) || defined(_IRR_OSX_PLATFORM_)
+	#define IRR_MAP_FILES_POSIX
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+#include <string.h>
+
+namespace irr
+{
+namespace io
+{
+
+namespace
+{
+	//! Size of a file on disk without opening it, -1 when unknown
+	long getFileSizeOnDisk(const io::path& fileName)
+	{
+#if defined(IRR_MAP_FILES_WIN32)
+		WIN32_FILE_ATTRIBUTE_DATA info;
+#if defined(_IRR_WCHAR_FILESYSTEM)
+		if (!GetFileAttributesExW(fileName.c_str(), GetFileExInfoStandard, &info))
+#else
+		if (!GetFileAttributesExA(fileName.c_str(), GetFileExInfoStandard, &info))
+#endif
+			return -1;
+		if (info.nFileSizeHigh != 0 || info.nFileSizeLow > 0x7fffffff)
+			return 0x7fffffff;
+		return (long)info.nFileSizeLow;
+#elif defined(IRR_MAP_FILES_POSIX)
+		struct stat info;
+		if (stat(fileName.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+			return -1;
+		return (long)info.st_size == info.st_size ? (long)info.st_size : -1;
+#else
+		return -1;
+#endif
+	}
+}
+
+
+CMappedReadFile::CMappedReadFile(const io::path& fileName)
+: Buffer(0), FileSize(0), Pos(0), Filename(fileName)
+#if defined(_IRR_WINDOWS_API_)
+, FileHandle(0), MappingHandle(0)
+#endif
+{
+	#ifdef _DEBUG
+	setDebugName("CMappedReadFile");
+	#endif
+
+	mapFile();
+}
+
+
+CMappedReadFile::~CMappedReadFile()
+{
+#if defined(IRR_MAP_FILES_WIN32)
+	if (Buffer)
+		UnmapViewOfFile(Buffer);
+	if (MappingHandle)
+		CloseHandle(MappingHandle);
+	if (FileHandle)
+		CloseHandle(FileHandle);
+#elif defined(IRR_MAP_FILES_POSIX)
+	if (Buffer)
+		munmap(const_cast<u8*>(Buffer), FileSize);
+#endif
+}
+
+
+//! returns how much was read
+size_t CMappedReadFile::read(void* buffer, size_t sizeToRead)
+{
+	if (!isOpen())
+		return 0;
+
+	const size_t available = (size_t)(FileSize - Pos);
+	if (sizeToRead > available)
+		sizeToRead = available;
+
+	memcpy(buffer, Buffer + Pos, sizeToRead);
+	Pos += (long)sizeToRead;
+	return sizeToRead;
+}
+
+
+//! changes position in file, returns true if successful
+//! if relativeMovement==true, the pos is changed relative to current pos,
+//! otherwise from begin of file
+bool CMappedReadFile::seek(long finalPos, bool relativeMovement)
+{
+	if (relativeMovement)
+		finalPos += Pos;
+
+	if (finalPos < 0 || finalPos > FileSize)
+		return false;
+
+	Pos = finalPos;
+	return true;
+}
+
+
+//! returns size of file
+long CMappedReadFile::getSize() const
+{
+	return FileSize;
+}
+
+
+//! returns where in the file we are.
+long CMappedReadFile::getPos() const
+{
+	return Pos;
+}
+
+
+//! maps the file
+void CMappedReadFile::mapFile()
+{
+	if (Filename.size() == 0)
+		return;
+
+#if defined(IRR_MAP_FILES_WIN32)
+#if defined(_IRR_WCHAR_FILESYSTEM)
+	HANDLE file = CreateFileW(Filename.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+#else
+	HANDLE file = CreateFileA(Filename.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+#endif
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+	FileHandle = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0 || size.QuadPart > 0x7fffffff)
+		return;
+
+	MappingHandle = CreateFileMapping(file, 0, PAGE_READONLY, 0, 0, 0);
+	if (!MappingHandle)
+		return;
+
+	Buffer = (const u8*)MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (Buffer)
+		FileSize = (long)size.QuadPart;
+
+#elif defined(IRR_MAP_FILES_POSIX)
+	const int file = open(Filename.c_str(), O_RDONLY);
+	if (file < 0)
+		return;
+
+	struct stat info;
+	if (fstat(file, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0 &&
+		(long)info.st_size == info.st_size)
+	{
+		void* memory = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (memory != MAP_FAILED)
+		{
+			Buffer = (const u8*)memory;
+			FileSize = (long)info.st_size;
+		}
+	}
+
+	// the mapping stays valid after closing
+	close(file);
+#endif
+}
+
+
+//! returns name of file
+const io::path& CMappedReadFile::getFileName() const
+{
+	return Filename;
+}
+
+
+IReadFile* CMappedReadFile::createMappedReadFile(const io::path& fileName)
+{
+	CMappedReadFile* file = new CMappedReadFile(fileName);
+	if (file->isOpen())
+		return file;
+
+	file->drop();
+	return 0;
+}
+
+
+IReadFile* CMappedReadFile::createReadFile(const io::path& fileName, long mappingThreshold)
+{
+	// the size is checked before opening, so each file is only opened once
+	if (mappingThreshold > 0 && getFileSizeOnDisk(fileName) >= mappingThreshold)
+	{
+		IReadFile* mapped = createMappedReadFile(fileName);
+		if (mapped)
+			return mapped;
+	}
+	return CReadFile::createReadFile(fileName);
+}
+
+
+} // end namespace io
+} // end namespace irr
+
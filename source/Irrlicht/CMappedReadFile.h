@@ -0,0 +1,92 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_C_MAPPED_READ_FILE_H_INCLUDED
+#define IRR_C_MAPPED_READ_FILE_H_INCLUDED
+
+#include "IMemoryReadFile.h"
+#include "irrString.h"
+
+namespace irr
+{
+
+namespace io
+{
+
+	/*!
+		Class for reading a real file from disk which is mapped into memory.
+		Loaders can parse the mapped bytes directly with getBuffer(),
+		pages are only read from disk when they are touched.
+	*/
+	class CMappedReadFile : public IMemoryReadFile
+	{
+	public:
+
+		CMappedReadFile(const io::path& fileName);
+
+		virtual ~CMappedReadFile();
+
+		//! returns how much was read
+		virtual size_t read(void* buffer, size_t sizeToRead) IRR_OVERRIDE;
+
+		//! changes position in file, returns true if successful
+		virtual bool seek(long finalPos, bool relativeMovement = false) IRR_OVERRIDE;
+
+		//! returns size of file
+		virtual long getSize() const IRR_OVERRIDE;
+
+		//! returns if the file is mapped
+		bool isOpen() const
+		{
+			return Buffer != 0;
+		}
+
+		//! returns where in the file we are.
+		virtual long getPos() const IRR_OVERRIDE;
+
+		//! returns name of file
+		virtual const io::path& getFileName() const IRR_OVERRIDE;
+
+		//! Get the type of the class implementing this interface
+		virtual EREAD_FILE_TYPE getType() const IRR_OVERRIDE
+		{
+			return ERFT_MAPPED_READ_FILE;
+		}
+
+		//! Get direct access to the mapped file
+		virtual const void *getBuffer() const IRR_OVERRIDE
+		{
+			return Buffer;
+		}
+
+		//! create mapped read file on disk.
+		/** \return 0 if the file can't be mapped, for example because it's
+		empty or the platform doesn't support mapping files. */
+		static IReadFile* createMappedReadFile(const io::path& fileName);
+
+		//! open a file on disk, mapped when it has at least mappingThreshold bytes
+		/** \param mappingThreshold 0 to never map the file
+		\return A CMappedReadFile or a CReadFile, 0 if the file can't be opened. */
+		static IReadFile* createReadFile(const io::path& fileName, long mappingThreshold);
+
+	private:
+
+		//! maps the file
+		void mapFile();
+
+		const u8* Buffer;
+		long FileSize;
+		long Pos;
+		io::path Filename;
+#if defined(_IRR_WINDOWS_API_)
+		void* FileHandle;
+		void* MappingHandle;
+#endif
+	};
+
+} // end namespace io
+} // end namespace irr
+
+#endif
+
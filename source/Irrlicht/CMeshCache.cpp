@@ -5,6 +5,8 @@
 #include "CMeshCache.h"
 #include "IAnimatedMesh.h"
 #include "IMesh.h"
+#include "IMeshBuffer.h"
+#include "ISkinnedMesh.h"
 
 namespace irr
 {
@@ -14,6 +16,11 @@ namespace scene
 static const io::SNamedPath emptyNamedPath;
 
 
+CMeshCache::CMeshCache() : MemoryBudget(0), Tick(0)
+{
+}
+
+
 CMeshCache::~CMeshCache()
 {
 	clear();
@@ -27,8 +34,13 @@ void CMeshCache::addMesh(const io::path& filename, IAnimatedMesh* mesh)
 
 	MeshEntry e ( filename );
 	e.Mesh = mesh;
+	e.Memory = getMeshMemory(mesh);
+	e.LastUsed = ++Tick;
 
 	Meshes.push_back(e);
+	Statistics.MemoryUsed += e.Memory;
+
+	evictUnusedMeshes(mesh);
 }
 
 
@@ -41,8 +53,7 @@ void CMeshCache::removeMesh(const IMesh* const mesh)
 	{
 		if (Meshes[i].Mesh == mesh || (Meshes[i].Mesh && Meshes[i].Mesh->getMesh(0) == mesh))
 		{
-			Meshes[i].Mesh->drop();
-			Meshes.erase(i);
+			eraseMesh(i);
 			return;
 		}
 	}
@@ -84,7 +95,15 @@ IAnimatedMesh* CMeshCache::getMeshByName(const io::path& name)
 {
 	MeshEntry e ( name );
 	s32 id = Meshes.binary_search(e);
-	return (id != -1) ? Meshes[id].Mesh : 0;
+	if (id == -1)
+	{
+		++Statistics.Misses;
+		return 0;
+	}
+
+	++Statistics.Hits;
+	Meshes[id].LastUsed = ++Tick;
+	return Meshes[id].Mesh;
 }
 
 
@@ -145,7 +164,8 @@ bool CMeshCache::renameMesh(const IMesh* const mesh, const io::path& name)
 //! returns if a mesh already was loaded
 bool CMeshCache::isMeshLoaded(const io::path& name)
 {
-	return getMeshByName(name) != 0;
+	MeshEntry e ( name );
+	return Meshes.binary_search(e) != -1;
 }
 
 
@@ -156,6 +176,7 @@ void CMeshCache::clear()
 		Meshes[i].Mesh->drop();
 
 	Meshes.clear();
+	Statistics.MemoryUsed = 0;
 }
 
 //! Clears all meshes that are held in the mesh cache but not used anywhere else.
@@ -165,14 +186,108 @@ void CMeshCache::clearUnusedMeshes()
 	{
 		if (Meshes[i].Mesh->getReferenceCount() == 1)
 		{
-			Meshes[i].Mesh->drop();
-			Meshes.erase(i);
+			eraseMesh(i);
 			--i;
 		}
 	}
 }
 
 
+//! Sets how much memory the meshes in the cache may use.
+void CMeshCache::setMemoryBudget(u32 bytes)
+{
+	MemoryBudget = bytes;
+	evictUnusedMeshes(0);
+}
+
+
+//! Returns the memory budget set with setMemoryBudget()
+u32 CMeshCache::getMemoryBudget() const
+{
+	return MemoryBudget;
+}
+
+
+//! Returns hit, miss and eviction counters and the memory used
+const SMeshCacheStatistics& CMeshCache::getStatistics() const
+{
+	return Statistics;
+}
+
+
+//! Estimates the memory of vertices, indices and animation data of a mesh
+u32 CMeshCache::getMeshMemory(const IAnimatedMesh* mesh)
+{
+	// the buffers of an animated mesh are those of its current frame
+	u32 memory = 0;
+	u32 vertexCount = 0;
+	for (u32 i=0; i<mesh->getMeshBufferCount(); ++i)
+	{
+		const IMeshBuffer* mb = mesh->getMeshBuffer(i);
+		vertexCount += mb->getVertexCount();
+		memory += mb->getVertexCount() * video::getVertexPitchFromType(mb->getVertexType());
+		memory += mb->getIndexCount() * (mb->getIndexType() == video::EIT_16BIT ? sizeof(u16) : sizeof(u32));
+	}
+
+	switch (mesh->getMeshType())
+	{
+	case EAMT_SKINNED:
+		{
+			const core::array<ISkinnedMesh::SJoint*>& joints = static_cast<const ISkinnedMesh*>(mesh)->getAllJoints();
+			for (u32 i=0; i<joints.size(); ++i)
+			{
+				memory += joints[i]->PositionKeys.size() * sizeof(ISkinnedMesh::SPositionKey);
+				memory += joints[i]->ScaleKeys.size() * sizeof(ISkinnedMesh::SScaleKey);
+				memory += joints[i]->RotationKeys.size() * sizeof(ISkinnedMesh::SRotationKey);
+				memory += joints[i]->Weights.size() * sizeof(ISkinnedMesh::SWeight);
+			}
+		}
+		break;
+	case EAMT_MD2:
+	case EAMT_MD3:
+		// keyframes keep position and normal of each vertex
+		memory += mesh->getFrameCount() * vertexCount * 6 * sizeof(f32);
+		break;
+	default:
+		break;
+	}
+
+	return memory;
+}
+
+
+//! Removes unused meshes, least recently used first, until the cache fits into the budget
+void CMeshCache::evictUnusedMeshes(const IAnimatedMesh* keep)
+{
+	while (MemoryBudget && Statistics.MemoryUsed > MemoryBudget)
+	{
+		s32 oldest = -1;
+		for (u32 i=0; i<Meshes.size(); ++i)
+		{
+			const MeshEntry& e = Meshes[i];
+			if (e.Mesh == keep || e.Mesh->getReferenceCount() != 1)
+				continue;
+			if (oldest == -1 || e.LastUsed < Meshes[oldest].LastUsed)
+				oldest = (s32)i;
+		}
+		if (oldest == -1)
+			return;
+
+		eraseMesh(oldest);
+		++Statistics.Evictions;
+	}
+}
+
+
+//! Drops the mesh at index and removes it from the list
+void CMeshCache::eraseMesh(u32 index)
+{
+	Statistics.MemoryUsed -= Meshes[index].Memory;
+	Meshes[index].Mesh->drop();
+	Meshes.erase(index);
+}
+
+
 } // end namespace scene
 } // end namespace irr
 
@@ -17,6 +17,8 @@ namespace scene
 	{
 	public:
 
+		CMeshCache();
+
 		virtual ~CMeshCache();
 
 		//! Adds a mesh to the internal list of loaded meshes.
@@ -94,8 +96,27 @@ namespace scene
 		//! Clears all meshes that are held in the mesh cache but not used anywhere else.
 		virtual void clearUnusedMeshes() IRR_OVERRIDE;
 
+		//! Sets how much memory the meshes in the cache may use.
+		virtual void setMemoryBudget(u32 bytes) IRR_OVERRIDE;
+
+		//! Returns the memory budget set with setMemoryBudget()
+		virtual u32 getMemoryBudget() const IRR_OVERRIDE;
+
+		//! Returns hit, miss and eviction counters and the memory used
+		virtual const SMeshCacheStatistics& getStatistics() const IRR_OVERRIDE;
+
 	protected:
 
+		//! Estimates the memory of vertices, indices and animation data of a mesh
+		static u32 getMeshMemory(const IAnimatedMesh* mesh);
+
+		//! Removes unused meshes, least recently used first, until the cache fits into the budget
+		/** \param keep Mesh which must not be removed */
+		void evictUnusedMeshes(const IAnimatedMesh* keep);
+
+		//! Drops the mesh at index and removes it from the list
+		void eraseMesh(u32 index);
+
 		struct MeshEntry
 		{
 			MeshEntry ( const io::path& name )
@@ -104,6 +125,8 @@ namespace scene
 			}
 			io::SNamedPath NamedPath;
 			IAnimatedMesh* Mesh;
+			u32 Memory;
+			u32 LastUsed;
 
 			bool operator < (const MeshEntry& other) const
 			{
@@ -113,6 +136,10 @@ namespace scene
 
 		//! loaded meshes
 		core::array<MeshEntry> Meshes;
+
+		SMeshCacheStatistics Statistics;
+		u32 MemoryBudget;
+		u32 Tick;
 	};
 
 
@@ -5,6 +5,9 @@
 #include "CMeshManipulator.h"
 #include "SMesh.h"
 #include "CMeshBuffer.h"
+#include "CMeshBufferQuantized.h"
+#include "CDynamicMeshBuffer.h"
+#include "CVertexHashGrid.h"
 #include "SAnimatedMesh.h"
 #include "os.h"
 #include "irrMap.h"
@@ -695,6 +698,8 @@ IMesh* CMeshManipulator::createMeshUniquePrimitives(IMesh* mesh) const
 				buffer->drop();
 			}
 			break;
+		default:
+			break;
 		}// end switch
 
 	}// end for all mesh buffers
@@ -704,188 +709,205 @@ IMesh* CMeshManipulator::createMeshUniquePrimitives(IMesh* mesh) const
 }
 
 
+namespace
+{
+//! Welds the vertices of one mesh buffer for createMeshWelded
+/** TBuffer is the 16 bit mesh buffer type for TVertex, buffers with more
+vertices become CDynamicMeshBuffers with 32 bit indices. */
+template <class TBuffer, class TVertex>
+IMeshBuffer* createWeldedBuffer(const IMeshBuffer* mb, f32 tolerance)
+{
+	const TVertex* v = static_cast<const TVertex*>(mb->getVertices());
+	const u32 vertexCount = mb->getVertexCount();
+
+	core::array<u32> redirects;
+	const u32 kept = weldVertices(v, vertexCount, tolerance, redirects);
+
+	// Clean up any degenerate tris
+	const u32 indexCount = mb->getIndexCount();
+	core::array<u32> indices;
+	indices.reallocate(indexCount);
+	for (u32 i=0; i+2 < indexCount; i+=3)
+	{
+		u32 a, b, c;
+		if (mb->getIndexType() == video::EIT_16BIT)
+		{
+			const u16* idx = mb->getIndices();
+			a = redirects[idx[i]];
+			b = redirects[idx[i+1]];
+			c = redirects[idx[i+2]];
+		}
+		else
+		{
+			const u32* idx = reinterpret_cast<const u32*>(mb->getIndices());
+			a = redirects[idx[i]];
+			b = redirects[idx[i+1]];
+			c = redirects[idx[i+2]];
+		}
+
+		if (a == b || b == c || a == c)
+			continue;
+
+		indices.push_back(a);
+		indices.push_back(b);
+		indices.push_back(c);
+	}
+
+	if (kept <= 65536)
+	{
+		TBuffer* buffer = new TBuffer();
+		buffer->BoundingBox = mb->getBoundingBox();
+		buffer->Material = mb->getMaterial();
+		buffer->Vertices.reallocate(kept);
+		for (u32 i=0; i < vertexCount; ++i)
+		{
+			if (redirects[i] == buffer->Vertices.size())
+				buffer->Vertices.push_back(v[i]);
+		}
+		buffer->Indices.reallocate(indices.size());
+		for (u32 i=0; i < indices.size(); ++i)
+			buffer->Indices.push_back((u16)indices[i]);
+		return buffer;
+	}
+
+	CDynamicMeshBuffer* buffer = new CDynamicMeshBuffer(mb->getVertexType(), video::EIT_32BIT);
+	buffer->setBoundingBox(mb->getBoundingBox());
+	buffer->getMaterial() = mb->getMaterial();
+	IVertexBuffer& vertices = buffer->getVertexBuffer();
+	vertices.reallocate(kept);
+	for (u32 i=0; i < vertexCount; ++i)
+	{
+		if (redirects[i] == vertices.size())
+			vertices.push_back(v[i]);
+	}
+	IIndexBuffer& outIndices = buffer->getIndexBuffer();
+	outIndices.set_used(indices.size());
+	memcpy(outIndices.pointer(), indices.const_pointer(), indices.size() * sizeof(u32));
+	return buffer;
+}
+}
+
+
 //! Creates a copy of a mesh, which will have identical vertices welded together
-// not yet 32bit
 IMesh* CMeshManipulator::createMeshWelded(IMesh *mesh, f32 tolerance) const
 {
 	SMesh* clone = new SMesh();
 	clone->BoundingBox = mesh->getBoundingBox();
 
-	core::array<u16> redirects;
-
 	for (u32 b=0; b<mesh->getMeshBufferCount(); ++b)
 	{
 		const IMeshBuffer* const mb = mesh->getMeshBuffer(b);
-		// reset redirect list
-		redirects.set_used(mb->getVertexCount());
-
-		const u16* indices = 0;
-		u32 indexCount = 0;
-		core::array<u16>* outIdx = 0;
+		IMeshBuffer* buffer = 0;
 
 		switch(mb->getVertexType())
 		{
 		case video::EVT_STANDARD:
-		{
-			SMeshBuffer* buffer = new SMeshBuffer();
-			buffer->BoundingBox = mb->getBoundingBox();
-			buffer->Material = mb->getMaterial();
-			clone->addMeshBuffer(buffer);
-			buffer->drop();
-
-			video::S3DVertex* v =
-					(video::S3DVertex*)mb->getVertices();
-
-			u32 vertexCount = mb->getVertexCount();
-
-			indices = mb->getIndices();
-			indexCount = mb->getIndexCount();
-			outIdx = &buffer->Indices;
-
-			buffer->Vertices.reallocate(vertexCount);
-
-			for (u32 i=0; i < vertexCount; ++i)
-			{
-				bool found = false;
-				for (u32 j=0; j < i; ++j)
-				{
-					if ( v[i].Pos.equals( v[j].Pos, tolerance) &&
-						 v[i].Normal.equals( v[j].Normal, tolerance) &&
-						 v[i].TCoords.equals( v[j].TCoords ) &&
-						(v[i].Color == v[j].Color) )
-					{
-						redirects[i] = redirects[j];
-						found = true;
-						break;
-					}
-				}
-				if (!found)
-				{
-					redirects[i] = buffer->Vertices.size();
-					buffer->Vertices.push_back(v[i]);
-				}
-			}
-
+			buffer = createWeldedBuffer<SMeshBuffer, video::S3DVertex>(mb, tolerance);
 			break;
-		}
 		case video::EVT_2TCOORDS:
+			buffer = createWeldedBuffer<SMeshBufferLightMap, video::S3DVertex2TCoords>(mb, tolerance);
+			break;
+		case video::EVT_TANGENTS:
+			buffer = createWeldedBuffer<SMeshBufferTangents, video::S3DVertexTangents>(mb, tolerance);
+			break;
+		default:
+			os::Printer::log("Cannot create welded mesh, vertex type unsupported", ELL_ERROR);
+			break;
+		}
+
+		if (buffer)
 		{
-			SMeshBufferLightMap* buffer = new SMeshBufferLightMap();
-			buffer->BoundingBox = mb->getBoundingBox();
-			buffer->Material = mb->getMaterial();
 			clone->addMeshBuffer(buffer);
 			buffer->drop();
+		}
+	}
+	return clone;
+}
 
-			video::S3DVertex2TCoords* v =
-					(video::S3DVertex2TCoords*)mb->getVertices();
-
-			u32 vertexCount = mb->getVertexCount();
 
-			indices = mb->getIndices();
-			indexCount = mb->getIndexCount();
-			outIdx = &buffer->Indices;
+namespace
+{
+//! Quantizes the vertices of one mesh buffer for createMeshQuantized
+/** The quantization covers the bounding box of the positions and the range
+of the texture coordinates. */
+template <class TBuffer, class TVertex>
+IMeshBuffer* createQuantizedBuffer(const IMeshBuffer* mb)
+{
+	const TVertex* v = static_cast<const TVertex*>(mb->getVertices());
+	const u32 vertexCount = mb->getVertexCount();
 
-			buffer->Vertices.reallocate(vertexCount);
+	TBuffer* buffer = new TBuffer();
+	buffer->Material = mb->getMaterial();
+	buffer->PrimitiveType = mb->getPrimitiveType();
+	buffer->MappingHint_Vertex = mb->getHardwareMappingHint_Vertex();
+	buffer->MappingHint_Index = mb->getHardwareMappingHint_Index();
 
-			for (u32 i=0; i < vertexCount; ++i)
-			{
-				bool found = false;
-				for (u32 j=0; j < i; ++j)
-				{
-					if ( v[i].Pos.equals( v[j].Pos, tolerance) &&
-						 v[i].Normal.equals( v[j].Normal, tolerance) &&
-						 v[i].TCoords.equals( v[j].TCoords ) &&
-						 v[i].TCoords2.equals( v[j].TCoords2 ) &&
-						(v[i].Color == v[j].Color) )
-					{
-						redirects[i] = redirects[j];
-						found = true;
-						break;
-					}
-				}
-				if (!found)
-				{
-					redirects[i] = buffer->Vertices.size();
-					buffer->Vertices.push_back(v[i]);
-				}
-			}
-			break;
-		}
-		case video::EVT_TANGENTS:
+	if (vertexCount)
+	{
+		core::aabbox3df box(v[0].Pos);
+		core::vector2df minTCoords(v[0].TCoords);
+		core::vector2df maxTCoords(v[0].TCoords);
+		for (u32 i=1; i < vertexCount; ++i)
 		{
-			SMeshBufferTangents* buffer = new SMeshBufferTangents();
-			buffer->BoundingBox = mb->getBoundingBox();
-			buffer->Material = mb->getMaterial();
-			clone->addMeshBuffer(buffer);
-			buffer->drop();
-
-			video::S3DVertexTangents* v =
-					(video::S3DVertexTangents*)mb->getVertices();
-
-			u32 vertexCount = mb->getVertexCount();
+			box.addInternalPoint(v[i].Pos);
+			minTCoords.X = core::min_(minTCoords.X, v[i].TCoords.X);
+			minTCoords.Y = core::min_(minTCoords.Y, v[i].TCoords.Y);
+			maxTCoords.X = core::max_(maxTCoords.X, v[i].TCoords.X);
+			maxTCoords.Y = core::max_(maxTCoords.Y, v[i].TCoords.Y);
+		}
+		buffer->Quantization.setRanges(box.MinEdge, box.MaxEdge, minTCoords, maxTCoords);
+	}
 
-			indices = mb->getIndices();
-			indexCount = mb->getIndexCount();
-			outIdx = &buffer->Indices;
+	buffer->Vertices.set_used(vertexCount);
+	for (u32 i=0; i < vertexCount; ++i)
+		buffer->Quantization.encode(v[i], buffer->Vertices[i]);
 
-			buffer->Vertices.reallocate(vertexCount);
+	const u32 indexCount = mb->getIndexCount();
+	buffer->Indices.set_used(indexCount);
+	memcpy(buffer->Indices.pointer(), mb->getIndices(), indexCount * sizeof(u16));
 
-			for (u32 i=0; i < vertexCount; ++i)
-			{
-				bool found = false;
-				for (u32 j=0; j < i; ++j)
-				{
-					if ( v[i].Pos.equals( v[j].Pos, tolerance) &&
-						 v[i].Normal.equals( v[j].Normal, tolerance) &&
-						 v[i].TCoords.equals( v[j].TCoords ) &&
-						 v[i].Tangent.equals( v[j].Tangent, tolerance ) &&
-						 v[i].Binormal.equals( v[j].Binormal, tolerance ) &&
-						(v[i].Color == v[j].Color) )
-					{
-						redirects[i] = redirects[j];
-						found = true;
-						break;
-					}
-				}
-				if (!found)
-				{
-					redirects[i] = buffer->Vertices.size();
-					buffer->Vertices.push_back(v[i]);
-				}
-			}
-			break;
-		}
-		default:
-			os::Printer::log("Cannot create welded mesh, vertex type unsupported", ELL_ERROR);
-			break;
-		}
+	buffer->recalculateBoundingBox();
+	return buffer;
+}
+}
 
-		// Clean up any degenerate tris
- 		core::array<u16> &Indices = *outIdx;
-		Indices.clear();
-		Indices.reallocate(indexCount);
-		for (u32 i = 0; i < indexCount; i+=3)
- 		{
-			u16 a, b, c;
-			a = redirects[indices[i]];
-			b = redirects[indices[i+1]];
-			c = redirects[indices[i+2]];
 
-			bool drop = false;
+//! Creates a copy of the mesh with 16 bit positions, texture coordinates and directions
+IMesh* CMeshManipulator::createMeshQuantized(IMesh* mesh) const
+{
+	if (!mesh)
+		return 0;
 
-			if (a == b || b == c || a == c)
-				drop = true;
+	SMesh* clone = new SMesh();
 
-			// Open for other checks
+	for (u32 b=0; b<mesh->getMeshBufferCount(); ++b)
+	{
+		const IMeshBuffer* const mb = mesh->getMeshBuffer(b);
+		IMeshBuffer* buffer = 0;
 
-			if (!drop)
+		if (mb->getIndexType() == video::EIT_16BIT)
+		{
+			switch(mb->getVertexType())
 			{
-				Indices.push_back(a);
-				Indices.push_back(b);
-				Indices.push_back(c);
+			case video::EVT_STANDARD:
+				buffer = createQuantizedBuffer<SMeshBufferQuantized, video::S3DVertex>(mb);
+				break;
+			case video::EVT_TANGENTS:
+				buffer = createQuantizedBuffer<SMeshBufferQuantizedTangents, video::S3DVertexTangents>(mb);
+				break;
+			default:
+				break;
 			}
 		}
+
+		if (!buffer)
+			buffer = mb->createClone();
+
+		clone->addMeshBuffer(buffer);
+		buffer->drop();
 	}
+
+	clone->BoundingBox = mesh->getBoundingBox();
 	return clone;
 }
 
@@ -951,6 +973,13 @@ IMesh* CMeshManipulator::createMeshWithTangents(IMesh* mesh, bool recalculateNor
 					buffer->Vertices.push_back(v[i]);
 			}
 			break;
+		case video::EVT_QUANTIZED:
+		case video::EVT_QUANTIZED_TANGENTS:
+			{
+				for (u32 i=0; i < vtxCnt; ++i)
+					buffer->Vertices.push_back(getDecodedVertex(original, i));
+			}
+			break;
 		}
 		buffer->recalculateBoundingBox();
 
@@ -1339,6 +1368,17 @@ IMesh* CMeshManipulator::createMeshWith2TCoords(IMesh* mesh) const
 						v[i].Pos, v[i].Normal, v[i].Color, v[i].TCoords, v[i].TCoords) );
 			}
 			break;
+		case video::EVT_QUANTIZED:
+		case video::EVT_QUANTIZED_TANGENTS:
+			{
+				for (u32 i=0; i < vtxCnt; ++i)
+				{
+					const S3DVertexTangents v = getDecodedVertex(original, i);
+					buffer->Vertices.push_back( S3DVertex2TCoords(
+						v.Pos, v.Normal, v.Color, v.TCoords, v.TCoords) );
+				}
+			}
+			break;
 		}
 		buffer->recalculateBoundingBox();
 
@@ -1413,6 +1453,13 @@ IMesh* CMeshManipulator::createMeshWith1TCoords(IMesh* mesh) const
 						v[i].Pos, v[i].Normal, v[i].Color, v[i].TCoords) );
 			}
 			break;
+		case video::EVT_QUANTIZED:
+		case video::EVT_QUANTIZED_TANGENTS:
+			{
+				for (u32 i=0; i < vtxCnt; ++i)
+					buffer->Vertices.push_back(getDecodedVertex(original, i));
+			}
+			break;
 		}
 
 		buffer->recalculateBoundingBox();
@@ -2046,6 +2093,8 @@ IMesh* CMeshManipulator::createForsythOptimizedMesh(const IMesh *mesh) const
 				buf->drop();
 			}
 			break;
+			default:
+				break;
 		}
 
 		delete [] vc;
@@ -2056,6 +2105,753 @@ IMesh* CMeshManipulator::createForsythOptimizedMesh(const IMesh *mesh) const
 	return newmesh;
 }
 
+
+namespace
+{
+
+//! Vertices and triangles of a meshbuffer while createOptimizedMesh works on it
+struct SOptimizerBuffer
+{
+	SOptimizerBuffer() : Source(0), VertexPitch(0), VertexCount(0), Optimize(false) {}
+
+	const IMeshBuffer* Source; // first source, gives the material and mapping hints
+	core::array<u8> Vertices; // VertexPitch bytes per vertex
+	core::array<u32> Indices;
+	u32 VertexPitch;
+	u32 VertexCount;
+	bool Optimize; // false for buffers which are only copied
+};
+
+//! Returns the position of a vertex, all vertex types start with it
+inline const core::vector3df& getVertexPosition(const u8* vertices, u32 pitch, u32 index)
+{
+	return *reinterpret_cast<const core::vector3df*>(vertices + index*pitch);
+}
+
+//! Reads the indices of a triangle list, skipping triangles with invalid indices
+void getTriangleIndices(const IMeshBuffer* mb, core::array<u32>& indices)
+{
+	const u32 indexCount = mb->getIndexCount() / 3 * 3;
+	const u32 vertexCount = mb->getVertexCount();
+	indices.set_used(indexCount);
+	if (mb->getIndexType() == video::EIT_16BIT)
+	{
+		const u16* idx = mb->getIndices();
+		for (u32 i=0; i<indexCount; ++i)
+			indices[i] = idx[i];
+	}
+	else if (indexCount)
+		memcpy(indices.pointer(), mb->getIndices(), indexCount * sizeof(u32));
+
+	u32 kept = 0;
+	for (u32 i=0; i<indexCount; i+=3)
+	{
+		if (indices[i] >= vertexCount || indices[i+1] >= vertexCount || indices[i+2] >= vertexCount)
+			continue;
+		indices[kept++] = indices[i];
+		indices[kept++] = indices[i+1];
+		indices[kept++] = indices[i+2];
+	}
+	indices.set_used(kept);
+}
+
+//! Size of the FIFO cache simulated for SMeshOptimizationReport and overdraw clusters
+const u32 FifoCacheSize = 16;
+
+//! Counts the vertex cache misses of a triangle list
+/** \param stamps Time each vertex was last loaded, holds at least vertexCount
+entries and is reset here. */
+u32 countCacheMisses(const u32* indices, u32 indexCount, u32 vertexCount, core::array<u32>& stamps)
+{
+	stamps.set_used(vertexCount);
+	for (u32 i=0; i<vertexCount; ++i)
+		stamps[i] = 0;
+
+	u32 time = FifoCacheSize + 1;
+	for (u32 i=0; i<indexCount; ++i)
+	{
+		if (time - stamps[indices[i]] > FifoCacheSize)
+			stamps[indices[i]] = time++;
+	}
+	return time - FifoCacheSize - 1;
+}
+
+//! Vertex cache optimization according to the Forsyth paper, in linear time
+/** Uses the scores of FindVertexScore, but only rescores the triangles of
+vertices in the cache and keeps the triangles of each vertex in one array.
+When no triangle of a cached vertex is left, the next triangle in the old
+order is taken instead of searching the best one. */
+void optimizeVertexCache(core::array<u32>& indices, u32 vertexCount)
+{
+	const u32 triangleCount = indices.size() / 3;
+	if (triangleCount < 2)
+		return;
+
+	// Scores by cache position and by the number of triangles still to draw,
+	// valences above the table are rare and get the score of the last entry
+	f32 cacheScores[cachesize];
+	for (u32 i=0; i<cachesize; ++i)
+		cacheScores[i] = i < 3 ? 0.75f : powf(1.0f - (i - 3) / (f32)(cachesize - 3), 1.5f);
+	f32 valenceScores[64];
+	for (u32 i=1; i<64; ++i)
+		valenceScores[i] = 2.0f * powf((f32)i, -0.5f);
+
+	// Triangles of each vertex
+	core::array<u32> live;
+	live.set_used(vertexCount);
+	for (u32 i=0; i<vertexCount; ++i)
+		live[i] = 0;
+	for (u32 i=0; i<indices.size(); ++i)
+		++live[indices[i]];
+
+	core::array<u32> offsets;
+	offsets.set_used(vertexCount + 1);
+	offsets[0] = 0;
+	for (u32 i=0; i<vertexCount; ++i)
+		offsets[i+1] = offsets[i] + live[i];
+
+	core::array<u32> triangles;
+	triangles.set_used(indices.size());
+	{
+		core::array<u32> fill(offsets);
+		for (u32 i=0; i<indices.size(); ++i)
+			triangles[fill[indices[i]]++] = i / 3;
+	}
+
+	core::array<s32> cachePositions;
+	core::array<f32> vertexScores;
+	cachePositions.set_used(vertexCount);
+	vertexScores.set_used(vertexCount);
+	for (u32 i=0; i<vertexCount; ++i)
+	{
+		cachePositions[i] = -1;
+		vertexScores[i] = live[i] ? valenceScores[core::min_(live[i], 63u)] : -1.0f;
+	}
+
+	core::array<f32> triangleScores;
+	core::array<u8> drawn;
+	triangleScores.set_used(triangleCount);
+	drawn.set_used(triangleCount);
+	u32 best = 0;
+	for (u32 t=0; t<triangleCount; ++t)
+	{
+		triangleScores[t] = vertexScores[indices[t*3]] + vertexScores[indices[t*3+1]] + vertexScores[indices[t*3+2]];
+		drawn[t] = 0;
+		if (triangleScores[t] > triangleScores[best])
+			best = t;
+	}
+
+	core::array<u32> result;
+	result.set_used(indices.size());
+
+	u32 cache[cachesize + 3];
+	u32 newCache[cachesize + 3];
+	u32 cacheCount = 0;
+	u32 nextUndrawn = 0;
+
+	for (u32 n=0; n<triangleCount; ++n)
+	{
+		if (best == 0xffffffff)
+		{
+			while (drawn[nextUndrawn])
+				++nextUndrawn;
+			best = nextUndrawn;
+		}
+
+		const u32* tri = &indices[best*3];
+		result[n*3] = tri[0];
+		result[n*3+1] = tri[1];
+		result[n*3+2] = tri[2];
+		drawn[best] = 1;
+
+		// remove the triangle from the lists of its vertices
+		for (u32 k=0; k<3; ++k)
+		{
+			u32* list = &triangles[offsets[tri[k]]];
+			const u32 count = live[tri[k]];
+			for (u32 j=0; j<count; ++j)
+			{
+				if (list[j] == best)
+				{
+					list[j] = list[count-1];
+					break;
+				}
+			}
+			--live[tri[k]];
+		}
+
+		// the vertices of the triangle move to the front of the cache
+		u32 newCount = 0;
+		for (u32 k=0; k<3; ++k)
+		{
+			if ((k < 1 || tri[k] != tri[0]) && (k < 2 || tri[k] != tri[1]))
+				newCache[newCount++] = tri[k];
+		}
+		for (u32 i=0; i<cacheCount; ++i)
+		{
+			const u32 v = cache[i];
+			if (v != tri[0] && v != tri[1] && v != tri[2])
+				newCache[newCount++] = v;
+		}
+
+		// rescore the vertices, including those which just left the cache
+		for (u32 i=0; i<newCount; ++i)
+		{
+			const u32 v = newCache[i];
+			const s32 position = i < cachesize ? (s32)i : -1;
+			cachePositions[v] = position;
+
+			f32 score = -1.0f;
+			if (live[v])
+			{
+				score = valenceScores[core::min_(live[v], 63u)];
+				if (position >= 0)
+					score += cacheScores[position];
+			}
+
+			const f32 delta = score - vertexScores[v];
+			vertexScores[v] = score;
+			const u32* list = &triangles[offsets[v]];
+			for (u32 j=0; j<live[v]; ++j)
+				triangleScores[list[j]] += delta;
+		}
+
+		cacheCount = core::min_(newCount, (u32)cachesize);
+		best = 0xffffffff;
+		f32 bestScore = 0.f;
+		for (u32 i=0; i<cacheCount; ++i)
+		{
+			const u32 v = newCache[i];
+			cache[i] = v;
+			const u32* list = &triangles[offsets[v]];
+			for (u32 j=0; j<live[v]; ++j)
+			{
+				if (triangleScores[list[j]] > bestScore)
+				{
+					best = list[j];
+					bestScore = triangleScores[list[j]];
+				}
+			}
+		}
+	}
+
+	indices.swap(result);
+}
+
+//! Cluster of triangles for optimizeOverdraw
+struct SOverdrawCluster
+{
+	f32 Sort;
+	u32 Start;
+
+	// outward facing clusters first, stable for equal values
+	bool operator<(const SOverdrawCluster& other) const
+	{
+		return Sort > other.Sort || (Sort == other.Sort && Start < other.Start);
+	}
+};
+
+//! Reorders groups of triangles so that outward facing groups are drawn first
+/** A group starts with each triangle whose vertices all miss the vertex cache,
+so the cache order within the groups stays intact. This is the sorting step of
+Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced
+Overdraw", without splitting the groups further. */
+void optimizeOverdraw(core::array<u32>& indices, const u8* vertices, u32 pitch, u32 vertexCount)
+{
+	const u32 triangleCount = indices.size() / 3;
+
+	core::array<SOverdrawCluster> clusters;
+	core::array<u32> stamps;
+	stamps.set_used(vertexCount);
+	for (u32 i=0; i<vertexCount; ++i)
+		stamps[i] = 0;
+	u32 time = FifoCacheSize + 1;
+	for (u32 t=0; t<triangleCount; ++t)
+	{
+		u32 misses = 0;
+		for (u32 k=0; k<3; ++k)
+		{
+			const u32 v = indices[t*3+k];
+			if (time - stamps[v] > FifoCacheSize)
+			{
+				stamps[v] = time++;
+				++misses;
+			}
+		}
+		if (t == 0 || misses == 3)
+		{
+			SOverdrawCluster cluster;
+			cluster.Sort = 0.f;
+			cluster.Start = t;
+			clusters.push_back(cluster);
+		}
+	}
+	if (clusters.size() < 2)
+		return;
+
+	// area weighted centers and normals
+	core::array<core::vector3df> centers;
+	core::array<core::vector3df> normals;
+	centers.set_used(clusters.size());
+	normals.set_used(clusters.size());
+	core::vector3df meshCenter;
+	f32 meshArea = 0.f;
+	for (u32 c=0; c<clusters.size(); ++c)
+	{
+		const u32 end = c+1 < clusters.size() ? clusters[c+1].Start : triangleCount;
+		core::vector3df center;
+		core::vector3df normal;
+		f32 area = 0.f;
+		for (u32 t=clusters[c].Start; t<end; ++t)
+		{
+			const core::vector3df& a = getVertexPosition(vertices, pitch, indices[t*3]);
+			const core::vector3df& b = getVertexPosition(vertices, pitch, indices[t*3+1]);
+			const core::vector3df& d = getVertexPosition(vertices, pitch, indices[t*3+2]);
+			const core::vector3df n = (b - a).crossProduct(d - a);
+			const f32 triangleArea = n.getLength();
+			center += (a + b + d) * (triangleArea / 3.f);
+			normal += n;
+			area += triangleArea;
+		}
+		meshCenter += center;
+		meshArea += area;
+		centers[c] = area > 0.f ? center / area : center;
+		normals[c] = normal.normalize();
+	}
+	if (meshArea > 0.f)
+		meshCenter /= meshArea;
+
+	for (u32 c=0; c<clusters.size(); ++c)
+		clusters[c].Sort = (centers[c] - meshCenter).dotProduct(normals[c]);
+
+	// sort the starts together with the values, the ends are needed as well
+	core::array<u32> ends;
+	ends.set_used(triangleCount);
+	for (u32 c=0; c<clusters.size(); ++c)
+		ends[clusters[c].Start] = c+1 < clusters.size() ? clusters[c+1].Start : triangleCount;
+	clusters.sort();
+
+	core::array<u32> result;
+	result.set_used(indices.size());
+	u32 written = 0;
+	for (u32 c=0; c<clusters.size(); ++c)
+	{
+		const u32 count = (ends[clusters[c].Start] - clusters[c].Start) * 3;
+		memcpy(&result[written], &indices[clusters[c].Start*3], count * sizeof(u32));
+		written += count;
+	}
+	indices.swap(result);
+}
+
+//! Renumbers the vertices in the order of their first use and removes unused ones
+void optimizeVertexFetch(SOptimizerBuffer& buffer)
+{
+	core::array<u32> remap;
+	remap.set_used(buffer.VertexCount);
+	for (u32 i=0; i<buffer.VertexCount; ++i)
+		remap[i] = 0xffffffff;
+
+	core::array<u8> vertices;
+	vertices.set_used(buffer.Vertices.size());
+	u32 count = 0;
+	for (u32 i=0; i<buffer.Indices.size(); ++i)
+	{
+		u32& v = buffer.Indices[i];
+		if (remap[v] == 0xffffffff)
+		{
+			memcpy(&vertices[count*buffer.VertexPitch], &buffer.Vertices[v*buffer.VertexPitch], buffer.VertexPitch);
+			remap[v] = count++;
+		}
+		v = remap[v];
+	}
+	vertices.set_used(count*buffer.VertexPitch);
+	buffer.Vertices.swap(vertices);
+	buffer.VertexCount = count;
+}
+
+//! Creates a meshbuffer from the vertices and indices of createOptimizedMesh
+/** TBuffer is the 16 bit mesh buffer type for TVertex, buffers with more
+vertices become CDynamicMeshBuffers with 32 bit indices. */
+template <class TBuffer, class TVertex>
+IMeshBuffer* createOptimizedBuffer(const IMeshBuffer* source, const u8* vertices, u32 vertexCount, const core::array<u32>& indices)
+{
+	IMeshBuffer* result;
+	if (vertexCount <= 65536)
+	{
+		TBuffer* buffer = new TBuffer();
+		buffer->Material = source->getMaterial();
+		buffer->Vertices.set_used(vertexCount);
+		if (vertexCount)
+			memcpy(buffer->Vertices.pointer(), vertices, vertexCount * sizeof(TVertex));
+		buffer->Indices.set_used(indices.size());
+		for (u32 i=0; i<indices.size(); ++i)
+			buffer->Indices[i] = (u16)indices[i];
+		result = buffer;
+	}
+	else
+	{
+		CDynamicMeshBuffer* buffer = new CDynamicMeshBuffer(source->getVertexType(), video::EIT_32BIT);
+		buffer->getMaterial() = source->getMaterial();
+		buffer->getVertexBuffer().set_used(vertexCount);
+		memcpy(buffer->getVertexBuffer().pointer(), vertices, vertexCount * sizeof(TVertex));
+		buffer->getIndexBuffer().set_used(indices.size());
+		if (indices.size())
+			memcpy(buffer->getIndexBuffer().pointer(), indices.const_pointer(), indices.size() * sizeof(u32));
+		result = buffer;
+	}
+
+	result->setHardwareMappingHint(source->getHardwareMappingHint_Vertex(), EBT_VERTEX);
+	result->setHardwareMappingHint(source->getHardwareMappingHint_Index(), EBT_INDEX);
+	result->recalculateBoundingBox();
+	return result;
+}
+
+void addOptimizedBuffer(SMesh* mesh, const IMeshBuffer* source, const u8* vertices, u32 vertexCount, const core::array<u32>& indices)
+{
+	IMeshBuffer* buffer = 0;
+	switch (source->getVertexType())
+	{
+	case video::EVT_STANDARD:
+		buffer = createOptimizedBuffer<SMeshBuffer, video::S3DVertex>(source, vertices, vertexCount, indices);
+		break;
+	case video::EVT_2TCOORDS:
+		buffer = createOptimizedBuffer<SMeshBufferLightMap, video::S3DVertex2TCoords>(source, vertices, vertexCount, indices);
+		break;
+	case video::EVT_TANGENTS:
+		buffer = createOptimizedBuffer<SMeshBufferTangents, video::S3DVertexTangents>(source, vertices, vertexCount, indices);
+		break;
+	default:
+		break;
+	}
+	if (buffer)
+	{
+		mesh->addMeshBuffer(buffer);
+		buffer->drop();
+	}
+}
+
+//! Adds a buffer in chunks of at most 65536 vertices, following the triangle order
+void addSplitBuffers(SMesh* mesh, const SOptimizerBuffer& buffer)
+{
+	core::array<u32> remap;
+	remap.set_used(buffer.VertexCount);
+	for (u32 i=0; i<buffer.VertexCount; ++i)
+		remap[i] = 0xffffffff;
+
+	core::array<u32> used; // vertices of the current chunk in their new order
+	core::array<u8> vertices;
+	core::array<u32> indices;
+	u32 t = 0;
+	const u32 triangleCount = buffer.Indices.size() / 3;
+	while (t < triangleCount)
+	{
+		for (; t<triangleCount; ++t)
+		{
+			const u32* tri = &buffer.Indices[t*3];
+			u32 added = 0;
+			for (u32 k=0; k<3; ++k)
+			{
+				if (remap[tri[k]] == 0xffffffff && (k < 1 || tri[k] != tri[0]) && (k < 2 || tri[k] != tri[1]))
+					++added;
+			}
+			if (used.size() + added > 65536)
+				break;
+
+			for (u32 k=0; k<3; ++k)
+			{
+				if (remap[tri[k]] == 0xffffffff)
+				{
+					remap[tri[k]] = used.size();
+					used.push_back(tri[k]);
+				}
+				indices.push_back(remap[tri[k]]);
+			}
+		}
+
+		vertices.set_used(used.size() * buffer.VertexPitch);
+		for (u32 i=0; i<used.size(); ++i)
+		{
+			memcpy(&vertices[i*buffer.VertexPitch], &buffer.Vertices[used[i]*buffer.VertexPitch], buffer.VertexPitch);
+			remap[used[i]] = 0xffffffff;
+		}
+		addOptimizedBuffer(mesh, buffer.Source, vertices.const_pointer(), used.size(), indices);
+		used.set_used(0);
+		indices.set_used(0);
+	}
+}
+
+//! Computes the ACMR of all triangle lists of a mesh
+f32 getMeshAcmr(const IMesh* mesh)
+{
+	core::array<u32> indices;
+	core::array<u32> stamps;
+	u32 misses = 0;
+	u32 triangles = 0;
+	for (u32 b=0; b<mesh->getMeshBufferCount(); ++b)
+	{
+		const IMeshBuffer* mb = mesh->getMeshBuffer(b);
+		if (mb->getPrimitiveType() != EPT_TRIANGLES)
+			continue;
+		getTriangleIndices(mb, indices);
+		misses += countCacheMisses(indices.const_pointer(), indices.size(), mb->getVertexCount(), stamps);
+		triangles += indices.size() / 3;
+	}
+	return triangles ? (f32)misses / triangles : 0.f;
+}
+
+//! Size of the views rasterized for the overdraw of SMeshOptimizationReport
+const u32 OverdrawResolution = 256;
+
+//! Rasterizes the triangle lists of a mesh with depth test and counts the shaded pixels
+/** Front faces are clockwise like for the drivers. Samples at the pixel
+centers, samples on shared edges are only taken by one of the triangles.
+\param axis View direction, 0 to 2 for +X, +Y, +Z, 3 to 5 for -X, -Y, -Z.
+\param depth Depth buffer with OverdrawResolution squared entries.
+\return Number of shaded pixels. */
+u32 rasterizeOverdrawView(const IMesh* mesh, const core::aabbox3df& box, u32 axis, core::array<f32>& depth)
+{
+	const u32 d = axis % 3;
+	const u32 u = (d + 1) % 3;
+	const u32 v = (d + 2) % 3;
+	const f32 sign = axis < 3 ? 1.f : -1.f;
+
+	const f32 boxMin[3] = { box.MinEdge.X, box.MinEdge.Y, box.MinEdge.Z };
+	const f32 boxMax[3] = { box.MaxEdge.X, box.MaxEdge.Y, box.MaxEdge.Z };
+	const f32 extent = core::max_(boxMax[u] - boxMin[u], boxMax[v] - boxMin[v]);
+	if (extent <= 0.f)
+		return 0;
+	const f32 scale = OverdrawResolution / extent;
+
+	core::array<u32> indices;
+	u32 shaded = 0;
+	for (u32 b=0; b<mesh->getMeshBufferCount(); ++b)
+	{
+		const IMeshBuffer* mb = mesh->getMeshBuffer(b);
+		if (mb->getPrimitiveType() != EPT_TRIANGLES)
+			continue;
+		getTriangleIndices(mb, indices);
+		const u8* vertices = static_cast<const u8*>(mb->getVertices());
+		const u32 pitch = video::getVertexPitchFromType(mb->getVertexType());
+
+		for (u32 i=0; i<indices.size(); i+=3)
+		{
+			f32 x[3], y[3], z[3];
+			core::vector3df p[3];
+			for (u32 k=0; k<3; ++k)
+			{
+				p[k] = getVertexPosition(vertices, pitch, indices[i+k]);
+				const f32 c[3] = { p[k].X, p[k].Y, p[k].Z };
+				x[k] = (c[u] - boxMin[u]) * scale;
+				y[k] = (c[v] - boxMin[v]) * scale;
+				z[k] = c[d] * sign;
+			}
+
+			// backface culling, the normal of front faces points to the viewer
+			const core::vector3df n = (p[1] - p[0]).crossProduct(p[2] - p[0]);
+			const f32 n3[3] = { n.X, n.Y, n.Z };
+			if (n3[d] * sign >= 0.f)
+				continue;
+
+			// counterclockwise in x,y
+			f32 area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+			if (area == 0.f)
+				continue;
+			if (area < 0.f)
+			{
+				core::swap(x[1], x[2]);
+				core::swap(y[1], y[2]);
+				core::swap(z[1], z[2]);
+				area = -area;
+			}
+
+			const s32 minX = core::max_(core::floor32(core::min_(x[0], x[1], x[2])), 0);
+			const s32 minY = core::max_(core::floor32(core::min_(y[0], y[1], y[2])), 0);
+			const s32 maxX = core::min_(core::ceil32(core::max_(x[0], x[1], x[2])), (s32)OverdrawResolution - 1);
+			const s32 maxY = core::min_(core::ceil32(core::max_(y[0], y[1], y[2])), (s32)OverdrawResolution - 1);
+
+			for (s32 py=minY; py<=maxY; ++py)
+			{
+				for (s32 px=minX; px<=maxX; ++px)
+				{
+					const f32 sx = px + 0.5f;
+					const f32 sy = py + 0.5f;
+					f32 w[3];
+					bool inside = true;
+					for (u32 k=0; k<3 && inside; ++k)
+					{
+						// edge opposite to vertex k
+						const u32 e0 = (k + 1) % 3;
+						const u32 e1 = (k + 2) % 3;
+						const f32 dx = x[e1] - x[e0];
+						const f32 dy = y[e1] - y[e0];
+						w[k] = dx * (sy - y[e0]) - dy * (sx - x[e0]);
+						// one of two triangles sharing the edge owns samples on it
+						inside = w[k] > 0.f || (w[k] == 0.f && (dy < 0.f || (dy == 0.f && dx > 0.f)));
+					}
+					if (!inside)
+						continue;
+
+					const f32 sampleDepth = (w[0] * z[0] + w[1] * z[1] + w[2] * z[2]) / area;
+					f32& pixel = depth[py * OverdrawResolution + px];
+					if (sampleDepth < pixel)
+					{
+						pixel = sampleDepth;
+						++shaded;
+					}
+				}
+			}
+		}
+	}
+	return shaded;
+}
+
+//! Computes the overdraw of all triangle lists of a mesh
+f32 getMeshOverdraw(const IMesh* mesh, const core::aabbox3df& box)
+{
+	core::array<f32> depth;
+	depth.set_used(OverdrawResolution * OverdrawResolution);
+	u32 shaded = 0;
+	u32 covered = 0;
+	for (u32 axis=0; axis<6; ++axis)
+	{
+		for (u32 i=0; i<depth.size(); ++i)
+			depth[i] = FLT_MAX;
+		shaded += rasterizeOverdrawView(mesh, box, axis, depth);
+		for (u32 i=0; i<depth.size(); ++i)
+		{
+			if (depth[i] != FLT_MAX)
+				++covered;
+		}
+	}
+	return covered ? (f32)shaded / covered : 0.f;
+}
+
+//! Bounding box of the vertices of all triangle lists of a mesh
+core::aabbox3df getTriangleListBox(const IMesh* mesh)
+{
+	core::aabbox3df box;
+	bool first = true;
+	for (u32 b=0; b<mesh->getMeshBufferCount(); ++b)
+	{
+		const IMeshBuffer* mb = mesh->getMeshBuffer(b);
+		if (mb->getPrimitiveType() != EPT_TRIANGLES)
+			continue;
+		for (u32 i=0; i<mb->getVertexCount(); ++i)
+		{
+			if (first)
+				box.reset(mb->getPosition(i));
+			else
+				box.addInternalPoint(mb->getPosition(i));
+			first = false;
+		}
+	}
+	return box;
+}
+
+} // end anonymous namespace
+
+
+//! Optimizes the order of triangles and vertices for rendering
+IMesh* CMeshManipulator::createOptimizedMesh(const IMesh* mesh, u32 flags, SMeshOptimizationReport* report) const
+{
+	if (!mesh)
+		return 0;
+
+	// collect the buffers, merged ones go to the place of the first
+	core::array<SOptimizerBuffer> buffers;
+	core::array<u32> indices;
+	for (u32 b=0; b<mesh->getMeshBufferCount(); ++b)
+	{
+		const IMeshBuffer* mb = mesh->getMeshBuffer(b);
+		const video::E_VERTEX_TYPE vertexType = mb->getVertexType();
+		const bool optimize = mb->getPrimitiveType() == EPT_TRIANGLES &&
+			(vertexType == video::EVT_STANDARD || vertexType == video::EVT_2TCOORDS || vertexType == video::EVT_TANGENTS);
+
+		SOptimizerBuffer* target = 0;
+		if (optimize && (flags & EMOF_MERGE_BUFFERS))
+		{
+			for (u32 i=0; i<buffers.size(); ++i)
+			{
+				if (buffers[i].Optimize && buffers[i].Source->getVertexType() == vertexType &&
+					buffers[i].Source->getMaterial() == mb->getMaterial())
+				{
+					target = &buffers[i];
+					break;
+				}
+			}
+		}
+		if (!target)
+		{
+			buffers.push_back(SOptimizerBuffer());
+			target = &buffers.getLast();
+			target->Source = mb;
+			target->Optimize = optimize;
+			target->VertexPitch = video::getVertexPitchFromType(vertexType);
+		}
+		if (!optimize)
+			continue;
+
+		getTriangleIndices(mb, indices);
+		const u32 first = target->VertexCount;
+		target->Indices.reallocate(target->Indices.size() + indices.size());
+		for (u32 i=0; i<indices.size(); ++i)
+			target->Indices.push_back(indices[i] + first);
+
+		const u32 bytes = mb->getVertexCount() * target->VertexPitch;
+		target->Vertices.set_used(target->Vertices.size() + bytes);
+		if (bytes)
+			memcpy(&target->Vertices[first * target->VertexPitch], mb->getVertices(), bytes);
+		target->VertexCount += mb->getVertexCount();
+	}
+
+	SMesh* result = new SMesh();
+	for (u32 b=0; b<buffers.size(); ++b)
+	{
+		SOptimizerBuffer& buffer = buffers[b];
+		if (!buffer.Optimize)
+		{
+			IMeshBuffer* clone = buffer.Source->createClone();
+			if (clone)
+			{
+				result->addMeshBuffer(clone);
+				clone->drop();
+			}
+			continue;
+		}
+
+		if (flags & EMOF_VERTEX_CACHE)
+		{
+			// keep orders which are better already, like those of regular grids
+			core::array<u32> original(buffer.Indices);
+			optimizeVertexCache(buffer.Indices, buffer.VertexCount);
+			if (countCacheMisses(buffer.Indices.const_pointer(), buffer.Indices.size(), buffer.VertexCount, indices) >
+				countCacheMisses(original.const_pointer(), original.size(), buffer.VertexCount, indices))
+				buffer.Indices.swap(original);
+		}
+		if (flags & EMOF_OVERDRAW)
+			optimizeOverdraw(buffer.Indices, buffer.Vertices.const_pointer(), buffer.VertexPitch, buffer.VertexCount);
+		if (flags & EMOF_VERTEX_FETCH)
+			optimizeVertexFetch(buffer);
+
+		if ((flags & EMOF_SPLIT_BUFFERS) && buffer.VertexCount > 65536)
+			addSplitBuffers(result, buffer);
+		else
+			addOptimizedBuffer(result, buffer.Source, buffer.Vertices.const_pointer(), buffer.VertexCount, buffer.Indices);
+	}
+	result->recalculateBoundingBox();
+
+	if (report)
+	{
+		const core::aabbox3df box = getTriangleListBox(mesh);
+		report->AcmrBefore = getMeshAcmr(mesh);
+		report->AcmrAfter = getMeshAcmr(result);
+		report->OverdrawBefore = getMeshOverdraw(mesh, box);
+		report->OverdrawAfter = getMeshOverdraw(result, box);
+	}
+
+	return result;
+}
+
 } // end namespace scene
 } // end namespace irr
 
@@ -75,6 +75,9 @@ public:
 	//! Creates a copy of the mesh, which will have all duplicated vertices removed, i.e. maximal amount of vertices are shared via indexing.
 	virtual IMesh* createMeshWelded(IMesh *mesh, f32 tolerance=core::ROUNDING_ERROR_f32) const IRR_OVERRIDE;
 
+	//! Creates a copy of the mesh with 16 bit positions, texture coordinates and directions
+	virtual IMesh* createMeshQuantized(IMesh* mesh) const IRR_OVERRIDE;
+
 	//! Returns amount of polygons in mesh.
 	virtual s32 getPolyCount(scene::IMesh* mesh) const IRR_OVERRIDE;
 
@@ -87,6 +90,10 @@ public:
 	//! create a mesh optimized for the vertex cache
 	virtual IMesh* createForsythOptimizedMesh(const scene::IMesh *mesh) const IRR_OVERRIDE;
 
+	//! Optimizes the order of triangles and vertices for rendering
+	virtual IMesh* createOptimizedMesh(const IMesh* mesh, u32 flags=EMOF_DEFAULT,
+		SMeshOptimizationReport* report=0) const IRR_OVERRIDE;
+
 	//! Optimizes the mesh using an algorithm tuned for heightmaps
 	virtual void heightmapOptimizeMesh(IMesh * const m, const f32 tolerance = core::ROUNDING_ERROR_f32) const IRR_OVERRIDE;
 
@@ -9,6 +9,12 @@ namespace irr
 namespace scene
 {
 
+namespace
+{
+	//! Bounds of selectors are enlarged by this part of their diagonal for the tests
+	const f32 BOUNDS_TOLERANCE = 0.001f;
+}
+
 //! constructor
 CMetaTriangleSelector::CMetaTriangleSelector()
 {
@@ -74,12 +80,15 @@ void CMetaTriangleSelector::getTriangles(core::triangle3df* triangles, s32 array
 		const core::matrix4* transform, bool useNodeTransform, 
 		irr::core::array<SCollisionTriangleRange>* outTriangleInfo) const
 {
+	core::array<u32> selectors;
+	collectSelectors(selectors, useNodeTransform, box, 0);
+
 	s32 outWritten = 0;
 	irr::u32 outTriangleInfoSize = outTriangleInfo ? outTriangleInfo->size() : 0;
-	for (u32 i=0; i<TriangleSelectors.size(); ++i)
+	for (u32 s=0; s<selectors.size(); ++s)
 	{
 		s32 t = 0;
-		TriangleSelectors[i]->getTriangles(triangles + outWritten,
+		TriangleSelectors[selectors[s]]->getTriangles(triangles + outWritten,
 				arraySize - outWritten, t, box, transform, useNodeTransform, outTriangleInfo);
 
 		if ( outTriangleInfo )
@@ -107,12 +116,18 @@ void CMetaTriangleSelector::getTriangles(core::triangle3df* triangles, s32 array
 		const core::matrix4* transform, bool useNodeTransform, 
 		irr::core::array<SCollisionTriangleRange>* outTriangleInfo) const
 {
+	core::aabbox3d<f32> box(line.start);
+	box.addInternalPoint(line.end);
+
+	core::array<u32> selectors;
+	collectSelectors(selectors, useNodeTransform, box, &line);
+
 	s32 outWritten = 0;
 	irr::u32 outTriangleInfoSize = outTriangleInfo ? outTriangleInfo->size() : 0;
-	for (u32 i=0; i<TriangleSelectors.size(); ++i)
+	for (u32 s=0; s<selectors.size(); ++s)
 	{
 		s32 t = 0;
-		TriangleSelectors[i]->getTriangles(triangles + outWritten,
+		TriangleSelectors[selectors[s]]->getTriangles(triangles + outWritten,
 				arraySize - outWritten, t, line, transform, useNodeTransform, outTriangleInfo);
 
 		if ( outTriangleInfo )
@@ -134,6 +149,123 @@ void CMetaTriangleSelector::getTriangles(core::triangle3df* triangles, s32 array
 }
 
 
+//! Gets the nearest intersection of a 3d line with the triangles of all selectors.
+bool CMetaTriangleSelector::getCollisionPoint(SCollisionHit& hitResult,
+		const core::line3d<f32>& line, bool useNodeTransform) const
+{
+	core::aabbox3d<f32> box(line.start);
+	box.addInternalPoint(line.end);
+
+	core::array<u32> selectors;
+	collectSelectors(selectors, useNodeTransform, box, &line);
+
+	bool found = false;
+	f32 nearest = FLT_MAX;
+	core::line3d<f32> rest(line);
+
+	for (u32 s=0; s<selectors.size(); ++s)
+	{
+		// skip selectors which are only behind the nearest hit so far
+		core::aabbox3d<f32> bounds;
+		if (found && useNodeTransform && getSelectorBounds(selectors[s], bounds) &&
+			!bounds.intersectsWithLine(rest))
+			continue;
+
+		SCollisionHit candidate;
+		if (!TriangleSelectors[selectors[s]]->getCollisionPoint(candidate, rest, useNodeTransform))
+			continue;
+
+		const f32 distance = candidate.Intersection.getDistanceFromSQ(line.start);
+		if (distance < nearest)
+		{
+			nearest = distance;
+			hitResult = candidate;
+			found = true;
+
+			// later selectors only have to check the part in front of the hit
+			rest.end = candidate.Intersection;
+		}
+	}
+
+	return found;
+}
+
+
+//! Gets the nearest intersections of several 3d lines with the triangles of all selectors.
+u32 CMetaTriangleSelector::getCollisionPoints(SCollisionHit* hitResults, bool* hitFound,
+		const core::line3d<f32>* lines, u32 lineCount, bool useNodeTransform) const
+{
+	for (u32 i=0; i<lineCount; ++i)
+		hitFound[i] = false;
+
+	if (!lineCount)
+		return 0;
+
+	core::aabbox3d<f32> box(lines[0].start);
+	for (u32 i=0; i<lineCount; ++i)
+	{
+		box.addInternalPoint(lines[i].start);
+		box.addInternalPoint(lines[i].end);
+	}
+
+	core::array<u32> selectors;
+	collectSelectors(selectors, useNodeTransform, box, 0);
+
+	// lines get shortened to the nearest hit so far, so later selectors skip more
+	core::array<core::line3d<f32> > rest(lineCount);
+	core::array<SCollisionHit> candidates(lineCount);
+	core::array<bool> candidateFound(lineCount);
+	for (u32 i=0; i<lineCount; ++i)
+		rest.push_back(lines[i]);
+	candidates.set_used(lineCount);
+	candidateFound.set_used(lineCount);
+
+	u32 hits = 0;
+	for (u32 s=0; s<selectors.size(); ++s)
+	{
+		if (!TriangleSelectors[selectors[s]]->getCollisionPoints(candidates.pointer(), candidateFound.pointer(),
+				rest.const_pointer(), lineCount, useNodeTransform))
+			continue;
+
+		for (u32 i=0; i<lineCount; ++i)
+		{
+			if (!candidateFound[i])
+				continue;
+
+			// a shortened line only finds hits in front of the last one
+			hitResults[i] = candidates[i];
+			rest[i].end = candidates[i].Intersection;
+			if (!hitFound[i])
+			{
+				hitFound[i] = true;
+				++hits;
+			}
+		}
+	}
+
+	return hits;
+}
+
+
+//! Get a box around the triangles of all selectors.
+bool CMetaTriangleSelector::getBoundingBox(core::aabbox3d<f32>& outBox, bool useNodeTransform) const
+{
+	for (u32 i=0; i<TriangleSelectors.size(); ++i)
+	{
+		core::aabbox3d<f32> box;
+		if (!TriangleSelectors[i]->getBoundingBox(box, useNodeTransform))
+			return false;
+
+		if (i == 0)
+			outBox = box;
+		else
+			outBox.addInternalBox(box);
+	}
+
+	return !TriangleSelectors.empty();
+}
+
+
 //! Adds a triangle selector to the collection of triangle selectors
 //! in this metaTriangleSelector.
 void CMetaTriangleSelector::addTriangleSelector(ITriangleSelector* toAdd)
@@ -220,6 +352,45 @@ const ITriangleSelector* CMetaTriangleSelector::getSelector(u32 index) const
 }
 
 
+//! Gets the bounds of a selector with node transformation, a bit enlarged
+bool CMetaTriangleSelector::getSelectorBounds(u32 selector, core::aabbox3d<f32>& outBox) const
+{
+	if (!TriangleSelectors[selector]->getBoundingBox(outBox, true))
+		return false;
+
+	// lines grazing an edge are not lost to rounding errors of the box tests
+	const core::vector3df margin(outBox.getExtent().getLength() * BOUNDS_TOLERANCE + core::ROUNDING_ERROR_f32);
+	outBox.MinEdge -= margin;
+	outBox.MaxEdge += margin;
+	return true;
+}
+
+
+//! Collects the selectors whose bounds touch a box and, if given, a line
+void CMetaTriangleSelector::collectSelectors(core::array<u32>& outSelectors, bool useNodeTransform,
+		const core::aabbox3d<f32>& box, const core::line3d<f32>* line) const
+{
+	outSelectors.set_used(0);
+	outSelectors.reallocate(TriangleSelectors.size());
+
+	for (u32 i=0; i<TriangleSelectors.size(); ++i)
+	{
+		// Nodes can move and animate at any time, so the bounds are taken
+		// for each query. That's far cheaper than asking for the triangles.
+		core::aabbox3d<f32> bounds;
+		if (useNodeTransform && getSelectorBounds(i, bounds))
+		{
+			if (!bounds.intersectsWithBox(box))
+				continue;
+			if (line && !bounds.intersectsWithLine(*line))
+				continue;
+		}
+
+		outSelectors.push_back(i);
+	}
+}
+
+
 } // end namespace scene
 } // end namespace irr
 
@@ -14,6 +14,8 @@ namespace scene
 {
 
 //! Interface for making multiple triangle selectors work as one big selector.
+/** Queries check the current bounds of each selector first and only ask
+the selectors they can touch for triangles. */
 class CMetaTriangleSelector : public IMetaTriangleSelector
 {
 public:
@@ -44,6 +46,17 @@ public:
 		const core::matrix4* transform,	bool useNodeTransform, 
 		irr::core::array<SCollisionTriangleRange>* outTriangleInfo) const IRR_OVERRIDE;
 
+	//! Gets the nearest intersection of a 3d line with the triangles of all selectors.
+	virtual bool getCollisionPoint(SCollisionHit& hitResult, const core::line3d<f32>& line,
+		bool useNodeTransform) const IRR_OVERRIDE;
+
+	//! Gets the nearest intersections of several 3d lines with the triangles of all selectors.
+	virtual u32 getCollisionPoints(SCollisionHit* hitResults, bool* hitFound,
+		const core::line3d<f32>* lines, u32 lineCount, bool useNodeTransform) const IRR_OVERRIDE;
+
+	//! Get a box around the triangles of all selectors.
+	virtual bool getBoundingBox(core::aabbox3d<f32>& outBox, bool useNodeTransform) const IRR_OVERRIDE;
+
 	//! Adds a triangle selector to the collection of triangle selectors
 	//! in this metaTriangleSelector.
 	virtual void addTriangleSelector(ITriangleSelector* toAdd) IRR_OVERRIDE;
@@ -68,6 +81,16 @@ public:
 
 private:
 
+	//! Gets the bounds of a selector with node transformation, a bit enlarged
+	bool getSelectorBounds(u32 selector, core::aabbox3d<f32>& outBox) const;
+
+	//! Collects the selectors whose bounds touch a box and, if given, a line
+	/** Selectors without bounds are always collected, all selectors when
+	useNodeTransform is false.
+	\param outSelectors Receives the indices in the order the selectors were added */
+	void collectSelectors(core::array<u32>& outSelectors, bool useNodeTransform,
+		const core::aabbox3d<f32>& box, const core::line3d<f32>* line) const;
+
 	core::array<ITriangleSelector*> TriangleSelectors;
 };
 
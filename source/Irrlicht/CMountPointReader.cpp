@@ -6,7 +6,7 @@
 
 #ifdef __IRR_COMPILE_WITH_MOUNT_ARCHIVE_LOADER_
 
-#include "CReadFile.h"
+#include "CMappedReadFile.h"
 #include "os.h"
 
 namespace irr
@@ -155,7 +155,7 @@ IReadFile* CMountPointReader::createAndOpenFile(u32 index)
 	if (index >= Files.size())
 		return 0;
 
-	return CReadFile::createReadFile(RealFileNames[Files[index].ID]);
+	return CMappedReadFile::createReadFile(RealFileNames[Files[index].ID], Parent->getFileMappingThreshold());
 }
 
 //! opens a file by file name
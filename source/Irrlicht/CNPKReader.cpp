@@ -113,6 +113,7 @@ CNPKReader::CNPKReader(IReadFile* file, bool ignoreCase, bool ignorePaths)
 	if (File)
 	{
 		File->grab();
+		ReadHandles.set(File);
 		if (scanLocalHeader())
 			sort();
 		else
@@ -247,7 +248,7 @@ IReadFile* CNPKReader::createAndOpenFile(u32 index)
 		return 0;
 
 	const SFileListEntry &entry = Files[index];
-	return createLimitReadFile( entry.FullName, File, entry.Offset, entry.Size );
+	return createLimitReadFile( entry.FullName, ReadHandles.get(), entry.Offset, entry.Size );
 }
 
 void CNPKReader::readString(core::stringc& name)
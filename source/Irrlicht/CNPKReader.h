@@ -12,6 +12,7 @@
 
 #include "IReferenceCounted.h"
 #include "IReadFile.h"
+#include "CPerThreadReadFile.h"
 #include "irrArray.h"
 #include "irrString.h"
 #include "IFileSystem.h"
@@ -114,6 +115,9 @@ namespace io
 		void readString(core::stringc& name);
 
 		IReadFile* File;
+
+		//! Handles to File for the threads opening entries
+		CPerThreadReadFile ReadHandles;
 	};
 
 } // end namespace io
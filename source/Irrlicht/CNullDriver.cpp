@@ -86,7 +86,8 @@ IImageWriter* createImageWriterPPM();
 
 //! constructor
 CNullDriver::CNullDriver(io::IFileSystem* io, const core::dimension2d<u32>& screenSize)
-	: SharedRenderTarget(0), CurrentRenderTarget(0), CurrentRenderTargetSize(0, 0), FileSystem(io), MeshManipulator(0),
+	: TextureMemoryBudget(0), FrameNumber(0), SharedRenderTarget(0), CurrentRenderTarget(0), CurrentRenderTargetSize(0, 0),
+	FileSystem(io), MeshManipulator(0),
 	ViewPort(0, 0, 0, 0), ScreenSize(screenSize), PrimitivesDrawn(0), MinVertexCountForVBO(500),
 	TextureCreationFlags(0), OverrideMaterial2DEnabled(false), AllowZWriteOnTransparent(false)
 {
@@ -313,6 +314,8 @@ void CNullDriver::deleteAllTextures()
 		Textures[i].Surface->drop();
 
 	Textures.clear();
+	UsedTextures.clear();
+	TextureStatistics.MemoryUsed = 0;
 
 	SharedDepthTextures.clear();
 }
@@ -328,6 +331,8 @@ bool CNullDriver::endScene()
 	FPSCounter.registerFrame(os::Timer::getRealTime(), PrimitivesDrawn);
 	updateAllHardwareBuffers();
 	updateAllOcclusionQueries();
+	evictTextures();
+	++FrameNumber;
 	return true;
 }
 
@@ -383,6 +388,8 @@ void CNullDriver::removeTexture(ITexture* texture)
 	{
 		if (Textures[i].Surface == texture)
 		{
+			if (Textures[i].Resident)
+				TextureStatistics.MemoryUsed -= Textures[i].Memory;
 			texture->drop();
 			Textures.erase(i);
 			return;
@@ -400,6 +407,166 @@ void CNullDriver::removeAllTextures()
 }
 
 
+//! Sets the memory budget for textures loaded from files
+void CNullDriver::setTextureMemoryBudget(u32 bytes)
+{
+	TextureMemoryBudget = bytes;
+	UsedTextures.clear();
+
+	// don't release the textures used so far before they had a chance to be used
+	for (u32 i=0; i<Textures.size(); ++i)
+		Textures[i].LastUsed = FrameNumber;
+}
+
+
+//! Returns the budget set with setTextureMemoryBudget()
+u32 CNullDriver::getTextureMemoryBudget() const
+{
+	return TextureMemoryBudget;
+}
+
+
+//! Returns the memory used by textures and the eviction and reload counters
+const STextureStatistics& CNullDriver::getTextureStatistics() const
+{
+	return TextureStatistics;
+}
+
+
+//! Marks the textures of a material as used in this frame
+void CNullDriver::touchTextures(const SMaterial& material)
+{
+	if (!TextureMemoryBudget)
+		return;
+
+	for (u32 i=0; i<MATERIAL_MAX_TEXTURES; ++i)
+	{
+		ITexture* texture = material.TextureLayer[i].Texture;
+		// materials are often set again with the same textures
+		if (texture && (UsedTextures.empty() || UsedTextures.getLast() != texture))
+			UsedTextures.push_back(texture);
+	}
+}
+
+
+namespace
+{
+	struct SEvictionCandidate
+	{
+		u32 LastUsed;
+		u32 Index;
+
+		bool operator < (const SEvictionCandidate& other) const
+		{
+			return LastUsed < other.LastUsed;
+		}
+	};
+}
+
+//! Releases the least recently used textures until the budget fits again
+void CNullDriver::evictTextures()
+{
+	if (!TextureMemoryBudget)
+		return;
+
+	if (!UsedTextures.empty())
+	{
+		UsedTextures.sort();
+		for (u32 i=0; i<Textures.size(); ++i)
+		{
+			if (UsedTextures.binary_search(Textures[i].Surface) != -1)
+				Textures[i].LastUsed = FrameNumber;
+		}
+		UsedTextures.set_used(0);
+	}
+
+	if (TextureStatistics.MemoryUsed <= TextureMemoryBudget)
+		return;
+
+	core::array<SEvictionCandidate> candidates;
+	for (u32 i=0; i<Textures.size(); ++i)
+	{
+		const SSurface& s = Textures[i];
+		if (s.Resident && s.FromFile && s.LastUsed < FrameNumber &&
+			s.Surface->getType() == ETT_2D && !s.Surface->isRenderTarget())
+		{
+			SEvictionCandidate c;
+			c.LastUsed = s.LastUsed;
+			c.Index = i;
+			candidates.push_back(c);
+		}
+	}
+	candidates.sort();
+
+	for (u32 i=0; i<candidates.size() && TextureStatistics.MemoryUsed > TextureMemoryBudget; ++i)
+	{
+		SSurface& s = Textures[candidates[i].Index];
+		if (evictTextureData(s.Surface))
+		{
+			s.Resident = false;
+			TextureStatistics.MemoryUsed -= s.Memory;
+			++TextureStatistics.Evictions;
+		}
+	}
+}
+
+
+//! Loads the data of a texture released by evictTextureData() again from its file
+bool CNullDriver::reloadTexture(ITexture* texture)
+{
+	SSurface s;
+	s.Surface = texture;
+	const s32 index = Textures.binary_search(s);
+	if (index == -1 || Textures[index].Surface != texture || Textures[index].Resident)
+		return false;
+
+	bool restored = false;
+	io::IReadFile* file = FileSystem->createAndOpenFile(texture->getName().getPath());
+	if (file)
+	{
+		E_TEXTURE_TYPE type = ETT_2D;
+		core::array<IImage*> imageArray = createImagesFromFile(file, &type);
+		if (type == ETT_2D && checkImage(imageArray))
+			restored = restoreTextureData(texture, imageArray[0]);
+
+		for (u32 i = 0; i < imageArray.size(); ++i)
+		{
+			if (imageArray[i])
+				imageArray[i]->drop();
+		}
+		file->drop();
+	}
+
+	// the caller fills in other data when the file can't be loaded, which
+	// uses the same memory but can't be released again
+	SSurface& surface = Textures[index];
+	surface.Resident = true;
+	surface.LastUsed = FrameNumber;
+	TextureStatistics.MemoryUsed += surface.Memory;
+
+	if (!restored)
+	{
+		os::Printer::log("Could not reload texture", texture->getName(), ELL_WARNING);
+		surface.FromFile = false;
+		return false;
+	}
+
+	++TextureStatistics.Reloads;
+	return true;
+}
+
+
+//! Keeps the data of a texture from being released
+void CNullDriver::keepTextureData(ITexture* texture)
+{
+	SSurface s;
+	s.Surface = texture;
+	const s32 index = Textures.binary_search(s);
+	if (index != -1 && Textures[index].Surface == texture)
+		Textures[index].FromFile = false;
+}
+
+
 //! Returns a texture by index
 ITexture* CNullDriver::getTextureByIndex(u32 i)
 {
@@ -427,6 +594,13 @@ void CNullDriver::renameTexture(ITexture* texture, const io::path& newName)
 	io::SNamedPath& name = const_cast<io::SNamedPath&>(texture->getName());
 	name.setPath(newName);
 
+	// the new name is no file to reload from
+	for (u32 i=0; i<Textures.size(); ++i)
+	{
+		if (Textures[i].Surface == texture)
+			Textures[i].FromFile = false;
+	}
+
 	Textures.sort();
 }
 
@@ -592,7 +766,7 @@ ITexture* CNullDriver::getTexture(const io::path& filename)
 		if (texture)
 		{
 			texture->updateSource(ETS_FROM_FILE);
-			addTexture(texture);
+			addTexture(texture, true);
 			texture->drop(); // drop it because we created it, one grab too much
 		}
 		else
@@ -681,13 +855,22 @@ video::ITexture* CNullDriver::loadTextureFromFile(io::IReadFile* file, const io:
 
 
 //! adds a surface, not loaded or created by the Irrlicht Engine
-void CNullDriver::addTexture(video::ITexture* texture)
+void CNullDriver::addTexture(video::ITexture* texture, bool fromFile)
 {
 	if (texture)
 	{
 		SSurface s;
 		s.Surface = texture;
+		s.Memory = texture->getPitch() * texture->getSize().Height;
+		if (texture->hasMipMaps())
+			s.Memory += s.Memory / 3;
+		if (texture->getType() == ETT_CUBEMAP)
+			s.Memory *= 6;
+		s.LastUsed = FrameNumber;
+		s.Resident = true;
+		s.FromFile = fromFile;
 		texture->grab();
+		TextureStatistics.MemoryUsed += s.Memory;
 
 		Textures.push_back(s);
 
@@ -717,7 +900,7 @@ video::ITexture* CNullDriver::findTexture(const io::path& filename)
 
 ITexture* CNullDriver::createDeviceDependentTexture(const io::path& name, IImage* image)
 {
-	return new SDummyTexture(name, ETT_2D);
+	return new SDummyTexture(name, ETT_2D, image);
 }
 
 ITexture* CNullDriver::createDeviceDependentTextureCubemap(const io::path& name, const core::array<IImage*>& image)
@@ -1620,6 +1803,98 @@ core::array<IImage*> CNullDriver::createImagesFromFile(io::IReadFile* file, E_TE
 }
 
 
+//! Creates a software image from a file, reduced to fit into maxSize.
+IImage* CNullDriver::createReducedImageFromFile(const io::path& filename, const core::dimension2du& maxSize)
+{
+	IImage* image = 0;
+
+	if (filename.size() > 0)
+	{
+		io::IReadFile* file = FileSystem->createAndOpenFile(filename);
+
+		if (file)
+		{
+			image = createReducedImageFromFile(file, maxSize);
+			file->drop();
+		}
+		else
+			os::Printer::log("Could not open file of image", filename, ELL_WARNING);
+	}
+
+	return image;
+}
+
+
+//! Creates a software image from a file, reduced to fit into maxSize.
+IImage* CNullDriver::createReducedImageFromFile(io::IReadFile* file, const core::dimension2du& maxSize)
+{
+	if (!file)
+		return 0;
+
+	const core::dimension2du size(core::max_(maxSize.Width, 1u), core::max_(maxSize.Height, 1u));
+	IImage* image = 0;
+	s32 i;
+
+	// try to load file based on file extension
+	for (i = SurfaceLoader.size() - 1; i >= 0 && !image; --i)
+	{
+		if (SurfaceLoader[i]->isALoadableFileExtension(file->getFileName()))
+		{
+			file->seek(0);
+			image = SurfaceLoader[i]->loadReducedImage(file, size);
+		}
+	}
+
+	// try to load file based on what is in it
+	for (i = SurfaceLoader.size() - 1; i >= 0 && !image; --i)
+	{
+		file->seek(0);
+		if (SurfaceLoader[i]->isALoadableFileFormat(file)
+			&& !SurfaceLoader[i]->isALoadableFileExtension(file->getFileName())	// extension was tried above already
+			)
+		{
+			file->seek(0);
+			image = SurfaceLoader[i]->loadReducedImage(file, size);
+		}
+	}
+
+	// loaders which only implement loadImages
+	if (!image)
+		image = createImageFromFile(file);
+	if (!image)
+		return 0;
+
+	// scale down what the loader couldn't reduce enough
+	const core::dimension2du& dim = image->getDimension();
+	if (dim.Width <= size.Width && dim.Height <= size.Height)
+		return image;
+
+	switch (image->getColorFormat())
+	{
+	case ECF_A1R5G5B5:
+	case ECF_R5G6B5:
+	case ECF_R8G8B8:
+	case ECF_A8R8G8B8:
+		break;
+	default:
+		os::Printer::log("Could not reduce image of this color format", file->getFileName(), ELL_INFORMATION);
+		return image;
+	}
+
+	core::dimension2du fit(size);
+	if ((u64)dim.Width * size.Height > (u64)dim.Height * size.Width)
+		fit.Height = core::max_((u32)((u64)dim.Height * size.Width / dim.Width), 1u);
+	else
+		fit.Width = core::max_((u32)((u64)dim.Width * size.Height / dim.Height), 1u);
+
+	IImage* scaled = new CImage(image->getColorFormat(), fit);
+	image->copyToScalingBoxFilter(scaled);
+	image->drop();
+
+	return scaled;
+}
+
+
 //! Writes the provided image to disk file
 bool CNullDriver::writeImageToFile(IImage* image, const io::path& filename,u32 param)
 {
@@ -1765,13 +2040,40 @@ void CNullDriver::drawMeshBuffer(const scene::IMeshBuffer* mb)
 	//IVertexBuffer and IIndexBuffer later
 	SHWBufferLink *HWBuffer=getBufferLink(mb);
 
+	// hardware buffers hold quantized vertices decoded, without one they are decoded for each draw
 	if (HWBuffer)
 		drawHardwareBuffer(HWBuffer);
+	else if (isQuantized(mb->getVertexType()))
+		drawVertexPrimitiveList(decodeQuantizedVertices(mb), mb->getVertexCount(), mb->getIndices(), mb->getPrimitiveCount(),
+			getDecodedVertexType(mb->getVertexType()), mb->getPrimitiveType(), mb->getIndexType());
 	else
 		drawVertexPrimitiveList(mb->getVertices(), mb->getVertexCount(), mb->getIndices(), mb->getPrimitiveCount(), mb->getVertexType(), mb->getPrimitiveType(), mb->getIndexType());
 }
 
 
+//! Decodes the vertices of a quantized mesh buffer for drawing
+const void* CNullDriver::decodeQuantizedVertices(const scene::IMeshBuffer* mb)
+{
+	const SVertexQuantization* quantization = mb->getVertexQuantization();
+	const u32 count = mb->getVertexCount();
+
+	if (mb->getVertexType() == EVT_QUANTIZED_TANGENTS)
+	{
+		const S3DVertexQuantizedTangents* v = static_cast<const S3DVertexQuantizedTangents*>(mb->getVertices());
+		DecodedTangentVertices.set_used(count);
+		for (u32 i=0; i < count; ++i)
+			quantization->decode(v[i], DecodedTangentVertices[i]);
+		return DecodedTangentVertices.const_pointer();
+	}
+
+	const S3DVertexQuantized* v = static_cast<const S3DVertexQuantized*>(mb->getVertices());
+	DecodedVertices.set_used(count);
+	for (u32 i=0; i < count; ++i)
+		quantization->decode(v[i], DecodedVertices[i]);
+	return DecodedVertices.const_pointer();
+}
+
+
 //! Draws the normals of a mesh buffer
 void CNullDriver::drawMeshBufferNormals(const scene::IMeshBuffer* mb, f32 length, SColor color)
 {
@@ -317,6 +317,28 @@ namespace video
 		//! memory.
 		virtual void removeAllTextures() IRR_OVERRIDE;
 
+		//! Sets the memory budget for textures loaded from files
+		virtual void setTextureMemoryBudget(u32 bytes) IRR_OVERRIDE;
+
+		//! Returns the budget set with setTextureMemoryBudget()
+		virtual u32 getTextureMemoryBudget() const IRR_OVERRIDE;
+
+		//! Returns the memory used by textures and the eviction and reload counters
+		virtual const STextureStatistics& getTextureStatistics() const IRR_OVERRIDE;
+
+		//! Loads the data of a texture released by evictTextureData() again from its file
+		/** Called by textures of the driver when they are used after their
+		data was released.
+		\return True if the data was restored. Otherwise the texture counts
+		as resident again and is never released again, the caller has to
+		create some data for it. */
+		bool reloadTexture(ITexture* texture);
+
+		//! Keeps the data of a texture from being released
+		/** Called by textures of the driver when they are locked for
+		writing, as their data no longer matches the file then. */
+		void keepTextureData(ITexture* texture);
+
 		//! Creates a render target texture.
 		virtual ITexture* addRenderTargetTexture(const core::dimension2d<u32>& size,
 			const io::path& name, const ECOLOR_FORMAT format = ECF_UNKNOWN) IRR_OVERRIDE;
@@ -351,6 +373,12 @@ namespace video
 
 		virtual core::array<IImage*> createImagesFromFile(io::IReadFile* file, E_TEXTURE_TYPE* type = 0) IRR_OVERRIDE;
 
+		//! Creates a software image from a file, reduced to fit into maxSize.
+		virtual IImage* createReducedImageFromFile(const io::path& filename, const core::dimension2du& maxSize) IRR_OVERRIDE;
+
+		//! Creates a software image from a file, reduced to fit into maxSize.
+		virtual IImage* createReducedImageFromFile(io::IReadFile* file, const core::dimension2du& maxSize) IRR_OVERRIDE;
+
 		//! Creates a software image from a byte array.
 		/** \param useForeignMemory: If true, the image will use the data pointer
 		directly and own it from now on, which means it will also try to delete [] the
@@ -429,6 +457,26 @@ namespace video
 		//! Create hardware buffer from mesh (only some drivers can)
 		virtual SHWBufferLink *createHardwareBuffer(const scene::IMeshBuffer* mb) {return 0;}
 
+		//! Decodes the vertices of an EVT_QUANTIZED or EVT_QUANTIZED_TANGENTS mesh buffer
+		/** \return S3DVertex or S3DVertexTangents vertices, valid until the next call. */
+		const void* decodeQuantizedVertices(const scene::IMeshBuffer* mb);
+
+		//! Returns true for EVT_QUANTIZED and EVT_QUANTIZED_TANGENTS
+		static bool isQuantized(E_VERTEX_TYPE vType)
+		{
+			return vType == EVT_QUANTIZED || vType == EVT_QUANTIZED_TANGENTS;
+		}
+
+		//! Returns the type of the vertices decodeQuantizedVertices() creates, other types are returned unchanged
+		static E_VERTEX_TYPE getDecodedVertexType(E_VERTEX_TYPE vType)
+		{
+			if (vType == EVT_QUANTIZED)
+				return EVT_STANDARD;
+			if (vType == EVT_QUANTIZED_TANGENTS)
+				return EVT_TANGENTS;
+			return vType;
+		}
+
 	public:
 		//! Remove hardware buffer
 		virtual void removeHardwareBuffer(const scene::IMeshBuffer* mb) IRR_OVERRIDE;
@@ -697,7 +745,26 @@ namespace video
 		video::ITexture* loadTextureFromFile(io::IReadFile* file, const io::path& hashName = "");
 
 		//! adds a surface, not loaded or created by the Irrlicht Engine
-		void addTexture(video::ITexture* surface);
+		/** \param fromFile The texture can be loaded again from the file named like it */
+		void addTexture(video::ITexture* surface, bool fromFile=false);
+
+		//! Marks the textures of a material as used in this frame
+		/** Drivers call this when a material is set, it only records
+		something while a texture memory budget is set. */
+		void touchTextures(const SMaterial& material);
+
+		//! Releases the least recently used textures until the budget fits again
+		void evictTextures();
+
+		//! Releases the data of a texture, which stays valid otherwise
+		/** Drivers supporting texture memory budgets override this.
+		\return True if the data was released */
+		virtual bool evictTextureData(ITexture* texture) { return false; }
+
+		//! Restores the data of a texture released by evictTextureData()
+		/** \param image Image loaded from the file of the texture
+		\return True if the data was restored */
+		virtual bool restoreTextureData(ITexture* texture, IImage* image) { return false; }
 
 		virtual ITexture* createDeviceDependentTexture(const io::path& name, IImage* image);
 
@@ -764,6 +831,10 @@ namespace video
 		struct SSurface
 		{
 			video::ITexture* Surface;
+			u32 Memory; // estimated size of the data in bytes
+			u32 LastUsed; // frame number
+			bool Resident; // false while the data is released
+			bool FromFile; // can be loaded again from the texture name
 
 			bool operator < (const SSurface& other) const
 			{
@@ -779,7 +850,16 @@ namespace video
 
 		struct SDummyTexture : public ITexture
 		{
-			SDummyTexture(const io::path& name, E_TEXTURE_TYPE type) : ITexture(name, type) {};
+			SDummyTexture(const io::path& name, E_TEXTURE_TYPE type, const IImage* image=0) : ITexture(name, type)
+			{
+				// report the size of the image, so texture memory can be counted
+				if (image)
+				{
+					OriginalSize = Size = image->getDimension();
+					OriginalColorFormat = ColorFormat = image->getColorFormat();
+					Pitch = image->getPitch();
+				}
+			}
 
 			virtual void* lock(E_TEXTURE_LOCK_MODE mode = ETLM_READ_WRITE, u32 mipmapLevel=0, u32 layer = 0, E_TEXTURE_LOCK_FLAGS lockFlags = ETLF_FLIP_Y_UP_RTT) IRR_OVERRIDE { return 0; }
 			virtual void unlock()IRR_OVERRIDE {}
@@ -787,6 +867,12 @@ namespace video
 		};
 		core::array<SSurface> Textures;
 
+		//! Textures passed to touchTextures() in this frame, not sorted
+		core::array<ITexture*> UsedTextures;
+		u32 TextureMemoryBudget;
+		STextureStatistics TextureStatistics;
+		u32 FrameNumber;
+
 		struct SOccQuery
 		{
 			SOccQuery(scene::ISceneNode* node, const scene::IMesh* mesh=0) : Node(node), Mesh(mesh), PID(0), Result(0xffffffff), Run(0xffffffff)
@@ -896,6 +982,10 @@ namespace video
 		bool AllowZWriteOnTransparent;
 
 		bool FeatureEnabled[video::EVDF_COUNT];
+
+		//! vertices of the last quantized mesh buffer drawn
+		core::array<S3DVertex> DecodedVertices;
+		core::array<S3DVertexTangents> DecodedTangentVertices;
 	};
 
 } // end namespace video
@@ -17,6 +17,7 @@
 #include "fast_atof.h"
 #include "coreutil.h"
 #include "os.h"
+#include "CTextChunks.h"
 
 namespace irr
 {
@@ -29,6 +30,24 @@ namespace scene
 
 static const u32 WORD_BUFFER_LENGTH = 512;
 
+namespace
+{
+
+template <class T, class TAlloc>
+void appendArray(core::array<T, TAlloc>& to, core::array<T, TAlloc>& from)
+{
+	if (to.empty())
+	{
+		to.swap(from);
+		return;
+	}
+	to.reallocate(to.size() + from.size());
+	for (u32 i=0; i<from.size(); ++i)
+		to.push_back(from[i]);
+}
+
+} // end anonymous namespace
+
 //! Constructor
 COBJMeshFileLoader::COBJMeshFileLoader(scene::ISceneManager* smgr, io::IFileSystem* fs)
 : SceneManager(smgr), FileSystem(fs)
@@ -89,128 +108,129 @@ IAnimatedMesh* COBJMeshFileLoader::createMesh(io::IReadFile* file)
 	const io::path fullName = file->getFileName();
 	const io::path relPath = FileSystem->getFileDir(fullName)+"/";
 
-	c8* buf = new c8[filesize];
-	memset(buf, 0, filesize);
+	// terminated, so numbers can be parsed in place up to the end
+	c8* buf = new c8[filesize+1];
+	memset(buf, 0, filesize+1);
 	file->read((void*)buf, filesize);
 	const c8* const bufEnd = buf+filesize;
 
+	// Parse large files in chunks at the same time, then process the
+	// records in file order. Same result as with a single chunk.
+	core::array<const c8*> bounds;
+	splitTextAtLines(buf, bufEnd, getTextChunkCount(filesize,
+		SceneManager->getParameters()->getAttributeAsInt(MESH_LOADER_PARSE_THREADS)), bounds);
+	core::array<SObjChunk> chunks;
+	chunks.reallocate(bounds.size()-1);
+	for (u32 i=0; i+1<bounds.size(); ++i)
+	{
+		chunks.push_back(SObjChunk());
+		chunks[i].Loader = this;
+		chunks[i].Begin = bounds[i];
+		chunks[i].End = bounds[i+1];
+	}
+	parseChunks(chunks);
+
 	// Process obj information
-	const c8* bufPtr = buf;
 	core::stringc grpName, mtlName;
 	bool mtlChanged=false;
 	bool useGroups = !SceneManager->getParameters()->getAttributeAsBool(OBJ_LOADER_IGNORE_GROUPS);
 	bool useMaterials = !SceneManager->getParameters()->getAttributeAsBool(OBJ_LOADER_IGNORE_MATERIAL_FILES);
-	irr::u32 lineNr = 1;	// only counts non-empty lines, still useful in debugging to locate errors
 	core::array<int> faceCorners;
 	faceCorners.reallocate(32); // should be large enough
 	const core::stringc TAG_OFF = "off";
 	irr::u32 degeneratedFaces = 0;
 
-	while(bufPtr != bufEnd)
+	for (u32 chunkNr = 0; chunkNr < chunks.size(); ++chunkNr)
 	{
-		switch(bufPtr[0])
-		{
-		case 'm':	// mtllib (material)
-		{
-			if (useMaterials)
-			{
-				// Bit fuzzy definition. Some doc (http://paulbourke.net) says there can be more then one file and they are separated by spaces
-				// Other doc (Wikipedia) says it's one file. Which does allow loading mtl files with spaces in the name.
-				// Other tools I tested seem to go with the Wikipedia definition
-				// Irrlicht did just use first word in Irrlicht 1.8, but with 1.9 we switch to allowing filenames with spaces
-				// If this turns out to cause troubles we can maybe try to catch those cases by looking for ".mtl " inside the string
-				const c8 * inBuf = goNextWord(bufPtr, bufEnd, false);
-				core::stringc name = copyLine(inBuf, bufEnd);
+		SObjChunk& chunk = chunks[chunkNr];
 
-#ifdef _IRR_DEBUG_OBJ_LOADER_
-				os::Printer::log("Reading material file",name);
-#endif
-				readMTL(name.c_str(), relPath);
-			}
-		}
-			break;
+		// records before this chunk, in the order of the indices
+		const u32 base[3] = { vertexBuffer.size(), textureCoordBuffer.size(), normalsBuffer.size() };
+		appendArray(vertexBuffer, chunk.Positions);
+		appendArray(textureCoordBuffer, chunk.TexCoords);
+		appendArray(normalsBuffer, chunk.Normals);
 
-		case 'v':               // v, vn, vt
-			switch(bufPtr[1])
+		u32 stateLine = 0;
+		for (u32 faceNr = 0; faceNr <= chunk.Faces.size(); ++faceNr)
+		{
+			// lines changing the state before this face
+			for (; stateLine < chunk.StateLines.size() && chunk.StateLines[stateLine].Face == faceNr; ++stateLine)
 			{
-			case ' ':          // vertex
+				const c8* bufPtr = chunk.StateLines[stateLine].Line;
+				switch(bufPtr[0])
 				{
-					core::vector3df vec;
-					bufPtr = readVec3(bufPtr, vec, bufEnd);
-					vertexBuffer.push_back(vec);
-				}
-				break;
-
-			case 'n':       // normal
+				case 'm':	// mtllib (material)
 				{
-					core::vector3df vec;
-					bufPtr = readVec3(bufPtr, vec, bufEnd);
-					normalsBuffer.push_back(vec);
-				}
-				break;
+					if (useMaterials)
+					{
+						// Bit fuzzy definition. Some doc (http://paulbourke.net) says there can be more then one file and they are separated by spaces
+						// Other doc (Wikipedia) says it's one file. Which does allow loading mtl files with spaces in the name.
+						// Other tools I tested seem to go with the Wikipedia definition
+						// Irrlicht did just use first word in Irrlicht 1.8, but with 1.9 we switch to allowing filenames with spaces
+						// If this turns out to cause troubles we can maybe try to catch those cases by looking for ".mtl " inside the string
+						const c8 * inBuf = goNextWord(bufPtr, bufEnd, false);
+						core::stringc name = copyLine(inBuf, bufEnd);
 
-			case 't':       // texcoord
-				{
-					core::vector2df vec;
-					bufPtr = readUV(bufPtr, vec, bufEnd);
-					textureCoordBuffer.push_back(vec);
+#ifdef _IRR_DEBUG_OBJ_LOADER_
+						os::Printer::log("Reading material file",name);
+#endif
+						readMTL(name.c_str(), relPath);
+					}
 				}
-				break;
-			}
-			break;
+					break;
 
-		case 'g': // group name
-			{
-				c8 grp[WORD_BUFFER_LENGTH];
-				bufPtr = goAndCopyNextWord(grp, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
+				case 'g': // group name
+					{
+						c8 grp[WORD_BUFFER_LENGTH];
+						bufPtr = goAndCopyNextWord(grp, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
 #ifdef _IRR_DEBUG_OBJ_LOADER_
 	os::Printer::log("Loaded group start",grp, ELL_DEBUG);
 #endif
-				if (useGroups)
-				{
-					if (0 != grp[0])
-						grpName = grp;
-					else
-						grpName = "default";
-				}
-				mtlChanged=true;
-			}
-			break;
+						if (useGroups)
+						{
+							if (0 != grp[0])
+								grpName = grp;
+							else
+								grpName = "default";
+						}
+						mtlChanged=true;
+					}
+					break;
 
-		case 's': // smoothing can be a group or off (equiv. to 0)
-			{
-				c8 smooth[WORD_BUFFER_LENGTH];
-				bufPtr = goAndCopyNextWord(smooth, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
+				case 's': // smoothing can be a group or off (equiv. to 0)
+					{
+						c8 smooth[WORD_BUFFER_LENGTH];
+						bufPtr = goAndCopyNextWord(smooth, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
 #ifdef _IRR_DEBUG_OBJ_LOADER_
 	os::Printer::log("Loaded smoothing group start",smooth, ELL_DEBUG);
 #endif
-				if (TAG_OFF==smooth)
-					smoothingGroup=0;
-				else
-					smoothingGroup=core::strtoul10(smooth);
+						if (TAG_OFF==smooth)
+							smoothingGroup=0;
+						else
+							smoothingGroup=core::strtoul10(smooth);
 
-				(void)smoothingGroup; // disable unused variable warnings
-			}
-			break;
+						(void)smoothingGroup; // disable unused variable warnings
+					}
+					break;
 
-		case 'u': // usemtl
-			// get name of material
-			{
-				c8 matName[WORD_BUFFER_LENGTH];
-				bufPtr = goAndCopyNextWord(matName, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
+				case 'u': // usemtl
+					// get name of material
+					{
+						c8 matName[WORD_BUFFER_LENGTH];
+						bufPtr = goAndCopyNextWord(matName, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
 #ifdef _IRR_DEBUG_OBJ_LOADER_
 	os::Printer::log("Loaded material start",matName, ELL_DEBUG);
 #endif
-				mtlName=matName;
-				mtlChanged=true;
+						mtlName=matName;
+						mtlChanged=true;
+					}
+					break;
+				}	// end switch(bufPtr[0])
 			}
-			break;
+			if (faceNr == chunk.Faces.size())
+				break;
 
-		case 'f':               // face
-		{
-			c8 vertexWord[WORD_BUFFER_LENGTH]; // for retrieving vertex data
-			video::S3DVertex v;
-			// Assign vertex color from currently active material's diffuse color
+			const SObjFace& face = chunk.Faces[faceNr];
 			if (mtlChanged)
 			{
 				// retrieve the material
@@ -220,79 +240,73 @@ IAnimatedMesh* COBJMeshFileLoader::createMesh(io::IReadFile* file)
 					currMtl = useMtl;
 				mtlChanged=false;
 			}
-			if (currMtl)
-				v.Color = currMtl->Meshbuffer->Material.DiffuseColor;
 
 			// get all vertices data in this face (current line of obj file)
 			IVertexBuffer& mbVertexBuffer = currMtl->Meshbuffer->getVertexBuffer();
 			IIndexBuffer& mbIndexBuffer = currMtl->Meshbuffer->getIndexBuffer();
-			const core::stringc wordBuffer = copyLine(bufPtr, bufEnd);
-			const c8* linePtr = wordBuffer.c_str();
-			const c8* const endPtr = linePtr+wordBuffer.size();
 
 			faceCorners.set_used(0); // fast clear
 
 			// read in all vertices
-			linePtr = goNextWord(linePtr, endPtr);
-			while (0 != linePtr[0])
+			const u32 cornerEnd = faceNr+1 < chunk.Faces.size() ? chunk.Faces[faceNr+1].FirstCorner : chunk.Corners.size();
+			for (u32 corner = face.FirstCorner; corner < cornerEnd; ++corner)
 			{
-				// Array to communicate with retrieveVertexIndices()
-				// sends the buffer sizes and gets the actual indices
-				// if index not set returns -1
+				// convert obj's 1-based index to c++'s 0-based index
+				// relative indices count back from the records before the face
+				// if index not set becomes -1
 				s32 Idx[3];
-				Idx[0] = Idx[1] = Idx[2] = -1;
-
-				// read in next vertex's data
-				u32 wlength = copyWord(vertexWord, linePtr, WORD_BUFFER_LENGTH, endPtr);
-				// this function will also convert obj's 1-based index to c++'s 0-based index
-				retrieveVertexIndices(vertexWord, Idx, vertexWord+wlength+1, vertexBuffer.size(), textureCoordBuffer.size(), normalsBuffer.size());
-				if ( -1 != Idx[0] && Idx[0] < (irr::s32)vertexBuffer.size() )
-					v.Pos = vertexBuffer[Idx[0]];
-				else
+				s32 sizes[3];
+				for (u32 i = 0; i < 3; ++i)
 				{
-					os::Printer::log("Invalid vertex index in this line:", wordBuffer.c_str(), ELL_ERROR);
-					delete [] buf;
-					return 0;
+					sizes[i] = (s32)(base[i] + face.Counts[i]);
+					Idx[i] = chunk.Corners[corner].Idx[i];
+					Idx[i] += Idx[i] < 0 ? sizes[i] : -1;
 				}
-				if ( -1 != Idx[1] && Idx[1] < (irr::s32)textureCoordBuffer.size() )
-					v.TCoords = textureCoordBuffer[Idx[1]];
-				else
-					v.TCoords.set(0.0f,0.0f);
-				if ( -1 != Idx[2] && Idx[2] < (irr::s32)normalsBuffer.size() )
-					v.Normal = normalsBuffer[Idx[2]];
-				else
-				{
-					v.Normal.set(0.0f,0.0f,0.0f);
-					currMtl->RecalculateNormals=true;
-				}
-
-				int vertLocation;
-				core::map<video::S3DVertex, int>::Node* n = currMtl->VertMap.find(v);
-				if (n)
+				if ( Idx[0] < 0 || Idx[0] >= sizes[0] )
 				{
-					vertLocation = n->getValue();
+					os::Printer::log("Invalid vertex index in this line:", copyLine(face.Line, bufEnd).c_str(), ELL_ERROR);
+					delete [] buf;
+					cleanUp();
+					return 0;
 				}
-				else
+				if ( Idx[1] < 0 || Idx[1] >= sizes[1] )
+					Idx[1] = -1;
+				if ( Idx[2] < 0 || Idx[2] >= sizes[2] )
+					Idx[2] = -1;
+
+				// corners sharing the same indices share the vertex
+				s32 vertLocation = mbVertexBuffer.size();
+				if (!currMtl->VertMap.findOrInsert(Idx, vertLocation))
 				{
+					video::S3DVertex v;
+					// Assign vertex color from currently active material's diffuse color
+					v.Color = currMtl->Meshbuffer->Material.DiffuseColor;
+					v.Pos = vertexBuffer[Idx[0]];
+					if ( Idx[1] >= 0 )
+						v.TCoords = textureCoordBuffer[Idx[1]];
+					else
+						v.TCoords.set(0.0f,0.0f);
+					if ( Idx[2] >= 0 )
+						v.Normal = normalsBuffer[Idx[2]];
+					else
+					{
+						v.Normal.set(0.0f,0.0f,0.0f);
+						currMtl->RecalculateNormals=true;
+					}
 					mbVertexBuffer.push_back(v);
-					vertLocation = mbVertexBuffer.size() -1;
-					currMtl->VertMap.insert(v, vertLocation);
 				}
 
 				faceCorners.push_back(vertLocation);
-
-				// go to next vertex
-				linePtr = goNextWord(linePtr, endPtr);
 			}
 
 			// triangulate the face
-			const int c = faceCorners[0];
-			for ( u32 i = 1; i < faceCorners.size() - 1; ++i )
+			for ( u32 i = 1; i + 1 < faceCorners.size(); ++i )
 			{
 				// Add a triangle
 				const int a = faceCorners[i + 1];
 				const int b = faceCorners[i];
-				if (a != b && a != c && b != c)	// ignore degenerated faces. We can get them when we merge vertices above in the VertMap.
+				const int c = faceCorners[0];
+				if (a != b && a != c && b != c)	// ignore degenerated faces. We can get them when a face uses the same indices twice.
 				{
 					mbIndexBuffer.push_back(a);
 					mbIndexBuffer.push_back(b);
@@ -304,16 +318,10 @@ IAnimatedMesh* COBJMeshFileLoader::createMesh(io::IReadFile* file)
 				}
 			}
 		}
-		break;
 
-		case '#': // comment
-		default:
-			break;
-		}	// end switch(bufPtr[0])
-		// eat up rest of line
-		bufPtr = goNextLine(bufPtr, bufEnd);
-		++lineNr;
-	}	// end while(bufPtr && (bufPtr-buf<filesize))
+		// the records are copied, free them early
+		chunk = SObjChunk();
+	}
 
 	if ( degeneratedFaces > 0 )
 	{
@@ -369,6 +377,91 @@ IAnimatedMesh* COBJMeshFileLoader::createMesh(io::IReadFile* file)
 }
 
 
+//! Collects the records of a chunk, called on worker threads
+void COBJMeshFileLoader::parseChunk(SObjChunk& chunk)
+{
+	const c8* const bufEnd = chunk.End;
+	const c8* bufPtr = goFirstWord(chunk.Begin, bufEnd);
+
+	while(bufPtr != bufEnd)
+	{
+		switch(bufPtr[0])
+		{
+		case 'v':               // v, vn, vt
+			switch(bufPtr[1])
+			{
+			case ' ':          // vertex
+				{
+					core::vector3df vec;
+					bufPtr = readVec3(bufPtr, vec, bufEnd);
+					chunk.Positions.push_back(vec);
+				}
+				break;
+
+			case 'n':       // normal
+				{
+					core::vector3df vec;
+					bufPtr = readVec3(bufPtr, vec, bufEnd);
+					chunk.Normals.push_back(vec);
+				}
+				break;
+
+			case 't':       // texcoord
+				{
+					core::vector2df vec;
+					bufPtr = readUV(bufPtr, vec, bufEnd);
+					chunk.TexCoords.push_back(vec);
+				}
+				break;
+			}
+			break;
+
+		case 'f':               // face
+			{
+				SObjFace face;
+				face.Line = bufPtr;
+				face.FirstCorner = chunk.Corners.size();
+				face.Counts[0] = chunk.Positions.size();
+				face.Counts[1] = chunk.TexCoords.size();
+				face.Counts[2] = chunk.Normals.size();
+				chunk.Faces.push_back(face);
+
+				const c8* linePtr = goNextWord(bufPtr, bufEnd, false);
+				while (linePtr != bufEnd && !core::isspace(*linePtr))
+				{
+					SObjCorner corner;
+					linePtr = retrieveVertexIndices(linePtr, corner.Idx, bufEnd);
+					chunk.Corners.push_back(corner);
+
+					// go to next vertex
+					linePtr = goFirstWord(linePtr, bufEnd, false);
+				}
+				bufPtr = linePtr;
+			}
+			break;
+
+		case 'm':	// mtllib (material)
+		case 'g':	// group name
+		case 's':	// smoothing group
+		case 'u':	// usemtl
+			{
+				SObjStateLine line;
+				line.Line = bufPtr;
+				line.Face = chunk.Faces.size();
+				chunk.StateLines.push_back(line);
+			}
+			break;
+
+		case '#': // comment
+		default:
+			break;
+		}	// end switch(bufPtr[0])
+		// eat up rest of line
+		bufPtr = goNextLine(bufPtr, bufEnd);
+	}
+}
+
+
 const c8* COBJMeshFileLoader::readTextures(const c8* bufPtr, const c8* const bufEnd, SObjMtl* currMaterial, const io::path& relPath)
 {
 	u8 type=0; // map_Kd - diffuse color texture map
@@ -730,32 +823,31 @@ const c8* COBJMeshFileLoader::readColor(const c8* bufPtr, video::SColor& color,
 }
 
 
+//! Read the next float of the line in place, returns the pointer behind it
+const c8* COBJMeshFileLoader::readFloat(const c8* bufPtr, f32& value, const c8* const bufEnd)
+{
+	bufPtr = goNextWord(bufPtr, bufEnd, false);
+	// the buffer is terminated, at the line end this reads 0 and stays there
+	return core::fast_atof_move(bufPtr, value);
+}
+
+
 //! Read 3d vector of floats
 const c8* COBJMeshFileLoader::readVec3(const c8* bufPtr, core::vector3df& vec, const c8* const bufEnd)
 {
-	const u32 WORD_BUFFER_LENGTH = 256;
-	c8 wordBuffer[WORD_BUFFER_LENGTH];
-
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	vec.X=-core::fast_atof(wordBuffer); // change handedness
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	vec.Y=core::fast_atof(wordBuffer);
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	vec.Z=core::fast_atof(wordBuffer);
-	return bufPtr;
+	bufPtr = readFloat(bufPtr, vec.X, bufEnd);
+	vec.X = -vec.X; // change handedness
+	bufPtr = readFloat(bufPtr, vec.Y, bufEnd);
+	return readFloat(bufPtr, vec.Z, bufEnd);
 }
 
 
 //! Read 2d vector of floats
 const c8* COBJMeshFileLoader::readUV(const c8* bufPtr, core::vector2df& vec, const c8* const bufEnd)
 {
-	const u32 WORD_BUFFER_LENGTH = 256;
-	c8 wordBuffer[WORD_BUFFER_LENGTH];
-
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	vec.X=core::fast_atof(wordBuffer);
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	vec.Y=1-core::fast_atof(wordBuffer); // change handedness
+	bufPtr = readFloat(bufPtr, vec.X, bufEnd);
+	bufPtr = readFloat(bufPtr, vec.Y, bufEnd);
+	vec.Y = 1-vec.Y; // change handedness
 	return bufPtr;
 }
 
@@ -897,72 +989,94 @@ const c8* COBJMeshFileLoader::goAndCopyNextWord(c8* outBuf, const c8* inBuf, u32
 }
 
 
-bool COBJMeshFileLoader::retrieveVertexIndices(c8* vertexData, s32* idx, const c8* bufEnd, u32 vbsize, u32 vtsize, u32 vnsize)
+const c8* COBJMeshFileLoader::retrieveVertexIndices(const c8* vertexData, s32* idx, const c8* bufEnd)
 {
-	c8 word[16] = "";
-	const c8* p = goFirstWord(vertexData, bufEnd);
-	u32 idxType = 0;	// 0 = posIdx, 1 = texcoordIdx, 2 = normalIdx
+	const c8* p = vertexData;
+	idx[0] = idx[1] = idx[2] = 0;
 
-	u32 i = 0;
-	while ( p != bufEnd )
+	for (u32 idxType = 0; idxType < 3; ++idxType)	// 0 = posIdx, 1 = texcoordIdx, 2 = normalIdx
+	{
+		// if no number was found index stays 0
+		idx[idxType] = core::strtol10(p, &p);
+
+		// go to the next kind of index type
+		if (p == bufEnd || *p != '/')
+			break;
+		++p;
+	}
+
+	// skip anything else in this corner
+	while ( p != bufEnd && !core::isspace(*p) )
+		++p;
+
+	return p;
+}
+
+
+COBJMeshFileLoader::CVertexIndexMap::CVertexIndexMap()
+	: Used(0)
+{
+}
+
+
+//! Returns true and sets vertex if the triple is known, else adds it with the given vertex
+bool COBJMeshFileLoader::CVertexIndexMap::findOrInsert(const s32* idx, s32& vertex)
+{
+	if (2*(Used+1) > Slots.size())
+		grow();
+
+	const u32 mask = Slots.size()-1;
+	for (u32 i = hash(idx) & mask; ; i = (i+1) & mask)
 	{
-		if ( ( core::isdigit(*p)) || (*p == '-') )
+		SSlot& slot = Slots[i];
+		if (slot.Vertex == -1)
 		{
-			// build up the number
-			word[i++] = *p;
+			slot.Idx[0] = idx[0];
+			slot.Idx[1] = idx[1];
+			slot.Idx[2] = idx[2];
+			slot.Vertex = vertex;
+			++Used;
+			return false;
 		}
-		else if ( *p == '/' || *p == ' ' || *p == '\0' )
+		if (slot.Idx[0] == idx[0] && slot.Idx[1] == idx[1] && slot.Idx[2] == idx[2])
 		{
-			// number is completed. Convert and store it
-			word[i] = '\0';
-			// if no number was found index will become 0 and later on -1 by decrement
-			idx[idxType] = core::strtol10(word);
-			if (idx[idxType]<0)
-			{
-				switch (idxType)
-				{
-					case 0:
-						idx[idxType] += vbsize;
-						break;
-					case 1:
-						idx[idxType] += vtsize;
-						break;
-					case 2:
-						idx[idxType] += vnsize;
-						break;
-				}
-			}
-			else
-				idx[idxType]-=1;
+			vertex = slot.Vertex;
+			return true;
+		}
+	}
+}
 
-			// reset the word
-			word[0] = '\0';
-			i = 0;
 
-			// go to the next kind of index type
-			if (*p == '/')
-			{
-				if ( ++idxType > 2 )
-				{
-					// error checking, shouldn't reach here unless file is wrong
-					idxType = 0;
-				}
-			}
-			else
-			{
-				// set all missing values to disable (=-1)
-				while (++idxType < 3)
-					idx[idxType]=-1;
-				++p;
-				break; // while
-			}
-		}
+u32 COBJMeshFileLoader::CVertexIndexMap::hash(const s32* idx)
+{
+	u32 h = (u32)idx[0] * 73856093u ^ (u32)idx[1] * 19349663u ^ (u32)idx[2] * 83492791u;
+	// fold the high bits in, the mask only uses the low ones
+	return h ^ (h >> 16);
+}
 
-		// go to the next char
-		++p;
-	}
 
-	return true;
+//! Doubles the slot count and inserts the used slots again
+void COBJMeshFileLoader::CVertexIndexMap::grow()
+{
+	core::array<SSlot> old;
+	old.swap(Slots);
+
+	SSlot empty;
+	empty.Vertex = -1;
+	Slots.set_used(old.size() ? old.size()*2 : 256);
+	for (u32 i=0; i<Slots.size(); ++i)
+		Slots[i] = empty;
+
+	const u32 mask = Slots.size()-1;
+	for (u32 i=0; i<old.size(); ++i)
+	{
+		if (old[i].Vertex == -1)
+			continue;
+		u32 k = hash(old[i].Idx) & mask;
+		while (Slots[k].Vertex != -1)
+			k = (k+1) & mask;
+		Slots[k] = old[i];
+	}
 }
 
 
@@ -40,6 +40,75 @@ public:
 
 private:
 
+	//! Maps the (v, vt, vn) index triples of face corners to meshbuffer vertices
+	/** Open addressing with linear probing, keeps the load below 1/2. */
+	class CVertexIndexMap
+	{
+	public:
+		CVertexIndexMap();
+
+		//! Returns true and sets vertex if the triple is known, else adds it with the given vertex
+		bool findOrInsert(const s32* idx, s32& vertex);
+
+	private:
+		struct SSlot
+		{
+			s32 Idx[3];
+			s32 Vertex; // -1 for empty slots
+		};
+
+		static u32 hash(const s32* idx);
+
+		void grow();
+
+		core::array<SSlot> Slots;
+		u32 Used;
+	};
+
+	//! Indices of a face corner as written in the file, 0 for missing ones
+	struct SObjCorner
+	{
+		s32 Idx[3];
+	};
+
+	struct SObjFace
+	{
+		const c8* Line;
+		u32 FirstCorner;
+		// positions, texture coordinates and normals in the chunk before the face
+		u32 Counts[3];
+	};
+
+	//! Line changing the group, material or smoothing
+	struct SObjStateLine
+	{
+		const c8* Line;
+		u32 Face; // faces in the chunk before the line
+	};
+
+	typedef core::array<core::vector3df, core::irrAllocatorFast<core::vector3df> > TVec3Array;
+	typedef core::array<core::vector2df, core::irrAllocatorFast<core::vector2df> > TVec2Array;
+
+	//! Part of the file between two line starts, parsed on its own
+	struct SObjChunk
+	{
+		//! Called by parseChunks()
+		void parse()
+		{
+			Loader->parseChunk(*this);
+		}
+
+		COBJMeshFileLoader* Loader;
+		const c8* Begin;
+		const c8* End;
+		TVec3Array Positions;
+		TVec3Array Normals;
+		TVec2Array TexCoords;
+		core::array<SObjCorner> Corners;
+		core::array<SObjFace> Faces;
+		core::array<SObjStateLine> StateLines;
+	};
+
 	struct SObjMtl
 	{
 		SObjMtl(E_INDEX_TYPE_HINT typeHint) 
@@ -63,7 +132,7 @@ private:
 			Meshbuffer->Material = o.Meshbuffer->Material;
 		}
 
-		core::map<video::S3DVertex, int> VertMap;
+		CVertexIndexMap VertMap;
 		irr::video::E_INDEX_TYPE IndexType;
 		scene::CDynamicMeshBuffer *Meshbuffer;
 		core::stringc Name;
@@ -73,6 +142,9 @@ private:
 		bool RecalculateNormals;
 	};
 
+	//! Collects the records of a chunk, called on worker threads
+	void parseChunk(SObjChunk& chunk);
+
 	// helper method for material reading
 	const c8* readTextures(const c8* bufPtr, const c8* const bufEnd, SObjMtl* currMaterial, const io::path& relPath);
 
@@ -98,6 +170,8 @@ private:
 
 	//! Read RGB color
 	const c8* readColor(const c8* bufPtr, video::SColor& color, const c8* const pBufEnd);
+	//! Read the next float of the line in place, returns the pointer behind it
+	const c8* readFloat(const c8* bufPtr, f32& value, const c8* const pBufEnd);
 	//! Read 3d vector of floats
 	const c8* readVec3(const c8* bufPtr, core::vector3df& vec, const c8* const pBufEnd);
 	//! Read 2d vector of floats
@@ -105,10 +179,10 @@ private:
 	//! Read boolean value represented as 'on' or 'off'
 	const c8* readBool(const c8* bufPtr, bool& tf, const c8* const bufEnd);
 
-	// reads and convert to integer the vertex indices in a line of obj file's face statement
-	// -1 for the index if it doesn't exist
-	// indices are changed to 0-based index instead of 1-based from the obj file
-	bool retrieveVertexIndices(c8* vertexData, s32* idx, const c8* bufEnd, u32 vbsize, u32 vtsize, u32 vnsize);
+	// reads and convert to integer the vertex indices of the face corner at vertexData
+	// 0 for the index if it doesn't exist, the indices are not resolved yet
+	// returns the pointer behind the corner
+	const c8* retrieveVertexIndices(const c8* vertexData, s32* idx, const c8* bufEnd);
 
 	void cleanUp();
 
@@ -13,6 +13,7 @@
 #include "IMeshCache.h"
 #include "IAnimatedMesh.h"
 #include "IMaterialRenderer.h"
+#include "CMeshBufferQuantized.h"
 #include "os.h"
 #ifdef _IRR_COMPILE_WITH_SHADOW_VOLUME_SCENENODE_
 #include "CShadowVolumeSceneNode.h"
@@ -266,6 +267,8 @@ void COctreeSceneNode::render()
 			}
 		}
 		break;
+	default:
+		break;
 	}
 
 	// for debug purposes only
@@ -288,6 +291,8 @@ void COctreeSceneNode::render()
 				case video::EVT_TANGENTS:
 					TangentsOctree->getBoundingBoxes(box, boxes);
 					break;
+				default:
+					break;
 			}
 
 			for (u32 b=0; b!=boxes.size(); ++b)
@@ -407,7 +412,7 @@ bool COctreeSceneNode::createTree(IMesh* mesh)
 				++meshReserve;
 				if (b->getVertexType() == video::EVT_2TCOORDS)
 					VertexType = video::EVT_2TCOORDS;
-				else if (b->getVertexType() == video::EVT_TANGENTS)
+				else if (b->getVertexType() == video::EVT_TANGENTS || b->getVertexType() == video::EVT_QUANTIZED_TANGENTS)
 					VertexType = video::EVT_TANGENTS;
 			}
 		}
@@ -446,6 +451,14 @@ bool COctreeSceneNode::createTree(IMesh* mesh)
 							for (v=0; v<b->getVertexCount(); ++v)
 								nchunk.Vertices.push_back(((video::S3DVertexTangents*)b->getVertices())[v]);
 							break;
+						case video::EVT_QUANTIZED:
+						case video::EVT_QUANTIZED_TANGENTS:
+							for (v=0; v<b->getVertexCount(); ++v)
+							{
+								video::S3DVertexTangents tmpV = getDecodedVertex(b, v);
+								nchunk.Vertices.push_back(tmpV);
+							}
+							break;
 						}
 
 						polyCount += b->getIndexCount();
@@ -499,6 +512,14 @@ bool COctreeSceneNode::createTree(IMesh* mesh)
 							for (v=0; v<b->getVertexCount(); ++v)
 								nchunk.Vertices.push_back(((video::S3DVertexTangents*)b->getVertices())[v]);
 							break;
+						case video::EVT_QUANTIZED:
+						case video::EVT_QUANTIZED_TANGENTS:
+							for (v=0; v<b->getVertexCount(); ++v)
+							{
+								video::S3DVertexTangents tmpV = getDecodedVertex(b, v);
+								nchunk.Vertices.push_back(tmpV);
+							}
+							break;
 						}
 
 						polyCount += b->getIndexCount();
@@ -549,6 +570,14 @@ bool COctreeSceneNode::createTree(IMesh* mesh)
 							for (v=0; v<b->getVertexCount(); ++v)
 								nchunk.Vertices.push_back(((video::S3DVertexTangents*)b->getVertices())[v]);
 							break;
+						case video::EVT_QUANTIZED:
+						case video::EVT_QUANTIZED_TANGENTS:
+							for (v=0; v<b->getVertexCount(); ++v)
+							{
+								video::S3DVertexTangents tmpV = getDecodedVertex(b, v);
+								nchunk.Vertices.push_back(tmpV);
+							}
+							break;
 						}
 
 						polyCount += b->getIndexCount();
@@ -562,6 +591,8 @@ bool COctreeSceneNode::createTree(IMesh* mesh)
 				nodeCount = TangentsOctree->getNodeCount();
 			}
 			break;
+		default:
+			break;
 		}
 	}
 
@@ -12,137 +12,180 @@ namespace irr
 namespace scene
 {
 
+namespace
+{
+	//! Id of the octree in acceleration data
+	const u32 OCTREE_DATA_TYPE = MAKE_IRR_ID('o','c','t','r');
+}
+
 //! constructor
 COctreeTriangleSelector::COctreeTriangleSelector(const IMesh* mesh,
-		ISceneNode* node, s32 minimalPolysPerNode)
+		ISceneNode* node, s32 minimalPolysPerNode, io::IReadFile* accelerationData)
 	: CTriangleSelector(mesh, node, false)
-	, Root(0), NodeCount(0)
 	, MinimalPolysPerNode(minimalPolysPerNode)
 {
 	#ifdef _DEBUG
 	setDebugName("COctreeTriangleSelector");
 	#endif
 
-	if (!Triangles.empty())
-	{
-		const u32 start = os::Timer::getRealTime();
-
-		// create the triangle octree
-		Root = new SOctreeNode();
-		Root->Triangles = Triangles;
-		constructOctree(Root);
-
-		c8 tmp[256];
-		sprintf(tmp, "Needed %ums to create OctreeTriangleSelector.(%d nodes, %u polys)",
-			os::Timer::getRealTime() - start, NodeCount, Triangles.size());
-		os::Printer::log(tmp, ELL_INFORMATION);
-	}
+	createOctree(accelerationData);
 }
 
-COctreeTriangleSelector::COctreeTriangleSelector(const IMeshBuffer* meshBuffer, irr::u32 materialIndex, ISceneNode* node, s32 minimalPolysPerNode)
+COctreeTriangleSelector::COctreeTriangleSelector(const IMeshBuffer* meshBuffer, irr::u32 materialIndex,
+		ISceneNode* node, s32 minimalPolysPerNode, io::IReadFile* accelerationData)
 	: CTriangleSelector(meshBuffer, materialIndex, node)
-	, Root(0), NodeCount(0)
 	, MinimalPolysPerNode(minimalPolysPerNode)
 {
 	#ifdef _DEBUG
 	setDebugName("COctreeTriangleSelector");
 	#endif
 
-	if (!Triangles.empty())
-	{
-		const u32 start = os::Timer::getRealTime();
-
-		// create the triangle octree
-		Root = new SOctreeNode();
-		Root->Triangles = Triangles;
-		constructOctree(Root);
-
-		c8 tmp[256];
-		sprintf(tmp, "Needed %ums to create OctreeTriangleSelector.(%d nodes, %u polys)",
-			os::Timer::getRealTime() - start, NodeCount, Triangles.size());
-		os::Printer::log(tmp, ELL_INFORMATION);
-	}
+	createOctree(accelerationData);
 }
 
-//! destructor
-COctreeTriangleSelector::~COctreeTriangleSelector()
+
+void COctreeTriangleSelector::createOctree(io::IReadFile* accelerationData)
 {
-	delete Root;
+	if (Triangles.empty())
+		return;
+
+	if (accelerationData && readOctree(accelerationData))
+		return;
+
+	const u32 start = os::Timer::getRealTime();
+
+	// create the triangle octree
+	core::array<u32> triangleIndices(Triangles.size());
+	for (u32 i=0; i<Triangles.size(); ++i)
+		triangleIndices.push_back(i);
+
+	TriangleIndices.reallocate(Triangles.size());
+	Nodes.set_used(1);
+	constructOctree(0, triangleIndices);
+
+	c8 tmp[256];
+	sprintf(tmp, "Needed %ums to create OctreeTriangleSelector.(%u nodes, %u polys)",
+		os::Timer::getRealTime() - start, Nodes.size(), Triangles.size());
+	os::Printer::log(tmp, ELL_INFORMATION);
 }
 
 
-void COctreeTriangleSelector::constructOctree(SOctreeNode* node)
+void COctreeTriangleSelector::constructOctree(u32 nodeIndex, core::array<u32>& triangleIndices)
 {
-	++NodeCount;
-
-	node->Box.reset(node->Triangles[0].pointA);
+	core::aabbox3d<f32> nodeBox(Triangles[triangleIndices[0]].pointA);
 
 	// get bounding box
-	const u32 cnt = node->Triangles.size();
+	const u32 cnt = triangleIndices.size();
 	for (u32 i=0; i<cnt; ++i)
 	{
-		node->Box.addInternalPoint(node->Triangles[i].pointA);
-		node->Box.addInternalPoint(node->Triangles[i].pointB);
-		node->Box.addInternalPoint(node->Triangles[i].pointC);
+		const core::triangle3df& tri = Triangles[triangleIndices[i]];
+		nodeBox.addInternalPoint(tri.pointA);
+		nodeBox.addInternalPoint(tri.pointB);
+		nodeBox.addInternalPoint(tri.pointC);
 	}
 
 	// calculate children
 
-	if (!node->Box.isEmpty() && (s32)node->Triangles.size() > MinimalPolysPerNode)
+	core::array<u32> childIndices[8];
+
+	if (!nodeBox.isEmpty() && (s32)cnt > MinimalPolysPerNode)
 	{
-		const core::vector3df& middle = node->Box.getCenter();
+		const core::vector3df& middle = nodeBox.getCenter();
 		core::vector3df edges[8];
-		node->Box.getEdges(edges);
+		nodeBox.getEdges(edges);
 
 		core::aabbox3d<f32> box;
-		core::array<core::triangle3df> keepTriangles(node->Triangles.size()); // reserving enough memory, so we don't get re-allocations per child
+		core::array<u32> keepTriangles(cnt); // reserving enough memory, so we don't get re-allocations per child
 
 		for (s32 ch=0; ch<8; ++ch)
 		{
 			box.reset(middle);
 			box.addInternalPoint(edges[ch]);
-			node->Child[ch] = new SOctreeNode();
 
-			for (s32 i=0; i<(s32)node->Triangles.size(); ++i)
+			for (u32 i=0; i<triangleIndices.size(); ++i)
 			{
-				if (node->Triangles[i].isTotalInsideBox(box))
-				{
-					node->Child[ch]->Triangles.push_back(node->Triangles[i]);
-					//node->Triangles.erase(i);
-					//--i;
-				}
+				if (Triangles[triangleIndices[i]].isTotalInsideBox(box))
+					childIndices[ch].push_back(triangleIndices[i]);
 				else
-				{
-					keepTriangles.push_back(node->Triangles[i]);
-				}
+					keepTriangles.push_back(triangleIndices[i]);
 			}
-			memcpy(node->Triangles.pointer(), keepTriangles.pointer(),
-				sizeof(core::triangle3df)*keepTriangles.size());
 
-			node->Triangles.set_used(keepTriangles.size());
+			triangleIndices.swap(keepTriangles);
 			keepTriangles.set_used(0);
 		}
-		keepTriangles.clear();	// release memory early, for large meshes it can matter.
-		node->Triangles.reallocate(node->Triangles.size(), true); // shrink memory to minimum necessary
+	}
 
-		// Note: We use an extra loop to construct child-nodes instead of doing
-		// that in above loop to avoid memory fragmentation which happens if
-		// the code has to switch between allocating memory for this node and
-		// the child nodes (thanks @Squarefox for noting this).
-		for (s32 ch=0; ch<8; ++ch)
+	// the triangles staying in this node are stored before those of the children
+	SOctreeNode& node = Nodes[nodeIndex];
+	node.Box = nodeBox;
+	node.FirstTriangle = TriangleIndices.size();
+	node.TriangleCount = triangleIndices.size();
+	for (u32 i=0; i<triangleIndices.size(); ++i)
+		TriangleIndices.push_back(triangleIndices[i]);
+	triangleIndices.clear(); // release memory early, for large meshes it can matter.
+
+	for (u32 ch=0; ch<8; ++ch)
+	{
+		if (childIndices[ch].empty())
 		{
-			if (node->Child[ch]->Triangles.empty())
-			{
-				delete node->Child[ch];
-				node->Child[ch] = 0;
-			}
-			else
-				constructOctree(node->Child[ch]);
+			Nodes[nodeIndex].Child[ch] = 0;
+		}
+		else
+		{
+			const u32 childIndex = Nodes.size();
+			Nodes[nodeIndex].Child[ch] = childIndex;
+			Nodes.set_used(childIndex + 1);
+			constructOctree(childIndex, childIndices[ch]);
 		}
 	}
 }
 
 
+bool COctreeTriangleSelector::writeAccelerationData(io::IWriteFile* file) const
+{
+	if (Nodes.empty())
+		return false;
+
+	return writeTreeData(file, OCTREE_DATA_TYPE, (u32)MinimalPolysPerNode,
+		Nodes, TriangleIndices);
+}
+
+
+bool COctreeTriangleSelector::readOctree(io::IReadFile* file)
+{
+	const u32 start = os::Timer::getRealTime();
+
+	if (!readTreeData(file, OCTREE_DATA_TYPE, (u32)MinimalPolysPerNode, Nodes, TriangleIndices))
+		return false;
+
+	// check the references, so broken files can't make queries read outside the arrays
+	bool valid = !Nodes.empty();
+	const u32 nodeCount = Nodes.size();
+	const u32 indexCount = TriangleIndices.size();
+	for (u32 i=0; i<nodeCount && valid; ++i)
+	{
+		const SOctreeNode& node = Nodes[i];
+		valid = node.FirstTriangle <= indexCount && node.TriangleCount <= indexCount - node.FirstTriangle;
+		for (u32 ch=0; ch<8 && valid; ++ch)
+			valid = node.Child[ch] == 0 || (node.Child[ch] > i && node.Child[ch] < nodeCount);
+	}
+
+	if (!valid)
+	{
+		os::Printer::log("Invalid acceleration data for OctreeTriangleSelector", ELL_WARNING);
+		Nodes.clear();
+		TriangleIndices.clear();
+		return false;
+	}
+
+	c8 tmp[256];
+	sprintf(tmp, "Needed %ums to load OctreeTriangleSelector.(%u nodes, %u polys)",
+		os::Timer::getRealTime() - start, Nodes.size(), Triangles.size());
+	os::Printer::log(tmp, ELL_INFORMATION);
+	return true;
+}
+
+
 //! Gets all triangles which lie within a specific bounding box.
 void COctreeTriangleSelector::getTriangles(core::triangle3df* triangles,
 					s32 arraySize, s32& outTriangleCount,
@@ -172,8 +215,8 @@ void COctreeTriangleSelector::getTriangles(core::triangle3df* triangles,
 
 	s32 trianglesWritten = 0;
 
-	if (Root)
-		getTrianglesFromOctree(Root, trianglesWritten,
+	if (!Nodes.empty())
+		getTrianglesFromOctree(0, trianglesWritten,
 			arraySize, invbox, &mat, triangles);
 
 	if ( outTriangleInfo )
@@ -192,18 +235,20 @@ void COctreeTriangleSelector::getTriangles(core::triangle3df* triangles,
 
 
 void COctreeTriangleSelector::getTrianglesFromOctree(
-		SOctreeNode* node, s32& trianglesWritten,
+		u32 nodeIndex, s32& trianglesWritten,
 		s32 maximumSize, const core::aabbox3d<f32>& box,
 		const core::matrix4* mat, core::triangle3df* triangles) const
 {
-	if (!box.intersectsWithBox(node->Box))
+	const SOctreeNode& node = Nodes[nodeIndex];
+	if (trianglesWritten == maximumSize || !box.intersectsWithBox(node.Box))
 		return;
 
-	const u32 cnt = node->Triangles.size();
+	const u32* indices = TriangleIndices.const_pointer() + node.FirstTriangle;
+	const u32 cnt = node.TriangleCount;
 
 	for (u32 i=0; i<cnt; ++i)
 	{
-		const core::triangle3df& srcTri = node->Triangles[i];
+		const core::triangle3df& srcTri = Triangles[indices[i]];
 		// This isn't an accurate test, but it's fast, and the
 		// API contract doesn't guarantee complete accuracy.
 		if (srcTri.isTotalOutsideBox(box))
@@ -221,8 +266,8 @@ void COctreeTriangleSelector::getTrianglesFromOctree(
 	}
 
 	for (u32 i=0; i<8; ++i)
-		if (node->Child[i])
-			getTrianglesFromOctree(node->Child[i], trianglesWritten,
+		if (node.Child[i])
+			getTrianglesFromOctree(node.Child[i], trianglesWritten,
 			maximumSize, box, mat, triangles);
 }
 
@@ -265,8 +310,8 @@ void COctreeTriangleSelector::getTriangles(core::triangle3df* triangles, s32 arr
 
 	s32 trianglesWritten = 0;
 
-	if (Root)
-		getTrianglesFromOctree(Root, trianglesWritten, arraySize, invline, &mat, triangles);
+	if (!Nodes.empty())
+		getTrianglesFromOctree(0, trianglesWritten, arraySize, invline, &mat, triangles);
 
 	if ( outTriangleInfo )
 	{
@@ -283,14 +328,16 @@ void COctreeTriangleSelector::getTriangles(core::triangle3df* triangles, s32 arr
 #endif
 }
 
-void COctreeTriangleSelector::getTrianglesFromOctree(SOctreeNode* node,
+void COctreeTriangleSelector::getTrianglesFromOctree(u32 nodeIndex,
 		s32& trianglesWritten, s32 maximumSize, const core::line3d<f32>& line,
 		const core::matrix4* transform, core::triangle3df* triangles) const
 {
-	if (!node->Box.intersectsWithLine(line))
+	const SOctreeNode& node = Nodes[nodeIndex];
+	if (!node.Box.intersectsWithLine(line))
 		return;
 
-	s32 cnt = node->Triangles.size();
+	const u32* indices = TriangleIndices.const_pointer() + node.FirstTriangle;
+	s32 cnt = node.TriangleCount;
 	if (cnt + trianglesWritten > maximumSize)
 		cnt -= cnt + trianglesWritten - maximumSize;
 
@@ -300,7 +347,7 @@ void COctreeTriangleSelector::getTrianglesFromOctree(SOctreeNode* node,
 	{
 		for (i=0; i<cnt; ++i)
 		{
-			triangles[trianglesWritten] = node->Triangles[i];
+			triangles[trianglesWritten] = Triangles[indices[i]];
 			++trianglesWritten;
 		}
 	}
@@ -308,7 +355,7 @@ void COctreeTriangleSelector::getTrianglesFromOctree(SOctreeNode* node,
 	{
 		for (i=0; i<cnt; ++i)
 		{
-			triangles[trianglesWritten] = node->Triangles[i];
+			triangles[trianglesWritten] = Triangles[indices[i]];
 			transform->transformVect(triangles[trianglesWritten].pointA);
 			transform->transformVect(triangles[trianglesWritten].pointB);
 			transform->transformVect(triangles[trianglesWritten].pointC);
@@ -317,11 +364,68 @@ void COctreeTriangleSelector::getTrianglesFromOctree(SOctreeNode* node,
 	}
 
 	for (i=0; i<8; ++i)
-		if (node->Child[i])
-			getTrianglesFromOctree(node->Child[i], trianglesWritten,
+		if (node.Child[i])
+			getTrianglesFromOctree(node.Child[i], trianglesWritten,
 			maximumSize, line, transform, triangles);
 }
 
 
+
+//! Gets the nearest intersection of a 3d line with the triangles of this selector.
+bool COctreeTriangleSelector::getCollisionPoint(SCollisionHit& hitResult,
+		const core::line3d<f32>& line, bool useNodeTransform) const
+{
+	if (Nodes.empty())
+		return false;
+
+	core::matrix4 mat;
+	core::line3d<f32> invline(line);
+	if (SceneNode && useNodeTransform)
+	{
+		mat = SceneNode->getAbsoluteTransformation();
+
+		core::matrix4 inverse(core::matrix4::EM4CONST_NOTHING);
+		if (!mat.getInverse(inverse))
+			return CTriangleSelector::getCollisionPoint(hitResult, line, useNodeTransform);
+		inverse.transformVect(invline.start);
+		inverse.transformVect(invline.end);
+	}
+
+	SNearestLineHit hit(line);
+	getCollisionPointFromOctree(0, invline, mat, hit);
+	if (!hit.Found)
+		return false;
+
+	hitResult.Intersection = hit.Intersection;
+	hitResult.Triangle = hit.Triangle;
+	setCollisionHitInfo(hitResult, hit.Index);
+	return true;
+}
+
+
+void COctreeTriangleSelector::getCollisionPointFromOctree(u32 nodeIndex,
+		const core::line3d<f32>& line, const core::matrix4& transform,
+		SNearestLineHit& hit) const
+{
+	const SOctreeNode& node = Nodes[nodeIndex];
+	if (!node.Box.intersectsWithLine(line))
+		return;
+
+	const u32* indices = TriangleIndices.const_pointer() + node.FirstTriangle;
+	for (u32 i=0; i<node.TriangleCount; ++i)
+	{
+		const core::triangle3df& source = Triangles[indices[i]];
+		core::triangle3df triangle;
+		transform.transformVect(triangle.pointA, source.pointA);
+		transform.transformVect(triangle.pointB, source.pointB);
+		transform.transformVect(triangle.pointC, source.pointC);
+		hit.test(triangle, indices[i]);
+	}
+
+	for (u32 i=0; i<8; ++i)
+		if (node.Child[i])
+			getCollisionPointFromOctree(node.Child[i], line, transform, hit);
+}
+
 } // end namespace scene
 } // end namespace irr
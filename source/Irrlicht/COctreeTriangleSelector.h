@@ -14,18 +14,23 @@ namespace scene
 
 class ISceneNode;
 
-//! Stupid triangle selector without optimization
+//! Triangle selector sorting the triangles into an octree
+/** The nodes are stored in one array in depth first order. Each node
+references its triangles by a range of indices into the triangles of the
+selector, so the tree can be written and read as two plain arrays. */
 class COctreeTriangleSelector : public CTriangleSelector
 {
 public:
 
 	//! Constructs a selector based on a mesh
-	COctreeTriangleSelector(const IMesh* mesh, ISceneNode* node, s32 minimalPolysPerNode);
+	/** \param accelerationData When it contains a tree written for the
+	same triangles, that tree is used instead of building a new one. */
+	COctreeTriangleSelector(const IMesh* mesh, ISceneNode* node, s32 minimalPolysPerNode,
+		io::IReadFile* accelerationData=0);
 
 	//! Constructs a selector based on a meshbuffer
-	COctreeTriangleSelector(const IMeshBuffer* meshBuffer, irr::u32 materialIndex, ISceneNode* node, s32 minimalPolysPerNode);
-
-	virtual ~COctreeTriangleSelector();
+	COctreeTriangleSelector(const IMeshBuffer* meshBuffer, irr::u32 materialIndex, ISceneNode* node, s32 minimalPolysPerNode,
+		io::IReadFile* accelerationData=0);
 
 	//! Gets all triangles which lie within a specific bounding box.
 	virtual void getTriangles(core::triangle3df* triangles, s32 arraySize, s32& outTriangleCount,
@@ -38,42 +43,49 @@ public:
 		const core::matrix4* transform, bool useNodeTransform, 
 		irr::core::array<SCollisionTriangleRange>* outTriangleInfo) const IRR_OVERRIDE;
 
+	//! Gets the nearest intersection of a 3d line with the triangles of this selector.
+	virtual bool getCollisionPoint(SCollisionHit& hitResult, const core::line3d<f32>& line,
+		bool useNodeTransform) const IRR_OVERRIDE;
+
+	//! Writes the octree
+	virtual bool writeAccelerationData(io::IWriteFile* file) const IRR_OVERRIDE;
+
 private:
 
+	//! Node of the octree
+	/** Children are stored behind their parent, a Child entry of 0 means
+	there is no child as the root is never one. */
 	struct SOctreeNode
 	{
-		SOctreeNode()
-		{
-			for (u32 i=0; i!=8; ++i)
-				Child[i] = 0;
-		}
-
-		~SOctreeNode()
-		{
-			for (u32 i=0; i!=8; ++i)
-				delete Child[i];
-		}
-
-		core::array<core::triangle3df> Triangles;
-		SOctreeNode* Child[8];
 		core::aabbox3d<f32> Box;
+		u32 FirstTriangle;
+		u32 TriangleCount;
+		u32 Child[8];
 	};
 
+	//! Builds the octree, or takes it from accelerationData if that fits
+	void createOctree(io::IReadFile* accelerationData);
 
-	void constructOctree(SOctreeNode* node);
-	void deleteEmptyNodes(SOctreeNode* node);
-	void getTrianglesFromOctree(SOctreeNode* node, s32& trianglesWritten,
+	//! Reads a tree written by writeAccelerationData()
+	bool readOctree(io::IReadFile* file);
+
+	void constructOctree(u32 nodeIndex, core::array<u32>& triangleIndices);
+
+	void getTrianglesFromOctree(u32 nodeIndex, s32& trianglesWritten,
 			s32 maximumSize, const core::aabbox3d<f32>& box,
 			const core::matrix4* transform,
 			core::triangle3df* triangles) const;
 
-	void getTrianglesFromOctree(SOctreeNode* node, s32& trianglesWritten,
+	void getTrianglesFromOctree(u32 nodeIndex, s32& trianglesWritten,
 			s32 maximumSize, const core::line3d<f32>& line,
 			const core::matrix4* transform,
 			core::triangle3df* triangles) const;
 
-	SOctreeNode* Root;
-	s32 NodeCount;
+	void getCollisionPointFromOctree(u32 nodeIndex, const core::line3d<f32>& line,
+			const core::matrix4& transform, SNearestLineHit& hit) const;
+
+	core::array<SOctreeNode> Nodes;
+	core::array<u32> TriangleIndices;
 	s32 MinimalPolysPerNode;
 };
 
@@ -380,9 +380,9 @@ bool COpenGLDriver::updateVertexHardwareBuffer(SHWBufferLink_opengl *HWBuffer)
 
 #if defined(GL_ARB_vertex_buffer_object)
 	const scene::IMeshBuffer* mb = HWBuffer->MeshBuffer;
-	const void* vertices=mb->getVertices();
+	const void* vertices=isQuantized(mb->getVertexType()) ? decodeQuantizedVertices(mb) : mb->getVertices();
 	const u32 vertexCount=mb->getVertexCount();
-	const E_VERTEX_TYPE vType=mb->getVertexType();
+	const E_VERTEX_TYPE vType=getDecodedVertexType(mb->getVertexType());
 	const u32 vertexSize = getVertexPitchFromType(vType);
 
 	const c8* vbuf = static_cast<const c8*>(vertices);
@@ -663,6 +663,8 @@ void COpenGLDriver::drawHardwareBuffer(SHWBufferLink *_HWBuffer)
 		extGlBindBuffer(GL_ARRAY_BUFFER, HWBuffer->vbo_verticesID);
 		vertices=0;
 	}
+	else if (isQuantized(mb->getVertexType()))
+		vertices=decodeQuantizedVertices(mb);
 
 	if (HWBuffer->Mapped_Index!=scene::EHM_NEVER)
 	{
@@ -670,7 +672,7 @@ void COpenGLDriver::drawHardwareBuffer(SHWBufferLink *_HWBuffer)
 		indexList=0;
 	}
 
-	drawVertexPrimitiveList(vertices, mb->getVertexCount(), indexList, mb->getPrimitiveCount(), mb->getVertexType(), mb->getPrimitiveType(), mb->getIndexType());
+	drawVertexPrimitiveList(vertices, mb->getVertexCount(), indexList, mb->getPrimitiveCount(), getDecodedVertexType(mb->getVertexType()), mb->getPrimitiveType(), mb->getIndexType());
 
 	if (HWBuffer->Mapped_Vertex!=scene::EHM_NEVER)
 		extGlBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -859,6 +861,8 @@ void COpenGLDriver::drawVertexPrimitiveList(const void* vertices, u32 vertexCoun
 				case EVT_TANGENTS:
 					glColorPointer(colorSize, GL_UNSIGNED_BYTE, sizeof(S3DVertexTangents), &(static_cast<const S3DVertexTangents*>(vertices))[0].Color);
 					break;
+				default:
+					break;
 			}
 		}
 		else
@@ -954,6 +958,8 @@ void COpenGLDriver::drawVertexPrimitiveList(const void* vertices, u32 vertexCoun
 					glTexCoordPointer(3, GL_FLOAT, sizeof(S3DVertexTangents), buffer_offset(48));
 			}
 			break;
+		default:
+			break;
 	}
 
 	renderArray(indexList, primitiveCount, pType, iType);
@@ -1014,6 +1020,8 @@ void COpenGLDriver::getColorBuffer(const void* vertices, u32 vertexCount, E_VERT
 			}
 		}
 		break;
+		default:
+			break;
 	}
 }
 
@@ -1186,6 +1194,8 @@ void COpenGLDriver::draw2DVertexPrimitiveList(const void* vertices, u32 vertexCo
 				case EVT_TANGENTS:
 					glColorPointer(colorSize, GL_UNSIGNED_BYTE, sizeof(S3DVertexTangents), &(static_cast<const S3DVertexTangents*>(vertices))[0].Color);
 					break;
+				default:
+					break;
 			}
 		}
 		else
@@ -1257,6 +1267,8 @@ void COpenGLDriver::draw2DVertexPrimitiveList(const void* vertices, u32 vertexCo
 				glVertexPointer(2, GL_FLOAT, sizeof(S3DVertexTangents), buffer_offset(0));
 			}
 
+			break;
+		default:
 			break;
 	}
 
@@ -11,6 +11,8 @@
 #include "CDynamicMeshBuffer.h"
 #include "SAnimatedMesh.h"
 #include "IReadFile.h"
+#include "CMemoryFile.h"
+#include "CTextChunks.h"
 #include "fast_atof.h"
 #include "os.h"
 
@@ -22,6 +24,244 @@ namespace scene
 // input buffer must be at least twice as long as the longest line in the file
 #define PLY_INPUT_BUFFER_SIZE 51200 // file is loaded in 50k chunks
 
+namespace
+{
+
+// Returns the start of the line after the next count lines.
+// Splits lines like CPLYMeshFileLoader::getNextLine().
+const c8* skipLines(const c8* p, const c8* const end, u32 count)
+{
+	for (u32 i=0; i<count && p<end; ++i)
+	{
+		// crlf of the previous line
+		if (*p == '\n')
+			++p;
+		while (p < end && *p && *p != '\r' && *p != '\n')
+			++p;
+		if (p+1 < end && (p[1] == '\r' || p[1] == '\n'))
+			++p;
+		if (p < end)
+			++p;
+	}
+	return p;
+}
+
+// Vertex members which properties of the vertex element are read into
+enum E_PLY_VERTEX_TARGET
+{
+	EPLYVT_POS_X = 0,
+	EPLYVT_POS_Y,
+	EPLYVT_POS_Z,
+	EPLYVT_NORMAL_X,
+	EPLYVT_NORMAL_Y,
+	EPLYVT_NORMAL_Z,
+	EPLYVT_TCOORD_U,
+	EPLYVT_TCOORD_V,
+	EPLYVT_RED,
+	EPLYVT_GREEN,
+	EPLYVT_BLUE,
+	EPLYVT_ALPHA,
+	EPLYVT_NONE
+};
+
+// Returns the vertex member of a property, y and z are swapped.
+E_PLY_VERTEX_TARGET getVertexTarget(const core::stringc& name)
+{
+	if (name == "x")
+		return EPLYVT_POS_X;
+	else if (name == "y")
+		return EPLYVT_POS_Z;
+	else if (name == "z")
+		return EPLYVT_POS_Y;
+	else if (name == "nx")
+		return EPLYVT_NORMAL_X;
+	else if (name == "ny")
+		return EPLYVT_NORMAL_Z;
+	else if (name == "nz")
+		return EPLYVT_NORMAL_Y;
+	 // There isn't a single convention for the UV, some software like Blender or Assimp uses "st" instead of "uv"
+	 // Not sure which tool creates texture_u/texture_v, but those exist as well.
+	else if (name == "u" || name == "s" || name == "texture_u")
+		return EPLYVT_TCOORD_U;
+	else if (name == "v" || name == "t" || name == "texture_v")
+		return EPLYVT_TCOORD_V;
+	else if (name == "red")
+		return EPLYVT_RED;
+	else if (name == "green")
+		return EPLYVT_GREEN;
+	else if (name == "blue")
+		return EPLYVT_BLUE;
+	else if (name == "alpha")
+		return EPLYVT_ALPHA;
+	return EPLYVT_NONE;
+}
+
+inline bool isNormalTarget(E_PLY_VERTEX_TARGET target)
+{
+	return target >= EPLYVT_NORMAL_X && target <= EPLYVT_NORMAL_Z;
+}
+
+// Sets a color channel from an integer property
+inline void setVertexColor(video::S3DVertex& vert, E_PLY_VERTEX_TARGET target, u32 value)
+{
+	switch (target)
+	{
+	case EPLYVT_RED:
+		vert.Color.setRed(value);
+		break;
+	case EPLYVT_GREEN:
+		vert.Color.setGreen(value);
+		break;
+	case EPLYVT_BLUE:
+		vert.Color.setBlue(value);
+		break;
+	case EPLYVT_ALPHA:
+		vert.Color.setAlpha(value);
+		break;
+	default:
+		break;
+	}
+}
+
+// Sets a vertex member from a float property, colors go from 0 to 1
+inline void setVertexValue(video::S3DVertex& vert, E_PLY_VERTEX_TARGET target, f32 value)
+{
+	switch (target)
+	{
+	case EPLYVT_POS_X:
+		vert.Pos.X = value;
+		break;
+	case EPLYVT_POS_Y:
+		vert.Pos.Y = value;
+		break;
+	case EPLYVT_POS_Z:
+		vert.Pos.Z = value;
+		break;
+	case EPLYVT_NORMAL_X:
+		vert.Normal.X = value;
+		break;
+	case EPLYVT_NORMAL_Y:
+		vert.Normal.Y = value;
+		break;
+	case EPLYVT_NORMAL_Z:
+		vert.Normal.Z = value;
+		break;
+	case EPLYVT_TCOORD_U:
+		vert.TCoords.X = value;
+		break;
+	case EPLYVT_TCOORD_V:
+		vert.TCoords.Y = value;
+		break;
+	default:
+		setVertexColor(vert, target, (u32)(value*255.0f));
+		break;
+	}
+}
+
+// Bytes a binary value takes, lists and unknown types skip one byte
+inline u32 getBinarySize(E_PLY_PROPERTY_TYPE t)
+{
+	switch (t)
+	{
+	case EPLYPT_INT8:
+		return 1;
+	case EPLYPT_INT16:
+		return 2;
+	case EPLYPT_INT32:
+	case EPLYPT_FLOAT32:
+		return 4;
+	case EPLYPT_FLOAT64:
+		return 8;
+	default:
+		return 1;
+	}
+}
+
+// Reads a binary value as float, int types are signed
+inline f32 readBinaryFloat(const c8* p, E_PLY_PROPERTY_TYPE t, bool swap)
+{
+	switch (t)
+	{
+	case EPLYPT_INT8:
+		return *p;
+	case EPLYPT_INT16:
+	{
+		s16 v;
+		memcpy(&v, p, 2);
+		return swap ? os::Byteswap::byteswap(v) : v;
+	}
+	case EPLYPT_INT32:
+	{
+		s32 v;
+		memcpy(&v, p, 4);
+		return f32(swap ? os::Byteswap::byteswap(v) : v);
+	}
+	case EPLYPT_FLOAT32:
+	{
+		f32 v;
+		memcpy(&v, p, 4);
+		return swap ? os::Byteswap::byteswap(v) : v;
+	}
+	case EPLYPT_FLOAT64:
+	{
+		// todo: byteswap 64-bit
+		f64 v;
+		memcpy(&v, p, 8);
+		return f32(v);
+	}
+	default:
+		return 0.0f;
+	}
+}
+
+// Reads a binary value as int, int16 is unsigned
+inline u32 readBinaryInt(const c8* p, E_PLY_PROPERTY_TYPE t, bool swap)
+{
+	switch (t)
+	{
+	case EPLYPT_INT8:
+		return *p;
+	case EPLYPT_INT16:
+	{
+		u16 v;
+		memcpy(&v, p, 2);
+		return swap ? os::Byteswap::byteswap(v) : v;
+	}
+	case EPLYPT_INT32:
+	{
+		s32 v;
+		memcpy(&v, p, 4);
+		return swap ? os::Byteswap::byteswap(v) : v;
+	}
+	case EPLYPT_FLOAT32:
+	{
+		f32 v;
+		memcpy(&v, p, 4);
+		return (u32)(swap ? os::Byteswap::byteswap(v) : v);
+	}
+	case EPLYPT_FLOAT64:
+	{
+		// todo: byteswap 64-bit
+		f64 v;
+		memcpy(&v, p, 8);
+		return (u32)v;
+	}
+	default:
+		return 0;
+	}
+}
+
+// A vertex property of a fixed width binary element
+struct SPLYVertexField
+{
+	u32 Offset;
+	E_PLY_PROPERTY_TYPE Type;
+	E_PLY_VERTEX_TARGET Target;
+	bool IsFloat;
+};
+
+} // end anonymous namespace
+
 // constructor
 CPLYMeshFileLoader::CPLYMeshFileLoader(scene::ISceneManager* smgr)
 : SceneManager(smgr), File(0), Buffer(0)
@@ -55,10 +295,27 @@ bool CPLYMeshFileLoader::isALoadableFileExtension(const io::path& filename) cons
 
 //! creates/loads an animated mesh from the file.
 IAnimatedMesh* CPLYMeshFileLoader::createMesh(io::IReadFile* file)
+{
+	return createMeshWithParameters(file, SceneManager->getParameters());
+}
+
+
+//! creates/loads an animated mesh from the file with the given scene parameters.
+IAnimatedMesh* CPLYMeshFileLoader::createMeshWithParameters(io::IReadFile* file, const io::IAttributes* parameters)
 {
 	if (!file)
 		return 0;
 
+	// getMesh() and worker threads of IAsyncLoader may call this at the same
+	// time, so the parse state is kept in a loader of this call only
+	CPLYMeshFileLoader parser(SceneManager);
+	return parser.parseMesh(file, parameters);
+}
+
+
+//! Loads the mesh, uses the members for the parse state
+IAnimatedMesh* CPLYMeshFileLoader::parseMesh(io::IReadFile* file, const io::IAttributes* parameters)
+{
 	File = file;
 	File->grab();
 
@@ -236,27 +493,56 @@ IAnimatedMesh* CPLYMeshFileLoader::createMesh(io::IReadFile* file)
 			mb->setHardwareMappingHint(EHM_STATIC);
 
 			bool hasNormals=true;
-			// loop through each of the elements
-			for (u32 i=0; i<ElementList.size(); ++i)
+			// big ascii files are split into chunks
+			const u32 chunkCount = IsBinaryFile ? 1 : getTextChunkCount(File->getSize() - File->getPos(),
+				parameters->getAttributeAsInt(MESH_LOADER_PARSE_THREADS));
+			if (chunkCount > 1)
 			{
-				// do we want this element type?
-				if (ElementList[i]->Name == "vertex")
-				{
-					// loop through vertex properties
-					for (u32 j=0; j < ElementList[i]->Count; ++j)
-						hasNormals &= readVertex(*ElementList[i], mb);
-				}
-				else if (ElementList[i]->Name == "face")
-				{
-					// read faces
-					for (u32 j=0; j < ElementList[i]->Count; ++j)
-						readFace(*ElementList[i], mb);
-				}
-				else
+				hasNormals = readChunks(chunkCount, mb);
+			}
+			else
+			{
+				// loop through each of the elements
+				for (u32 i=0; i<ElementList.size(); ++i)
 				{
-					// skip these elements
-					for (u32 j=0; j < ElementList[i]->Count; ++j)
-						skipElement(*ElementList[i]);
+					// do we want this element type?
+					const SPLYElement& element = *ElementList[i];
+					if (element.Name == "vertex")
+					{
+						if (IsBinaryFile && element.IsFixedWidth)
+							hasNormals &= readBinaryVertices(element, mb);
+						else
+						{
+							// loop through vertex properties
+							for (u32 j=0; j < element.Count; ++j)
+								hasNormals &= readVertex(element, mb);
+						}
+					}
+					else if (element.Name == "face")
+					{
+						// common layout with nothing but the index list
+						if (IsBinaryFile && element.Properties.size() == 1 &&
+							element.Properties[0].Type == EPLYPT_LIST &&
+							(element.Properties[0].Name == "vertex_indices" || element.Properties[0].Name == "vertex_index"))
+						{
+							if (mb->getIndexBuffer().getType() == video::EIT_32BIT)
+								readBinaryFaces<u32>(element, mb);
+							else
+								readBinaryFaces<u16>(element, mb);
+						}
+						else
+						{
+							// read faces
+							for (u32 j=0; j < element.Count; ++j)
+								readFace(element, mb);
+						}
+					}
+					else
+					{
+						// skip these elements
+						for (u32 j=0; j < ElementList[i]->Count; ++j)
+							skipElement(*ElementList[i]);
+					}
 				}
 			}
 			mb->recalculateBoundingBox();
@@ -285,6 +571,99 @@ IAnimatedMesh* CPLYMeshFileLoader::createMesh(io::IReadFile* file)
 }
 
 
+//! Reads the ascii vertices and faces in chunks at the same time
+bool CPLYMeshFileLoader::readChunks(u32 chunkCount, scene::CDynamicMeshBuffer* mb)
+{
+	// the data starts behind the last line of the header
+	const long dataStart = File->getPos() - (long)(EndPointer - (LineEndPointer + 1));
+	const long size = File->getSize() - dataStart;
+	c8* text = new c8[size];
+	File->seek(dataStart);
+	const c8* const textEnd = text + File->read(text, size);
+
+	// split each element at line starts
+	core::array<SPLYChunk> chunks;
+	const c8* p = text;
+	for (u32 i=0; i<ElementList.size(); ++i)
+	{
+		const SPLYElement& element = *ElementList[i];
+		if (element.Name != "vertex" && element.Name != "face")
+		{
+			p = skipLines(p, textEnd, element.Count);
+			continue;
+		}
+
+		for (u32 c=0; c<chunkCount; ++c)
+		{
+			SPLYChunk chunk;
+			chunk.Element = &element;
+			chunk.Count = (u32)((u64)element.Count * (c+1) / chunkCount - (u64)element.Count * c / chunkCount);
+			chunk.Begin = p;
+			p = skipLines(p, textEnd, chunk.Count);
+			chunk.End = p;
+			chunk.Buffer = new CDynamicMeshBuffer(video::EVT_STANDARD, mb->getIndexType());
+			chunk.HasNormals = true;
+			chunks.push_back(chunk);
+		}
+	}
+
+	parseChunks(chunks);
+
+	// append the chunks in file order
+	bool hasNormals = true;
+	for (u32 i=0; i<chunks.size(); ++i)
+	{
+		IVertexBuffer& vertices = chunks[i].Buffer->getVertexBuffer();
+		if (vertices.size())
+		{
+			IVertexBuffer& to = mb->getVertexBuffer();
+			const u32 used = to.size();
+			to.set_used(used + vertices.size());
+			memcpy((c8*)to.getData() + used * to.stride(), vertices.getData(), vertices.size() * vertices.stride());
+		}
+		IIndexBuffer& indices = chunks[i].Buffer->getIndexBuffer();
+		if (indices.size())
+		{
+			IIndexBuffer& to = mb->getIndexBuffer();
+			const u32 used = to.size();
+			to.set_used(used + indices.size());
+			memcpy((c8*)to.getData() + used * to.stride(), indices.getData(), indices.size() * indices.stride());
+		}
+		if (chunks[i].Element->Name == "vertex")
+			hasNormals &= chunks[i].HasNormals;
+		chunks[i].Buffer->drop();
+	}
+
+	delete [] text;
+	return hasNormals;
+}
+
+
+//! Called by parseChunks()
+void CPLYMeshFileLoader::SPLYChunk::parse()
+{
+	// the loader reads the lines exactly like those of the whole file
+	CPLYMeshFileLoader* reader = new CPLYMeshFileLoader(0);
+	reader->File = new io::CMemoryReadFile(Begin, (long)(End - Begin), "", false);
+	reader->IsBinaryFile = false;
+	reader->IsWrongEndian = false;
+	reader->allocateBuffer();
+
+	const bool isVertex = Element->Name == "vertex";
+	for (u32 j=0; j < Count; ++j)
+	{
+		if (isVertex)
+			HasNormals &= reader->readVertex(*Element, Buffer);
+		else
+			reader->readFace(*Element, Buffer);
+	}
+
+	reader->File->drop();
+	reader->File = 0;
+	reader->drop();
+}
+
+
 bool CPLYMeshFileLoader::readVertex(const SPLYElement &Element, scene::CDynamicMeshBuffer* mb)
 {
 	if (!IsBinaryFile)
@@ -301,58 +680,18 @@ bool CPLYMeshFileLoader::readVertex(const SPLYElement &Element, scene::CDynamicM
 	bool result=false;
 	for (u32 i=0; i < Element.Properties.size(); ++i)
 	{
-		E_PLY_PROPERTY_TYPE t = Element.Properties[i].Type;
-		const core::stringc& name = Element.Properties[i].Name;
+		const SPLYProperty& property = Element.Properties[i];
+		const E_PLY_VERTEX_TARGET target = getVertexTarget(property.Name);
 
-		if (name == "x")
-			vert.Pos.X = getFloat(t);
-		else if (name == "y")
-			vert.Pos.Z = getFloat(t);
-		else if (name == "z")
-			vert.Pos.Y = getFloat(t);
-		else if (name == "nx")
-		{
-			vert.Normal.X = getFloat(t);
-			result=true;
-		}
-		else if (name == "ny")
-		{
-			vert.Normal.Z = getFloat(t);
-			result=true;
-		}
-		else if (name == "nz")
-		{
-			vert.Normal.Y = getFloat(t);
-			result=true;
-		}
-		 // There isn't a single convention for the UV, some software like Blender or Assimp uses "st" instead of "uv"
-		 // Not sure which tool creates texture_u/texture_v, but those exist as well.
-		else if (name == "u" || name == "s" || name == "texture_u")
-			vert.TCoords.X = getFloat(t);
-		else if (name == "v" || name == "t" || name == "texture_v")
-			vert.TCoords.Y = getFloat(t);
-		else if (name == "red")
-		{
-			u32 value = Element.Properties[i].isFloat() ? (u32)(getFloat(t)*255.0f) : getInt(t);
-			vert.Color.setRed(value);
-		}
-		else if (name == "green")
-		{
-			u32 value = Element.Properties[i].isFloat() ? (u32)(getFloat(t)*255.0f) : getInt(t);
-			vert.Color.setGreen(value);
-		}
-		else if (name == "blue")
-		{
-			u32 value = Element.Properties[i].isFloat() ? (u32)(getFloat(t)*255.0f) : getInt(t);
-			vert.Color.setBlue(value);
-		}
-		else if (name == "alpha")
-		{
-			u32 value = Element.Properties[i].isFloat() ? (u32)(getFloat(t)*255.0f) : getInt(t);
-			vert.Color.setAlpha(value);
-		}
+		if (target == EPLYVT_NONE)
+			skipProperty(property);
+		else if (target >= EPLYVT_RED && !property.isFloat())
+			setVertexColor(vert, target, getInt(property.Type));
 		else
-			skipProperty(Element.Properties[i]);
+			setVertexValue(vert, target, getFloat(property.Type));
+
+		if (isNormalTarget(target))
+			result=true;
 	}
 
 	mb->getVertexBuffer().push_back(vert);
@@ -361,6 +700,70 @@ bool CPLYMeshFileLoader::readVertex(const SPLYElement &Element, scene::CDynamicM
 }
 
 
+//! Reads all vertices of a fixed width binary element in blocks
+bool CPLYMeshFileLoader::readBinaryVertices(const SPLYElement &Element, scene::CDynamicMeshBuffer* mb)
+{
+	// look up the vertex members only once
+	core::array<SPLYVertexField> fields;
+	bool result = false;
+	u32 offset = 0;
+	for (u32 i=0; i < Element.Properties.size(); ++i)
+	{
+		const SPLYProperty& property = Element.Properties[i];
+		SPLYVertexField field;
+		field.Offset = offset;
+		field.Type = property.Type;
+		field.Target = getVertexTarget(property.Name);
+		field.IsFloat = property.isFloat();
+		if (field.Target != EPLYVT_NONE)
+			fields.push_back(field);
+		if (isNormalTarget(field.Target))
+			result = true;
+		offset += property.size();
+	}
+
+	video::S3DVertex vert;
+	vert.Color.set(255,255,255,255);
+	vert.TCoords.X = 0.0f;
+	vert.TCoords.Y = 0.0f;
+	vert.Normal.X = 0.0f;
+	vert.Normal.Y = 1.0f;
+	vert.Normal.Z = 0.0f;
+
+	const u32 stride = Element.KnownSize;
+	const u32 blockCount = PLY_INPUT_BUFFER_SIZE / core::max_(stride, 1u) + 1;
+	core::array<c8> block;
+	block.set_used(blockCount * stride);
+
+	IVertexBuffer& vertices = mb->getVertexBuffer();
+	u32 count = 0;
+	for (u32 first=0; first < Element.Count; first += count)
+	{
+		count = core::min_(blockCount, Element.Count - first);
+		readBinaryBlock(block.pointer(), count * stride);
+
+		const u32 used = vertices.size();
+		vertices.set_used(used + count);
+		video::S3DVertex* out = vertices.pointer() + used;
+		const c8* data = block.const_pointer();
+		for (u32 i=0; i < count; ++i, data += stride)
+		{
+			out[i] = vert;
+			for (u32 j=0; j < fields.size(); ++j)
+			{
+				const SPLYVertexField& field = fields[j];
+				if (field.Target >= EPLYVT_RED && !field.IsFloat)
+					setVertexColor(out[i], field.Target, readBinaryInt(data + field.Offset, field.Type, IsWrongEndian));
+				else
+					setVertexValue(out[i], field.Target, readBinaryFloat(data + field.Offset, field.Type, IsWrongEndian));
+			}
+		}
+	}
+
+	return result || Element.Count == 0;
+}
+
+
 bool CPLYMeshFileLoader::readFace(const SPLYElement &Element, scene::CDynamicMeshBuffer* mb)
 {
 	if (!IsBinaryFile)
@@ -404,6 +807,83 @@ bool CPLYMeshFileLoader::readFace(const SPLYElement &Element, scene::CDynamicMes
 }
 
 
+//! Reads binary faces which only have a vertex index list, T is the index type
+template <class T>
+void CPLYMeshFileLoader::readBinaryFaces(const SPLYElement &Element, scene::CDynamicMeshBuffer* mb)
+{
+	const SPLYProperty& property = Element.Properties[0];
+	const E_PLY_PROPERTY_TYPE countType = property.Data.List.CountType;
+	const E_PLY_PROPERTY_TYPE itemType = property.Data.List.ItemType;
+	const s32 countSize = (s32)getBinarySize(countType);
+	const s32 itemSize = (s32)getBinarySize(itemType);
+	// faces with more corners are rare, readFace() reads them
+	const s32 maxCorners = 64;
+
+	IIndexBuffer& indices = mb->getIndexBuffer();
+	u32 used = indices.size();
+	for (u32 i=0; i < Element.Count; ++i)
+	{
+		if (EndPointer - StartPointer < countSize + maxCorners * itemSize)
+			fillBuffer();
+
+		const s32 count = EndPointer - StartPointer >= countSize ?
+			(s32)readBinaryInt(StartPointer, countType, IsWrongEndian) : 0;
+		if (count < 3 || count > maxCorners || EndPointer - StartPointer < countSize + count * itemSize)
+		{
+			indices.set_used(used);
+			readFace(Element, mb);
+			used = indices.size();
+			continue;
+		}
+
+		const u32 needed = (u32)(count - 2) * 3;
+		if (used + needed > indices.size())
+			indices.set_used(core::max_(used + needed, indices.size() * 2));
+		T* out = static_cast<T*>(indices.pointer()) + used;
+		used += needed;
+
+		// same winding as readFace()
+		const c8* p = StartPointer + countSize;
+		const T a = (T)readBinaryInt(p, itemType, IsWrongEndian);
+		T b = (T)readBinaryInt(p + itemSize, itemType, IsWrongEndian);
+		T c = (T)readBinaryInt(p + 2 * itemSize, itemType, IsWrongEndian);
+		p += 3 * itemSize;
+		*out++ = a;
+		*out++ = c;
+		*out++ = b;
+		for (s32 j=3; j < count; ++j, p += itemSize)
+		{
+			b = c;
+			c = (T)readBinaryInt(p, itemType, IsWrongEndian);
+			*out++ = a;
+			*out++ = c;
+			*out++ = b;
+		}
+		StartPointer += countSize + count * itemSize;
+	}
+	indices.set_used(used);
+}
+
+
+//! Copies the next bytes of binary data, past the end of the file they are 0
+void CPLYMeshFileLoader::readBinaryBlock(c8* dest, u32 size)
+{
+	const u32 buffered = core::min_(size, (u32)(EndPointer - StartPointer));
+	memcpy(dest, StartPointer, buffered);
+	StartPointer += buffered;
+	if (buffered == size)
+		return;
+
+	// the buffer is empty now, fillBuffer() continues behind the block
+	const size_t count = EndOfFile ? 0 : File->read(dest + buffered, size - buffered);
+	if (count != size - buffered)
+	{
+		memset(dest + buffered + count, 0, size - buffered - count);
+		EndOfFile = true;
+	}
+}
+
+
 // skips an element and all properties. return false on EOF
 void CPLYMeshFileLoader::skipElement(const SPLYElement &Element)
 {
@@ -669,44 +1149,8 @@ f32 CPLYMeshFileLoader::getFloat(E_PLY_PROPERTY_TYPE t)
 
 		if (EndPointer - StartPointer > 0)
 		{
-			switch (t)
-			{
-			case EPLYPT_INT8:
-				retVal = *StartPointer;
-				StartPointer++;
-				break;
-			case EPLYPT_INT16:
-				if (IsWrongEndian)
-					retVal = os::Byteswap::byteswap(*(reinterpret_cast<s16*>(StartPointer)));
-				else
-					retVal = *(reinterpret_cast<s16*>(StartPointer));
-				StartPointer += 2;
-				break;
-			case EPLYPT_INT32:
-				if (IsWrongEndian)
-					retVal = f32(os::Byteswap::byteswap(*(reinterpret_cast<s32*>(StartPointer))));
-				else
-					retVal = f32(*(reinterpret_cast<s32*>(StartPointer)));
-				StartPointer += 4;
-				break;
-			case EPLYPT_FLOAT32:
-				if (IsWrongEndian)
-					retVal = os::Byteswap::byteswap(*(reinterpret_cast<f32*>(StartPointer)));
-				else
-					retVal = *(reinterpret_cast<f32*>(StartPointer));
-				StartPointer += 4;
-				break;
-			case EPLYPT_FLOAT64:
-				// todo: byteswap 64-bit
-				retVal = f32(*(reinterpret_cast<f64*>(StartPointer)));
-				StartPointer += 8;
-				break;
-			case EPLYPT_LIST:
-			case EPLYPT_UNKNOWN:
-			default:
-				retVal = 0.0f;
-				StartPointer++; // ouch!
-			}
+			retVal = readBinaryFloat(StartPointer, t, IsWrongEndian);
+			StartPointer += getBinarySize(t);
 		}
 		else
 			retVal = 0.0f;
@@ -747,44 +1191,8 @@ u32 CPLYMeshFileLoader::getInt(E_PLY_PROPERTY_TYPE t)
 
 		if (EndPointer - StartPointer)
 		{
-			switch (t)
-			{
-			case EPLYPT_INT8:
-				retVal = *StartPointer;
-				StartPointer++;
-				break;
-			case EPLYPT_INT16:
-				if (IsWrongEndian)
-					retVal = os::Byteswap::byteswap(*(reinterpret_cast<u16*>(StartPointer)));
-				else
-					retVal = *(reinterpret_cast<u16*>(StartPointer));
-				StartPointer += 2;
-				break;
-			case EPLYPT_INT32:
-				if (IsWrongEndian)
-					retVal = os::Byteswap::byteswap(*(reinterpret_cast<s32*>(StartPointer)));
-				else
-					retVal = *(reinterpret_cast<s32*>(StartPointer));
-				StartPointer += 4;
-				break;
-			case EPLYPT_FLOAT32:
-				if (IsWrongEndian)
-					retVal = (u32)os::Byteswap::byteswap(*(reinterpret_cast<f32*>(StartPointer)));
-				else
-					retVal = (u32)(*(reinterpret_cast<f32*>(StartPointer)));
-				StartPointer += 4;
-				break;
-			case EPLYPT_FLOAT64:
-				// todo: byteswap 64-bit
-				retVal = (u32)(*(reinterpret_cast<f64*>(StartPointer)));
-				StartPointer += 8;
-				break;
-			case EPLYPT_LIST:
-			case EPLYPT_UNKNOWN:
-			default:
-				retVal = 0;
-				StartPointer++; // ouch!
-			}
+			retVal = readBinaryInt(StartPointer, t, IsWrongEndian);
+			StartPointer += getBinarySize(t);
 		}
 		else
 			retVal = 0;
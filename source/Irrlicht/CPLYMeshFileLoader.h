@@ -43,8 +43,20 @@ public:
 	//! creates/loads an animated mesh from the file.
 	virtual IAnimatedMesh* createMesh(io::IReadFile* file) IRR_OVERRIDE;
 
+	//! creates/loads an animated mesh from the file with the given scene parameters.
+	virtual IAnimatedMesh* createMeshWithParameters(io::IReadFile* file, const io::IAttributes* parameters) IRR_OVERRIDE;
+
+	//! Meshes can be loaded on worker threads, each call parses with a loader object of its own
+	virtual bool isThreadSafe() const IRR_OVERRIDE
+	{
+		return true;
+	}
+
 private:
 
+	//! Loads the mesh, uses the members for the parse state
+	IAnimatedMesh* parseMesh(io::IReadFile* file, const io::IAttributes* parameters);
+
 	struct SPLYProperty
 	{
 		core::stringc Name;
@@ -117,6 +129,24 @@ private:
 		u32 KnownSize;
 	};
 
+	//! Lines of a vertex or face element, read by a loader of their own
+	struct SPLYChunk
+	{
+		//! Called by parseChunks()
+		void parse();
+
+		const SPLYElement* Element;
+		const c8* Begin;
+		const c8* End;
+		u32 Count;
+		scene::CDynamicMeshBuffer* Buffer;
+		bool HasNormals;
+	};
+
+	//! Reads the ascii vertices and faces in chunks at the same time
+	/** \return True if all vertices had normals */
+	bool readChunks(u32 chunkCount, scene::CDynamicMeshBuffer* mb);
+
 	bool allocateBuffer();
 	c8* getNextLine();
 	c8* getNextWord();
@@ -125,6 +155,15 @@ private:
 
 	bool readVertex(const SPLYElement &Element, scene::CDynamicMeshBuffer* mb);
 	bool readFace(const SPLYElement &Element, scene::CDynamicMeshBuffer* mb);
+
+	//! Reads all vertices of a fixed width binary element in blocks
+	/** \return True if the vertices have normals */
+	bool readBinaryVertices(const SPLYElement &Element, scene::CDynamicMeshBuffer* mb);
+	//! Reads binary faces which only have a vertex index list, T is the index type
+	template <class T>
+	void readBinaryFaces(const SPLYElement &Element, scene::CDynamicMeshBuffer* mb);
+	//! Copies the next bytes of binary data, past the end of the file they are 0
+	void readBinaryBlock(c8* dest, u32 size);
 	void skipElement(const SPLYElement &Element);
 	void skipProperty(const SPLYProperty &Property);
 	f32 getFloat(E_PLY_PROPERTY_TYPE t);
@@ -10,6 +10,7 @@
 #include "os.h"
 #include "IMesh.h"
 #include "IMeshBuffer.h"
+#include "CMeshBufferQuantized.h"
 #include "IWriteFile.h"
 
 namespace irr
@@ -105,6 +106,7 @@ bool CPLYMeshWriter::writeMesh(io::IWriteFile* file, scene::IMesh* mesh, s32 fla
 	{
 		const scene::IMeshBuffer* mb = mesh->getMeshBuffer(i);
 		u32 vertexSize = 0;
+		bool quantized = false;
 		switch(mb->getVertexType())
 		{
 		case video::EVT_STANDARD:
@@ -116,6 +118,10 @@ bool CPLYMeshWriter::writeMesh(io::IWriteFile* file, scene::IMesh* mesh, s32 fla
 		case video::EVT_TANGENTS:
 			vertexSize = sizeof(video::S3DVertexTangents);
 			break;
+		case video::EVT_QUANTIZED:
+		case video::EVT_QUANTIZED_TANGENTS:
+			quantized = true;
+			break;
 		}
 		u8 *vertices  = (u8*)mb->getVertices() ;
 
@@ -123,6 +129,12 @@ bool CPLYMeshWriter::writeMesh(io::IWriteFile* file, scene::IMesh* mesh, s32 fla
 		{
         	u8 *buf = vertices + j * vertexSize;
 			const video::S3DVertex* vertex = ( (video::S3DVertex*)buf );
+			video::S3DVertex decoded;
+			if (quantized)
+			{
+				decoded = getDecodedVertex(mb, j);
+				vertex = &decoded;
+			}
 			const core::vector3df& pos    = vertex->Pos;
 			const core::vector3df& n      = vertex->Normal;
 			const core::vector2df& uv     = vertex->TCoords;
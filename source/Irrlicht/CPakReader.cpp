@@ -109,6 +109,7 @@ CPakReader::CPakReader(IReadFile* file, bool ignoreCase, bool ignorePaths)
 	if (File)
 	{
 		File->grab();
+		ReadHandles.set(File);
 		scanLocalHeader();
 		sort();
 	}
@@ -186,7 +187,7 @@ IReadFile* CPakReader::createAndOpenFile(u32 index)
 		return 0;
 
 	const SFileListEntry &entry = Files[index];
-	return createLimitReadFile( entry.FullName, File, entry.Offset, entry.Size );
+	return createLimitReadFile( entry.FullName, ReadHandles.get(), entry.Offset, entry.Size );
 }
 
 } // end namespace io
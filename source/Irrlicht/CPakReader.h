@@ -11,6 +11,7 @@
 
 #include "IReferenceCounted.h"
 #include "IReadFile.h"
+#include "CPerThreadReadFile.h"
 #include "irrArray.h"
 #include "irrString.h"
 #include "IFileSystem.h"
@@ -111,6 +112,9 @@ namespace io
 
 		IReadFile* File;
 
+		//! Handles to File for the threads opening entries
+		CPerThreadReadFile ReadHandles;
+
 	};
 
 } // end namespace io
@@ -0,0 +1,235 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CPerThreadReadFile.h"
+#include "CReadFile.h"
+#include "CMemoryFile.h"
+#include "IMemoryReadFile.h"
+#include "os.h"
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+#if defined(_IRR_WINDOWS_API_) && !defined(_IRR_XBOX_PLATFORM_)
+	#include <windows.h>
+#elif defined(_IRR_POSIX_API_) || defined(_IRR_OSX_PLATFORM_)
+	#include <sys/stat.h>
+#endif
+#endif
+
+namespace irr
+{
+namespace io
+{
+
+CPerThreadReadFile::CPerThreadReadFile() : File(0)
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	, Copy(0)
+#endif
+{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	Owner = CThread::getCurrentId();
+#endif
+}
+
+
+CPerThreadReadFile::~CPerThreadReadFile()
+{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	for (u32 i=0; i<Handles.size(); ++i)
+		Handles[i].File->drop();
+	if (Copy)
+		Copy->drop();
+#endif
+	if (File)
+		File->drop();
+}
+
+
+void CPerThreadReadFile::set(IReadFile* file)
+{
+	if (file)
+		file->grab();
+	if (File)
+		File->drop();
+	File = file;
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	Owner = CThread::getCurrentId();
+	for (u32 i=0; i<Handles.size(); ++i)
+		Handles[i].File->drop();
+	Handles.clear();
+	if (Copy)
+	{
+		Copy->drop();
+		Copy = 0;
+	}
+
+	// to find out if the file on disk is still the same when opening it again
+	Stamp = SFileStamp();
+	if (File && File->getType() == ERFT_READ_FILE)
+		getFileStamp(File->getFileName(), Stamp);
+#endif
+}
+
+
+IReadFile* CPerThreadReadFile::get()
+{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	const CThread::Id thread = CThread::getCurrentId();
+	if (!File || CThread::isSameThread(thread, Owner))
+		return File;
+
+	CMutexLock lock(Mutex);
+	for (u32 i=0; i<Handles.size(); ++i)
+	{
+		if (CThread::isSameThread(Handles[i].Thread, thread))
+			return Handles[i].File;
+	}
+
+	SHandle handle;
+	handle.Thread = thread;
+	handle.File = createHandle();
+	if (!handle.File)
+	{
+		// not safe when several threads read, but better than failing
+		os::Printer::log("Could not open archive again for another thread", File->getFileName(), ELL_WARNING);
+		return File;
+	}
+
+	Handles.push_back(handle);
+	return handle.File;
+#else
+	return File;
+#endif
+}
+
+
+IReadFile* CPerThreadReadFile::createOwnHandle()
+{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	if (File && !CThread::isSameThread(CThread::getCurrentId(), Owner))
+	{
+		CMutexLock lock(Mutex);
+		IReadFile* handle = createHandle();
+		if (handle)
+			return handle;
+	}
+#endif
+	IReadFile* file = get();
+	if (file)
+		file->grab();
+	return file;
+}
+
+
+IReadFile* CPerThreadReadFile::getOriginal() const
+{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	// threads with a handle over the copy got it with Mutex locked, so they see Copy
+	if (Copy && !CThread::isSameThread(CThread::getCurrentId(), Owner))
+		return Copy;
+#endif
+	return File;
+}
+
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+
+IReadFile* CPerThreadReadFile::createHandle()
+{
+	if (File->getType() == ERFT_READ_FILE)
+	{
+		IReadFile* handle = reopen();
+		if (handle)
+			return handle;
+	}
+
+	IReadFile* source = File;
+	if (File->getType() != ERFT_MEMORY_READ_FILE && File->getType() != ERFT_MAPPED_READ_FILE)
+	{
+		// only copied now, applications using one thread never need it
+		if (!Copy)
+		{
+			Copy = createMemoryCopy(File);
+			if (!Copy)
+				return 0;
+			os::Printer::log("Copied archive into memory for reading from several threads",
+				File->getFileName(), ELL_DEBUG);
+		}
+		source = Copy;
+	}
+
+	// the memory stays valid as long as source exists
+	return new CMemoryReadFile(static_cast<IMemoryReadFile*>(source)->getBuffer(),
+		source->getSize(), source->getFileName(), false);
+}
+
+
+IReadFile* CPerThreadReadFile::reopen() const
+{
+	SFileStamp stamp;
+	if (Stamp.Size < 0 || !getFileStamp(File->getFileName(), stamp) || !(stamp == Stamp))
+		return 0;
+
+	IReadFile* handle = CReadFile::createReadFile(File->getFileName());
+	if (handle && handle->getSize() != Stamp.Size)
+	{
+		handle->drop();
+		return 0;
+	}
+	return handle;
+}
+
+
+IReadFile* CPerThreadReadFile::createMemoryCopy(IReadFile* file)
+{
+	const long size = file->getSize();
+	const long pos = file->getPos();
+	if (size <= 0 || !file->seek(0))
+		return 0;
+
+	c8* data = new c8[size];
+	const bool complete = file->read(data, size) == (size_t)size;
+	file->seek(pos);
+	if (!complete)
+	{
+		delete [] data;
+		return 0;
+	}
+
+	return new CMemoryReadFile(data, size, file->getFileName(), true);
+}
+
+
+bool CPerThreadReadFile::getFileStamp(const io::path& fileName, SFileStamp& stamp)
+{
+#if defined(_IRR_WINDOWS_API_) && !defined(_IRR_XBOX_PLATFORM_)
+	WIN32_FILE_ATTRIBUTE_DATA info;
+#if defined(_IRR_WCHAR_FILESYSTEM)
+	if (!GetFileAttributesExW(fileName.c_str(), GetFileExInfoStandard, &info))
+#else
+	if (!GetFileAttributesExA(fileName.c_str(), GetFileExInfoStandard, &info))
+#endif
+		return false;
+	if (info.nFileSizeHigh != 0 || info.nFileSizeLow > 0x7fffffff)
+		return false;
+	stamp.Size = (long)info.nFileSizeLow;
+	stamp.Time = ((u64)info.ftLastWriteTime.dwHighDateTime << 32) | info.ftLastWriteTime.dwLowDateTime;
+	return true;
+#elif defined(_IRR_POSIX_API_) || defined(_IRR_OSX_PLATFORM_)
+	struct stat info;
+	if (stat(fileName.c_str(), &info) != 0 || !S_ISREG(info.st_mode) || (long)info.st_size != info.st_size)
+		return false;
+	stamp.Size = (long)info.st_size;
+	stamp.Time = (u64)info.st_mtime;
+	return true;
+#else
+	return false;
+#endif
+}
+
+#endif
+
+} // end namespace io
+} // end namespace irr
+
@@ -0,0 +1,114 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_C_PER_THREAD_READ_FILE_H_INCLUDED
+#define IRR_C_PER_THREAD_READ_FILE_H_INCLUDED
+
+#include "IReadFile.h"
+#include "irrArray.h"
+#include "CThread.h"
+
+namespace irr
+{
+namespace io
+{
+
+//! Gives each thread its own handle to the file of an archive.
+/** Archives read their entries by seeking in one file, which would mix up
+the positions when several threads open entries at the same time. The thread
+which created the archive uses the original file, other threads get their own
+handle: another CReadFile for files on disk and another CMemoryReadFile over
+the same memory for memory and mapped files. Files on disk are only opened
+again when their size and modification time didn't change since set().
+Other files (like archives inside archives) can't be opened twice. They are
+copied into memory when another thread needs a handle the first time, which
+reads the original file, so the creating thread should not read the archive
+at that moment. Files opened from an archive with a per-thread handle must be
+read by the thread which opened them. */
+class CPerThreadReadFile
+{
+public:
+
+	CPerThreadReadFile();
+
+	//! Drops all handles
+	~CPerThreadReadFile();
+
+	//! Sets the file of the archive, grabs it
+	/** Has to be called by the thread creating the archive, before other
+	threads read the file. */
+	void set(IReadFile* file);
+
+	//! Returns the handle for the calling thread, it is not grabbed
+	/** Handles of other threads are kept until the archive is destroyed. */
+	IReadFile* get();
+
+	//! Returns a handle for the calling thread which is not kept
+	/** For threads which end soon. Drop the handle when done. */
+	IReadFile* createOwnHandle();
+
+	//! Returns the file the handle of the calling thread reads from
+	/** The file passed to set(), or its copy in memory for other threads.
+	Handles of other threads may only reference its memory, so files using
+	that memory should grab this one. */
+	IReadFile* getOriginal() const;
+
+private:
+
+	CPerThreadReadFile(const CPerThreadReadFile&);
+	CPerThreadReadFile& operator=(const CPerThreadReadFile&);
+
+	IReadFile* File;
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	//! Creates a new handle for File, 0 if that's not possible
+	/** Mutex has to be locked. */
+	IReadFile* createHandle();
+
+	//! Opens File again from disk, 0 if it has been replaced meanwhile
+	IReadFile* reopen() const;
+
+	//! Returns a copy of a file in memory, 0 if it can't be read
+	static IReadFile* createMemoryCopy(IReadFile* file);
+
+	//! Size and modification time of a file on disk
+	struct SFileStamp
+	{
+		SFileStamp() : Size(-1), Time(0) {}
+
+		bool operator==(const SFileStamp& other) const
+		{
+			return Size == other.Size && Time == other.Time;
+		}
+
+		long Size;
+		u64 Time;
+	};
+
+	//! Gets the stamp of a file on disk, false if it's not known
+	static bool getFileStamp(const io::path& fileName, SFileStamp& stamp);
+
+	struct SHandle
+	{
+		CThread::Id Thread;
+		IReadFile* File;
+	};
+
+	CThread::Id Owner;
+	core::array<SHandle> Handles;
+	CMutex Mutex;
+
+	//! Stamp of File on disk when it was set, Size is -1 if unknown
+	SFileStamp Stamp;
+
+	//! Copy of File in memory for other threads, made on first use
+	IReadFile* Copy;
+#endif
+};
+
+} // end namespace io
+} // end namespace irr
+
+#endif
+
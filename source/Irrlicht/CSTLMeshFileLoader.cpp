@@ -10,17 +10,26 @@
 #include "SMesh.h"
 #include "CDynamicMeshBuffer.h"
 #include "CMemoryFile.h"
+#include "CVertexHashGrid.h"
 #include "SAnimatedMesh.h"
 #include "IReadFile.h"
 #include "fast_atof.h"
 #include "coreutil.h"
 #include "os.h"
+#include "SceneParameters.h"
+#include "IAttributes.h"
 
 namespace irr
 {
 namespace scene
 {
 
+//! Constructor
+CSTLMeshFileLoader::CSTLMeshFileLoader(scene::ISceneManager* smgr)
+: SceneManager(smgr)
+{
+}
+
 
 //! returns true if the file maybe is able to be loaded by this class
 //! based on the file extension (e.g. ".bsp")
@@ -36,6 +45,13 @@ bool CSTLMeshFileLoader::isALoadableFileExtension(const io::path& filename) cons
 //! If you no longer need the mesh, you should call IAnimatedMesh::drop().
 //! See IReferenceCounted::drop() for more information.
 IAnimatedMesh* CSTLMeshFileLoader::createMesh(io::IReadFile* fileIn)
+{
+	return createMeshWithParameters(fileIn, SceneManager ? SceneManager->getParameters() : 0);
+}
+
+
+//! creates/loads an animated mesh from the file with the given scene parameters.
+IAnimatedMesh* CSTLMeshFileLoader::createMeshWithParameters(io::IReadFile* fileIn, const io::IAttributes* parameters)
 {
 	const long filesize = fileIn->getSize();
 	if (filesize < 6) // we need a header
@@ -43,7 +59,7 @@ IAnimatedMesh* CSTLMeshFileLoader::createMesh(io::IReadFile* fileIn)
 
 	// We copy the whole file into a memory-read file if it isn't already one.
 	io::CMemoryReadFile * memoryFile = 0;
-	if ( fileIn->getType() != io::ERFT_MEMORY_READ_FILE )
+	if ( fileIn->getType() != io::ERFT_MEMORY_READ_FILE && fileIn->getType() != io::ERFT_MAPPED_READ_FILE )
 	{
 		u8* fileBuffer = new u8[filesize];
 		if ( fileIn->read(fileBuffer, filesize) != (size_t)filesize )
@@ -64,106 +80,88 @@ IAnimatedMesh* CSTLMeshFileLoader::createMesh(io::IReadFile* fileIn)
 	core::vector3df vertex[3];
 	core::vector3df normal;
 
-	bool binary = false;
-	if (getNextToken(file) != "solid")
-		binary = true;
-	// read/skip header
-	u32 binFaceCount = 0;
-	if (binary)
+	// kept for the whole file to avoid reallocating it for each word
+	core::stringc token;
+	token.reserve(32);
+	bool failure = false;
+
+	if (getNextToken(file, token) != "solid")
 	{
-		file->seek(80);
-		file->read(&binFaceCount, 4);
-#ifdef __BIG_ENDIAN__
-		binFaceCount = os::Byteswap::byteswap(binFaceCount);
-#endif
+		// binary, skip the header and the triangle count. Like before the
+		// triangles are read up to the end of the file, but only complete ones.
+		file->seek(84);
+		readBinaryTriangles(file, filesize > 84 ? (u32)((filesize - 84) / 50) : 0, vertBuffer);
 	}
 	else
+	{
 		goNextLine(file);
 
-	u16 attrib=0;
-	Token.reserve(32);
-	bool failure = false;
-
-	while (file->getPos() < filesize)
-	{
-		if (!binary)
+		while (file->getPos() < filesize)
 		{
-			if (getNextToken(file) != "facet")
+			if (getNextToken(file, token) != "facet")
 			{
-				if (Token!="endsolid")
+				if (token!="endsolid")
 					failure = true;
 				break;
 			}
-			if (getNextToken(file) != "normal")
+			if (getNextToken(file, token) != "normal")
 			{
 				failure = true;
 				break;
 			}
-		}
-		getNextVector(file, normal, binary);
-		if (!binary)
-		{
-			if (getNextToken(file) != "outer")
+			getNextVector(file, normal, token);
+			if (getNextToken(file, token) != "outer")
 			{
 				failure = true;
 				break;
 			}
-			if (getNextToken(file) != "loop")
+			if (getNextToken(file, token) != "loop")
 			{
 				failure = true;
 				break;
 			}
-		}
-		for (u32 i=0; i<3; ++i)
-		{
-			if (!binary)
+			for (u32 i=0; i<3; ++i)
 			{
-				if (getNextToken(file) != "vertex")
+				if (getNextToken(file, token) != "vertex")
 				{
 					failure = true;
 					break;
 				}
+				getNextVector(file, vertex[i], token);
 			}
-			getNextVector(file, vertex[i], binary);
-		}
-		if ( failure )
-			break;
-		if (!binary)
-		{
-			if (getNextToken(file) != "endloop")
+			if ( failure )
+				break;
+			if (getNextToken(file, token) != "endloop")
 			{
 				failure = true;
 				break;
 			}
-			if (getNextToken(file) != "endfacet")
+			if (getNextToken(file, token) != "endfacet")
 			{
 				failure = true;
 				break;
 			}
-		}
-		else
-		{
-			file->read(&attrib, 2);
-#ifdef __BIG_ENDIAN__
-			attrib = os::Byteswap::byteswap(attrib);
-#endif
-		}
 
-		video::SColor color(0xffffffff);
-		if (attrib & 0x8000)
-			color = video::A1R5G5B5toA8R8G8B8(attrib);
-		if (normal==core::vector3df())
-			normal=core::plane3df(vertex[2],vertex[1],vertex[0]).Normal;
-		vertBuffer.push_back(video::S3DVertex(vertex[2],normal,color, core::vector2df()));
-		vertBuffer.push_back(video::S3DVertex(vertex[1],normal,color, core::vector2df()));
-		vertBuffer.push_back(video::S3DVertex(vertex[0],normal,color, core::vector2df()));
-	}	// end while (file->getPos() < filesize)
+			const video::SColor color(0xffffffff);
+			if (normal==core::vector3df())
+				normal=core::plane3df(vertex[2],vertex[1],vertex[0]).Normal;
+			vertBuffer.push_back(video::S3DVertex(vertex[2],normal,color, core::vector2df()));
+			vertBuffer.push_back(video::S3DVertex(vertex[1],normal,color, core::vector2df()));
+			vertBuffer.push_back(video::S3DVertex(vertex[0],normal,color, core::vector2df()));
+		}	// end while (file->getPos() < filesize)
+	}
 
 	// Create the Animated mesh if there's anything in the mesh
 	SAnimatedMesh* pAM = 0;
 	if ( !failure && mesh->getMeshBufferCount() > 0 )
 	{
 		IIndexBuffer& indexBuffer = meshBuffer->getIndexBuffer();
+
+		core::array<u32> weldedIndices;
+		const bool welded = parameters &&
+			parameters->getAttributeAsBool(STL_LOADER_WELD_VERTICES) &&
+			weldVertices(vertBuffer, weldedIndices);
+
 		u32 vertCount = vertBuffer.size();
 		if (vertCount > 65535 )	// Note 65535 instead of 65536 as it divides by 3
 		{
@@ -176,9 +174,18 @@ IAnimatedMesh* CSTLMeshFileLoader::createMesh(io::IReadFile* fileIn)
 			}
 		}
 
-		indexBuffer.reallocate(vertCount);
-		for (u32 i=0; i<vertCount; ++i)	//every vertex is unique, so we can just generate the indices
-			indexBuffer.push_back(i);
+		if (welded)
+		{
+			indexBuffer.reallocate(weldedIndices.size());
+			for (u32 i=0; i<weldedIndices.size(); ++i)
+				indexBuffer.push_back(weldedIndices[i]);
+		}
+		else
+		{
+			indexBuffer.reallocate(vertCount);
+			for (u32 i=0; i<vertCount; ++i)	//every vertex is unique, so we can just generate the indices
+				indexBuffer.push_back(i);
+		}
 
 		meshBuffer->recalculateBoundingBox();
 		mesh->recalculateBoundingBox();
@@ -189,7 +196,6 @@ IAnimatedMesh* CSTLMeshFileLoader::createMesh(io::IReadFile* fileIn)
 	}
 
 	mesh->drop();
-	Token.clear();
 	if ( memoryFile )
 		memoryFile->drop();
 
@@ -197,50 +203,122 @@ IAnimatedMesh* CSTLMeshFileLoader::createMesh(io::IReadFile* fileIn)
 }
 
 
-//! Read 3d vector of floats
-void CSTLMeshFileLoader::getNextVector(io::IReadFile* file, core::vector3df& vec, bool binary)
+//! Reads all triangles of a binary file in blocks
+void CSTLMeshFileLoader::readBinaryTriangles(io::IReadFile* file, u32 triangleCount, IVertexBuffer& vertBuffer) const
 {
-	if (binary)
+	const u32 recordSize = 50; // normal, 3 vertices, attribute
+	const u32 blockSize = 1024;
+	core::array<u8> block;
+	block.set_used(blockSize * recordSize);
+
+	vertBuffer.set_used(triangleCount * 3);
+	video::S3DVertex* vertex = vertBuffer.pointer();
+
+	u32 count = 0;
+	for (u32 first=0; first<triangleCount; first+=count)
 	{
-		file->read(&vec.X, 4);
-		file->read(&vec.Y, 4);
-		file->read(&vec.Z, 4);
+		count = core::min_(blockSize, triangleCount - first);
+		file->read(block.pointer(), count * recordSize);
+
+		const u8* record = block.const_pointer();
+		for (u32 i=0; i<count; ++i, record += recordSize, vertex += 3)
+		{
+			f32 v[12];
+			u16 attrib;
+			memcpy(v, record, sizeof(v));
+			memcpy(&attrib, record + 48, 2);
 #ifdef __BIG_ENDIAN__
-		vec.X = os::Byteswap::byteswap(vec.X);
-		vec.Y = os::Byteswap::byteswap(vec.Y);
-		vec.Z = os::Byteswap::byteswap(vec.Z);
+			for (u32 j=0; j<12; ++j)
+				v[j] = os::Byteswap::byteswap(v[j]);
+			attrib = os::Byteswap::byteswap(attrib);
 #endif
+
+			// x is mirrored like in getNextVector
+			core::vector3df normal(-v[0], v[1], v[2]);
+			const core::vector3df v0(-v[3], v[4], v[5]);
+			const core::vector3df v1(-v[6], v[7], v[8]);
+			const core::vector3df v2(-v[9], v[10], v[11]);
+
+			video::SColor color(0xffffffff);
+			if (attrib & 0x8000)
+				color = video::A1R5G5B5toA8R8G8B8(attrib);
+			if (normal==core::vector3df())
+				normal=core::plane3df(v2,v1,v0).Normal;
+			vertex[0] = video::S3DVertex(v2, normal, color, core::vector2df());
+			vertex[1] = video::S3DVertex(v1, normal, color, core::vector2df());
+			vertex[2] = video::S3DVertex(v0, normal, color, core::vector2df());
+		}
 	}
-	else
+}
+
+
+//! Merges equal vertices and returns the indices of the remaining triangles
+bool CSTLMeshFileLoader::weldVertices(IVertexBuffer& vertBuffer, core::array<u32>& indices) const
+{
+	const u32 vertCount = vertBuffer.size();
+	video::S3DVertex* v = vertBuffer.pointer();
+
+	const u32 uniqueCount = scene::weldVertices(v, vertCount, core::ROUNDING_ERROR_f32, indices);
+	if (uniqueCount > 65535 && getIndexTypeHint() == EITH_16BIT)
+		return false;
+
+	// kept vertices are numbered in order, so they can be moved down in place
+	u32 kept = 0;
+	for (u32 i=0; i<vertCount; ++i)
+	{
+		if (indices[i] == kept)
+			v[kept++] = v[i];
+	}
+	vertBuffer.set_used(kept);
+
+	// drop triangles which collapsed, like createMeshWelded does
+	u32 indexCount = 0;
+	for (u32 i=0; i+2<vertCount; i+=3)
 	{
-		goNextWord(file);
-
-		getNextToken(file);
-		core::fast_atof_move(Token.c_str(), vec.X);
-		getNextToken(file);
-		core::fast_atof_move(Token.c_str(), vec.Y);
-		getNextToken(file);
-		core::fast_atof_move(Token.c_str(), vec.Z);
+		const u32 a = indices[i];
+		const u32 b = indices[i+1];
+		const u32 c = indices[i+2];
+		if (a == b || b == c || a == c)
+			continue;
+		indices[indexCount++] = a;
+		indices[indexCount++] = b;
+		indices[indexCount++] = c;
 	}
+	indices.set_used(indexCount);
+	return true;
+}
+
+
+//! Read 3d vector of floats
+void CSTLMeshFileLoader::getNextVector(io::IReadFile* file, core::vector3df& vec, core::stringc& token) const
+{
+	goNextWord(file);
+
+	getNextToken(file, token);
+	core::fast_atof_move(token.c_str(), vec.X);
+	getNextToken(file, token);
+	core::fast_atof_move(token.c_str(), vec.Y);
+	getNextToken(file, token);
+	core::fast_atof_move(token.c_str(), vec.Z);
 	vec.X=-vec.X;
 }
 
 
 //! Read next word
-const core::stringc& CSTLMeshFileLoader::getNextToken(io::IReadFile* file)
+const core::stringc& CSTLMeshFileLoader::getNextToken(io::IReadFile* file, core::stringc& token) const
 {
 	goNextWord(file);
 	u8 c;
-	Token = "";
+	token = "";
 	while(file->getPos() != file->getSize())
 	{
 		file->read(&c, 1);
 		// found it, so leave
 		if (core::isspace(c))
 			break;
-		Token.append(c);
+		token.append(c);
 	}
-	return Token;
+	return token;
 }
 
 
@@ -6,6 +6,8 @@
 #define IRR_C_STL_MESH_FILE_LOADER_H_INCLUDED
 
 #include "IMeshLoader.h"
+#include "ISceneManager.h"
+#include "IVertexBuffer.h"
 #include "irrString.h"
 #include "vector3d.h"
 
@@ -19,6 +21,9 @@ class CSTLMeshFileLoader : public IMeshLoader
 {
 public:
 
+	//! Constructor
+	CSTLMeshFileLoader(scene::ISceneManager* smgr);
+
 	//! returns true if the file maybe is able to be loaded by this class
 	//! based on the file extension (i.e. ".stl")
 	virtual bool isALoadableFileExtension(const io::path& filename) const IRR_OVERRIDE;
@@ -29,20 +34,38 @@ public:
 	//! See IReferenceCounted::drop() for more information.
 	virtual IAnimatedMesh* createMesh(io::IReadFile* file) IRR_OVERRIDE;
 
+	//! creates/loads an animated mesh from the file with the given scene parameters.
+	virtual IAnimatedMesh* createMeshWithParameters(io::IReadFile* file, const io::IAttributes* parameters) IRR_OVERRIDE;
+
+	//! Meshes can be loaded on worker threads, the parse state is local to createMesh()
+	virtual bool isThreadSafe() const IRR_OVERRIDE
+	{
+		return true;
+	}
+
 private:
 
 	// skips to the first non-space character available
 	void goNextWord(io::IReadFile* file) const;
-	// returns the next word
-	const core::stringc& getNextToken(io::IReadFile* file);
+	// returns the next word, read into token
+	const core::stringc& getNextToken(io::IReadFile* file, core::stringc& token) const;
 	// skip to next printable character after the first line break
 	void goNextLine(io::IReadFile* file) const;
 
-	//! Read 3d vector of floats
-	void getNextVector(io::IReadFile* file, core::vector3df& vec, bool binary);
+	//! Read 3d vector of floats of an ascii file
+	void getNextVector(io::IReadFile* file, core::vector3df& vec, core::stringc& token) const;
+
+	//! Reads all triangles of a binary file in blocks
+	void readBinaryTriangles(io::IReadFile* file, u32 triangleCount, IVertexBuffer& vertBuffer) const;
+
+	//! Merges equal vertices and returns the indices of the remaining triangles
+	/** Like IMeshManipulator::createMeshWelded() triangles which collapse
+	are dropped. Returns false and leaves the vertices alone if the welded
+	vertices still need 32 bit indices which the index type hint doesn't
+	allow. */
+	bool weldVertices(IVertexBuffer& vertBuffer, core::array<u32>& indices) const;
 
-	//! Buffering last read token to avoid reallocating string all the time
-	core::stringc Token;
+	scene::ISceneManager* SceneManager;
 };
 
 } // end namespace scene
@@ -7,6 +7,7 @@
 #include "ICameraSceneNode.h"
 #include "ITriangleSelector.h"
 #include "SViewFrustum.h"
+#include "CThread.h"
 
 #include "os.h"
 #include "irrMath.h"
@@ -16,6 +17,39 @@ namespace irr
 namespace scene
 {
 
+#ifdef _IRR_COMPILE_WITH_THREADS_
+namespace
+{
+	//! Batches of lines are split between threads only into parts of at least this size
+	const u32 MIN_LINES_PER_THREAD = 256;
+
+	//! Upper limit of threads tracing one batch
+	const u32 MAX_BATCH_THREADS = 16;
+
+	//! Part of a batch of lines, traced by one thread
+	struct SCollisionBatch
+	{
+		ITriangleSelector* Selector;
+		SCollisionHit* HitResults;
+		bool* HitFound;
+		const core::line3d<f32>* Rays;
+		u32 RayCount;
+		u32 HitCount;
+
+		void trace()
+		{
+			HitCount = Selector->getCollisionPoints(HitResults, HitFound, Rays, RayCount);
+		}
+	};
+
+	//! Thread function tracing a SCollisionBatch
+	void traceCollisionBatch(void* batch)
+	{
+		static_cast<SCollisionBatch*>(batch)->trace();
+	}
+}
+#endif
+
 //! constructor
 CSceneCollisionManager::CSceneCollisionManager(ISceneManager* smanager, video::IVideoDriver* driver)
 : SceneManager(smanager), Driver(driver)
@@ -72,7 +106,7 @@ ISceneNode* CSceneCollisionManager::getSceneNodeFromRayBB(
 //! recursive method for going through all scene nodes
 void CSceneCollisionManager::getPickedNodeBB(ISceneNode* root,
 		core::line3df& ray, s32 bits, bool noDebugObjects,
-		f32& outbestdistance, ISceneNode*& outbestnode)
+		f32& outbestdistance, ISceneNode*& outbestnode) const
 {
 	const ISceneNodeList& children = root->getChildren();
 	const core::vector3df rayVector = ray.getVector().normalize();
@@ -271,7 +305,7 @@ void CSceneCollisionManager::getPickedNodeFromBBAndSelector(
 				core::line3df & ray,
 				s32 bits,
 				bool noDebugObjects,
-				f32 & outBestDistanceSquared)
+				f32 & outBestDistanceSquared) const
 {
 	const ISceneNodeList& children = root->getChildren();
 
@@ -301,7 +335,7 @@ void CSceneCollisionManager::getPickedNodeFromBBAndSelector(
 
 			// do intersection test in object space
 			if (box.intersectsWithLine(line) &&
-				getCollisionPoint(candidateHitResult, ray, selector))
+				selector->getCollisionPoint(candidateHitResult, ray))
 			{
 				const f32 distanceSquared = (candidateHitResult.Intersection - ray.start).getLengthSQ();
 
@@ -344,81 +378,69 @@ bool CSceneCollisionManager::getCollisionPoint(SCollisionHit& hitResult, const c
 		return false;
 	}
 
-	s32 totalcnt = selector->getTriangleCount();
-	if ( totalcnt <= 0 )
-		return false;
-
-	Triangles.set_used(totalcnt);
-
-	s32 cnt = 0;
-	irr::core::array<SCollisionTriangleRange> outTriangleInfo;
-	selector->getTriangles(Triangles.pointer(), totalcnt, cnt, ray, 0, true, &outTriangleInfo);
-
-	const core::vector3df linevect = ray.getVector().normalize();
-	core::vector3df intersection;
-	f32 nearest = FLT_MAX;
-	irr::s32 foundIndex = -1;
-	const f32 raylength = ray.getLengthSQ();
-
-	const f32 minX = core::min_(ray.start.X, ray.end.X);
-	const f32 maxX = core::max_(ray.start.X, ray.end.X);
-	const f32 minY = core::min_(ray.start.Y, ray.end.Y);
-	const f32 maxY = core::max_(ray.start.Y, ray.end.Y);
-	const f32 minZ = core::min_(ray.start.Z, ray.end.Z);
-	const f32 maxZ = core::max_(ray.start.Z, ray.end.Z);
+	return selector->getCollisionPoint(hitResult, ray);
+}
 
-	for (s32 i=0; i<cnt; ++i)
+u32 CSceneCollisionManager::getCollisionPoints(SCollisionHit* hitResults, bool* hitFound,
+		const core::line3d<f32>* rays, u32 rayCount, ITriangleSelector* selector)
+{
+	if (!selector)
 	{
-		const core::triangle3df & triangle = Triangles[i];
-
-		if(minX > triangle.pointA.X && minX > triangle.pointB.X && minX > triangle.pointC.X)
-			continue;
-		if(maxX < triangle.pointA.X && maxX < triangle.pointB.X && maxX < triangle.pointC.X)
-			continue;
-		if(minY > triangle.pointA.Y && minY > triangle.pointB.Y && minY > triangle.pointC.Y)
-			continue;
-		if(maxY < triangle.pointA.Y && maxY < triangle.pointB.Y && maxY < triangle.pointC.Y)
-			continue;
-		if(minZ > triangle.pointA.Z && minZ > triangle.pointB.Z && minZ > triangle.pointC.Z)
-			continue;
-		if(maxZ < triangle.pointA.Z && maxZ < triangle.pointB.Z && maxZ < triangle.pointC.Z)
-			continue;
-
-		if (triangle.getIntersectionWithLine(ray.start, linevect, intersection))
-		{
-			const f32 tmp = intersection.getDistanceFromSQ(ray.start);
-			const f32 tmp2 = intersection.getDistanceFromSQ(ray.end);
+		for (u32 i=0; i<rayCount; ++i)
+			hitFound[i] = false;
+		return 0;
+	}
 
-			if (tmp < raylength && tmp2 < raylength && tmp < nearest)
-			{
-				nearest = tmp;
+	if (rayCount == 0)
+		return 0;
 
-				hitResult.Triangle = triangle;
-				hitResult.Intersection = intersection;
-				foundIndex = i;
-			}
-		}
+	// The first line is traced alone. That brings selectors of animated
+	// nodes up to date before several threads query them.
+	u32 hitCount = selector->getCollisionPoints(hitResults, hitFound, rays, 1);
+	++hitResults;
+	++hitFound;
+	++rays;
+	--rayCount;
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	const u32 threadCount = core::min_(CThread::getHardwareConcurrency(), rayCount / MIN_LINES_PER_THREAD, MAX_BATCH_THREADS);
+	if (threadCount <= 1)
+		return hitCount + selector->getCollisionPoints(hitResults, hitFound, rays, rayCount);
+
+	// Split the rest into consecutive parts, lines next to each other in the
+	// batch often share the nodes of a hierarchy.
+	SCollisionBatch batches[MAX_BATCH_THREADS];
+	for (u32 i=0; i<threadCount; ++i)
+	{
+		const u32 start = (u32)((u64)rayCount * i / threadCount);
+		const u32 end = (u32)((u64)rayCount * (i+1) / threadCount);
+		batches[i].Selector = selector;
+		batches[i].HitResults = hitResults + start;
+		batches[i].HitFound = hitFound + start;
+		batches[i].Rays = rays + start;
+		batches[i].RayCount = end - start;
+		batches[i].HitCount = 0;
 	}
 
-	if ( foundIndex >= 0 )
+	// the calling thread traces the first part
+	CThread threads[MAX_BATCH_THREADS];
+	for (u32 i=1; i<threadCount; ++i)
 	{
-		for ( irr::u32 t=0; t<outTriangleInfo.size(); ++t )
-		{
-			if ( outTriangleInfo[t].isIndexInRange(foundIndex) )
-			{
-				hitResult.Node = outTriangleInfo[t].SceneNode;
-				hitResult.MeshBuffer = outTriangleInfo[t].MeshBuffer;
-				hitResult.MaterialIndex = outTriangleInfo[t].MaterialIndex;
-				hitResult.TriangleSelector = outTriangleInfo[t].Selector;
-
-				break;
-			}
-		}
+		if (!threads[i].start(traceCollisionBatch, &batches[i]))
+			batches[i].trace();
+	}
+	batches[0].trace();
 
-		return true;
+	for (u32 i=0; i<threadCount; ++i)
+	{
+		threads[i].join();
+		hitCount += batches[i].HitCount;
 	}
 
-	return false;
+	return hitCount;
+#else
+	return hitCount + selector->getCollisionPoints(hitResults, hitFound, rays, rayCount);
+#endif
 }
 
 //! Collides a moving ellipsoid with a 3d world with gravity and returns
@@ -440,10 +462,8 @@ core::vector3df CSceneCollisionManager::getCollisionResultPosition(
 
 
 bool CSceneCollisionManager::testTriangleIntersection(SCollisionData* colData,
-			const core::triangle3df& triangle)
+			const core::triangle3df& triangle, const core::plane3d<f32>& trianglePlane) const
 {
-	const core::plane3d<f32> trianglePlane = triangle.getPlane();
-
 	// only check front facing polygons
 	if ( !trianglePlane.isFrontFacing(colData->normalizedVelocity) )
 		return false;
@@ -699,7 +719,7 @@ core::vector3df CSceneCollisionManager::collideEllipsoidWithWorld(
 		core::triangle3df& triout,
 		core::vector3df& hitPosition,
 		bool& outFalling,
-		ISceneNode*& outNode)
+		ISceneNode*& outNode) const
 {
 	if (!selector || radius.X == 0.0f || radius.Y == 0.0f || radius.Z == 0.0f)
 		return position;
@@ -722,6 +742,7 @@ core::vector3df CSceneCollisionManager::collideEllipsoidWithWorld(
 
 	// iterate until we have our final position
 
+	collectTriangles(colData);
 	core::vector3df finalPos = collideWithWorld(
 		0, colData, eSpacePosition, eSpaceVelocity);
 
@@ -737,6 +758,7 @@ core::vector3df CSceneCollisionManager::collideEllipsoidWithWorld(
 
 		eSpaceVelocity = gravity/colData.eRadius;
 
+		collectTriangles(colData);
 		finalPos = collideWithWorld(0, colData,
 			finalPos, eSpaceVelocity);
 
@@ -758,8 +780,45 @@ core::vector3df CSceneCollisionManager::collideEllipsoidWithWorld(
 }
 
 
+void CSceneCollisionManager::collectTriangles(SCollisionData& colData) const
+{
+	// get all triangles with which we might collide
+	core::aabbox3d<f32> box(colData.R3Position);
+	box.addInternalPoint(colData.R3Position + colData.R3Velocity);
+	box.MinEdge -= colData.eRadius;
+	box.MaxEdge += colData.eRadius;
+
+	// the selector transforms the triangles into ellipsoid space for us
+	core::matrix4 scaleMatrix;
+	scaleMatrix.setScale(
+			core::vector3df(1.0f / colData.eRadius.X,
+					1.0f / colData.eRadius.Y,
+					1.0f / colData.eRadius.Z));
+
+	// The box around a move usually contains few triangles, so start with
+	// a small buffer and only grow it when it got filled up.
+	const s32 totalTriangleCnt = colData.selector->getTriangleCount();
+	s32 bufferSize = core::min_(totalTriangleCnt, 256);
+	for (;;)
+	{
+		colData.triangles.set_used(bufferSize);
+		colData.triangleInfo.set_used(0);
+		colData.triangleCount = 0;
+		colData.selector->getTriangles(colData.triangles.pointer(), bufferSize, colData.triangleCount, box, &scaleMatrix, true, &colData.triangleInfo);
+
+		if (colData.triangleCount < bufferSize || bufferSize >= totalTriangleCnt)
+			break;
+		bufferSize = core::min_(bufferSize * 4, totalTriangleCnt);
+	}
+
+	colData.planes.set_used(colData.triangleCount);
+	for (s32 i=0; i<colData.triangleCount; ++i)
+		colData.planes[i] = colData.triangles[i].getPlane();
+}
+
+
 core::vector3df CSceneCollisionManager::collideWithWorld(s32 recursionDepth,
-	SCollisionData &colData, const core::vector3df& pos, const core::vector3df& vel)
+	SCollisionData &colData, const core::vector3df& pos, const core::vector3df& vel) const
 {
 	f32 veryCloseDistance = colData.slidingSpeed;
 
@@ -775,41 +834,45 @@ core::vector3df CSceneCollisionManager::collideWithWorld(s32 recursionDepth,
 
 	//------------------ collide with world
 
-	// get all triangles with which we might collide
-	core::aabbox3d<f32> box(colData.R3Position);
-	box.addInternalPoint(colData.R3Position + colData.R3Velocity);
-	box.MinEdge -= colData.eRadius;
-	box.MaxEdge += colData.eRadius;
-
-	s32 totalTriangleCnt = colData.selector->getTriangleCount();
-	Triangles.set_used(totalTriangleCnt);
-
-	core::matrix4 scaleMatrix;
-	scaleMatrix.setScale(
-			core::vector3df(1.0f / colData.eRadius.X,
-					1.0f / colData.eRadius.Y,
-					1.0f / colData.eRadius.Z));
-
-	irr::core::array<SCollisionTriangleRange> outTriangleInfo;
-	s32 triangleCnt = 0;
-	colData.selector->getTriangles(Triangles.pointer(), totalTriangleCnt, triangleCnt, box, &scaleMatrix, true, &outTriangleInfo);
+	// The triangles were collected for the whole move by collectTriangles,
+	// each slide step only moves within that box.
+	// First drop all triangles which are back facing or which the sphere
+	// can't reach during this step, in a loop without branches over the planes.
+	const s32 triangleCnt = colData.triangleCount;
+	colData.candidates.set_used(triangleCnt);
+	u32 candidateCnt = 0;
+	for (s32 i=0; i<triangleCnt; ++i)
+	{
+		const core::plane3d<f32>& plane = colData.planes[i];
+		const f32 startDist = plane.getDistanceTo(colData.basePoint);
+		const f32 endDist = startDist + plane.Normal.dotProduct(colData.velocity);
+
+		// generous for rounding, testTriangleIntersection does the exact test
+		const f32 slack = core::ROUNDING_ERROR_f32 * (1.f + core::abs_(startDist) + core::abs_(endDist));
+		const bool candidate = plane.isFrontFacing(colData.normalizedVelocity)
+			& (core::min_(startDist, endDist) <= 1.f + slack)
+			& (core::max_(startDist, endDist) >= -1.f - slack);
+		colData.candidates[candidateCnt] = i;
+		candidateCnt += candidate ? 1 : 0;
+	}
 
 	// Find closest intersection
 	irr::s32 nearestTriangleIndex = -1;
-	for (s32 i=0; i<triangleCnt; ++i)
+	for (u32 c=0; c<candidateCnt; ++c)
 	{
-		if(testTriangleIntersection(&colData, Triangles[i]))
+		const s32 i = colData.candidates[c];
+		if(testTriangleIntersection(&colData, colData.triangles[i], colData.planes[i]))
 		{
 			nearestTriangleIndex = i;
 		}
 	}
 	if ( nearestTriangleIndex >= 0 )
 	{
-		for ( irr::u32 t=0; t<outTriangleInfo.size(); ++t )
+		for ( irr::u32 t=0; t<colData.triangleInfo.size(); ++t )
 		{
-			if ( outTriangleInfo[t].isIndexInRange(nearestTriangleIndex) )
+			if ( colData.triangleInfo[t].isIndexInRange(nearestTriangleIndex) )
 			{
-				colData.node = outTriangleInfo[t].SceneNode;
+				colData.node = colData.triangleInfo[t].SceneNode;
 				break;
 			}
 		}
@@ -45,6 +45,10 @@ namespace scene
 		virtual bool getCollisionPoint(SCollisionHit& hitResult, const core::line3d<f32>& ray,
 				ITriangleSelector* selector)  IRR_OVERRIDE;
 
+		//! Finds the nearest collision points of many lines with lots of triangles.
+		virtual u32 getCollisionPoints(SCollisionHit* hitResults, bool* hitFound,
+				const core::line3d<f32>* rays, u32 rayCount, ITriangleSelector* selector) IRR_OVERRIDE;
+
 		//! Collides a moving ellipsoid with a 3d world with gravity and returns
 		//! the resulting new position of the ellipsoid.
 		virtual core::vector3df getCollisionResultPosition(
@@ -81,7 +85,7 @@ namespace scene
 		//! recursive method for going through all scene nodes
 		void getPickedNodeBB(ISceneNode* root, core::line3df& ray, s32 bits,
 					bool bNoDebugObjects,
-					f32& outbestdistance, ISceneNode*& outbestnode);
+					f32& outbestdistance, ISceneNode*& outbestnode) const;
 
 		//! recursive method for going through all scene nodes
 		void getPickedNodeFromBBAndSelector(
@@ -90,7 +94,7 @@ namespace scene
 						core::line3df & ray,
 						s32 bits,
 						bool noDebugObjects,
-						f32 & outBestDistanceSquared);
+						f32 & outBestDistanceSquared) const;
 
 
 		struct SCollisionData
@@ -115,15 +119,28 @@ namespace scene
 			f32 slidingSpeed;
 
 			ITriangleSelector* selector;
+
+			// triangle buffer, per query so several threads can collide at once
+			core::array<core::triangle3df> triangles;
+			core::array<core::plane3df> planes;
+			core::array<SCollisionTriangleRange> triangleInfo;
+			s32 triangleCount;
+
+			// triangles which can be hit in the current slide step
+			core::array<s32> candidates;
 		};
 
 		//! Tests the current collision data against an individual triangle.
 		/**
 		\param colData: the collision data.
 		\param triangle: the triangle to test against.
+		\param trianglePlane: the plane of the triangle.
 		\return true if the triangle is hit (and is the closest hit), false otherwise */
 		bool testTriangleIntersection(SCollisionData* colData,
-			const core::triangle3df& triangle);
+			const core::triangle3df& triangle, const core::plane3d<f32>& trianglePlane) const;
+
+		//! Gets the triangles the ellipsoid can touch during the whole move, in ellipsoid space
+		void collectTriangles(SCollisionData& colData) const;
 
 		//! recursive method for doing collision response
 		core::vector3df collideEllipsoidWithWorld(ITriangleSelector* selector,
@@ -133,16 +150,15 @@ namespace scene
 			const core::vector3df& gravity, core::triangle3df& triout,
 			core::vector3df& hitPosition,
 			bool& outFalling,
-			ISceneNode*& outNode);
+			ISceneNode*& outNode) const;
 
 		core::vector3df collideWithWorld(s32 recursionDepth, SCollisionData &colData,
-			const core::vector3df& pos, const core::vector3df& vel);
+			const core::vector3df& pos, const core::vector3df& vel) const;
 
 		inline bool getLowestRoot(f32 a, f32 b, f32 c, f32 maxR, f32* root) const;
 
 		ISceneManager* SceneManager;
 		video::IVideoDriver* Driver;
-		core::array<core::triangle3df> Triangles; // triangle buffer
 	};
 
 
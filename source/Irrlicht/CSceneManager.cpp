@@ -30,6 +30,10 @@
 #include "CIrrMeshFileLoader.h"
 #endif
 
+#ifdef _IRR_COMPILE_WITH_IRR_BINARY_MESH_LOADER_
+#include "CIrrBinaryMeshFileLoader.h"
+#endif
+
 #ifdef _IRR_COMPILE_WITH_BSP_LOADER_
 #include "CBSPMeshFileLoader.h"
 #endif
@@ -138,6 +142,10 @@
 #include "CB3DMeshWriter.h"
 #endif
 
+#ifdef _IRR_COMPILE_WITH_IRR_BINARY_MESH_WRITER_
+#include "CIrrBinaryMeshWriter.h"
+#endif
+
 #ifdef _IRR_COMPILE_WITH_CUBE_SCENENODE_
 #include "CCubeSceneNode.h"
 #endif // _IRR_COMPILE_WITH_CUBE_SCENENODE_
@@ -186,6 +194,7 @@
 #include "CSceneCollisionManager.h"
 #include "CTriangleSelector.h"
 #include "COctreeTriangleSelector.h"
+#include "CBVHTriangleSelector.h"
 #include "CTriangleBBSelector.h"
 #include "CMetaTriangleSelector.h"
 #ifdef _IRR_COMPILE_WITH_TERRAIN_SCENENODE_
@@ -266,7 +275,7 @@ CSceneManager::CSceneManager(video::IVideoDriver* driver, io::IFileSystem* fs,
 	// shallow copies from the previous manager if there is one.
 
 	#ifdef _IRR_COMPILE_WITH_STL_LOADER_
-	MeshLoaderList.push_back(new CSTLMeshFileLoader());
+	MeshLoaderList.push_back(new CSTLMeshFileLoader(this));
 	#endif
 	#ifdef _IRR_COMPILE_WITH_PLY_LOADER_
 	MeshLoaderList.push_back(new CPLYMeshFileLoader(this));
@@ -307,6 +316,9 @@ CSceneManager::CSceneManager(video::IVideoDriver* driver, io::IFileSystem* fs,
 	#ifdef _IRR_COMPILE_WITH_IRR_MESH_LOADER_
 	MeshLoaderList.push_back(new CIrrMeshFileLoader(this, FileSystem));
 	#endif
+	#ifdef _IRR_COMPILE_WITH_IRR_BINARY_MESH_LOADER_
+	MeshLoaderList.push_back(new CIrrBinaryMeshFileLoader(this, FileSystem));
+	#endif
 	#ifdef _IRR_COMPILE_WITH_BSP_LOADER_
 	MeshLoaderList.push_back(new CBSPMeshFileLoader(this, FileSystem));
 	#endif
@@ -1990,21 +2002,50 @@ ITriangleSelector* CSceneManager::createTriangleSelectorFromBoundingBox(ISceneNo
 
 //! Creates a simple ITriangleSelector, based on a mesh.
 ITriangleSelector* CSceneManager::createOctreeTriangleSelector(IMesh* mesh,
-							ISceneNode* node, s32 minimalPolysPerNode)
+							ISceneNode* node, s32 minimalPolysPerNode, io::IReadFile* accelerationData)
 {
 	if (!mesh)
 		return 0;
 
-	return new COctreeTriangleSelector(mesh, node, minimalPolysPerNode);
+	return new COctreeTriangleSelector(mesh, node, minimalPolysPerNode, accelerationData);
 }
 
 ITriangleSelector* CSceneManager::createOctreeTriangleSelector(IMeshBuffer* meshBuffer, irr::u32 materialIndex,
-			ISceneNode* node, s32 minimalPolysPerNode)
+			ISceneNode* node, s32 minimalPolysPerNode, io::IReadFile* accelerationData)
 {
 	if ( !meshBuffer)
 		return 0;
 
-	return new COctreeTriangleSelector(meshBuffer, materialIndex, node, minimalPolysPerNode);
+	return new COctreeTriangleSelector(meshBuffer, materialIndex, node, minimalPolysPerNode, accelerationData);
+}
+
+//! Creates a ITriangleSelector organized in a bounding volume hierarchy, based on a mesh.
+ITriangleSelector* CSceneManager::createBVHTriangleSelector(IMesh* mesh,
+			ISceneNode* node, bool separateMeshbuffers, u32 maxTrianglesPerLeaf,
+			io::IReadFile* accelerationData)
+{
+	if (!mesh)
+		return 0;
+
+	return new CBVHTriangleSelector(mesh, node, separateMeshbuffers, maxTrianglesPerLeaf, accelerationData);
+}
+
+ITriangleSelector* CSceneManager::createBVHTriangleSelector(IMeshBuffer* meshBuffer, irr::u32 materialIndex,
+			ISceneNode* node, u32 maxTrianglesPerLeaf, io::IReadFile* accelerationData)
+{
+	if ( !meshBuffer)
+		return 0;
+
+	return new CBVHTriangleSelector(meshBuffer, materialIndex, node, maxTrianglesPerLeaf, accelerationData);
+}
+
+ITriangleSelector* CSceneManager::createBVHTriangleSelector(IAnimatedMeshSceneNode* node,
+			bool separateMeshbuffers, u32 maxTrianglesPerLeaf)
+{
+	if (!node || !node->getMesh())
+		return 0;
+
+	return new CBVHTriangleSelector(node, separateMeshbuffers, maxTrianglesPerLeaf);
 }
 
 //! Creates a meta triangle selector.
@@ -2686,6 +2727,13 @@ IMeshWriter* CSceneManager::createMeshWriter(EMESH_WRITER_TYPE type)
 #else
 		return 0;
 #endif
+
+	case EMWT_IRR_BINARY_MESH:
+#ifdef _IRR_COMPILE_WITH_IRR_BINARY_MESH_WRITER_
+		return new CIrrBinaryMeshWriter();
+#else
+		return 0;
+#endif
 	}
 
 	return 0;
@@ -360,11 +360,24 @@ namespace scene
 
 		//! Creates a simple ITriangleSelector, based on a mesh.
 		virtual ITriangleSelector* createOctreeTriangleSelector(IMesh* mesh,
-			ISceneNode* node, s32 minimalPolysPerNode) IRR_OVERRIDE;
+			ISceneNode* node, s32 minimalPolysPerNode, io::IReadFile* accelerationData) IRR_OVERRIDE;
 
 		//! Creates a simple ITriangleSelector, based on a meshbuffer.
 		virtual ITriangleSelector* createOctreeTriangleSelector(IMeshBuffer* meshBuffer, irr::u32 materialIndex,
-			ISceneNode* node, s32 minimalPolysPerNode=32) IRR_OVERRIDE;
+			ISceneNode* node, s32 minimalPolysPerNode, io::IReadFile* accelerationData) IRR_OVERRIDE;
+
+		//! Creates a ITriangleSelector organized in a bounding volume hierarchy, based on a mesh.
+		virtual ITriangleSelector* createBVHTriangleSelector(IMesh* mesh,
+			ISceneNode* node, bool separateMeshbuffers, u32 maxTrianglesPerLeaf,
+			io::IReadFile* accelerationData) IRR_OVERRIDE;
+
+		//! Creates a ITriangleSelector organized in a bounding volume hierarchy, based on a meshbuffer.
+		virtual ITriangleSelector* createBVHTriangleSelector(IMeshBuffer* meshBuffer, irr::u32 materialIndex,
+			ISceneNode* node, u32 maxTrianglesPerLeaf, io::IReadFile* accelerationData) IRR_OVERRIDE;
+
+		//! Creates a ITriangleSelector organized in a bounding volume hierarchy, based on an animated mesh scene node.
+		virtual ITriangleSelector* createBVHTriangleSelector(IAnimatedMeshSceneNode* node,
+			bool separateMeshbuffers, u32 maxTrianglesPerLeaf) IRR_OVERRIDE;
 
 		//! Creates a simple dynamic ITriangleSelector, based on a axis aligned bounding box.
 		virtual ITriangleSelector* createTriangleSelectorFromBoundingBox(
@@ -387,6 +387,8 @@ void CSoftwareDriver::drawVertexPrimitiveList16(const void* vertices, u32 vertex
 									((S3DVertexTangents*)vertices)[indexList[i]].Color);
 						}
 						break;
+					default:
+						break;
 				}
 			}
 			return;
@@ -409,6 +411,8 @@ void CSoftwareDriver::drawVertexPrimitiveList16(const void* vertices, u32 vertex
 						((S3DVertexTangents*)vertices)[indexList[0]].Pos,
 						((S3DVertexTangents*)vertices)[indexList[primitiveCount-1]].Color);
 					break;
+				default:
+					break;
 			}
 			return;
 		case scene::EPT_LINES:
@@ -439,6 +443,8 @@ void CSoftwareDriver::drawVertexPrimitiveList16(const void* vertices, u32 vertex
 									((S3DVertexTangents*)vertices)[indexList[i]].Color);
 						}
 						break;
+					default:
+						break;
 				}
 			}
 			return;
@@ -473,6 +479,8 @@ void CSoftwareDriver::drawVertexPrimitiveList16(const void* vertices, u32 vertex
 		case EVT_TANGENTS:
 			drawClippedIndexedTriangleListT((S3DVertexTangents*)vertices, vertexCount, indexPointer, primitiveCount);
 			break;
+		default:
+			break;
 	}
 }
 
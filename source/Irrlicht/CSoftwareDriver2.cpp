@@ -1443,6 +1443,8 @@ void CBurningVideoDriver::VertexCache_map_source_format()
 
 	VertexCache.mem.resize(VERTEXCACHE_ELEMENT * 2);
 	VertexCache.vType = E4VT_STANDARD;
+	VertexCache.quantization = 0;
+	VertexCache.quantizedTangents = false;
 
 	Clipper.resize(VERTEXCACHE_ELEMENT * 2);
 	Clipper_temp.resize(VERTEXCACHE_ELEMENT * 2);
@@ -1466,7 +1468,17 @@ void CBurningVideoDriver::VertexCache_fill(const u32 sourceIndex, const u32 dest
 	u8* burning_restrict source;
 	s4DVertex* burning_restrict dest;
 
-	source = (u8*)VertexCache.vertices + (sourceIndex * VertexCache.vSize[VertexCache.vType].Pitch);
+	if (VertexCache.quantization)
+	{
+		// decode into a float vertex of the type the source format was mapped to
+		if (VertexCache.quantizedTangents)
+			VertexCache.quantization->decode(((const S3DVertexQuantizedTangents*)VertexCache.vertices)[sourceIndex], VertexCache.decoded);
+		else
+			VertexCache.quantization->decode(((const S3DVertexQuantized*)VertexCache.vertices)[sourceIndex], VertexCache.decoded);
+		source = (u8*)&VertexCache.decoded;
+	}
+	else
+		source = (u8*)VertexCache.vertices + (sourceIndex * VertexCache.vSize[VertexCache.vType].Pitch);
 
 	// it's a look ahead so we never hit it..
 	// but give priority...
@@ -2110,6 +2122,28 @@ int CBurningVideoDriver::VertexCache_reset(const void* vertices, u32 vertexCount
 }
 
 
+//! Draws a mesh buffer, quantized vertices are decoded while transforming them
+void CBurningVideoDriver::drawMeshBuffer(const scene::IMeshBuffer* mb)
+{
+	if (!mb)
+		return;
+
+	const E_VERTEX_TYPE vType = mb->getVertexType();
+	if (vType != EVT_QUANTIZED && vType != EVT_QUANTIZED_TANGENTS)
+	{
+		CNullDriver::drawMeshBuffer(mb);
+		return;
+	}
+
+	// only the vertices the vertex cache misses get decoded
+	VertexCache.quantization = mb->getVertexQuantization();
+	VertexCache.quantizedTangents = vType == EVT_QUANTIZED_TANGENTS;
+	drawVertexPrimitiveList(mb->getVertices(), mb->getVertexCount(), mb->getIndices(), mb->getPrimitiveCount(),
+		VertexCache.quantizedTangents ? EVT_TANGENTS : EVT_STANDARD, mb->getPrimitiveType(), mb->getIndexType());
+	VertexCache.quantization = 0;
+}
+
+
 //! draws a vertex primitive list
 void CBurningVideoDriver::drawVertexPrimitiveList(const void* vertices, u32 vertexCount,
 	const void* indexList, u32 primitiveCount,
@@ -2419,6 +2453,7 @@ void CBurningVideoDriver::setMaterial(const SMaterial& material)
 	OverrideMaterial.apply(Material.org);
 
 	const SMaterial& in = Material.org;
+	touchTextures(in);
 
 	// ---------- Notify Shader
 		// unset old material
@@ -3033,6 +3068,8 @@ void CBurningVideoDriver::setRenderStates2DMode(const video::SColor& color, cons
 	{
 		setMaterial(Material.mat2D);
 	}
+	else
+		touchTextures(Material.mat2D);
 	if (CurrentShader)
 	{
 		CurrentShader->setPrimitiveColor(color.color);
@@ -3529,6 +3566,32 @@ ITexture* CBurningVideoDriver::createDeviceDependentTextureCubemap(const io::pat
 	return 0;
 }
 
+//! releases the image data of a texture to stay within the texture memory budget
+bool CBurningVideoDriver::evictTextureData(ITexture* texture)
+{
+	if (texture->getDriverType() != EDT_BURNINGSVIDEO)
+		return false;
+
+	// the shaders keep the last textures locked
+	for (u32 i = 0; i < MATERIAL_MAX_TEXTURES; ++i)
+	{
+		if (Material.org.getTexture(i) == texture)
+			return false;
+	}
+
+	((CSoftwareTexture2*)texture)->evict();
+	return true;
+}
+
+//! creates the image data of an evicted texture again
+bool CBurningVideoDriver::restoreTextureData(ITexture* texture, IImage* image)
+{
+	if (texture->getDriverType() != EDT_BURNINGSVIDEO)
+		return false;
+
+	return ((CSoftwareTexture2*)texture)->restore(image);
+}
+
 //! Returns the maximum amount of primitives (mostly vertices) which
 //! the device is able to render with one drawIndexedTriangleList
 //! call.
@@ -102,6 +102,9 @@ namespace video
 			const void* indexList, u32 primitiveCount,
 			E_VERTEX_TYPE vType, scene::E_PRIMITIVE_TYPE pType, E_INDEX_TYPE iType) IRR_OVERRIDE;
 
+		//! Draws a mesh buffer, quantized vertices are decoded while transforming them
+		virtual void drawMeshBuffer(const scene::IMeshBuffer* mb) IRR_OVERRIDE;
+
 
 		//! draws an 2d image
 		//virtual void draw2DImage(const video::ITexture* texture, const core::position2d<s32>& destPos, bool useAlphaChannelOfTexture) IRR_OVERRIDE;
@@ -314,6 +317,12 @@ namespace video
 		virtual ITexture* createDeviceDependentTexture(const io::path& name, IImage* image) IRR_OVERRIDE;
 		virtual ITexture* createDeviceDependentTextureCubemap(const io::path& name, const core::array<IImage*>& image) IRR_OVERRIDE;
 
+		//! releases the image data of a texture to stay within the texture memory budget
+		virtual bool evictTextureData(ITexture* texture) IRR_OVERRIDE;
+
+		//! creates the image data of an evicted texture again
+		virtual bool restoreTextureData(ITexture* texture, IImage* image) IRR_OVERRIDE;
+
 		video::CImage* BackBuffer;
 		video::IImagePresenter* Presenter;
 
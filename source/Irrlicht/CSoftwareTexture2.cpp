@@ -71,6 +71,15 @@ CSoftwareTexture2::CSoftwareTexture2(IImage* image, const io::path& name, u32 fl
 	for (size_t i = 0; i < array_size(MipMap); ++i) MipMap[i] = 0;
 	if (!image) return;
 
+	loadImage(image);
+}
+
+
+//! creates the mipmaps from an image
+void CSoftwareTexture2::loadImage(IImage* image)
+{
+	const io::path& name = getName().getPath();
+
 	OriginalSize = image->getDimension();
 	OriginalColorFormat = image->getColorFormat();
 
@@ -162,6 +171,13 @@ CSoftwareTexture2::CSoftwareTexture2(IImage* image, const io::path& name, u32 fl
 
 //! destructor
 CSoftwareTexture2::~CSoftwareTexture2()
+{
+	evict();
+}
+
+
+//! releases the image data
+void CSoftwareTexture2::evict()
 {
 	for (size_t i = 0; i < array_size(MipMap); ++i)
 	{
@@ -171,6 +187,37 @@ CSoftwareTexture2::~CSoftwareTexture2()
 			MipMap[i] = 0;
 		}
 	}
+	MipMapLOD = 0;
+}
+
+
+//! creates the image data again after evict()
+bool CSoftwareTexture2::restore(IImage* image)
+{
+	if (!MipMap[0])
+		loadImage(image);
+	return MipMap[0] != 0;
+}
+
+
+//! loads the image data released by evict() again
+void CSoftwareTexture2::makeResident() const
+{
+	CSoftwareTexture2* self = const_cast<CSoftwareTexture2*>(this);
+	if (Driver->reloadTexture(self))
+		return;
+
+	// keep the texture usable when the file is gone
+	self->MipMap[0] = new CImage(ColorFormat, core::dimension2du(MipMap0_Area[0], MipMap0_Area[1]));
+	self->MipMap[0]->fill(0);
+	self->regenerateMipMapLevels(0);
+}
+
+
+//! the data no longer matches the file, so it must not be released
+void CSoftwareTexture2::keepData()
+{
+	Driver->keepTextureData(this);
 }
 
 
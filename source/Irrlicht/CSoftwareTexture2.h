@@ -68,6 +68,11 @@ public:
 	virtual void* lock(E_TEXTURE_LOCK_MODE mode, u32 mipmapLevel, u32 layer, E_TEXTURE_LOCK_FLAGS lockFlags = ETLF_FLIP_Y_UP_RTT) IRR_OVERRIDE
 #endif
 	{
+		if (!MipMap[0])
+			makeResident();
+		if (mode != ETLM_READ_ONLY)
+			keepData();
+
 		if (Flags & GEN_MIPMAP)
 		{
 			//called from outside. must test
@@ -101,15 +106,25 @@ public:
 	//! returns unoptimized surface (misleading name. burning can scale down originalimage)
 	virtual CImage* getImage() const
 	{
+		if (!MipMap[0])
+			makeResident();
 		return MipMap[0];
 	}
 
 	//! returns texture surface
 	virtual CImage* getTexture() const
 	{
+		if (!MipMap[0])
+			makeResident();
 		return MipMap[MipMapLOD];
 	}
 
+	//! releases the image data, it is loaded again on the next use
+	void evict();
+
+	//! creates the image data again after evict()
+	bool restore(IImage* image);
+
 	//precalculated dimx-1/dimx*0.5f
 	const CSoftwareTexture2_Bound& getTexBound() const
 	{
@@ -146,6 +161,15 @@ public:
 private:
 	void calcDerivative();
 
+	//! creates the mipmaps from an image
+	void loadImage(IImage* image);
+
+	//! loads the image data released by evict() again
+	void makeResident() const;
+
+	//! the data no longer matches the file, so it must not be released
+	void keepData();
+
 	//! controls MipmapSelection. relation between drawn area and image size
 	u32 MipMapLOD; // 0 .. original Texture pot -SOFTWARE_DRIVER_2_MIPMAPPING_MAX
 	u32 Flags; //eTex2Flags
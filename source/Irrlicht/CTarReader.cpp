@@ -132,6 +132,7 @@ CTarReader::CTarReader(IReadFile* file, bool ignoreCase, bool ignorePaths)
 	if (File)
 	{
 		File->grab();
+		ReadHandles.set(File);
 
 		// fill the file list
 		populateFileList();
@@ -247,7 +248,7 @@ IReadFile* CTarReader::createAndOpenFile(u32 index)
 		return 0;
 
 	const SFileListEntry &entry = Files[index];
-	return createLimitReadFile( entry.FullName, File, entry.Offset, entry.Size );
+	return createLimitReadFile( entry.FullName, ReadHandles.get(), entry.Offset, entry.Size );
 }
 
 } // end namespace io
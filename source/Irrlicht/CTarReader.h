@@ -11,6 +11,7 @@
 
 #include "IReferenceCounted.h"
 #include "IReadFile.h"
+#include "CPerThreadReadFile.h"
 #include "irrArray.h"
 #include "irrString.h"
 #include "IFileSystem.h"
@@ -127,6 +128,9 @@ namespace io
 		u32 populateFileList();
 
 		IReadFile* File;
+
+		//! Handles to File for the threads opening entries
+		CPerThreadReadFile ReadHandles;
 	};
 
 } // end namespace io
@@ -8,6 +8,8 @@
 
 #include "CTerrainTriangleSelector.h"
 #include "CTerrainSceneNode.h"
+#include "CTriangleSelector.h"
+#include "SMesh.h"
 #include "os.h"
 
 namespace irr
@@ -16,9 +18,44 @@ namespace scene
 {
 
 
+namespace
+{
+	//! Clips the line parameters to a slab, false when nothing is left
+	inline bool clipSlab(f32 start, f32 dir, f32 invDir, f32 low, f32 high, f32& tMin, f32& tMax)
+	{
+		if (dir == 0.f)
+			return start >= low && start <= high;
+
+		f32 t0 = (low - start) * invDir;
+		f32 t1 = (high - start) * invDir;
+		if (t0 > t1)
+			core::swap(t0, t1);
+		tMin = core::max_(tMin, t0);
+		tMax = core::min_(tMax, t1);
+		return tMin <= tMax;
+	}
+}
+
+
+//! State of a line walking the height grid
+struct CTerrainTriangleSelector::SGridTrace
+{
+	core::vector3df Start; // in grid space
+	core::vector3df Dir;
+	core::vector3df InvDir;
+
+	//! Tests the triangles of the cells when set, cells behind the nearest hit are skipped
+	SNearestLineHit* Hit;
+
+	//! Receives the quads of all cells when set
+	core::array<u32>* Quads;
+};
+
+
 //! constructor
 CTerrainTriangleSelector::CTerrainTriangleSelector ( ITerrainSceneNode* node, s32 LOD )
-	: SceneNode(node)
+	: SceneNode(node), HeightTolerance(0.f), Size(0), PatchSize(0), PatchCount(0),
+	TotalTriangles(0), HasGrid(false)
 {
 	#ifdef _DEBUG
 	setDebugName ("CTerrainTriangleSelector");
@@ -31,50 +68,193 @@ CTerrainTriangleSelector::CTerrainTriangleSelector ( ITerrainSceneNode* node, s3
 //! destructor
 CTerrainTriangleSelector::~CTerrainTriangleSelector()
 {
-	TrianglePatches.TrianglePatchArray.clear();
 }
 
 
 //! Clears and sets triangle data
 void CTerrainTriangleSelector::setTriangleData(ITerrainSceneNode* node, s32 LOD)
 {
+	const CTerrainSceneNode* terrain = static_cast<CTerrainSceneNode*>(node);
+	const CTerrainSceneNode::STerrainData& data = terrain->TerrainData;
+
+	// Clear current data
+	Positions.clear();
+	PatchLODs.clear();
+	HeightRanges.clear();
+	LevelOffsets.clear();
+	LevelSizes.clear();
+	TotalTriangles = 0;
+	HasGrid = false;
+	BoundingBox.reset(0.f, 0.f, 0.f);
+
+	Size = data.Size;
+	PatchSize = data.CalcPatchSize;
+	PatchCount = data.PatchCount;
+
+	if (!terrain->Mesh->getMeshBufferCount() || Size < 2 || PatchSize < 1 || PatchCount < 1)
+		return;
+
 	// Get pointer to the GeoMipMaps vertices
 	const video::S3DVertex2TCoords* vertices = static_cast<const video::S3DVertex2TCoords*>(node->getRenderBuffer()->getVertices());
 
-	// Clear current data
-	const s32 count = (static_cast<CTerrainSceneNode*>(node))->TerrainData.PatchCount;
-	TrianglePatches.TotalTriangles = 0;
-	TrianglePatches.NumPatches = count*count;
+	const u32 vertexCount = (u32)(Size * Size);
+	Positions.set_used(vertexCount);
+	BoundingBox.reset(vertices[0].Pos);
+	for (u32 i=0; i<vertexCount; ++i)
+	{
+		Positions[i] = vertices[i].Pos;
+		BoundingBox.addInternalPoint(vertices[i].Pos);
+	}
 
-	TrianglePatches.TrianglePatchArray.reallocate(TrianglePatches.NumPatches);
-	for (s32 o=0; o<TrianglePatches.NumPatches; ++o)
-		TrianglePatches.TrianglePatchArray.push_back(SGeoMipMapTrianglePatch());
+	// The patches keep the level of detail getIndicesForPatch() would use
+	const s32 patchTotal = PatchCount * PatchCount;
+	PatchLODs.set_used(patchTotal);
+	for (s32 p=0; p<patchTotal; ++p)
+	{
+		s32 lod = LOD;
+		if (LOD == -1)
+			lod = core::max_(data.Patches[p].CurrentLOD, -1);
+		else if (LOD < 0 || LOD > data.MaxLOD - 1)
+			lod = -1;
+		PatchLODs[p] = lod;
+	}
 
-	core::triangle3df tri;
-	core::array<u32> indices;
-	s32 tIndex = 0;
-	for(s32 x = 0; x < count; ++x )
+	for (s32 p=0; p<patchTotal; ++p)
+		TotalTriangles += getPatchTriangleCount(p);
+
+	// The untransformed mesh has vertex x, z at (x, height, z). Rotation
+	// and scale give the grid axes, the first vertex its origin.
+	const IMeshBuffer* mb = terrain->Mesh->getMeshBuffer(0);
+	core::matrix4 rotation;
+	rotation.setRotationDegrees(data.Rotation);
+	core::vector3df axisX(data.Scale.X, 0.f, 0.f);
+	core::vector3df axisY(0.f, data.Scale.Y, 0.f);
+	core::vector3df axisZ(0.f, 0.f, data.Scale.Z);
+	rotation.inverseRotateVect(axisX);
+	rotation.inverseRotateVect(axisY);
+	rotation.inverseRotateVect(axisZ);
+	const core::vector3df& first = mb->getPosition(0);
+	const core::vector3df origin = Positions[0] - axisX * first.X - axisY * first.Y - axisZ * first.Z;
+
+	core::matrix4 gridToWorld;
+	gridToWorld[0] = axisX.X; gridToWorld[1] = axisX.Y; gridToWorld[2] = axisX.Z;
+	gridToWorld[4] = axisY.X; gridToWorld[5] = axisY.Y; gridToWorld[6] = axisY.Z;
+	gridToWorld[8] = axisZ.X; gridToWorld[9] = axisZ.Y; gridToWorld[10] = axisZ.Z;
+	gridToWorld[12] = origin.X; gridToWorld[13] = origin.Y; gridToWorld[14] = origin.Z;
+
+	// Without a grid, queries test all triangles
+	HasGrid = gridToWorld.getInverse(WorldToGrid);
+	if (!HasGrid)
+		return;
+
+	// Tree levels from single cells up to one node for the whole grid
+	s32 levelSize = Size - 1;
+	u32 nodeCount = 0;
+	while (true)
 	{
-		for(s32 z = 0; z < count; ++z )
-		{
-			TrianglePatches.TrianglePatchArray[tIndex].NumTriangles = 0;
-			TrianglePatches.TrianglePatchArray[tIndex].Box = node->getBoundingBox( x, z );
-			u32 indexCount = node->getIndicesForPatch( indices, x, z, LOD );
+		LevelOffsets.push_back(nodeCount);
+		LevelSizes.push_back(levelSize);
+		nodeCount += (u32)(levelSize * levelSize);
+		if (levelSize == 1 || LevelSizes.size() == MAX_LEVELS)
+			break;
+		levelSize = (levelSize + 1) / 2;
+	}
+	if (levelSize != 1)
+	{
+		HasGrid = false;
+		return;
+	}
+
+	HeightRanges.set_used(nodeCount * 2);
+	for (u32 i=0; i<nodeCount; ++i)
+	{
+		HeightRanges[i*2] = FLT_MAX;
+		HeightRanges[i*2+1] = -FLT_MAX;
+	}
 
-			TrianglePatches.TrianglePatchArray[tIndex].Triangles.reallocate(indexCount/3);
-			for(u32 i = 0; i < indexCount; i += 3 )
+	// Cells get the height range of all triangles reaching over them. At
+	// lower detail a triangle spans several cells, at borders to patches
+	// with less detail it stretches along the border.
+	f32 minHeight = FLT_MAX;
+	f32 maxHeight = -FLT_MAX;
+	const s32 cells = Size - 1;
+	s32 indices[6];
+	for (s32 p=0; p<patchTotal; ++p)
+	{
+		if (PatchLODs[p] < 0)
+			continue;
+
+		const s32 step = 1 << PatchLODs[p];
+		for (s32 z=0; z<PatchSize; z+=step)
+		{
+			for (s32 x=0; x<PatchSize; x+=step)
 			{
-				tri.pointA = vertices[indices[i+0]].Pos;
-				tri.pointB = vertices[indices[i+1]].Pos;
-				tri.pointC = vertices[indices[i+2]].Pos;
-				TrianglePatches.TrianglePatchArray[tIndex].Triangles.push_back(tri);
-				++TrianglePatches.TrianglePatchArray[tIndex].NumTriangles;
+				getQuadIndices(p, x, z, indices);
+				for (u32 t=0; t<6; t+=3)
+				{
+					s32 cellMinX = Size, cellMinZ = Size, cellMaxX = 0, cellMaxZ = 0;
+					f32 low = FLT_MAX;
+					f32 high = -FLT_MAX;
+					for (u32 v=t; v<t+3; ++v)
+					{
+						const s32 vx = indices[v] / Size;
+						const s32 vz = indices[v] % Size;
+						cellMinX = core::min_(cellMinX, vx);
+						cellMaxX = core::max_(cellMaxX, vx);
+						cellMinZ = core::min_(cellMinZ, vz);
+						cellMaxZ = core::max_(cellMaxZ, vz);
+
+						const f32 height = mb->getPosition(indices[v]).Y;
+						low = core::min_(low, height);
+						high = core::max_(high, height);
+					}
+					minHeight = core::min_(minHeight, low);
+					maxHeight = core::max_(maxHeight, high);
+
+					cellMaxX = core::min_(core::max_(cellMaxX, cellMinX + 1), cells);
+					cellMaxZ = core::min_(core::max_(cellMaxZ, cellMinZ + 1), cells);
+					for (s32 cx=cellMinX; cx<cellMaxX; ++cx)
+					{
+						for (s32 cz=cellMinZ; cz<cellMaxZ; ++cz)
+						{
+							f32* range = &HeightRanges[(cx * cells + cz) * 2];
+							range[0] = core::min_(range[0], low);
+							range[1] = core::max_(range[1], high);
+						}
+					}
+				}
 			}
+		}
+	}
 
-			TrianglePatches.TotalTriangles += TrianglePatches.TrianglePatchArray[tIndex].NumTriangles;
-			++tIndex;
+	for (u32 level=1; level<LevelSizes.size(); ++level)
+	{
+		const s32 childSize = LevelSizes[level-1];
+		const s32 size = LevelSizes[level];
+		const f32* children = &HeightRanges[LevelOffsets[level-1] * 2];
+		f32* nodes = &HeightRanges[LevelOffsets[level] * 2];
+		for (s32 nx=0; nx<size; ++nx)
+		{
+			for (s32 nz=0; nz<size; ++nz)
+			{
+				f32 low = FLT_MAX;
+				f32 high = -FLT_MAX;
+				for (s32 cx=nx*2; cx<core::min_(nx*2+2, childSize); ++cx)
+				{
+					for (s32 cz=nz*2; cz<core::min_(nz*2+2, childSize); ++cz)
+					{
+						low = core::min_(low, children[(cx * childSize + cz) * 2]);
+						high = core::max_(high, children[(cx * childSize + cz) * 2 + 1]);
+					}
+				}
+				nodes[(nx * size + nz) * 2] = low;
+				nodes[(nx * size + nz) * 2 + 1] = high;
+			}
 		}
 	}
+
+	// grid and world positions are rounded differently
+	HeightTolerance = (maxHeight > minHeight ? maxHeight - minHeight : 1.f) * 0.001f + 0.001f;
 }
 
 
@@ -84,11 +264,6 @@ void CTerrainTriangleSelector::getTriangles(core::triangle3df* triangles,
 			const core::matrix4* transform, bool useNodeTransform, 
 			irr::core::array<SCollisionTriangleRange>* outTriangleInfo) const
 {
-	s32 count = TrianglePatches.TotalTriangles;
-
-	if (count > arraySize)
-		count = arraySize;
-
 	core::matrix4 mat;
 
 	if (transform)
@@ -96,19 +271,15 @@ void CTerrainTriangleSelector::getTriangles(core::triangle3df* triangles,
 
 	s32 tIndex = 0;
 
-	for (s32 i=0; i<TrianglePatches.NumPatches; ++i)
+	for (s32 p=0; p<(s32)PatchLODs.size() && tIndex < arraySize; ++p)
 	{
-		if (tIndex + TrianglePatches.TrianglePatchArray[i].NumTriangles <= count)
-			for (s32 j=0; j<TrianglePatches.TrianglePatchArray[i].NumTriangles; ++j)
-			{
-				triangles[tIndex] = TrianglePatches.TrianglePatchArray[i].Triangles[j];
+		if (PatchLODs[p] < 0)
+			continue;
 
-				mat.transformVect(triangles[tIndex].pointA);
-				mat.transformVect(triangles[tIndex].pointB);
-				mat.transformVect(triangles[tIndex].pointC);
-
-				++tIndex;
-			}
+		const s32 step = 1 << PatchLODs[p];
+		for (s32 z=0; z<PatchSize; z+=step)
+			for (s32 x=0; x<PatchSize; x+=step)
+				addQuadTriangles(getQuadKey(p, x, z), triangles, arraySize, tIndex, mat, 0);
 	}
 
 	if ( outTriangleInfo )
@@ -131,11 +302,6 @@ void CTerrainTriangleSelector::getTriangles(core::triangle3df* triangles,
 		const core::matrix4* transform, bool useNodeTransform, 
 		irr::core::array<SCollisionTriangleRange>* outTriangleInfo) const
 {
-	s32 count = TrianglePatches.TotalTriangles;
-
-	if (count > arraySize)
-		count = arraySize;
-
 	core::matrix4 mat;
 
 	if (transform)
@@ -143,20 +309,37 @@ void CTerrainTriangleSelector::getTriangles(core::triangle3df* triangles,
 
 	s32 tIndex = 0;
 
-	for (s32 i=0; i<TrianglePatches.NumPatches; ++i)
+	// only the quads of the cells under the box
+	s32 minX, minZ, maxX, maxZ;
+	if (TotalTriangles && box.intersectsWithBox(BoundingBox) && getCellRange(box, minX, minZ, maxX, maxZ))
 	{
-		if (tIndex + TrianglePatches.TrianglePatchArray[i].NumTriangles <= count &&
-			TrianglePatches.TrianglePatchArray[i].Box.intersectsWithBox(box))
-			for (s32 j=0; j<TrianglePatches.TrianglePatchArray[i].NumTriangles; ++j)
+		const s32 lastPatchX = core::min_(maxX / PatchSize, PatchCount - 1);
+		const s32 lastPatchZ = core::min_(maxZ / PatchSize, PatchCount - 1);
+		for (s32 px=minX / PatchSize; px<=lastPatchX; ++px)
+		{
+			for (s32 pz=minZ / PatchSize; pz<=lastPatchZ; ++pz)
 			{
-				triangles[tIndex] = TrianglePatches.TrianglePatchArray[i].Triangles[j];
-
-				mat.transformVect(triangles[tIndex].pointA);
-				mat.transformVect(triangles[tIndex].pointB);
-				mat.transformVect(triangles[tIndex].pointC);
-
-				++tIndex;
+				const s32 p = px * PatchCount + pz;
+				if (PatchLODs[p] < 0)
+					continue;
+
+				const s32 step = 1 << PatchLODs[p];
+
+				// quads inside a patch run along z of the grid first
+				s32 firstZ = 0, lastZ = PatchSize - 1, firstX = 0, lastX = PatchSize - 1;
+				if (!hasCoarserNeighbor(p))
+				{
+					firstZ = core::max_(minX - px * PatchSize, 0);
+					lastZ = core::min_(maxX - px * PatchSize, PatchSize - 1);
+					firstX = core::max_(minZ - pz * PatchSize, 0);
+					lastX = core::min_(maxZ - pz * PatchSize, PatchSize - 1);
+				}
+
+				for (s32 z=firstZ - firstZ % step; z<=lastZ; z+=step)
+					for (s32 x=firstX - firstX % step; x<=lastX; x+=step)
+						addQuadTriangles(getQuadKey(p, x, z), triangles, arraySize, tIndex, mat, &box);
 			}
+		}
 	}
 
 	if ( outTriangleInfo )
@@ -178,31 +361,36 @@ void CTerrainTriangleSelector::getTriangles(core::triangle3df* triangles,
 		const core::matrix4* transform, bool useNodeTransform, 
 		irr::core::array<SCollisionTriangleRange>* outTriangleInfo) const
 {
-	const s32 count = core::min_((s32)TrianglePatches.TotalTriangles, arraySize);
+	if (!HasGrid)
+	{
+		core::aabbox3d<f32> box(line.start);
+		box.addInternalPoint(line.end);
+		getTriangles(triangles, arraySize, outTriangleCount, box, transform, useNodeTransform, outTriangleInfo);
+		return;
+	}
 
 	core::matrix4 mat;
 
 	if (transform)
 		mat = (*transform);
 
-	s32 tIndex = 0;
+	// collect the quads of all cells the line passes
+	core::array<u32> quads;
+	SGridTrace trace;
+	WorldToGrid.transformVect(trace.Start, line.start);
+	WorldToGrid.transformVect(trace.Dir, line.end);
+	trace.Dir -= trace.Start;
+	trace.Hit = 0;
+	trace.Quads = &quads;
+	traceLine(trace);
 
-	for (s32 i=0; i<TrianglePatches.NumPatches; ++i)
-	{
-		if (tIndex + TrianglePatches.TrianglePatchArray[i].NumTriangles <= count
-            && TrianglePatches.TrianglePatchArray[i].Box.intersectsWithLine(line))
-		{
-			for (s32 j=0; j<TrianglePatches.TrianglePatchArray[i].NumTriangles; ++j)
-			{
-				triangles[tIndex] = TrianglePatches.TrianglePatchArray[i].Triangles[j];
-
-				mat.transformVect(triangles[tIndex].pointA);
-				mat.transformVect(triangles[tIndex].pointB);
-				mat.transformVect(triangles[tIndex].pointC);
+	quads.sort();
 
-				++tIndex;
-			}
-		}
+	s32 tIndex = 0;
+	for (u32 i=0; i<quads.size() && tIndex < arraySize; ++i)
+	{
+		if (i == 0 || quads[i] != quads[i-1])
+			addQuadTriangles(quads[i], triangles, arraySize, tIndex, mat, 0);
 	}
 
 	if ( outTriangleInfo )
@@ -218,10 +406,378 @@ void CTerrainTriangleSelector::getTriangles(core::triangle3df* triangles,
 }
 
 
+//! Gets the nearest intersection of a 3d line with the terrain.
+bool CTerrainTriangleSelector::getCollisionPoint(SCollisionHit& hitResult,
+		const core::line3d<f32>& line, bool useNodeTransform) const
+{
+	if (!HasGrid)
+	{
+		return ITriangleSelector::getCollisionPoint(hitResult, line, useNodeTransform);
+	}
+
+	SNearestLineHit hit(line);
+	SGridTrace trace;
+	WorldToGrid.transformVect(trace.Start, line.start);
+	WorldToGrid.transformVect(trace.Dir, line.end);
+	trace.Dir -= trace.Start;
+	trace.Hit = &hit;
+	trace.Quads = 0;
+	traceLine(trace);
+
+	if (!hit.Found)
+		return false;
+
+	hitResult.Intersection = hit.Intersection;
+	hitResult.Triangle = hit.Triangle;
+	hitResult.Node = SceneNode;
+	hitResult.MeshBuffer = 0;
+	hitResult.MaterialIndex = 0;
+	hitResult.TriangleSelector = const_cast<CTerrainTriangleSelector*>(this);
+	return true;
+}
+
+
+//! Get a box around all triangles of this selector
+bool CTerrainTriangleSelector::getBoundingBox(core::aabbox3d<f32>& outBox, bool useNodeTransform) const
+{
+	// the terrain vertices are already transformed
+	outBox = BoundingBox;
+	return TotalTriangles > 0;
+}
+
+
+//! Walks the cells of the grid a line passes, front to back
+void CTerrainTriangleSelector::traceLine(SGridTrace& trace) const
+{
+	trace.InvDir.set(trace.Dir.X != 0.f ? 1.f / trace.Dir.X : 0.f,
+		trace.Dir.Y != 0.f ? 1.f / trace.Dir.Y : 0.f,
+		trace.Dir.Z != 0.f ? 1.f / trace.Dir.Z : 0.f);
+
+	struct SStackEntry
+	{
+		u32 Level;
+		s32 X;
+		s32 Z;
+		f32 T;
+	};
+
+	// each level pushes at most 4 children for the one node taken off
+	SStackEntry stack[MAX_LEVELS * 3 + 1];
+	u32 stackSize = 0;
+
+	const u32 top = LevelSizes.size() - 1;
+	SStackEntry entry;
+	entry.Level = top;
+	entry.X = 0;
+	entry.Z = 0;
+	if (!intersectsNode(top, 0, 0, trace, entry.T))
+		return;
+	stack[stackSize++] = entry;
+
+	core::array<u32> quads;
+	core::triangle3df quadTriangles[2];
+
+	while (stackSize)
+	{
+		entry = stack[--stackSize];
+
+		// hits in this node can't be in front of the nearest one
+		if (trace.Hit && trace.Hit->Found && entry.T > trace.Hit->getNearestT() + 0.0001f)
+			continue;
+
+		if (entry.Level == 0)
+		{
+			quads.set_used(0);
+			addQuadsForCell(entry.X, entry.Z, quads);
+
+			if (trace.Quads)
+			{
+				for (u32 i=0; i<quads.size(); ++i)
+					trace.Quads->push_back(quads[i]);
+			}
+			if (trace.Hit)
+			{
+				for (u32 i=0; i<quads.size(); ++i)
+				{
+					getQuadTriangles(quads[i], quadTriangles);
+					trace.Hit->test(quadTriangles[0]);
+					trace.Hit->test(quadTriangles[1]);
+				}
+			}
+			continue;
+		}
+
+		// children hit by the line, the nearest one goes on top of the stack
+		const u32 level = entry.Level - 1;
+		const s32 size = LevelSizes[level];
+		SStackEntry children[4];
+		u32 childCount = 0;
+		for (s32 cx=entry.X*2; cx<core::min_(entry.X*2+2, size); ++cx)
+		{
+			for (s32 cz=entry.Z*2; cz<core::min_(entry.Z*2+2, size); ++cz)
+			{
+				SStackEntry child;
+				child.Level = level;
+				child.X = cx;
+				child.Z = cz;
+				if (!intersectsNode(level, cx, cz, trace, child.T))
+					continue;
+
+				u32 i = childCount++;
+				for (; i>0 && children[i-1].T < child.T; --i)
+					children[i] = children[i-1];
+				children[i] = child;
+			}
+		}
+
+		for (u32 i=0; i<childCount; ++i)
+			stack[stackSize++] = children[i];
+	}
+}
+
+
+//! Checks a line against the box of a node of the height tree
+bool CTerrainTriangleSelector::intersectsNode(u32 level, s32 nodeX, s32 nodeZ,
+		const SGridTrace& trace, f32& outT) const
+{
+	const s32 size = LevelSizes[level];
+	const f32* range = &HeightRanges[(LevelOffsets[level] + nodeX * size + nodeZ) * 2];
+	if (range[0] > range[1])
+		return false; // no triangles below this node
+
+	// a bit larger, so rounding doesn't lose hits at the edges
+	const f32 cellTolerance = 0.01f;
+	const s32 cells = Size - 1;
+	const f32 minX = (f32)(nodeX << level) - cellTolerance;
+	const f32 maxX = (f32)core::min_((nodeX + 1) << level, cells) + cellTolerance;
+	const f32 minZ = (f32)(nodeZ << level) - cellTolerance;
+	const f32 maxZ = (f32)core::min_((nodeZ + 1) << level, cells) + cellTolerance;
+
+	f32 tMin = 0.f;
+	f32 tMax = 1.f;
+	if (!clipSlab(trace.Start.X, trace.Dir.X, trace.InvDir.X, minX, maxX, tMin, tMax))
+		return false;
+	if (!clipSlab(trace.Start.Z, trace.Dir.Z, trace.InvDir.Z, minZ, maxZ, tMin, tMax))
+		return false;
+	if (!clipSlab(trace.Start.Y, trace.Dir.Y, trace.InvDir.Y, range[0] - HeightTolerance, range[1] + HeightTolerance, tMin, tMax))
+		return false;
+
+	outT = tMin;
+	return true;
+}
+
+
+//! Gets the range of cells which a box in world space can touch
+bool CTerrainTriangleSelector::getCellRange(const core::aabbox3d<f32>& box,
+		s32& minX, s32& minZ, s32& maxX, s32& maxZ) const
+{
+	const s32 cells = Size - 1;
+	if (!HasGrid)
+	{
+		minX = minZ = 0;
+		maxX = maxZ = cells - 1;
+		return true;
+	}
+
+	core::aabbox3d<f32> gridBox(box);
+	WorldToGrid.transformBoxEx(gridBox);
+
+	// cells reach from their index to the next one
+	minX = core::max_(core::floor32(gridBox.MinEdge.X) - 1, 0);
+	minZ = core::max_(core::floor32(gridBox.MinEdge.Z) - 1, 0);
+	maxX = core::min_(core::floor32(gridBox.MaxEdge.X) + 1, cells - 1);
+	maxZ = core::min_(core::floor32(gridBox.MaxEdge.Z) + 1, cells - 1);
+
+	return minX <= maxX && minZ <= maxZ;
+}
+
+
+//! Adds the quads whose triangles can cover a cell of the grid
+void CTerrainTriangleSelector::addQuadsForCell(s32 cellX, s32 cellZ, core::array<u32>& quads) const
+{
+	const s32 px = cellX / PatchSize;
+	const s32 pz = cellZ / PatchSize;
+	if (px >= PatchCount || pz >= PatchCount)
+		return;
+
+	const s32 p = px * PatchCount + pz;
+	const s32 lod = PatchLODs[p];
+	if (lod < 0)
+		return;
+
+	// inside a patch quads run along z of the grid first, like in CTerrainSceneNode
+	const s32 step = 1 << lod;
+	s32 x = cellZ - pz * PatchSize;
+	s32 z = cellX - px * PatchSize;
+	x -= x % step;
+	z -= z % step;
+	quads.push_back(getQuadKey(p, x, z));
+
+	// Triangles at borders to patches with less detail end at the
+	// vertices of that patch, they cover the cells between them.
+	if (z == 0 && px > 0 && lod < PatchLODs[p - PatchCount])
+	{
+		const s32 neighborStep = 1 << PatchLODs[p - PatchCount];
+		for (s32 b=x - x % neighborStep; b<core::min_(x - x % neighborStep + neighborStep, PatchSize); b+=step)
+			if (b != x)
+				quads.push_back(getQuadKey(p, b, z));
+	}
+	else if (z + step >= PatchSize && px < PatchCount - 1 && lod < PatchLODs[p + PatchCount])
+	{
+		const s32 neighborStep = 1 << PatchLODs[p + PatchCount];
+		for (s32 b=x - x % neighborStep; b<core::min_(x - x % neighborStep + neighborStep, PatchSize); b+=step)
+			if (b != x)
+				quads.push_back(getQuadKey(p, b, z));
+	}
+
+	if (x == 0 && pz > 0 && lod < PatchLODs[p - 1])
+	{
+		const s32 neighborStep = 1 << PatchLODs[p - 1];
+		for (s32 b=z - z % neighborStep; b<core::min_(z - z % neighborStep + neighborStep, PatchSize); b+=step)
+			if (b != z)
+				quads.push_back(getQuadKey(p, x, b));
+	}
+	else if (x + step >= PatchSize && pz < PatchCount - 1 && lod < PatchLODs[p + 1])
+	{
+		const s32 neighborStep = 1 << PatchLODs[p + 1];
+		for (s32 b=z - z % neighborStep; b<core::min_(z - z % neighborStep + neighborStep, PatchSize); b+=step)
+			if (b != z)
+				quads.push_back(getQuadKey(p, x, b));
+	}
+}
+
+
+//! True if the patch has a neighbor with less detail
+bool CTerrainTriangleSelector::hasCoarserNeighbor(s32 patch) const
+{
+	const s32 px = patch / PatchCount;
+	const s32 pz = patch % PatchCount;
+	const s32 lod = PatchLODs[patch];
+
+	return (px > 0 && lod < PatchLODs[patch - PatchCount]) ||
+		(px < PatchCount - 1 && lod < PatchLODs[patch + PatchCount]) ||
+		(pz > 0 && lod < PatchLODs[patch - 1]) ||
+		(pz < PatchCount - 1 && lod < PatchLODs[patch + 1]);
+}
+
+
+//! Number of triangles in a patch
+u32 CTerrainTriangleSelector::getPatchTriangleCount(s32 patch) const
+{
+	if (PatchLODs[patch] < 0)
+		return 0;
+
+	const s32 step = 1 << PatchLODs[patch];
+	const u32 quadsPerSide = (u32)((PatchSize + step - 1) / step);
+	return quadsPerSide * quadsPerSide * 2;
+}
+
+
+//! Returns the vertex of a patch like CTerrainSceneNode::getIndex
+s32 CTerrainTriangleSelector::getVertexIndex(s32 patchX, s32 patchZ, s32 vX, s32 vZ) const
+{
+	const s32 patch = patchX * PatchCount + patchZ;
+	const s32 lod = PatchLODs[patch];
+
+	// top border
+	if (vZ == 0)
+	{
+		if (patchX > 0 && lod < PatchLODs[patch - PatchCount])
+			vX -= vX % (1 << PatchLODs[patch - PatchCount]);
+	}
+	else
+	if (vZ == PatchSize) // bottom border
+	{
+		if (patchX < PatchCount - 1 && lod < PatchLODs[patch + PatchCount])
+			vX -= vX % (1 << PatchLODs[patch + PatchCount]);
+	}
+
+	// left border
+	if (vX == 0)
+	{
+		if (patchZ > 0 && lod < PatchLODs[patch - 1])
+			vZ -= vZ % (1 << PatchLODs[patch - 1]);
+	}
+	else
+	if (vX == PatchSize) // right border
+	{
+		if (patchZ < PatchCount - 1 && lod < PatchLODs[patch + 1])
+			vZ -= vZ % (1 << PatchLODs[patch + 1]);
+	}
+
+	if (vZ > PatchSize)
+		vZ = PatchSize;
+
+	if (vX > PatchSize)
+		vX = PatchSize;
+
+	return (vZ + PatchSize * patchX) * Size + (vX + PatchSize * patchZ);
+}
+
+
+//! Writes the vertex indices of the two triangles of a quad in a patch
+void CTerrainTriangleSelector::getQuadIndices(s32 patch, s32 x, s32 z, s32* indices) const
+{
+	const s32 px = patch / PatchCount;
+	const s32 pz = patch % PatchCount;
+	const s32 step = 1 << PatchLODs[patch];
+
+	const s32 index11 = getVertexIndex(px, pz, x, z);
+	const s32 index21 = getVertexIndex(px, pz, x + step, z);
+	const s32 index12 = getVertexIndex(px, pz, x, z + step);
+	const s32 index22 = getVertexIndex(px, pz, x + step, z + step);
+
+	indices[0] = index12;
+	indices[1] = index11;
+	indices[2] = index22;
+	indices[3] = index22;
+	indices[4] = index11;
+	indices[5] = index21;
+}
+
+
+//! Writes the two triangles of a quad
+void CTerrainTriangleSelector::getQuadTriangles(u32 quad, core::triangle3df* triangles) const
+{
+	const s32 x = (s32)(quad % PatchSize);
+	const s32 z = (s32)(quad / PatchSize % PatchSize);
+	const s32 patch = (s32)(quad / PatchSize / PatchSize);
+
+	s32 indices[6];
+	getQuadIndices(patch, x, z, indices);
+
+	triangles[0].set(Positions[indices[0]], Positions[indices[1]], Positions[indices[2]]);
+	triangles[1].set(Positions[indices[3]], Positions[indices[4]], Positions[indices[5]]);
+}
+
+
+//! Adds the triangles of a quad to the output when they pass the box
+void CTerrainTriangleSelector::addQuadTriangles(u32 quad, core::triangle3df* triangles, s32 arraySize,
+		s32& trianglesWritten, const core::matrix4& mat, const core::aabbox3d<f32>* box) const
+{
+	core::triangle3df quadTriangles[2];
+	getQuadTriangles(quad, quadTriangles);
+
+	for (u32 t=0; t<2 && trianglesWritten < arraySize; ++t)
+	{
+		// This isn't an accurate test, but it's fast, and the
+		// API contract doesn't guarantee complete accuracy.
+		if (box && quadTriangles[t].isTotalOutsideBox(*box))
+			continue;
+
+		triangles[trianglesWritten] = quadTriangles[t];
+		mat.transformVect(triangles[trianglesWritten].pointA);
+		mat.transformVect(triangles[trianglesWritten].pointB);
+		mat.transformVect(triangles[trianglesWritten].pointC);
+		++trianglesWritten;
+	}
+}
+
+
 //! Returns amount of all available triangles in this selector
 s32 CTerrainTriangleSelector::getTriangleCount() const
 {
-	return TrianglePatches.TotalTriangles;
+	return TotalTriangles;
 }
 
 
@@ -11,6 +11,7 @@
 
 #include "ITriangleSelector.h"
 #include "irrArray.h"
+#include "matrix4.h"
 
 namespace irr
 {
@@ -24,6 +25,10 @@ class ITerrainSceneNode;
 developed by Spintz. He made it available for Irrlicht and allowed it to be
 distributed under this license. I only modified some parts. A lot of thanks go
 to him.
+The selector keeps the terrain vertices as a height grid and creates the
+triangles of a grid cell only when a query needs them. A quadtree with the
+minimal and maximal height over the cells lets ray queries walk the grid front
+to back and skip everything the ray passes above or below.
 */
 class CTerrainTriangleSelector : public ITriangleSelector
 {
@@ -54,6 +59,13 @@ public:
 		const core::matrix4* transform, bool useNodeTransform, 
 		irr::core::array<SCollisionTriangleRange>* outTriangleInfo) const IRR_OVERRIDE;
 
+	//! Gets the nearest intersection of a 3d line with the terrain.
+	virtual bool getCollisionPoint(SCollisionHit& hitResult, const core::line3d<f32>& line,
+		bool useNodeTransform) const IRR_OVERRIDE;
+
+	//! Get a box around all triangles of this selector
+	virtual bool getBoundingBox(core::aabbox3d<f32>& outBox, bool useNodeTransform) const IRR_OVERRIDE;
+
 	//! Returns amount of all available triangles in this selector
 	virtual s32 getTriangleCount() const IRR_OVERRIDE;
 
@@ -73,27 +85,69 @@ private:
 
 	friend class CTerrainSceneNode;
 
-	struct SGeoMipMapTrianglePatch
-	{
-		core::array<core::triangle3df> Triangles;
-		s32 NumTriangles;
-		core::aabbox3df Box;
-	};
+	//! State of a line walking the height grid
+	struct SGridTrace;
+
+	//! Returns the vertex of a patch like CTerrainSceneNode::getIndex for the stored levels of detail
+	s32 getVertexIndex(s32 patchX, s32 patchZ, s32 vX, s32 vZ) const;
+
+	//! Writes the vertex indices of the two triangles of a quad in a patch
+	void getQuadIndices(s32 patch, s32 x, s32 z, s32* indices) const;
+
+	//! Writes the two triangles of a quad
+	void getQuadTriangles(u32 quad, core::triangle3df* triangles) const;
+
+	//! Number of triangles in a patch, 0 if it has none
+	u32 getPatchTriangleCount(s32 patch) const;
 
-	struct SGeoMipMapTrianglePatches
+	//! True if the patch has a neighbor with less detail, its border triangles stretch along that border
+	bool hasCoarserNeighbor(s32 patch) const;
+
+	//! Adds the quads whose triangles can cover a cell of the grid
+	void addQuadsForCell(s32 cellX, s32 cellZ, core::array<u32>& quads) const;
+
+	//! Gets the range of cells which a box in world space can touch
+	/** \return False if the box doesn't touch the grid */
+	bool getCellRange(const core::aabbox3d<f32>& box, s32& minX, s32& minZ, s32& maxX, s32& maxZ) const;
+
+	//! Checks a line against the box of a node of the height tree
+	bool intersectsNode(u32 level, s32 nodeX, s32 nodeZ, const SGridTrace& trace, f32& outT) const;
+
+	//! Walks the cells of the grid a line passes, front to back
+	void traceLine(SGridTrace& trace) const;
+
+	//! Adds the triangles of a quad to the output when they pass the box
+	void addQuadTriangles(u32 quad, core::triangle3df* triangles, s32 arraySize, s32& trianglesWritten,
+		const core::matrix4& mat, const core::aabbox3d<f32>* box) const;
+
+	//! Key of a quad, keys sort in the order getTriangles returns the triangles
+	u32 getQuadKey(s32 patch, s32 x, s32 z) const
 	{
-		SGeoMipMapTrianglePatches() :
-			NumPatches(0), TotalTriangles(0)
-		{
-		}
+		return ((u32)patch * PatchSize + z) * PatchSize + x;
+	}
 
-		core::array<SGeoMipMapTrianglePatch> TrianglePatchArray;
-		s32 NumPatches;
-		u32 TotalTriangles;
-	};
+	//! Levels the height tree has at most
+	enum { MAX_LEVELS = 32 };
 
 	ITerrainSceneNode* SceneNode;
-	SGeoMipMapTrianglePatches TrianglePatches;
+
+	core::array<core::vector3df> Positions; // transformed terrain vertices, Size*Size
+	core::array<s32> PatchLODs; // level of detail of each patch, -1 for patches without triangles
+
+	// Minimal and maximal grid height over the cells. The first level
+	// has one entry per cell, each following level combines 2x2 entries.
+	core::array<f32> HeightRanges;
+	core::array<u32> LevelOffsets;
+	core::array<s32> LevelSizes;
+
+	core::matrix4 WorldToGrid; // vertex x, z of the terrain is at grid position (x, height, z)
+	core::aabbox3d<f32> BoundingBox;
+	f32 HeightTolerance;
+	s32 Size;
+	s32 PatchSize; // quads along a patch side at full detail
+	s32 PatchCount;
+	u32 TotalTriangles;
+	bool HasGrid;
 };
 
 } // end namespace scene
@@ -0,0 +1,115 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_C_TEXT_CHUNKS_H_INCLUDED
+#define IRR_C_TEXT_CHUNKS_H_INCLUDED
+
+#include "IrrCompileConfig.h"
+#include "irrArray.h"
+#include "irrMath.h"
+#include "CThread.h"
+
+namespace irr
+{
+namespace scene
+{
+
+//! Texts are only split into chunks of at least this size
+const u32 TEXT_CHUNK_MIN_SIZE = 256*1024;
+
+//! Returns how many chunks a text loader should split a text of the given size into
+/** \param size Size of the text in bytes.
+\param maxThreads Value of the MESH_LOADER_PARSE_THREADS parameter, 0 for
+one chunk per hardware thread.
+\return At least 1, always 1 without _IRR_COMPILE_WITH_THREADS_ */
+inline u32 getTextChunkCount(long size, s32 maxThreads)
+{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	u32 count = maxThreads > 0 ? (u32)maxThreads : CThread::getHardwareConcurrency();
+	if (size > 0)
+		count = core::min_(count, (u32)(size / TEXT_CHUNK_MIN_SIZE));
+	return core::max_(count, 1u);
+#else
+	return 1;
+#endif
+}
+
+//! Splits a text into chunks which start at the beginning of a line
+/** \param bounds Receives one pointer more than there are chunks, chunk i
+goes from bounds[i] to bounds[i+1]. Texts with few lines can result in
+fewer chunks than requested, but there is always one. */
+inline void splitTextAtLines(const c8* text, const c8* textEnd, u32 count, core::array<const c8*>& bounds)
+{
+	const size_t size = (size_t)(textEnd - text);
+	bounds.set_used(0);
+	bounds.push_back(text);
+	for (u32 i=1; i<count; ++i)
+	{
+		const c8* p = core::max_(text + size / count * i, bounds.getLast());
+		while (p != textEnd && *p != '\n' && *p != '\r')
+			++p;
+		if (p == textEnd)
+			break;
+		bounds.push_back(p+1);
+	}
+	bounds.push_back(textEnd);
+}
+
+//! Calls parse() of each chunk, all but the first one on worker threads
+/** Returns when all chunks are parsed. The chunks must not share anything
+which isn't thread safe. */
+template <class T>
+void parseChunks(core::array<T>& chunks);
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+
+//! Thread function of parseChunks()
+template <class T>
+void parseChunk(void* chunk)
+{
+	static_cast<T*>(chunk)->parse();
+}
+
+template <class T>
+void parseChunks(core::array<T>& chunks)
+{
+	core::array<CThread*> threads;
+	for (u32 i=1; i<chunks.size(); ++i)
+	{
+		CThread* thread = new CThread();
+		if (thread->start(parseChunk<T>, &chunks[i]))
+			threads.push_back(thread);
+		else
+		{
+			// out of threads, do it here
+			delete thread;
+			chunks[i].parse();
+		}
+	}
+
+	if (!chunks.empty())
+		chunks[0].parse();
+
+	for (u32 i=0; i<threads.size(); ++i)
+	{
+		threads[i]->join();
+		delete threads[i];
+	}
+}
+
+#else
+
+template <class T>
+void parseChunks(core::array<T>& chunks)
+{
+	for (u32 i=0; i<chunks.size(); ++i)
+		chunks[i].parse();
+}
+
+#endif // _IRR_COMPILE_WITH_THREADS_
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
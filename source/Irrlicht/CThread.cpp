@@ -0,0 +1,233 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CThread.h"
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+
+#if !defined(_IRR_WINDOWS_API_)
+	#include <unistd.h>
+#endif
+
+namespace irr
+{
+
+#if defined(_IRR_WINDOWS_API_)
+
+CMutex::CMutex()
+{
+	InitializeCriticalSection(&Section);
+}
+
+CMutex::~CMutex()
+{
+	DeleteCriticalSection(&Section);
+}
+
+void CMutex::lock()
+{
+	EnterCriticalSection(&Section);
+}
+
+void CMutex::unlock()
+{
+	LeaveCriticalSection(&Section);
+}
+
+
+CSemaphore::CSemaphore()
+{
+	Semaphore = CreateSemaphore(0, 0, 0x7fffffff, 0);
+}
+
+CSemaphore::~CSemaphore()
+{
+	CloseHandle(Semaphore);
+}
+
+void CSemaphore::post()
+{
+	ReleaseSemaphore(Semaphore, 1, 0);
+}
+
+void CSemaphore::wait()
+{
+	WaitForSingleObject(Semaphore, INFINITE);
+}
+
+
+CThread::CThread() : Thread(0), Function(0), UserData(0)
+{
+}
+
+CThread::~CThread()
+{
+	join();
+}
+
+bool CThread::start(ThreadFunction function, void* userData)
+{
+	if (Thread)
+		return false;
+
+	Function = function;
+	UserData = userData;
+	Thread = CreateThread(0, 0, run, this, 0, 0);
+	return Thread != 0;
+}
+
+void CThread::join()
+{
+	if (Thread)
+	{
+		WaitForSingleObject(Thread, INFINITE);
+		CloseHandle(Thread);
+		Thread = 0;
+	}
+}
+
+DWORD WINAPI CThread::run(LPVOID data)
+{
+	CThread* thread = (CThread*)data;
+	thread->Function(thread->UserData);
+	return 0;
+}
+
+u32 CThread::getHardwareConcurrency()
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors > 0 ? (u32)info.dwNumberOfProcessors : 1;
+}
+
+CThread::Id CThread::getCurrentId()
+{
+	return GetCurrentThreadId();
+}
+
+bool CThread::isSameThread(Id a, Id b)
+{
+	return a == b;
+}
+
+#else // POSIX
+
+CMutex::CMutex()
+{
+	// recursive like the critical sections on Windows
+	pthread_mutexattr_t attributes;
+	pthread_mutexattr_init(&attributes);
+	pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&Mutex, &attributes);
+	pthread_mutexattr_destroy(&attributes);
+}
+
+CMutex::~CMutex()
+{
+	pthread_mutex_destroy(&Mutex);
+}
+
+void CMutex::lock()
+{
+	pthread_mutex_lock(&Mutex);
+}
+
+void CMutex::unlock()
+{
+	pthread_mutex_unlock(&Mutex);
+}
+
+
+CSemaphore::CSemaphore() : Count(0)
+{
+	pthread_mutex_init(&Mutex, 0);
+	pthread_cond_init(&Condition, 0);
+}
+
+CSemaphore::~CSemaphore()
+{
+	pthread_cond_destroy(&Condition);
+	pthread_mutex_destroy(&Mutex);
+}
+
+void CSemaphore::post()
+{
+	pthread_mutex_lock(&Mutex);
+	++Count;
+	pthread_cond_signal(&Condition);
+	pthread_mutex_unlock(&Mutex);
+}
+
+void CSemaphore::wait()
+{
+	pthread_mutex_lock(&Mutex);
+	while (Count == 0)
+		pthread_cond_wait(&Condition, &Mutex);
+	--Count;
+	pthread_mutex_unlock(&Mutex);
+}
+
+
+CThread::CThread() : Started(false), Function(0), UserData(0)
+{
+}
+
+CThread::~CThread()
+{
+	join();
+}
+
+bool CThread::start(ThreadFunction function, void* userData)
+{
+	if (Started)
+		return false;
+
+	Function = function;
+	UserData = userData;
+	Started = pthread_create(&Thread, 0, run, this) == 0;
+	return Started;
+}
+
+void CThread::join()
+{
+	if (Started)
+	{
+		pthread_join(Thread, 0);
+		Started = false;
+	}
+}
+
+void* CThread::run(void* data)
+{
+	CThread* thread = (CThread*)data;
+	thread->Function(thread->UserData);
+	return 0;
+}
+
+u32 CThread::getHardwareConcurrency()
+{
+#if defined(_SC_NPROCESSORS_ONLN)
+	const long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (u32)count : 1;
+#else
+	return 1;
+#endif
+}
+
+CThread::Id CThread::getCurrentId()
+{
+	return pthread_self();
+}
+
+bool CThread::isSameThread(Id a, Id b)
+{
+	return pthread_equal(a, b) != 0;
+}
+
+#endif
+
+} // end namespace irr
+
+#endif // _IRR_COMPILE_WITH_THREADS_
+
@@ -0,0 +1,167 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_C_THREAD_H_INCLUDED
+#define IRR_C_THREAD_H_INCLUDED
+
+#include "IrrCompileConfig.h"
+#include "irrTypes.h"
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+
+#if defined(_IRR_WINDOWS_API_)
+	#include <windows.h>
+#else
+	#include <pthread.h>
+#endif
+
+namespace irr
+{
+
+//! Lock which can be held by one thread at a time
+/** The thread holding it may lock it again, it has to unlock it as often. */
+class CMutex
+{
+public:
+	CMutex();
+	~CMutex();
+
+	void lock();
+	void unlock();
+
+private:
+	// not copyable
+	CMutex(const CMutex&);
+	CMutex& operator=(const CMutex&);
+
+#if defined(_IRR_WINDOWS_API_)
+	CRITICAL_SECTION Section;
+#else
+	pthread_mutex_t Mutex;
+#endif
+};
+
+//! Locks a mutex for the lifetime of the object
+class CMutexLock
+{
+public:
+	explicit CMutexLock(CMutex& mutex) : Mutex(mutex)
+	{
+		Mutex.lock();
+	}
+
+	~CMutexLock()
+	{
+		Mutex.unlock();
+	}
+
+private:
+	CMutexLock(const CMutexLock&);
+	CMutexLock& operator=(const CMutexLock&);
+
+	CMutex& Mutex;
+};
+
+//! Counting semaphore, wait() blocks until another thread called post()
+class CSemaphore
+{
+public:
+	CSemaphore();
+	~CSemaphore();
+
+	//! Increases the count, wakes up one waiting thread
+	void post();
+
+	//! Waits until the count is positive and decreases it
+	void wait();
+
+private:
+	CSemaphore(const CSemaphore&);
+	CSemaphore& operator=(const CSemaphore&);
+
+#if defined(_IRR_WINDOWS_API_)
+	HANDLE Semaphore;
+#else
+	pthread_mutex_t Mutex;
+	pthread_cond_t Condition;
+	u32 Count;
+#endif
+};
+
+//! Thread running a function
+class CThread
+{
+public:
+	typedef void (*ThreadFunction)(void* userData);
+
+	CThread();
+
+	//! Waits for the thread to finish
+	~CThread();
+
+	//! Starts the thread
+	/** \return False if the thread could not be started */
+	bool start(ThreadFunction function, void* userData);
+
+	//! Waits until the thread function returned
+	void join();
+
+	//! Number of threads the machine can run at the same time, at least 1
+	static u32 getHardwareConcurrency();
+
+#if defined(_IRR_WINDOWS_API_)
+	typedef DWORD Id;
+#else
+	typedef pthread_t Id;
+#endif
+
+	//! Returns the id of the calling thread
+	static Id getCurrentId();
+
+	//! Compares two thread ids
+	static bool isSameThread(Id a, Id b);
+
+private:
+	CThread(const CThread&);
+	CThread& operator=(const CThread&);
+
+#if defined(_IRR_WINDOWS_API_)
+	static DWORD WINAPI run(LPVOID data);
+	HANDLE Thread;
+#else
+	static void* run(void* data);
+	pthread_t Thread;
+	bool Started;
+#endif
+	ThreadFunction Function;
+	void* UserData;
+};
+
+} // end namespace irr
+
+#else // _IRR_COMPILE_WITH_THREADS_
+
+namespace irr
+{
+
+//! Without threads there is nothing to lock
+class CMutex
+{
+public:
+	void lock() {}
+	void unlock() {}
+};
+
+class CMutexLock
+{
+public:
+	explicit CMutexLock(CMutex&) {}
+};
+
+} // end namespace irr
+
+#endif // _IRR_COMPILE_WITH_THREADS_
+
+#endif
+
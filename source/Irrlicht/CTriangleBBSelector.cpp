@@ -18,7 +18,7 @@ CTriangleBBSelector::CTriangleBBSelector(ISceneNode* node)
 	setDebugName("CTriangleBBSelector");
 	#endif
 
-	Triangles.set_used(12); // a box has 12 triangles.
+	Triangles.set_used(BOX_TRIANGLE_COUNT); // only used for the triangle count
 }
 
 //! Gets all triangles.
@@ -27,10 +27,36 @@ void CTriangleBBSelector::getTriangles(core::triangle3df* triangles,
 					const core::matrix4* transform, bool useNodeTransform, 
 					irr::core::array<SCollisionTriangleRange>* outTriangleInfo) const
 {
-	fillTriangles();
+	core::triangle3df boxTriangles[BOX_TRIANGLE_COUNT];
+	fillTriangles(boxTriangles);
 
-	// call parent
-	CTriangleSelector::getTriangles(triangles, arraySize, outTriangleCount,	transform, useNodeTransform, outTriangleInfo);
+	u32 cnt = SceneNode ? (u32)BOX_TRIANGLE_COUNT : 0;
+	if (cnt > (u32)arraySize)
+		cnt = (u32)arraySize;
+
+	core::matrix4 mat;
+	if (transform)
+		mat = *transform;
+	if (SceneNode&&useNodeTransform)
+		mat *= SceneNode->getAbsoluteTransformation();
+
+	for (u32 i=0; i<cnt; ++i)
+	{
+		mat.transformVect( triangles[i].pointA, boxTriangles[i].pointA );
+		mat.transformVect( triangles[i].pointB, boxTriangles[i].pointB );
+		mat.transformVect( triangles[i].pointC, boxTriangles[i].pointC );
+	}
+
+	if ( outTriangleInfo )
+	{
+		SCollisionTriangleRange triRange;
+		triRange.RangeSize = cnt;
+		triRange.Selector = const_cast<CTriangleBBSelector*>(this);
+		triRange.SceneNode = SceneNode;
+		outTriangleInfo->push_back(triRange);
+	}
+
+	outTriangleCount = cnt;
 }
 
 void CTriangleBBSelector::getTriangles(core::triangle3df* triangles,
@@ -39,8 +65,58 @@ void CTriangleBBSelector::getTriangles(core::triangle3df* triangles,
 					const core::matrix4* transform, bool useNodeTransform, 
 					irr::core::array<SCollisionTriangleRange>* outTriangleInfo) const
 {
-	fillTriangles();
-	return CTriangleSelector::getTriangles(triangles, arraySize, outTriangleCount, box, transform, useNodeTransform, outTriangleInfo);
+	outTriangleCount = 0;
+	if (!SceneNode)
+		return;
+
+	core::matrix4 mat(core::matrix4::EM4CONST_NOTHING);
+	core::aabbox3df tBox(box);
+
+	if (useNodeTransform)
+	{
+		if ( SceneNode->getAbsoluteTransformation().getInverse(mat) )
+			mat.transformBoxEx(tBox);
+		else
+			return getTriangles(triangles, arraySize, outTriangleCount,
+					transform, useNodeTransform, outTriangleInfo );
+	}
+	if (transform)
+		mat = *transform;
+	else
+		mat.makeIdentity();
+	if (useNodeTransform)
+		mat *= SceneNode->getAbsoluteTransformation();
+
+	s32 triangleCount = 0;
+	if (tBox.intersectsWithBox(SceneNode->getBoundingBox()))
+	{
+		core::triangle3df boxTriangles[BOX_TRIANGLE_COUNT];
+		fillTriangles(boxTriangles);
+
+		for (u32 i=0; i<BOX_TRIANGLE_COUNT && triangleCount < arraySize; ++i)
+		{
+			// This isn't an accurate test, but it's fast, and the
+			// API contract doesn't guarantee complete accuracy.
+			if (boxTriangles[i].isTotalOutsideBox(tBox))
+			   continue;
+
+			mat.transformVect(triangles[triangleCount].pointA, boxTriangles[i].pointA);
+			mat.transformVect(triangles[triangleCount].pointB, boxTriangles[i].pointB);
+			mat.transformVect(triangles[triangleCount].pointC, boxTriangles[i].pointC);
+			++triangleCount;
+		}
+	}
+
+	if ( outTriangleInfo )
+	{
+		SCollisionTriangleRange triRange;
+		triRange.RangeSize = triangleCount;
+		triRange.Selector = const_cast<CTriangleBBSelector*>(this);
+		triRange.SceneNode = SceneNode;
+		outTriangleInfo->push_back(triRange);
+	}
+
+	outTriangleCount = triangleCount;
 }
 
 void CTriangleBBSelector::getTriangles(core::triangle3df* triangles,
@@ -49,38 +125,77 @@ void CTriangleBBSelector::getTriangles(core::triangle3df* triangles,
 					const core::matrix4* transform, bool useNodeTransform, 
 					irr::core::array<SCollisionTriangleRange>* outTriangleInfo) const
 {
-	fillTriangles();
-	return CTriangleSelector::getTriangles(triangles, arraySize, outTriangleCount, line, transform, useNodeTransform, outTriangleInfo);
+	core::aabbox3d<f32> box(line.start);
+	box.addInternalPoint(line.end);
+
+	getTriangles(triangles, arraySize, outTriangleCount,
+				box, transform, useNodeTransform, outTriangleInfo);
+}
+
+//! Gets the nearest intersection of a 3d line with the box of the node.
+bool CTriangleBBSelector::getCollisionPoint(SCollisionHit& hitResult,
+		const core::line3d<f32>& line, bool useNodeTransform) const
+{
+	core::triangle3df triangles[BOX_TRIANGLE_COUNT];
+	s32 cnt = 0;
+	getTriangles(triangles, BOX_TRIANGLE_COUNT, cnt, line, 0, useNodeTransform, 0);
+
+	SNearestLineHit hit(line);
+	for (s32 i=0; i<cnt; ++i)
+		hit.test(triangles[i]);
+
+	if (!hit.Found)
+		return false;
+
+	hitResult.Intersection = hit.Intersection;
+	hitResult.Triangle = hit.Triangle;
+	hitResult.Node = SceneNode;
+	hitResult.MeshBuffer = 0;
+	hitResult.MaterialIndex = 0;
+	hitResult.TriangleSelector = const_cast<CTriangleBBSelector*>(this);
+	return true;
+}
+
+//! Get a box around all triangles of this selector
+bool CTriangleBBSelector::getBoundingBox(core::aabbox3d<f32>& outBox, bool useNodeTransform) const
+{
+	if (!SceneNode)
+		return false;
+
+	outBox = SceneNode->getBoundingBox();
+	if (useNodeTransform)
+		SceneNode->getAbsoluteTransformation().transformBoxEx(outBox);
+
+	return true;
 }
 
-void CTriangleBBSelector::fillTriangles() const
+void CTriangleBBSelector::fillTriangles(core::triangle3df* boxTriangles) const
 {
 	if (SceneNode)
 	{
 		// construct triangles
+		// Written to the caller's array and not to any member, so queries from several threads don't interfere.
 		const core::aabbox3d<f32>& box = SceneNode->getBoundingBox();
-		BoundingBox = box;
 		core::vector3df edges[8];
 		box.getEdges(edges);
 
-		// yeah, not really const... Triangles are mutable
-		Triangles[0].set( edges[3], edges[0], edges[2]);
-		Triangles[1].set( edges[3], edges[1], edges[0]);
+		boxTriangles[0].set( edges[3], edges[0], edges[2]);
+		boxTriangles[1].set( edges[3], edges[1], edges[0]);
 
-		Triangles[2].set( edges[3], edges[2], edges[7]);
-		Triangles[3].set( edges[7], edges[2], edges[6]);
+		boxTriangles[2].set( edges[3], edges[2], edges[7]);
+		boxTriangles[3].set( edges[7], edges[2], edges[6]);
 
-		Triangles[4].set( edges[7], edges[6], edges[4]);
-		Triangles[5].set( edges[5], edges[7], edges[4]);
+		boxTriangles[4].set( edges[7], edges[6], edges[4]);
+		boxTriangles[5].set( edges[5], edges[7], edges[4]);
 
-		Triangles[6].set( edges[5], edges[4], edges[0]);
-		Triangles[7].set( edges[5], edges[0], edges[1]);
+		boxTriangles[6].set( edges[5], edges[4], edges[0]);
+		boxTriangles[7].set( edges[5], edges[0], edges[1]);
 
-		Triangles[8].set( edges[1], edges[3], edges[7]);
-		Triangles[9].set( edges[1], edges[7], edges[5]);
+		boxTriangles[8].set( edges[1], edges[3], edges[7]);
+		boxTriangles[9].set( edges[1], edges[7], edges[5]);
 
-		Triangles[10].set(edges[0], edges[6], edges[2]);
-		Triangles[11].set(edges[0], edges[4], edges[6]);
+		boxTriangles[10].set(edges[0], edges[6], edges[2]);
+		boxTriangles[11].set(edges[0], edges[4], edges[6]);
 	}
 }
 
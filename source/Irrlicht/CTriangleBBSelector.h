@@ -36,8 +36,19 @@ public:
 		const core::matrix4* transform, bool useNodeTransform, 
 		irr::core::array<SCollisionTriangleRange>* outTriangleInfo) const IRR_OVERRIDE;
 
+	//! Gets the nearest intersection of a 3d line with the box of the node.
+	virtual bool getCollisionPoint(SCollisionHit& hitResult, const core::line3d<f32>& line,
+		bool useNodeTransform) const IRR_OVERRIDE;
+
+	//! Get a box around all triangles of this selector
+	virtual bool getBoundingBox(core::aabbox3d<f32>& outBox, bool useNodeTransform) const IRR_OVERRIDE;
+
 protected:
-	void fillTriangles() const;
+	//! A box has 12 triangles
+	enum { BOX_TRIANGLE_COUNT = 12 };
+
+	//! Writes the triangles of the node's current bounding box
+	void fillTriangles(core::triangle3df* boxTriangles) const;
 
 };
 
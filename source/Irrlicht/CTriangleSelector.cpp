@@ -7,6 +7,7 @@
 #include "IMeshBuffer.h"
 #include "IAnimatedMeshSceneNode.h"
 #include "SSkinMeshBuffer.h"
+#include "os.h"
 
 namespace irr
 {
@@ -123,16 +124,16 @@ void CTriangleSelector::createFromMeshBuffer(const IMeshBuffer* meshBuffer)
 }
 
 template <typename TIndex>
-static void updateTriangles(u32& triangleCount, core::array<core::triangle3df>& triangles, u32 idxCnt, const TIndex* indices, const u8* vertices, u32 vertexPitch, const core::matrix4* bufferTransform)
+static void updateTriangles(u32& triangleCount, core::array<core::triangle3df>& triangles, u32 idxCnt, const TIndex* indices, const SVertexPositions& positions, const core::matrix4* bufferTransform)
 {
 	if ( bufferTransform )
 	{
 		for (u32 index = 2; index < idxCnt; index += 3)
 		{
 			core::triangle3df& tri = triangles[triangleCount++];
-			bufferTransform->transformVect( tri.pointA, (*reinterpret_cast<const video::S3DVertex*>(&vertices[indices[index - 2]*vertexPitch])).Pos );
-			bufferTransform->transformVect( tri.pointB, (*reinterpret_cast<const video::S3DVertex*>(&vertices[indices[index - 1]*vertexPitch])).Pos );
-			bufferTransform->transformVect( tri.pointC, (*reinterpret_cast<const video::S3DVertex*>(&vertices[indices[index - 0]*vertexPitch])).Pos );
+			bufferTransform->transformVect( tri.pointA, positions[indices[index - 2]] );
+			bufferTransform->transformVect( tri.pointB, positions[indices[index - 1]] );
+			bufferTransform->transformVect( tri.pointC, positions[indices[index - 0]] );
 		}
 	}
 	else
@@ -140,9 +141,9 @@ static void updateTriangles(u32& triangleCount, core::array<core::triangle3df>&
 		for (u32 index = 2; index < idxCnt; index += 3)
 		{
 			core::triangle3df& tri = triangles[triangleCount++];
-			tri.pointA = (*reinterpret_cast<const video::S3DVertex*>(&vertices[indices[index - 2]*vertexPitch])).Pos;
-			tri.pointB = (*reinterpret_cast<const video::S3DVertex*>(&vertices[indices[index - 1]*vertexPitch])).Pos;
-			tri.pointC = (*reinterpret_cast<const video::S3DVertex*>(&vertices[indices[index - 0]*vertexPitch])).Pos;
+			tri.pointA = positions[indices[index - 2]];
+			tri.pointB = positions[indices[index - 1]];
+			tri.pointC = positions[indices[index - 0]];
 		}
 	}
 }
@@ -160,8 +161,7 @@ void CTriangleSelector::updateFromMesh(const IMesh* mesh) const
 	{
 		IMeshBuffer* buf = mesh->getMeshBuffer(i);
 		u32 idxCnt = buf->getIndexCount();
-		u32 vertexPitch = getVertexPitchFromType(buf->getVertexType());
-		u8* vertices = (u8*)buf->getVertices();
+		const SVertexPositions positions(buf);
 
 		const core::matrix4* bufferTransform = 0;
 		if ( skinnnedMesh )
@@ -176,13 +176,13 @@ void CTriangleSelector::updateFromMesh(const IMesh* mesh) const
 			case video::EIT_16BIT:
 			{
 				const u16* indices = buf->getIndices();
-				updateTriangles(triangleCount, Triangles, idxCnt, indices, vertices, vertexPitch, bufferTransform);
+				updateTriangles(triangleCount, Triangles, idxCnt, indices, positions, bufferTransform);
 			}
 			break;
 			case video::EIT_32BIT:
 			{
 				const u32* indices = (u32*)buf->getIndices();
-				updateTriangles(triangleCount, Triangles, idxCnt, indices, vertices, vertexPitch, bufferTransform);
+				updateTriangles(triangleCount, Triangles, idxCnt, indices, positions, bufferTransform);
 			}
 			break;
 		}
@@ -198,24 +198,26 @@ void CTriangleSelector::updateFromMeshBuffer(const IMeshBuffer* meshBuffer) cons
 		return;
 
 	u32 idxCnt = meshBuffer->getIndexCount();
-	u32 vertexPitch = getVertexPitchFromType(meshBuffer->getVertexType());
-	u8* vertices = (u8*)meshBuffer->getVertices();
+	const SVertexPositions positions(meshBuffer);
 	u32 triangleCount = 0;
 	switch ( meshBuffer->getIndexType() )
 	{
 		case video::EIT_16BIT:
 		{
 			const u16* indices = meshBuffer->getIndices();
-			updateTriangles(triangleCount, Triangles, idxCnt, indices, vertices, vertexPitch, 0);
+			updateTriangles(triangleCount, Triangles, idxCnt, indices, positions, 0);
 		}
 		break;
 		case video::EIT_32BIT:
 		{
 			const u32* indices = (u32*)meshBuffer->getIndices();
-			updateTriangles(triangleCount, Triangles, idxCnt, indices, vertices, vertexPitch, 0);
+			updateTriangles(triangleCount, Triangles, idxCnt, indices, positions, 0);
 		}
 		break;
 	}
+
+	// Update bounding box
+	updateBoundingBox();
 }
 
 void CTriangleSelector::updateBoundingBox() const
@@ -237,6 +239,42 @@ void CTriangleSelector::updateBoundingBox() const
 	}
 }
 
+u32 CTriangleSelector::getTrianglesHash() const
+{
+	// FNV-1a over the bits of all coordinates
+	u32 hash = 2166136261u;
+	const u32 cnt = Triangles.size();
+	for (u32 i=0; i<cnt; ++i)
+	{
+		const core::triangle3df& tri = Triangles[i];
+		const f32 values[9] = { tri.pointA.X, tri.pointA.Y, tri.pointA.Z,
+			tri.pointB.X, tri.pointB.Y, tri.pointB.Z,
+			tri.pointC.X, tri.pointC.Y, tri.pointC.Z };
+		for (u32 v=0; v<9; ++v)
+		{
+			hash ^= IR(values[v]);
+			hash *= 16777619u;
+		}
+	}
+	return hash;
+}
+
+bool CTriangleSelector::isAccelerationDataHeaderValid(const SAccelerationDataHeader& header,
+	u32 type, u32 parameter, u32 nodeSize) const
+{
+	if (header.Magic != ACCELERATION_DATA_MAGIC || header.Version != ACCELERATION_DATA_VERSION ||
+		header.Type != type || header.Parameter != parameter || header.NodeSize != nodeSize)
+		return false;
+
+	if (header.TriangleCount != Triangles.size() || header.TrianglesHash != getTrianglesHash())
+	{
+		os::Printer::log("Acceleration data of triangle selector was written for other triangles", ELL_INFORMATION);
+		return false;
+	}
+
+	return true;
+}
+
 void CTriangleSelector::update(void) const
 {
 	if (!AnimatedNode)
@@ -464,6 +502,66 @@ void CTriangleSelector::getTriangles(core::triangle3df* triangles,
 }
 
 
+//! Gets the nearest intersection of a 3d line with the triangles of this selector.
+bool CTriangleSelector::getCollisionPoint(SCollisionHit& hitResult,
+		const core::line3d<f32>& line, bool useNodeTransform) const
+{
+	// Update my triangles if necessary
+	update();
+
+	core::matrix4 mat;
+	if (SceneNode && useNodeTransform)
+		mat = SceneNode->getAbsoluteTransformation();
+	const bool identity = mat.isIdentity();
+
+	// Test the triangles where they are instead of copying them out first
+	SNearestLineHit hit(line);
+	const u32 cnt = Triangles.size();
+	for (u32 i=0; i<cnt; ++i)
+	{
+		if (identity)
+		{
+			hit.test(Triangles[i], i);
+			continue;
+		}
+
+		core::triangle3df triangle;
+		mat.transformVect(triangle.pointA, Triangles[i].pointA);
+		mat.transformVect(triangle.pointB, Triangles[i].pointB);
+		mat.transformVect(triangle.pointC, Triangles[i].pointC);
+		hit.test(triangle, i);
+	}
+
+	if (!hit.Found)
+		return false;
+
+	hitResult.Intersection = hit.Intersection;
+	hitResult.Triangle = hit.Triangle;
+	setCollisionHitInfo(hitResult, hit.Index);
+	return true;
+}
+
+
+//! Sets node, meshbuffer and selector of a hit on one of the triangles
+void CTriangleSelector::setCollisionHitInfo(SCollisionHit& hitResult, u32 triangleIndex) const
+{
+	hitResult.Node = SceneNode;
+	hitResult.MeshBuffer = MeshBuffer;
+	hitResult.MaterialIndex = MaterialIndex;
+	hitResult.TriangleSelector = const_cast<CTriangleSelector*>(this);
+
+	for (u32 i=0; i<BufferRanges.size(); ++i)
+	{
+		if (BufferRanges[i].isIndexInRange(triangleIndex))
+		{
+			hitResult.MeshBuffer = BufferRanges[i].MeshBuffer;
+			hitResult.MaterialIndex = BufferRanges[i].MaterialIndex;
+			break;
+		}
+	}
+}
+
+
 //! Returns amount of all available triangles in this selector
 s32 CTriangleSelector::getTriangleCount() const
 {
@@ -471,6 +569,20 @@ s32 CTriangleSelector::getTriangleCount() const
 }
 
 
+//! Get a box around all triangles of this selector
+bool CTriangleSelector::getBoundingBox(core::aabbox3d<f32>& outBox, bool useNodeTransform) const
+{
+	// Update my triangles if necessary
+	update();
+
+	outBox = BoundingBox;
+	if (SceneNode && useNodeTransform)
+		SceneNode->getAbsoluteTransformation().transformBoxEx(outBox);
+
+	return true;
+}
+
+
 /* Get the number of TriangleSelectors that are part of this one.
 Only useful for MetaTriangleSelector others return 1
 */
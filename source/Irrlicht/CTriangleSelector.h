@@ -7,6 +7,9 @@
 
 #include "ITriangleSelector.h"
 #include "IMesh.h"
+#include "IMeshBuffer.h"
+#include "IReadFile.h"
+#include "IWriteFile.h"
 #include "irrArray.h"
 #include "aabbox3d.h"
 
@@ -18,6 +21,91 @@ namespace scene
 class ISceneNode;
 class IAnimatedMeshSceneNode;
 
+//! Nearest hit of a line, for selectors testing their triangles one by one
+struct SNearestLineHit
+{
+	SNearestLineHit(const core::line3d<f32>& line)
+		: Line(line), LineVect(line.getVector().normalize()),
+		RayLength(line.getLengthSQ()), Nearest(FLT_MAX), Index(0), Found(false)
+	{
+		Min.set(core::min_(line.start.X, line.end.X), core::min_(line.start.Y, line.end.Y), core::min_(line.start.Z, line.end.Z));
+		Max.set(core::max_(line.start.X, line.end.X), core::max_(line.start.Y, line.end.Y), core::max_(line.start.Z, line.end.Z));
+	}
+
+	//! Tests a triangle, index is stored when it is the nearest hit so far
+	void test(const core::triangle3df& triangle, u32 index=0)
+	{
+		if (Min.X > triangle.pointA.X && Min.X > triangle.pointB.X && Min.X > triangle.pointC.X)
+			return;
+		if (Max.X < triangle.pointA.X && Max.X < triangle.pointB.X && Max.X < triangle.pointC.X)
+			return;
+		if (Min.Y > triangle.pointA.Y && Min.Y > triangle.pointB.Y && Min.Y > triangle.pointC.Y)
+			return;
+		if (Max.Y < triangle.pointA.Y && Max.Y < triangle.pointB.Y && Max.Y < triangle.pointC.Y)
+			return;
+		if (Min.Z > triangle.pointA.Z && Min.Z > triangle.pointB.Z && Min.Z > triangle.pointC.Z)
+			return;
+		if (Max.Z < triangle.pointA.Z && Max.Z < triangle.pointB.Z && Max.Z < triangle.pointC.Z)
+			return;
+
+		core::vector3df intersection;
+		if (triangle.getIntersectionWithLine(Line.start, LineVect, intersection))
+		{
+			const f32 tmp = intersection.getDistanceFromSQ(Line.start);
+			const f32 tmp2 = intersection.getDistanceFromSQ(Line.end);
+
+			if (tmp < RayLength && tmp2 < RayLength && tmp < Nearest)
+			{
+				Nearest = tmp;
+				Triangle = triangle;
+				Intersection = intersection;
+				Index = index;
+				Found = true;
+			}
+		}
+	}
+
+	//! Line parameter of the nearest hit
+	f32 getNearestT() const
+	{
+		return Found ? sqrtf(Nearest / RayLength) : 1.f;
+	}
+
+	const core::line3d<f32>& Line;
+	core::vector3df LineVect;
+	core::vector3df Min;
+	core::vector3df Max;
+	f32 RayLength;
+	f32 Nearest;
+	core::triangle3df Triangle;
+	core::vector3df Intersection;
+	u32 Index;
+	bool Found;
+};
+
+//! Reads the vertex positions of a meshbuffer, quantized ones are decoded
+struct SVertexPositions
+{
+	SVertexPositions(const IMeshBuffer* buffer)
+		: Vertices(static_cast<const u8*>(buffer->getVertices())),
+		Pitch(video::getVertexPitchFromType(buffer->getVertexType())),
+		Quantization(buffer->getVertexQuantization())
+	{
+	}
+
+	core::vector3df operator[](u32 i) const
+	{
+		const u8* v = Vertices + i*Pitch;
+		if (Quantization)
+			return Quantization->decodePosition(reinterpret_cast<const video::S3DVertexQuantized*>(v)->Pos);
+		return reinterpret_cast<const video::S3DVertex*>(v)->Pos;
+	}
+
+	const u8* Vertices;
+	u32 Pitch;
+	const video::SVertexQuantization* Quantization;
+};
+
 //! Stupid triangle selector without optimization
 class CTriangleSelector : public ITriangleSelector
 {
@@ -55,9 +143,16 @@ public:
 		const core::matrix4* transform, bool useNodeTransform, 
 		irr::core::array<SCollisionTriangleRange>* outTriangleInfo) const IRR_OVERRIDE;
 
+	//! Gets the nearest intersection of a 3d line with the triangles of this selector.
+	virtual bool getCollisionPoint(SCollisionHit& hitResult, const core::line3d<f32>& line,
+		bool useNodeTransform) const IRR_OVERRIDE;
+
 	//! Returns amount of all available triangles in this selector
 	virtual s32 getTriangleCount() const IRR_OVERRIDE;
 
+	//! Get a box around all triangles of this selector
+	virtual bool getBoundingBox(core::aabbox3d<f32>& outBox, bool useNodeTransform) const IRR_OVERRIDE;
+
 	//! Return the scene node associated with a given triangle.
 	virtual ISceneNode* getSceneNodeForTriangle(u32 triangleIndex) const IRR_OVERRIDE { return SceneNode; }
 
@@ -71,6 +166,9 @@ public:
 	virtual const ITriangleSelector* getSelector(u32 index) const IRR_OVERRIDE;
 
 protected:
+	//! Sets node, meshbuffer and selector of a hit on one of the triangles
+	void setCollisionHitInfo(SCollisionHit& hitResult, u32 triangleIndex) const;
+
 	//! Create from a mesh
 	virtual void createFromMesh(const IMesh* mesh, bool createBufferRanges);
 
@@ -91,6 +189,103 @@ protected:
 	//! since the last time it was updated.
 	virtual void update(void) const;
 
+	//! Header in front of the data written by writeAccelerationData()
+	struct SAccelerationDataHeader
+	{
+		u32 Magic;
+		u32 Version;
+		u32 Type;		// id of the selector class which wrote the data
+		u32 Parameter;	// build parameter of that selector
+		u32 TriangleCount;
+		u32 TrianglesHash;
+		u32 NodeSize;
+		u32 NodeCount;
+		u32 IndexCount;
+	};
+
+	//! Hash over all triangles, to find out if acceleration data was built for them
+	u32 getTrianglesHash() const;
+
+	//! Checks if a header was written for the current triangles with the same build settings
+	bool isAccelerationDataHeaderValid(const SAccelerationDataHeader& header,
+		u32 type, u32 parameter, u32 nodeSize) const;
+
+	//! Writes a header followed by the nodes and triangle indices of a tree
+	template <class TNode>
+	bool writeTreeData(io::IWriteFile* file, u32 type, u32 parameter,
+		const core::array<TNode>& nodes, const core::array<u32>& indices) const
+	{
+		if (!file)
+			return false;
+
+		SAccelerationDataHeader header;
+		header.Magic = ACCELERATION_DATA_MAGIC;
+		header.Version = ACCELERATION_DATA_VERSION;
+		header.Type = type;
+		header.Parameter = parameter;
+		header.TriangleCount = Triangles.size();
+		header.TrianglesHash = getTrianglesHash();
+		header.NodeSize = sizeof(TNode);
+		header.NodeCount = nodes.size();
+		header.IndexCount = indices.size();
+
+		const size_t nodeBytes = nodes.size() * sizeof(TNode);
+		const size_t indexBytes = indices.size() * sizeof(u32);
+		return file->write(&header, sizeof(header)) == sizeof(header) &&
+			file->write(nodes.const_pointer(), nodeBytes) == nodeBytes &&
+			file->write(indices.const_pointer(), indexBytes) == indexBytes;
+	}
+
+	//! Reads the nodes and triangle indices of a tree written by writeTreeData()
+	/** The arrays are read in one block each. Callers still have to check
+	the indices stored in the nodes.
+	\return False if the data doesn't fit the current triangles, then the
+	arrays are left unchanged. */
+	template <class TNode>
+	bool readTreeData(io::IReadFile* file, u32 type, u32 parameter,
+		core::array<TNode>& nodes, core::array<u32>& indices) const
+	{
+		if (!file)
+			return false;
+
+		SAccelerationDataHeader header;
+		if (file->read(&header, sizeof(header)) != sizeof(header) ||
+			!isAccelerationDataHeaderValid(header, type, parameter, sizeof(TNode)))
+			return false;
+
+		const size_t remaining = (size_t)core::max_(file->getSize() - file->getPos(), 0L);
+		if (header.NodeCount > remaining / sizeof(TNode) ||
+			header.IndexCount > (remaining - header.NodeCount * sizeof(TNode)) / sizeof(u32))
+			return false;
+
+		const size_t nodeBytes = header.NodeCount * sizeof(TNode);
+		const size_t indexBytes = header.IndexCount * sizeof(u32);
+
+		core::array<TNode> newNodes;
+		core::array<u32> newIndices;
+		newNodes.set_used(header.NodeCount);
+		newIndices.set_used(header.IndexCount);
+		if (file->read(newNodes.pointer(), nodeBytes) != nodeBytes ||
+			file->read(newIndices.pointer(), indexBytes) != indexBytes)
+			return false;
+
+		for (u32 i=0; i<header.IndexCount; ++i)
+		{
+			if (newIndices[i] >= header.TriangleCount)
+				return false;
+		}
+
+		nodes.swap(newNodes);
+		indices.swap(newIndices);
+		return true;
+	}
+
+	enum
+	{
+		ACCELERATION_DATA_MAGIC = MAKE_IRR_ID('i','r','t','s'),
+		ACCELERATION_DATA_VERSION = 1
+	};
+
 	irr::core::array<SCollisionTriangleRange> BufferRanges;
 
 	ISceneNode* SceneNode;
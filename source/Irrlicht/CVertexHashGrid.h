@@ -0,0 +1,210 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_C_VERTEX_HASH_GRID_H_INCLUDED
+#define IRR_C_VERTEX_HASH_GRID_H_INCLUDED
+
+#include "irrArray.h"
+#include "vector3d.h"
+#include "S3DVertex.h"
+#include <math.h>
+#include <string.h>
+
+namespace irr
+{
+namespace scene
+{
+
+//! Finds vertices with positions close to a given position
+/** The positions are sorted into cubic cells much larger than the tolerance,
+so a search usually only has to look at the cell of the position and rarely at
+the neighbours it is close to. Close means 4 times the tolerance, because the
+f32 comparisons of core::equals() accept differences of up to about 3 times
+the tolerance for large coordinates. With a tolerance of 0 only equal
+positions share a cell. Used to weld vertices in linear instead of quadratic
+time. */
+class CVertexHashGrid
+{
+public:
+
+	//! Constructor
+	/** \param tolerance Largest difference per axis of positions which should
+	be found.
+	\param vertexCount Expected number of added vertices. */
+	CVertexHashGrid(f32 tolerance, u32 vertexCount)
+		: InvCellSize(tolerance > 0.f ? 1.0 / (tolerance * CellSizeFactor) : 0.0)
+	{
+		u32 size = 64;
+		while (size < vertexCount)
+			size <<= 1;
+		Buckets.set_used(size);
+		for (u32 i=0; i<size; ++i)
+			Buckets[i] = -1;
+		Next.reallocate(vertexCount);
+	}
+
+	//! Adds the position of the next vertex
+	/** Vertices are numbered in the order they are added, starting at 0. */
+	void add(const core::vector3df& pos)
+	{
+		s32* bucket = &Buckets[hash(cell(pos.X), cell(pos.Y), cell(pos.Z)) & (Buckets.size()-1)];
+		Next.push_back(*bucket);
+		*bucket = (s32)Next.size()-1;
+	}
+
+	//! Returns the number of added vertices
+	u32 size() const
+	{
+		return Next.size();
+	}
+
+	//! Finds the lowest added vertex accepted by a match functor
+	/** Only vertices in the cells around pos are passed to match(s32 vertex),
+	which has to do the exact comparison itself.
+	\return Index of the vertex or -1 if none was accepted. */
+	template <class TMatch>
+	s32 find(const core::vector3df& pos, TMatch& match) const
+	{
+		s64 c[3];
+		s32 lo[3], hi[3];
+		const f32 v[3] = { pos.X, pos.Y, pos.Z };
+		for (u32 i=0; i<3; ++i)
+		{
+			c[i] = cell(v[i]);
+			lo[i] = 0;
+			hi[i] = 0;
+			if (InvCellSize > 0.0)
+			{
+				// position within the cell, 0 to CellSizeFactor tolerances
+				const f64 inside = (v[i] * InvCellSize - (f64)c[i]) * CellSizeFactor;
+				if (inside < 4.0)
+					lo[i] = -1;
+				if (inside > CellSizeFactor - 4.0)
+					hi[i] = 1;
+			}
+		}
+
+		s32 found = -1;
+		for (s32 dz=lo[2]; dz<=hi[2]; ++dz)
+		{
+			for (s32 dy=lo[1]; dy<=hi[1]; ++dy)
+			{
+				for (s32 dx=lo[0]; dx<=hi[0]; ++dx)
+				{
+					// chains go from the newest to the oldest vertex
+					for (s32 i=Buckets[hash(c[0]+dx, c[1]+dy, c[2]+dz) & (Buckets.size()-1)]; i != -1; i = Next[i])
+					{
+						if ((found == -1 || i < found) && match(i))
+							found = i;
+					}
+				}
+			}
+		}
+		return found;
+	}
+
+private:
+
+	//! Edge length of the cells in tolerances
+	enum { CellSizeFactor = 32 };
+
+	s64 cell(f32 v) const
+	{
+		if (InvCellSize > 0.0)
+		{
+			const f64 c = floor(v * InvCellSize);
+			// also catches NaN, which never matches anything anyway
+			if (!(c > -1e15 && c < 1e15))
+				return c > 0.0 ? (s64)1e15 : (s64)-1e15;
+			return (s64)c;
+		}
+
+		// exact positions, 0 and -0 have to meet
+		if (v == 0.f)
+			return 0;
+		u32 bits;
+		memcpy(&bits, &v, 4);
+		return bits;
+	}
+
+	static u32 hash(s64 x, s64 y, s64 z)
+	{
+		u32 h = (u32)x * 73856093u ^ (u32)y * 19349663u ^ (u32)z * 83492791u;
+		return h ^ (h >> 16);
+	}
+
+	core::array<s32> Buckets;
+	core::array<s32> Next; // next older vertex in the same bucket, -1 ends a chain
+	f64 InvCellSize; // 0 for exact positions
+};
+
+
+//! Vertex comparisons of IMeshManipulator::createMeshWelded()
+inline bool weldEquals(const video::S3DVertex& a, const video::S3DVertex& b, f32 tolerance)
+{
+	return a.Pos.equals(b.Pos, tolerance) &&
+		a.Normal.equals(b.Normal, tolerance) &&
+		a.TCoords.equals(b.TCoords) &&
+		a.Color == b.Color;
+}
+
+inline bool weldEquals(const video::S3DVertex2TCoords& a, const video::S3DVertex2TCoords& b, f32 tolerance)
+{
+	return weldEquals(static_cast<const video::S3DVertex&>(a), static_cast<const video::S3DVertex&>(b), tolerance) &&
+		a.TCoords2.equals(b.TCoords2);
+}
+
+inline bool weldEquals(const video::S3DVertexTangents& a, const video::S3DVertexTangents& b, f32 tolerance)
+{
+	return weldEquals(static_cast<const video::S3DVertex&>(a), static_cast<const video::S3DVertex&>(b), tolerance) &&
+		a.Tangent.equals(b.Tangent, tolerance) &&
+		a.Binormal.equals(b.Binormal, tolerance);
+}
+
+//! Match functor of CVertexHashGrid::find() for weldEquals()
+template <class T>
+struct SWeldMatch
+{
+	bool operator()(s32 other) const
+	{
+		return weldEquals(*Vertex, Vertices[other], Tolerance);
+	}
+
+	const T* Vertices;
+	const T* Vertex;
+	f32 Tolerance;
+};
+
+//! Welds vertices like IMeshManipulator::createMeshWelded()
+/** Each vertex is merged into the first earlier vertex it equals.
+\param redirects Receives the new index of each vertex. Kept vertices are
+numbered in their order, so vertex i is kept if redirects[i] is the number of
+vertices kept before it.
+\return Number of kept vertices. */
+template <class T>
+u32 weldVertices(const T* vertices, u32 vertexCount, f32 tolerance, core::array<u32>& redirects)
+{
+	// all vertices go into the grid, not only the kept ones, as the
+	// tolerance makes equality intransitive
+	CVertexHashGrid grid(tolerance, vertexCount);
+	SWeldMatch<T> match;
+	match.Vertices = vertices;
+	match.Tolerance = tolerance;
+
+	redirects.set_used(vertexCount);
+	u32 kept = 0;
+	for (u32 i=0; i<vertexCount; ++i)
+	{
+		match.Vertex = &vertices[i];
+		const s32 found = grid.find(vertices[i].Pos, match);
+		redirects[i] = found != -1 ? redirects[found] : kept++;
+		grid.add(vertices[i].Pos);
+	}
+	return kept;
+}
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
@@ -100,6 +100,7 @@ CWADReader::CWADReader(IReadFile* file, bool ignoreCase, bool ignorePaths)
 	if (File)
 	{
 		File->grab();
+		ReadHandles.set(File);
 
 		Base = File->getFileName();
 		Base.replace ( '\\', '/' );
@@ -250,7 +251,7 @@ IReadFile* CWADReader::createAndOpenFile(u32 index)
 		return 0;
 
 	const SFileListEntry &entry = Files[index];
-	return createLimitReadFile( entry.FullName, File, entry.Offset, entry.Size );
+	return createLimitReadFile( entry.FullName, ReadHandles.get(), entry.Offset, entry.Size );
 }
 
 
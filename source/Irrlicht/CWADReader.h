@@ -10,6 +10,7 @@
 
 #include "IReferenceCounted.h"
 #include "IReadFile.h"
+#include "CPerThreadReadFile.h"
 #include "irrArray.h"
 #include "irrString.h"
 #include "IFileSystem.h"
@@ -158,6 +159,9 @@ namespace io
 
 		IReadFile* File;
 
+		//! Handles to File for the threads opening entries
+		CPerThreadReadFile ReadHandles;
+
 		eWADFileTypes WadType;
 		SWADFileHeader Header;
 
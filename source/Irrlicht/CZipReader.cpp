@@ -16,6 +16,7 @@ extern "C" void bz_internal_error(int errorCode)
 
 #include "CFileList.h"
 #include "CReadFile.h"
+#include "CMemoryFile.h"
 #include "coreutil.h"
 
 #include "IrrCompileConfig.h"
@@ -46,6 +47,31 @@ namespace irr
 namespace io
 {
 
+namespace
+{
+	//! Maximal number of threads decompressing in prefetchFiles()
+	const u32 MAX_PREFETCH_THREADS = 4;
+
+	//! Stored file read in place from an archive which is in memory
+	class CZipStoredReadFile : public CMemoryReadFile
+	{
+	public:
+		CZipStoredReadFile(IReadFile* archive, const void* memory, long len, const io::path& fileName)
+			: CMemoryReadFile(memory, len, fileName, false), Archive(archive)
+		{
+			Archive->grab();
+		}
+
+		virtual ~CZipStoredReadFile()
+		{
+			Archive->drop();
+		}
+
+	private:
+		IReadFile* Archive;
+	};
+}
+
 
 // -----------------------------------------------------------------------------
 // zip loader
@@ -138,7 +164,8 @@ bool CArchiveLoaderZIP::isALoadableFileFormat(io::IReadFile* file) const
 // -----------------------------------------------------------------------------
 
 CZipReader::CZipReader(IFileSystem* fs, IReadFile* file, bool ignoreCase, bool ignorePaths, bool isGZip)
- : CFileList((file ? file->getFileName() : io::path("")), ignoreCase, ignorePaths), FileSystem(fs), File(file), IsGZip(isGZip)
+ : CFileList((file ? file->getFileName() : io::path("")), ignoreCase, ignorePaths), FileSystem(fs), File(file),
+	CacheSize(0), CacheBudget(0), CacheTick(0), IsGZip(isGZip)
 {
 	#ifdef _DEBUG
 	setDebugName("CZipReader");
@@ -147,6 +174,7 @@ CZipReader::CZipReader(IFileSystem* fs, IReadFile* file, bool ignoreCase, bool i
 	if (File)
 	{
 		File->grab();
+		ReadHandles.set(File);
 
 		// load file entries
 		if (IsGZip)
@@ -160,6 +188,8 @@ CZipReader::CZipReader(IFileSystem* fs, IReadFile* file, bool ignoreCase, bool i
 
 CZipReader::~CZipReader()
 {
+	shrinkCache(0);
+
 	if (File)
 		File->drop();
 }
@@ -508,6 +538,225 @@ namespace
 
 //! opens a file by index
 IReadFile* CZipReader::createAndOpenFile(u32 index)
+{
+	const SZipFileEntry &e = FileInfo[Files[index].ID];
+	IReadFile* file = ReadHandles.get();
+
+	if (e.header.CompressionMethod == 0 && !(e.header.GeneralBitFlag & ZIP_FILE_ENCRYPTED))
+	{
+		// stored files of archives in memory (or mapped) are used in place
+		const u32 size = e.header.DataDescriptor.CompressedSize;
+		if ((file->getType() == ERFT_MEMORY_READ_FILE || file->getType() == ERFT_MAPPED_READ_FILE) &&
+			e.Offset >= 0 && e.Offset + (long)size <= file->getSize())
+		{
+			// handles of other threads don't own the memory, so the original is kept alive
+			const u8* data = (const u8*)static_cast<IMemoryReadFile*>(file)->getBuffer();
+			return new CZipStoredReadFile(ReadHandles.getOriginal(), data + e.Offset, size, Files[index].FullName);
+		}
+		return createLimitReadFile(Files[index].FullName, file, e.Offset, size);
+	}
+
+	// decrypted files are not cached, the next call might use another password
+	if (e.header.GeneralBitFlag & ZIP_FILE_ENCRYPTED)
+		return decompressFile(index, file);
+
+	IReadFile* cached = createCachedFile(index);
+	if (cached)
+		return cached;
+
+	IReadFile* result = decompressFile(index, file);
+	addToCache(index, result);
+	return result;
+}
+
+
+//! Sets how much memory is kept for decompressed files
+void CZipReader::setDecompressionCacheSize(u32 bytes)
+{
+	CMutexLock lock(CacheMutex);
+	CacheBudget = bytes;
+	shrinkCache(CacheBudget);
+}
+
+
+//! Returns a copy of a cached file, 0 if it is not in the cache
+IReadFile* CZipReader::createCachedFile(u32 index)
+{
+	CMutexLock lock(CacheMutex);
+	for (u32 i=0; i<Cache.size(); ++i)
+	{
+		SCachedFile& c = Cache[i];
+		if (c.Index != index)
+			continue;
+
+		// Copying is much cheaper than decompressing and keeps the returned
+		// file independent of the cache and of other threads.
+		c.LastUsed = ++CacheTick;
+		u8* copy = new u8[c.Size];
+		memcpy(copy, c.Data, c.Size);
+		return FileSystem->createMemoryReadFile(copy, c.Size, Files[index].FullName, true);
+	}
+	return 0;
+}
+
+
+//! Checks if a file is in the cache
+bool CZipReader::isCached(u32 index) const
+{
+	CMutexLock lock(CacheMutex);
+	for (u32 i=0; i<Cache.size(); ++i)
+	{
+		if (Cache[i].Index == index)
+			return true;
+	}
+	return false;
+}
+
+
+//! Keeps a copy of a decompressed file in the cache
+void CZipReader::addToCache(u32 index, IReadFile* file)
+{
+	if (!file || file->getType() != ERFT_MEMORY_READ_FILE)
+		return;
+
+	const u32 size = (u32)file->getSize();
+	CMutexLock lock(CacheMutex);
+	if (size == 0 || size > CacheBudget)
+		return;
+
+	for (u32 i=0; i<Cache.size(); ++i)
+	{
+		if (Cache[i].Index == index)
+		{
+			Cache[i].LastUsed = ++CacheTick;
+			return;
+		}
+	}
+
+	shrinkCache(CacheBudget - size);
+
+	SCachedFile c;
+	c.Data = new u8[size];
+	memcpy(c.Data, static_cast<IMemoryReadFile*>(file)->getBuffer(), size);
+	c.Size = size;
+	c.Index = index;
+	c.LastUsed = ++CacheTick;
+	Cache.push_back(c);
+	CacheSize += size;
+}
+
+
+//! Removes least recently used files until the cache fits into its budget
+void CZipReader::shrinkCache(u32 budget)
+{
+	CMutexLock lock(CacheMutex);
+	while (CacheSize > budget)
+	{
+		u32 oldest = 0;
+		for (u32 i=1; i<Cache.size(); ++i)
+		{
+			if (Cache[i].LastUsed < Cache[oldest].LastUsed)
+				oldest = i;
+		}
+		CacheSize -= Cache[oldest].Size;
+		delete [] Cache[oldest].Data;
+		Cache.erase(oldest);
+	}
+}
+
+
+//! Shared state of the prefetch threads
+struct CZipReader::SPrefetchJob
+{
+	CZipReader* Reader;
+	core::array<u32> Indices;
+	u32 Next;
+	CMutex Mutex;
+};
+
+
+//! Decompresses files on several threads and keeps them in the cache
+u32 CZipReader::prefetchFiles(const core::array<io::path>& filenames)
+{
+	SPrefetchJob job;
+	job.Reader = this;
+	job.Next = 0;
+
+	core::array<u32> requested;
+	for (u32 i=0; i<filenames.size(); ++i)
+	{
+		const s32 index = findFile(filenames[i], false);
+		if (index == -1)
+			continue;
+
+		// stored files are not decompressed, encrypted ones not cached
+		const SZipFileEntry &e = FileInfo[Files[index].ID];
+		if (e.header.CompressionMethod == 0 || (e.header.GeneralBitFlag & ZIP_FILE_ENCRYPTED))
+			continue;
+
+		requested.push_back(index);
+		if (!isCached(index))
+			job.Indices.push_back(index);
+	}
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	// the calling thread decompresses as well
+	u32 threadCount = core::min_(CThread::getHardwareConcurrency(), job.Indices.size(), MAX_PREFETCH_THREADS);
+	threadCount = threadCount ? threadCount-1 : 0;
+	CThread threads[MAX_PREFETCH_THREADS];
+	for (u32 i=0; i<threadCount; ++i)
+		threads[i].start(prefetchThread, &job);
+	prefetchThread(&job);
+	for (u32 i=0; i<threadCount; ++i)
+		threads[i].join();
+#else
+	prefetchThread(&job);
+#endif
+
+	u32 cached = 0;
+	for (u32 i=0; i<requested.size(); ++i)
+	{
+		if (isCached(requested[i]))
+			++cached;
+	}
+	return cached;
+}
+
+
+//! Worker of prefetchFiles()
+void CZipReader::prefetchThread(void* data)
+{
+	SPrefetchJob& job = *(SPrefetchJob*)data;
+	CZipReader* reader = job.Reader;
+
+	// the thread ends soon, so it doesn't leave a handle in the archive
+	IReadFile* archive = reader->ReadHandles.createOwnHandle();
+
+	while (archive)
+	{
+		u32 index;
+		{
+			CMutexLock lock(job.Mutex);
+			if (job.Next >= job.Indices.size())
+				break;
+			index = job.Indices[job.Next++];
+		}
+
+		IReadFile* file = reader->decompressFile(index, archive);
+		if (file)
+		{
+			reader->addToCache(index, file);
+			file->drop();
+		}
+	}
+
+	if (archive)
+		archive->drop();
+}
+
+
+//! Opens a file by index without using the cache
+IReadFile* CZipReader::decompressFile(u32 index, IReadFile* file)
 {
 	// Irrlicht supports 0, 8, 12, 14, 99
 	//0 - The file is stored (no compression)
@@ -540,11 +789,11 @@ IReadFile* CZipReader::createAndOpenFile(u32 index)
 		os::Printer::log("Reading encrypted file.");
 		u8 salt[16]={0};
 		const u16 saltSize = (((e.header.Sig & 0x00ff0000) >>16)+1)*4;
-		File->seek(e.Offset);
-		File->read(salt, saltSize);
+		file->seek(e.Offset);
+		file->read(salt, saltSize);
 		char pwVerification[2];
 		char pwVerificationFile[2];
-		File->read(pwVerification, 2);
+		file->read(pwVerification, 2);
 		fcrypt_ctx zctx; // the encryption context
 		int rc = fcrypt_init(
 			(e.header.Sig & 0x00ff0000) >>16,
@@ -563,14 +812,14 @@ IReadFile* CZipReader::createAndOpenFile(u32 index)
 		u32 c = 0;
 		while ((c+32768)<=decryptedSize)
 		{
-			File->read(decryptedBuf+c, 32768);
+			file->read(decryptedBuf+c, 32768);
 			fcrypt_decrypt(
 				decryptedBuf+c, // pointer to the data to decrypt
 				32768,   // how many bytes to decrypt
 				&zctx); // decryption context
 			c+=32768;
 		}
-		File->read(decryptedBuf+c, decryptedSize-c);
+		file->read(decryptedBuf+c, decryptedSize-c);
 		fcrypt_decrypt(
 			decryptedBuf+c, // pointer to the data to decrypt
 			decryptedSize-c,   // how many bytes to decrypt
@@ -587,7 +836,7 @@ IReadFile* CZipReader::createAndOpenFile(u32 index)
 			delete [] decryptedBuf;
 			return 0;
 		}
-		File->read(fileMAC, 10);
+		file->read(fileMAC, 10);
 		if (strncmp(fileMAC, resMAC, 10))
 		{
 			os::Printer::log("Error on encryption check");
@@ -618,7 +867,7 @@ IReadFile* CZipReader::createAndOpenFile(u32 index)
 			if (decrypted)
 				return decrypted;
 			else
-				return createLimitReadFile(Files[index].FullName, File, e.Offset, decryptedSize);
+				return createLimitReadFile(Files[index].FullName, file, e.Offset, decryptedSize);
 		}
 	case 8:
 		{
@@ -648,8 +897,8 @@ IReadFile* CZipReader::createAndOpenFile(u32 index)
 				}
 
 				//memset(pcData, 0, decryptedSize);
-				File->seek(e.Offset);
-				File->read(pcData, decryptedSize);
+				file->seek(e.Offset);
+				file->read(pcData, decryptedSize);
 			}
 
 			// Setup the inflate stream.
@@ -722,8 +971,8 @@ IReadFile* CZipReader::createAndOpenFile(u32 index)
 				}
 
 				//memset(pcData, 0, decryptedSize);
-				File->seek(e.Offset);
-				File->read(pcData, decryptedSize);
+				file->seek(e.Offset);
+				file->read(pcData, decryptedSize);
 			}
 
 			bz_stream bz_ctx;
@@ -795,8 +1044,8 @@ IReadFile* CZipReader::createAndOpenFile(u32 index)
 				}
 
 				//memset(pcData, 0, decryptedSize);
-				File->seek(e.Offset);
-				File->read(pcData, decryptedSize);
+				file->seek(e.Offset);
+				file->read(pcData, decryptedSize);
 			}
 
 			ELzmaStatus status;
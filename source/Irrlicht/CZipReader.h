@@ -10,6 +10,8 @@
 #ifdef __IRR_COMPILE_WITH_ZIP_ARCHIVE_LOADER_
 
 #include "IReadFile.h"
+#include "CPerThreadReadFile.h"
+#include "CThread.h"
 #include "irrArray.h"
 #include "irrString.h"
 #include "IFileSystem.h"
@@ -200,6 +202,12 @@ namespace io
 		//! return the id of the file Archive
 		virtual const io::path& getArchiveName() const IRR_OVERRIDE {return Path;}
 
+		//! Sets how much memory is kept for decompressed files
+		virtual void setDecompressionCacheSize(u32 bytes) IRR_OVERRIDE;
+
+		//! Decompresses files on several threads and keeps them in the cache
+		virtual u32 prefetchFiles(const core::array<io::path>& filenames) IRR_OVERRIDE;
+
 	protected:
 
 		//! reads the next file header from a ZIP file, returns false if there are no more headers.
@@ -213,12 +221,50 @@ namespace io
 
 		bool scanCentralDirectoryHeader();
 
+		//! Opens a file by index without using the cache
+		IReadFile* decompressFile(u32 index, IReadFile* file);
+
+		//! Returns a copy of a cached file, 0 if it is not in the cache
+		IReadFile* createCachedFile(u32 index);
+
+		//! Checks if a file is in the cache
+		bool isCached(u32 index) const;
+
+		//! Keeps a copy of a decompressed file in the cache
+		void addToCache(u32 index, IReadFile* file);
+
+		//! Removes least recently used files until the cache fits into its budget
+		void shrinkCache(u32 budget);
+
+		//! Worker of prefetchFiles()
+		static void prefetchThread(void* data);
+
+		struct SPrefetchJob;
+
+		struct SCachedFile
+		{
+			u8* Data;
+			u32 Size;
+			u32 Index;
+			u32 LastUsed;
+		};
+
 		io::IFileSystem* FileSystem;
 		IReadFile* File;
 
+		//! Handles to File for the threads opening entries
+		CPerThreadReadFile ReadHandles;
+
 		// holds extended info about files
 		core::array<SZipFileEntry> FileInfo;
 
+		//! Recently decompressed files, guarded by CacheMutex
+		core::array<SCachedFile> Cache;
+		u32 CacheSize;
+		u32 CacheBudget;
+		u32 CacheTick;
+		mutable CMutex CacheMutex;
+
 		bool IsGZip;
 	};
 
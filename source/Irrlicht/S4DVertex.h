@@ -9,6 +9,7 @@
 #include "SoftwareDriver2_helper.h"
 #include "irrAllocator.h"
 #include "EPrimitiveTypes.h"
+#include "S3DVertex.h"
 
 namespace irr
 {
@@ -720,6 +721,12 @@ struct SVertexCache
 	scene::E_PRIMITIVE_TYPE pType;		//scene::E_PRIMITIVE_TYPE
 	e4DIndexType iType;		//E_INDEX_TYPE iType
 
+	// quantized source vertices (EVT_QUANTIZED, EVT_QUANTIZED_TANGENTS), 0 for float vertices
+	const video::SVertexQuantization* quantization;
+	bool quantizedTangents;
+	// last decoded quantized vertex
+	video::S3DVertexTangents decoded;
+
 };
 
 
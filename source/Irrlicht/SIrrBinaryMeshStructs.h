@@ -0,0 +1,84 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+// Layout of the binary .irrbmesh files written by CIrrBinaryMeshWriter
+//
+// All values are little endian, strings are stored as u32 length followed
+// by the characters and padded to 4 bytes.
+//
+// SIrrBinaryMeshHeader
+// for each mesh buffer:
+//   SIrrBinaryMeshBuffer
+//   material: u32 type, 4 u32 colors, 7 f32 (shininess, type params,
+//     thickness, blend factor, polygon offset bias and slope scale),
+//     8 u8 (z buffer, anti aliasing, color mask, color material, blend
+//     operation, polygon offset factor and direction, z write), u32 flags,
+//     u32 layer count and per layer: texture name, 8 u8 (wrap u/v/w,
+//     anisotropic filter, lod bias, bilinear, trilinear, has matrix) and
+//     16 f32 texture matrix if it has one
+//   padding to 16 bytes, vertices as in memory (video::S3DVertex etc.)
+//   padding to 16 bytes, indices as in memory (u16 or u32)
+// for each joint (skinned meshes only):
+//   name, 16 f32 local matrix, 16 f32 global inversed matrix,
+//   u32 count and child joint indices, u32 count and attached buffer indices,
+//   u32 count and position keys (4 f32 each), u32 count and scale keys
+//   (4 f32 each), u32 count and rotation keys (5 f32 each),
+//   u32 count and weights (u32 buffer, u32 vertex, f32 strength each)
+
+#ifndef IRR_S_IRR_BINARY_MESH_STRUCTS_H_INCLUDED
+#define IRR_S_IRR_BINARY_MESH_STRUCTS_H_INCLUDED
+
+#include "irrTypes.h"
+
+namespace irr
+{
+namespace scene
+{
+
+//! Current version of the format
+const u32 IRR_BINARY_MESH_VERSION = 1;
+
+//! Alignment of the vertex and index data in the file
+const u32 IRR_BINARY_MESH_DATA_ALIGNMENT = 16;
+
+//! Flags in SIrrBinaryMeshHeader::Flags
+enum E_IRR_BINARY_MESH_FLAGS
+{
+	//! The mesh is an ISkinnedMesh, joints follow the mesh buffers
+	EIBMF_SKINNED = 1
+};
+
+// byte-align structures
+#include "irrpack.h"
+
+struct SIrrBinaryMeshHeader
+{
+	c8 Magic[4]; // "IRRB"
+	u32 Version;
+	u32 Flags;
+	u32 BufferCount;
+	u32 JointCount;
+	f32 AnimationSpeed;
+	f32 BoundingBox[6];
+} PACK_STRUCT;
+
+struct SIrrBinaryMeshBuffer
+{
+	u32 VertexType;
+	u32 IndexType;
+	u32 PrimitiveType;
+	u32 VertexCount;
+	u32 IndexCount;
+	u32 MappingHintVertex;
+	u32 MappingHintIndex;
+	f32 BoundingBox[6];
+} PACK_STRUCT;
+
+// Default alignment
+#include "irrunpack.h"
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
@@ -1,4 +1,11 @@
 #include "testUtils.h"
+#include <stdio.h> // For rename()
+
+#if defined(_IRR_WINDOWS_API_)
+#include <windows.h> // For CreateThread()
+#elif defined(_IRR_POSIX_API_)
+#include <pthread.h>
+#endif
 
 using namespace irr;
 using namespace core;
@@ -267,6 +274,26 @@ bool testEncryptedZip(IFileSystem* fs)
 		logTestString("Read bad data from archive: %s\n", tmp);
 		return false;
 	}
+
+	// decrypted files must not be served from the cache to a wrong password
+	archive->setDecompressionCacheSize(1024*1024);
+	readFile = fs->createAndOpenFile(filename);
+	if (readFile)
+		readFile->drop();
+	archive->Password="wrong";
+	readFile = fs->createAndOpenFile(filename);
+	if ( readFile )
+	{
+		memset(tmp, 0, sizeof(tmp));
+		readFile->read(tmp, 12);
+		readFile->drop();
+		if (!strncmp(tmp, "Linux Users:", 12))
+		{
+			logTestString("Read decrypted data with a wrong password\n");
+			fs->removeFileArchive(fs->getFileArchiveCount()-1);
+			return false;
+		}
+	}
 #endif
 
 	if (!fs->removeFileArchive(fs->getFileArchiveCount()-1))
@@ -426,6 +453,281 @@ bool testAddRemove(IFileSystem* fs, const io::path& archiveName)
 }
 
 
+struct SConcurrentReader
+{
+	IFileSystem* FileSystem;
+	u32 Offset;
+	bool Result;
+};
+
+#if defined(_IRR_WINDOWS_API_)
+DWORD WINAPI concurrentReadThread(LPVOID data)
+#else
+void* concurrentReadThread(void* data)
+#endif
+{
+	SConcurrentReader& reader = *(SConcurrentReader*)data;
+	const char* names[] = {"test/test.txt", "mypath/myfile.txt", "mypath/mypath/myfile.txt"};
+	const char* content[] = {"Hello world!", "1est\n", "2est"};
+
+	reader.Result = true;
+	for (u32 n=0; n<300; ++n)
+	{
+		const u32 i = (reader.Offset + n) % 3;
+		IReadFile* file = reader.FileSystem->createAndOpenFile(names[i]);
+		if (!file)
+		{
+			reader.Result = false;
+			continue;
+		}
+		char tmp[13] = {'\0'};
+		file->read(tmp, 12);
+		reader.Result &= strcmp(tmp, content[i]) == 0;
+		file->drop();
+	}
+	return 0;
+}
+
+// Opens and reads files of the mounted archives from several threads at the same time
+bool runConcurrentReaders(IFileSystem* fs, const io::path& archiveName)
+{
+	const u32 threadCount = 8;
+	SConcurrentReader readers[threadCount];
+	for (u32 i=0; i<threadCount; ++i)
+	{
+		readers[i].FileSystem = fs;
+		readers[i].Offset = i;
+		readers[i].Result = false;
+	}
+
+#if defined(_IRR_WINDOWS_API_)
+	HANDLE handles[threadCount];
+	for (u32 i=0; i<threadCount; ++i)
+		handles[i] = CreateThread(0, 0, concurrentReadThread, &readers[i], 0, 0);
+	for (u32 i=0; i<threadCount; ++i)
+	{
+		if (handles[i])
+		{
+			WaitForSingleObject(handles[i], INFINITE);
+			CloseHandle(handles[i]);
+		}
+		else
+			concurrentReadThread(&readers[i]);
+	}
+#elif defined(_IRR_POSIX_API_)
+	pthread_t handles[threadCount];
+	bool started[threadCount];
+	for (u32 i=0; i<threadCount; ++i)
+		started[i] = pthread_create(&handles[i], 0, concurrentReadThread, &readers[i]) == 0;
+	for (u32 i=0; i<threadCount; ++i)
+	{
+		if (started[i])
+			pthread_join(handles[i], 0);
+		else
+			concurrentReadThread(&readers[i]);
+	}
+#else
+	for (u32 i=0; i<threadCount; ++i)
+		concurrentReadThread(&readers[i]);
+#endif
+
+	bool result = true;
+	for (u32 i=0; i<threadCount; ++i)
+	{
+		if (!readers[i].Result)
+		{
+			logTestString("runConcurrentReaders: thread %u read bad data from %s.\n", i, archiveName.c_str());
+			result = false;
+		}
+	}
+	return result;
+}
+
+// Opens and reads files of an archive from several threads at the same time
+bool testConcurrentReads(IFileSystem* fs, const io::path& archiveName)
+{
+	if ( !fs->addFileArchive(archiveName, /*bool ignoreCase=*/true, /*bool ignorePaths=*/false) )
+	{
+		logTestString("Mounting archive failed\n");
+		return false;
+	}
+
+	const bool result = runConcurrentReaders(fs, archiveName);
+
+	fs->removeFileArchive(fs->getFileArchiveCount()-1);
+	return result;
+}
+
+// Finds files through the index of the file system, honoring the archive order
+bool testArchiveIndex(IFileSystem* fs)
+{
+	if ( !fs->addFileArchive("media/file_with_path.zip", /*bool ignoreCase=*/false, /*bool ignorePaths=*/false) ||
+		!fs->addFileArchive("media/file_with_path", /*bool ignoreCase=*/true, /*bool ignorePaths=*/false, EFAT_FOLDER) )
+	{
+		logTestString("Mounting archives failed\n");
+		return false;
+	}
+
+	bool result = true;
+
+	// the zip comes first and returns limit files, the folder real files
+	IReadFile* file = fs->createAndOpenFile("mypath/myfile.txt");
+	result &= file && file->getType() == ERFT_LIMIT_READ_FILE;
+	if (file)
+		file->drop();
+
+	// the zip doesn't ignore the case, so only the folder has this name
+	file = fs->createAndOpenFile("MyPath/MyFile.txt");
+	result &= file && file->getType() == ERFT_READ_FILE;
+	if (file)
+		file->drop();
+
+	fs->moveFileArchive(1, -1);
+	file = fs->createAndOpenFile("mypath\\myfile.txt");
+	result &= file && file->getType() == ERFT_READ_FILE;
+	if (file)
+		file->drop();
+
+	fs->removeFileArchive((u32)0);
+	file = fs->createAndOpenFile("mypath/mypath/myfile.txt");
+	result &= file && file->getType() == ERFT_LIMIT_READ_FILE;
+	if (file)
+		file->drop();
+	result &= !fs->existFile("myfile.txt");
+	result &= !fs->existFile("MyPath/MyPath/MyFile.txt");
+	fs->removeFileArchive((u32)0);
+
+	// without paths only the file name counts
+	if ( fs->addFileArchive("media/file_with_path.zip", /*bool ignoreCase=*/true, /*bool ignorePaths=*/true) )
+	{
+		result &= fs->existFile("test.txt") && fs->existFile("somewhere/TEST.TXT");
+		char tmp[13] = {'\0'};
+		file = fs->createAndOpenFile("other/test.txt");
+		result &= file && file->read(tmp, 12) == 12 && strcmp(tmp, "Hello world!") == 0;
+		if (file)
+			file->drop();
+		fs->removeFileArchive(fs->getFileArchiveCount()-1);
+	}
+	else
+		result = false;
+
+	result &= !fs->existFile("test.txt");
+
+	if (!result)
+		logTestString("testArchiveIndex failed\n");
+	return result;
+}
+
+
+// Reads a whole file of the mounted archives, returns false when it can't be opened
+bool readWholeFile(IFileSystem* fs, const io::path& filename, core::array<c8>& content)
+{
+	IReadFile* file = fs->createAndOpenFile(filename);
+	if (!file)
+		return false;
+	content.set_used(file->getSize());
+	const bool result = file->read(content.pointer(), content.size()) == (size_t)content.size();
+	file->drop();
+	return result;
+}
+
+// Opens compressed files through the decompression cache and after prefetching
+bool testDecompressionCache(IFileSystem* fs)
+{
+	if ( !fs->addFileArchive("media/Monty.zip", /*bool ignoreCase=*/true, /*bool ignorePaths=*/false) )
+	{
+		logTestString("Mounting archive failed\n");
+		return false;
+	}
+	io::IFileArchive* archive = fs->getFileArchive(fs->getFileArchiveCount()-1);
+	archive->setDecompressionCacheSize(1024*1024);
+
+	bool result = true;
+	core::array<c8> first, second;
+	result &= readWholeFile(fs, "monty/materials.dat", first);
+	result &= readWholeFile(fs, "monty/materials.dat", second);
+	result &= first.size() == 313 && second.size() == first.size() &&
+		memcmp(first.const_pointer(), second.const_pointer(), first.size()) == 0;
+
+	core::array<io::path> names;
+	names.push_back("monty/materials.dat");
+	names.push_back("monty/Monty.kart");
+	names.push_back("monty/License.txt");
+	names.push_back("monty/missing.txt");
+	const u32 prefetched = archive->prefetchFiles(names);
+	if (prefetched != 3)
+	{
+		logTestString("testDecompressionCache: prefetched %u instead of 3 files.\n", prefetched);
+		result = false;
+	}
+	result &= readWholeFile(fs, "monty/Monty.kart", second) && second.size() == 636;
+
+	archive->setDecompressionCacheSize(0);
+	result &= archive->prefetchFiles(names) == 0;
+	result &= readWholeFile(fs, "monty/materials.dat", second) && second.size() == first.size() &&
+		memcmp(first.const_pointer(), second.const_pointer(), first.size()) == 0;
+	fs->removeFileArchive(fs->getFileArchiveCount()-1);
+
+	// stored files of mapped archives are read in place
+	const long threshold = fs->getFileMappingThreshold();
+	fs->setFileMappingThreshold(1);
+	if ( fs->addFileArchive("media/file_with_path.zip", /*bool ignoreCase=*/true, /*bool ignorePaths=*/false) )
+	{
+		IReadFile* file = fs->createAndOpenFile("test/test.txt");
+		result &= file && file->getType() == ERFT_MEMORY_READ_FILE &&
+			memcmp(static_cast<IMemoryReadFile*>(file)->getBuffer(), "Hello world!", 12) == 0;
+		if (file)
+			file->drop();
+		fs->removeFileArchive(fs->getFileArchiveCount()-1);
+	}
+	else
+		result = false;
+	fs->setFileMappingThreshold(threshold);
+
+	if (!result)
+		logTestString("testDecompressionCache failed\n");
+	return result;
+}
+
+// Writes data into a new file
+bool writeWholeFile(IFileSystem* fs, const io::path& filename, const core::array<c8>& content)
+{
+	IWriteFile* file = fs->createAndWriteFile(filename);
+	if (!file)
+		return false;
+	const bool result = file->write(content.const_pointer(), content.size()) == content.size();
+	file->drop();
+	return result;
+}
+
+// Other threads must not open an archive again after it was replaced on disk
+bool testReplacedArchive(IFileSystem* fs)
+{
+	const io::path archiveName("results/replacedArchive.zip");
+	core::array<c8> content;
+	if (!readWholeFile(fs, "media/file_with_path.zip", content) || !writeWholeFile(fs, archiveName, content) ||
+		!fs->addFileArchive(archiveName, /*bool ignoreCase=*/true, /*bool ignorePaths=*/false))
+	{
+		logTestString("testReplacedArchive: Could not mount a copy of the archive\n");
+		return false;
+	}
+
+	// a new file takes the name, the mounted one stays open
+	core::array<c8> other;
+	other.set_used(content.size() / 2);
+	memset(other.pointer(), 'x', other.size());
+	bool result = writeWholeFile(fs, "results/replacedArchive.tmp", other);
+	if (result && rename("results/replacedArchive.tmp", archiveName.c_str()) == 0)
+		result = runConcurrentReaders(fs, archiveName);
+	else
+		logTestString("testReplacedArchive: Could not replace the archive, not tested\n");
+
+	fs->removeFileArchive(fs->getFileArchiveCount()-1);
+	if (!result)
+		logTestString("testReplacedArchive failed\n");
+	return result;
+}
+
 bool archiveReader()
 {
 	IrrlichtDevice * device = irr::createDevice(video::EDT_NULL, dimension2d<u32>(1, 1));
@@ -459,6 +761,15 @@ bool archiveReader()
 //	ret &= testMountFile(fs);
 	logTestString("Testing add/remove with filenames.\n");
 	ret &= testAddRemove(fs, "media/file_with_path.zip");
+	logTestString("Testing concurrent reads.\n");
+	ret &= testConcurrentReads(fs, "media/file_with_path.zip");
+	ret &= testConcurrentReads(fs, "media/sample_pakfile.pak");
+	ret &= testConcurrentReads(fs, "media/file_with_path.npk");
+	ret &= testReplacedArchive(fs);
+	logTestString("Testing the decompression cache.\n");
+	ret &= testDecompressionCache(fs);
+	logTestString("Testing the archive index.\n");
+	ret &= testArchiveIndex(fs);
 
 	device->closeDevice();
 	device->run();
@@ -122,6 +122,95 @@ static bool testgetRelativeFilename(io::IFileSystem* fs)
 	return result;
 }
 
+static bool testMappedFiles(IrrlichtDevice* device)
+{
+	io::IFileSystem* fs = device->getFileSystem();
+	const io::path name("../media/axe.jpg");
+
+	bool result = true;
+	io::IReadFile* file = fs->createAndOpenFile(name);
+	if (!file || file->getType() != io::ERFT_READ_FILE)
+	{
+		logTestString("Files should not be mapped by default.\n");
+		result = false;
+	}
+	const long size = file ? file->getSize() : 0;
+	core::array<u8> expected;
+	expected.set_used(size);
+	if (file)
+	{
+		file->read(expected.pointer(), size);
+		file->drop();
+	}
+
+	fs->setFileMappingThreshold(size + 1);
+	file = fs->createAndOpenFile(name);
+	if (!file || file->getType() != io::ERFT_READ_FILE)
+	{
+		logTestString("Files below the mapping threshold should not be mapped.\n");
+		result = false;
+	}
+	if (file)
+		file->drop();
+
+	fs->setFileMappingThreshold(size);
+	file = fs->createAndOpenFile(name);
+	if (!file || file->getType() != io::ERFT_MAPPED_READ_FILE || file->getSize() != size)
+	{
+		logTestString("Files at the mapping threshold should be mapped.\n");
+		result = false;
+	}
+	else
+	{
+		const u8* buffer = (const u8*)static_cast<io::IMemoryReadFile*>(file)->getBuffer();
+		if (memcmp(buffer, expected.const_pointer(), size))
+		{
+			logTestString("Mapped file has wrong content.\n");
+			result = false;
+		}
+
+		u8 tail[16];
+		if (!file->seek(size-10) || file->read(tail, 16) != 10 || memcmp(tail, buffer+size-10, 10) ||
+			file->getPos() != size || file->seek(size+1) || !file->seek(-size, true) || file->getPos() != 0)
+		{
+			logTestString("Reading and seeking in mapped file failed.\n");
+			result = false;
+		}
+
+		// jpg images are decoded from the mapped memory
+		video::IImage* mappedImage = device->getVideoDriver()->createImageFromFile(file);
+		fs->setFileMappingThreshold(0);
+		video::IImage* image = device->getVideoDriver()->createImageFromFile(name);
+		if (!mappedImage || !image || mappedImage->getDimension() != image->getDimension() ||
+			memcmp(mappedImage->getData(), image->getData(), image->getImageDataSizeInBytes()))
+		{
+			logTestString("Image loaded from mapped file differs.\n");
+			result = false;
+		}
+		if (mappedImage)
+			mappedImage->drop();
+		if (image)
+			image->drop();
+		file->drop();
+	}
+
+	// files in folder archives are mapped as well
+	fs->setFileMappingThreshold(1);
+	fs->addFileArchive("../media/", true, true, io::EFAT_FOLDER);
+	file = fs->createAndOpenFile("axe.jpg");
+	if (!file || file->getType() != io::ERFT_MAPPED_READ_FILE || file->getSize() != size)
+	{
+		logTestString("Files in folder archives should be mapped.\n");
+		result = false;
+	}
+	if (file)
+		file->drop();
+	fs->removeFileArchive(fs->getFileArchiveCount()-1);
+
+	fs->setFileMappingThreshold(0);
+	return result;
+}
+
 bool filesystem(void)
 {
 	IrrlichtDevice * device = irr::createDevice(video::EDT_NULL, dimension2d<u32>(1, 1));
@@ -173,6 +262,7 @@ bool filesystem(void)
 	result &= testFlattenFilename(fs);
 	result &= testgetAbsoluteFilename(fs);
 	result &= testgetRelativeFilename(fs);
+	result &= testMappedFiles(device);
 
 	device->closeDevice();
 	device->run();
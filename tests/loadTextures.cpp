@@ -2,6 +2,7 @@
 // No rights reserved: this software is in the public domain.
 
 #include "testUtils.h"
+#include <stdio.h> // For remove()
 
 using namespace irr;
 using namespace core;
@@ -88,10 +89,331 @@ bool loadFromFileFolder(void)
 	return ((tex1 == tex2) && (tex1 == tex3) && (tex1 == tex4));
 }
 
+//! Copies a file, so tests can change the copy
+static bool copyFile(IFileSystem* fs, const io::path& from, const io::path& to)
+{
+	IReadFile* in = fs->createAndOpenFile(from);
+	IWriteFile* out = fs->createAndWriteFile(to);
+	bool result = in && out;
+	if (result)
+	{
+		core::array<c8> data;
+		data.set_used(in->getSize());
+		result = in->read(data.pointer(), data.size()) == data.size() &&
+			out->write(data.const_pointer(), data.size()) == data.size();
+	}
+	if (in)
+		in->drop();
+	if (out)
+		out->drop();
+	return result;
+}
+
+/** Textures count their memory, and with a budget unused textures release
+	their data and load it again from their file when they are used. */
+static bool textureMemoryBudget(video::E_DRIVER_TYPE driverType)
+{
+	IrrlichtDevice * device = createDevice(driverType, dimension2du(160, 120));
+	if (!device)
+		return true; // no error if the device is not available
+
+	IVideoDriver * driver = device->getVideoDriver();
+	logTestString("Testing driver %ls\n", driver->getName());
+
+	bool result = true;
+	const u32 startMemory = driver->getTextureStatistics().MemoryUsed;
+
+	ITexture * tex1 = driver->getTexture("../media/tools.png");
+	const u32 memory1 = driver->getTextureStatistics().MemoryUsed - startMemory;
+	ITexture * tex2 = driver->getTexture("../media/fireball.bmp");
+	const u32 memory2 = driver->getTextureStatistics().MemoryUsed - startMemory - memory1;
+	result &= tex1 && tex2;
+	if (!result)
+	{
+		device->closeDevice();
+		device->run();
+		device->drop();
+		return false;
+	}
+
+	result &= memory1 >= tex1->getPitch() * tex1->getSize().Height;
+	result &= memory2 >= tex2->getPitch() * tex2->getSize().Height;
+
+	// textures used in the last frame stay resident
+	driver->setTextureMemoryBudget(1);
+	result &= driver->getTextureMemoryBudget() == 1;
+	SMaterial material;
+	material.setTexture(0, tex1);
+	for (u32 frame=0; frame<2; ++frame)
+	{
+		driver->beginScene(video::ECBF_ALL, video::SColor(255,0,0,0));
+		driver->setMaterial(material);
+		driver->setMaterial(SMaterial());
+		driver->endScene();
+	}
+
+	if (driverType == video::EDT_BURNINGSVIDEO)
+	{
+		result &= driver->getTextureStatistics().Evictions == 1;
+		result &= driver->getTextureStatistics().MemoryUsed == startMemory + memory1;
+
+		driver->beginScene(video::ECBF_ALL, video::SColor(255,0,0,0));
+		driver->endScene();
+		result &= driver->getTextureStatistics().Evictions == 2;
+		result &= driver->getTextureStatistics().MemoryUsed == startMemory;
+
+		// evicted data is loaded again on the next access
+		const video::SColor texel(*(u32*)tex2->lock(ETLM_READ_ONLY));
+		tex2->unlock();
+		result &= texel.getAlpha() == 255;
+		result &= driver->getTextureStatistics().Reloads == 1;
+		result &= driver->getTextureStatistics().MemoryUsed == startMemory + memory2;
+
+		// data written with lock() isn't in the file, so it's not released
+		*(u32*)tex2->lock(ETLM_WRITE_ONLY) = 0xff123456;
+		tex2->unlock();
+		for (u32 frame=0; frame<2; ++frame)
+		{
+			driver->beginScene(video::ECBF_ALL, video::SColor(255,0,0,0));
+			driver->endScene();
+		}
+		result &= driver->getTextureStatistics().Evictions == 2;
+		result &= *(u32*)tex2->lock(ETLM_READ_ONLY) == 0xff123456;
+		tex2->unlock();
+
+		// a texture whose file is gone gets data of its own, which counts again
+		ITexture* tex3 = copyFile(device->getFileSystem(), "../media/fireball.bmp", "results/evictedTexture.bmp") ?
+			driver->getTexture("results/evictedTexture.bmp") : 0;
+		result &= tex3 != 0;
+		if (tex3)
+		{
+			const u32 memory3 = driver->getTextureStatistics().MemoryUsed - startMemory - memory2;
+			for (u32 frame=0; frame<2; ++frame)
+			{
+				driver->beginScene(video::ECBF_ALL, video::SColor(255,0,0,0));
+				driver->endScene();
+			}
+			result &= driver->getTextureStatistics().Evictions == 3;
+			result &= driver->getTextureStatistics().MemoryUsed == startMemory + memory2;
+
+			remove("results/evictedTexture.bmp");
+			tex3->lock(ETLM_READ_ONLY);
+			tex3->unlock();
+			result &= driver->getTextureStatistics().Reloads == 1;
+			result &= driver->getTextureStatistics().MemoryUsed == startMemory + memory2 + memory3;
+			driver->removeTexture(tex3);
+		}
+	}
+	else
+	{
+		// drivers without eviction only count
+		result &= driver->getTextureStatistics().Evictions == 0;
+		result &= driver->getTextureStatistics().MemoryUsed == startMemory + memory1 + memory2;
+	}
+
+	driver->setTextureMemoryBudget(0);
+	driver->removeTexture(tex1);
+	driver->removeTexture(tex2);
+	result &= driver->getTextureStatistics().MemoryUsed == startMemory;
+
+	if (!result)
+		logTestString("Texture memory budget failed %s:%d\n", __FILE__, __LINE__);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+	return result;
+}
+
+static void appendBytes(core::array<u8>& data, const u8* bytes, u32 count)
+{
+	for (u32 i=0; i<count; ++i)
+		data.push_back(bytes[i]);
+}
+
+static IImage* loadImageFromMemory(IrrlichtDevice* device, const core::array<u8>& data, u32 size, const io::path& name)
+{
+	IReadFile* file = device->getFileSystem()->createMemoryReadFile(data.const_pointer(), size, name);
+	IImage* image = device->getVideoDriver()->createImageFromFile(file);
+	file->drop();
+	return image;
+}
+
+/** The TGA, BMP and PCX loaders decode run length encoded data directly
+	into the image. */
+static bool decodeRunLengthEncoded()
+{
+	IrrlichtDevice * device = createDevice(video::EDT_NULL, dimension2du(160, 120));
+	if (!device)
+		return true;
+
+	bool result = true;
+	const SColor red(255,255,0,0);
+	const SColor green(255,0,255,0);
+	const SColor blue(255,0,0,255);
+	const SColor black(255,0,0,0);
+
+	// 3x2 top-down tga, the run goes on in the second row
+	const u8 tgaBytes[] = { 0,0,10, 0,0, 0,0, 0, 0,0, 0,0, 3,0, 2,0, 24,0x20,
+		0x83, 0,0,255, 0x01, 255,0,0, 0,255,0 };
+	core::array<u8> tga;
+	appendBytes(tga, tgaBytes, sizeof(tgaBytes));
+
+	IImage* image = loadImageFromMemory(device, tga, tga.size(), "rle.tga");
+	result &= image && image->getColorFormat() == ECF_R8G8B8;
+	if (image)
+	{
+		result &= image->getPixel(0,0) == red && image->getPixel(2,0) == red;
+		result &= image->getPixel(0,1) == red && image->getPixel(1,1) == blue && image->getPixel(2,1) == green;
+		image->drop();
+	}
+
+	// a missing pixel leaves its row black
+	image = loadImageFromMemory(device, tga, tga.size()-3, "short.tga");
+	result &= image != 0;
+	if (image)
+	{
+		result &= image->getPixel(2,0) == red && image->getPixel(0,1) == black;
+		image->drop();
+	}
+
+	// 4x2 bmp with 4 bit RLE, the palette has red values of 16 times the index
+	const u8 bmpHeader[] = { 'B','M', 0,0,0,0, 0,0,0,0, 118,0,0,0,
+		40,0,0,0, 4,0,0,0, 2,0,0,0, 1,0, 4,0, 2,0,0,0, 0,0,0,0,
+		0,0,0,0, 0,0,0,0, 16,0,0,0, 0,0,0,0 };
+	const u8 bmpData[] = {
+		0x04,0x12, 0x00,0x00, // bottom row: run of 1 and 2, end of line
+		0x00,0x02,0x01,0x00, 0x00,0x03,0x34,0x50, // top row: skip 1 pixel, 3 absolute pixels
+		0x00,0x01 };
+	core::array<u8> bmp;
+	appendBytes(bmp, bmpHeader, sizeof(bmpHeader));
+	for (u32 i=0; i<16; ++i)
+	{
+		const u8 entry[] = { 0, 0, (u8)(i*16), 0 };
+		appendBytes(bmp, entry, 4);
+	}
+	appendBytes(bmp, bmpData, sizeof(bmpData));
+
+	image = loadImageFromMemory(device, bmp, bmp.size(), "rle4.bmp");
+	result &= image && image->getColorFormat() == ECF_A1R5G5B5;
+	if (image)
+	{
+		const u32 top[] = { 0, 3, 4, 5 };
+		const u32 bottom[] = { 1, 2, 1, 2 };
+		for (u32 x=0; x<4; ++x)
+		{
+			result &= image->getPixel(x,0).getRed() >> 3 == top[x]*2;
+			result &= image->getPixel(x,1).getRed() >> 3 == bottom[x]*2;
+		}
+		image->drop();
+	}
+
+	// 8x1 pcx with 4 planes of 1 bit, the bits of the palette indices
+	core::array<u8> pcx;
+	pcx.set_used(128);
+	memset(pcx.pointer(), 0, 128);
+	pcx[0] = 0x0a; pcx[1] = 5; pcx[2] = 1; pcx[3] = 1; // manufacturer, version, encoding, bits
+	pcx[8] = 7; // XMax
+	pcx[65] = 4; pcx[66] = 1; // planes, bytes per line
+	for (u32 i=0; i<16; ++i)
+		pcx[16+i*3] = (u8)(i*16);
+	const u8 pcxData[] = { 0xc1,0xf0, 0x0f, 0x00, 0xc1,0xff };
+	appendBytes(pcx, pcxData, sizeof(pcxData));
+
+	image = loadImageFromMemory(device, pcx, pcx.size(), "planes.pcx");
+	result &= image != 0;
+	if (image)
+	{
+		result &= image->getPixel(0,0).getRed() >> 3 == 9*2;
+		result &= image->getPixel(7,0).getRed() >> 3 == 10*2;
+		image->drop();
+	}
+
+	if (!result)
+		logTestString("Decoding run length encoded images failed %s:%d\n", __FILE__, __LINE__);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+	return result;
+}
+
+/** JPEG and PNG images are decoded at a lower resolution, other images are
+	scaled down after loading. */
+static bool loadReducedImages()
+{
+	IrrlichtDevice * device = createDevice(video::EDT_NULL, dimension2du(160, 120));
+	if (!device)
+		return true;
+
+	IVideoDriver * driver = device->getVideoDriver();
+	bool result = true;
+
+	// 512x512 jpg, the DCT scales by 1/8 or 4/8
+	IImage* image = driver->createReducedImageFromFile("../media/axe.jpg", dimension2du(100, 100));
+	result &= image && image->getDimension() == dimension2du(64, 64);
+	if (image)
+		image->drop();
+	image = driver->createReducedImageFromFile("../media/demoback.jpg", dimension2du(300, 400));
+	result &= image && image->getDimension() == dimension2du(256, 256);
+	if (image)
+		image->drop();
+
+	// 512x256 png, reduced by averaging 6x6 blocks
+	IImage* full = driver->createImageFromFile("../media/2ddemo.png");
+	image = driver->createReducedImageFromFile("../media/2ddemo.png", dimension2du(100, 100));
+	result &= full && image && image->getDimension() == dimension2du(86, 43);
+	if (full && image)
+	{
+		const u32 points[][2] = { {0,0}, {40,20}, {85,42} };
+		for (u32 i=0; i<3; ++i)
+		{
+			const u32 x0 = points[i][0];
+			const u32 y0 = points[i][1];
+			u32 sum = 0;
+			u32 count = 0;
+			for (u32 y=y0*6; y<core::min_(y0*6+6, 256u); ++y)
+			{
+				for (u32 x=x0*6; x<core::min_(x0*6+6, 512u); ++x, ++count)
+					sum += full->getPixel(x, y).getGreen();
+			}
+			result &= core::abs_((s32)image->getPixel(x0, y0).getGreen() - (s32)((sum + count/2) / count)) <= 1;
+		}
+	}
+	if (full)
+		full->drop();
+	if (image)
+		image->drop();
+
+	// images which fit are not changed
+	image = driver->createReducedImageFromFile("../media/2ddemo.png", dimension2du(512, 256));
+	result &= image && image->getDimension() == dimension2du(512, 256);
+	if (image)
+		image->drop();
+
+	// 220x193 bmp, scaled after loading
+	image = driver->createReducedImageFromFile("../media/faerie2.bmp", dimension2du(100, 100));
+	result &= image && image->getDimension() == dimension2du(100, 87);
+	if (image)
+		image->drop();
+
+	if (!result)
+		logTestString("Reduced images have the wrong size or content %s:%d\n", __FILE__, __LINE__);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+	return result;
+}
+
 bool loadTextures()
 {
 	bool result = true;
 	result &= loadFromFileFolder();
+	result &= decodeRunLengthEncoded();
+	result &= loadReducedImages();
+	result &= textureMemoryBudget(video::EDT_NULL);
+	TestWithAllDrivers(textureMemoryBudget);
 	return result;
 }
 
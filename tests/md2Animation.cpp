@@ -73,6 +73,79 @@ bool testLastFrame()
 	return result;
 }
 
+// Copies the vertex positions and bounding box of an interpolated frame
+void getFrame(scene::IAnimatedMesh* mesh, s32 frame, array<vector3df>& positions, aabbox3df& box)
+{
+	const scene::IMeshBuffer* mb = mesh->getMesh(frame)->getMeshBuffer(0);
+	positions.set_used(mb->getVertexCount());
+	for (u32 i=0; i<mb->getVertexCount(); ++i)
+		positions[i] = mb->getPosition(i);
+	box = mb->getBoundingBox();
+}
+
+// Tests that cached interpolated frames are the same as freshly calculated ones.
+bool testKeyFrameCache()
+{
+	IrrlichtDevice *device = createDevice(video::EDT_NULL, dimension2d<u32>(160, 120), 32);
+	if (!device)
+		return false;
+
+	scene::IAnimatedMesh* mesh = device->getSceneManager()->getMesh("./media/sydney.md2");
+	bool result = (mesh != 0);
+	if (mesh)
+	{
+		// frames between keyframes, 5 is first calculated, then cached
+		const s32 frames[] = { 5, 9, 5, 13, 17, 21, 25, 29, 5 };
+		array<vector3df> first;
+		aabbox3df firstBox;
+		getFrame(mesh, frames[0], first, firstBox);
+
+		for (u32 f=1; f<sizeof(frames)/sizeof(frames[0]); ++f)
+		{
+			array<vector3df> positions;
+			aabbox3df box;
+			getFrame(mesh, frames[f], positions, box);
+
+			// the box has to contain the blended vertices
+			aabbox3df tolerance(box.MinEdge - vector3df(0.001f), box.MaxEdge + vector3df(0.001f));
+			for (u32 i=0; i<positions.size(); ++i)
+			{
+				if (!tolerance.isPointInside(positions[i]))
+				{
+					logTestString("md2 vertex %u of frame %d outside of the bbox.\n", i, frames[f]);
+					result = false;
+					break;
+				}
+			}
+
+			if (frames[f] != frames[0])
+				continue;
+
+			if (box != firstBox || positions.size() != first.size())
+			{
+				logTestString("md2 frame %d changed after %u frames.\n", frames[f], f);
+				result = false;
+				continue;
+			}
+			for (u32 i=0; i<positions.size(); ++i)
+			{
+				if (positions[i] != first[i])
+				{
+					logTestString("md2 vertex %u of frame %d changed after %u frames.\n", i, frames[f], f);
+					result = false;
+					break;
+				}
+			}
+		}
+	}
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
 // Tests MD2 normals.
 bool testNormals()
 {
@@ -124,5 +197,6 @@ bool md2Animation(void)
 {
 	bool result = testLastFrame();
 	result &= testNormals();
+	result &= testKeyFrameCache();
 	return result;
 }
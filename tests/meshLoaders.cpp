@@ -5,6 +5,533 @@
 
 using namespace irr;
 
+namespace
+{
+
+// Loads meshes and textures with the async loader and checks that they end up in the caches.
+bool asyncLoading(IrrlichtDevice* device)
+{
+	IAsyncLoader* loader = device->getAsyncLoader();
+	assert_log(loader);
+	if (!loader)
+		return false;
+
+	scene::ISceneManager* smgr = device->getSceneManager();
+	video::IVideoDriver* driver = device->getVideoDriver();
+	bool result = true;
+
+	// STL meshes are decoded on the worker threads
+	scene::IMesh* cube = smgr->getGeometryCreator()->createCubeMesh();
+	scene::IMeshWriter* writer = smgr->createMeshWriter(scene::EMWT_STL);
+	io::IWriteFile* file = device->getFileSystem()->createAndWriteFile("results/asyncCube.stl");
+	if (!writer || !file || !writer->writeMesh(file, cube))
+	{
+		logTestString("Could not write the STL file for async loading\n");
+		result = false;
+	}
+	if (file)
+		file->drop();
+	if (writer)
+		writer->drop();
+	cube->drop();
+
+	IAsyncLoadRequest* stl = loader->loadMesh("results/asyncCube.stl", 1);
+	IAsyncLoadRequest* texture = loader->loadTexture("../media/wall.bmp");
+	IAsyncLoadRequest* cached = loader->loadMesh("../media/ninja.b3d");
+	IAsyncLoadRequest* missing = loader->loadMesh("../media/missing.stl");
+	IAsyncLoadRequest* canceled = loader->loadTexture("../media/axe.jpg", -1);
+
+	canceled->setPriority(-2);
+	result &= canceled->getPriority() == -2;
+	canceled->cancel();
+	result &= canceled->getState() == EALS_CANCELED;
+	result &= cached->getState() == EALS_DONE && cached->getMesh() == smgr->getMesh("../media/ninja.b3d");
+	result &= missing->getState() == EALS_FAILED && !missing->getMesh();
+
+	const u32 start = device->getTimer()->getRealTime();
+	while (loader->getPendingCount() && device->getTimer()->getRealTime() - start < 10000)
+	{
+		loader->update(5);
+		device->sleep(1);
+	}
+
+	result &= loader->getPendingCount() == 0;
+	result &= stl->getState() == EALS_DONE && stl->getMesh();
+	if (stl->getMesh())
+	{
+		result &= stl->getMesh()->getMeshBufferCount() > 0;
+		result &= smgr->getMeshCache()->getMeshByName("results/asyncCube.stl") == stl->getMesh();
+	}
+	result &= texture->getState() == EALS_DONE && texture->getTexture();
+	result &= texture->getTexture() == driver->getTexture("../media/wall.bmp");
+	result &= canceled->getState() == EALS_CANCELED && !driver->findTexture(
+		device->getFileSystem()->getAbsolutePath("../media/axe.jpg"));
+
+	if (!result)
+		logTestString("Async loading failed\n");
+
+	stl->drop();
+	texture->drop();
+	cached->drop();
+	missing->drop();
+	canceled->drop();
+
+	return result;
+}
+
+// Adds a cube to the mesh cache, only the cache keeps it
+void addCachedCube(scene::ISceneManager* smgr, const io::path& name)
+{
+	scene::IMesh* cube = smgr->getGeometryCreator()->createCubeMesh();
+	scene::SAnimatedMesh* mesh = new scene::SAnimatedMesh(cube);
+	cube->drop();
+	smgr->getMeshCache()->addMesh(name, mesh);
+	mesh->drop();
+}
+
+// Checks that unused meshes beyond the memory budget are evicted least recently used first.
+bool meshCacheBudget(IrrlichtDevice* device)
+{
+	scene::ISceneManager* smgr = device->getSceneManager();
+	scene::IMeshCache* cache = smgr->getMeshCache();
+	cache->clear();
+
+	const scene::SMeshCacheStatistics& stats = cache->getStatistics();
+	addCachedCube(smgr, "cubeA");
+	addCachedCube(smgr, "cubeB");
+	const u32 cubeMemory = stats.MemoryUsed / 2;
+	bool result = cubeMemory > 0 && stats.MemoryUsed == 2 * cubeMemory;
+
+	cache->setMemoryBudget(2 * cubeMemory);
+	const u32 hits = stats.Hits;
+	const u32 misses = stats.Misses;
+	const u32 evictions = stats.Evictions;
+
+	// cubeB is now the least recently used mesh
+	result &= cache->getMeshByName("cubeA") != 0;
+	addCachedCube(smgr, "cubeC");
+	result &= cache->isMeshLoaded("cubeA") && !cache->isMeshLoaded("cubeB") && cache->isMeshLoaded("cubeC");
+	result &= stats.Evictions == evictions + 1 && stats.MemoryUsed == 2 * cubeMemory;
+
+	// meshes in use stay
+	scene::IAnimatedMesh* used = cache->getMeshByName("cubeA");
+	used->grab();
+	cache->setMemoryBudget(1);
+	result &= cache->getMeshCount() == 1 && cache->getMeshByName("cubeA") == used;
+	result &= stats.Evictions == evictions + 2 && stats.MemoryUsed == cubeMemory;
+	used->drop();
+
+	result &= cache->getMeshByName("cubeB") == 0;
+	result &= stats.Hits == hits + 3 && stats.Misses == misses + 1;
+
+	cache->setMemoryBudget(0);
+	cache->clear();
+	result &= stats.MemoryUsed == 0;
+
+	if (!result)
+		logTestString("meshCacheBudget failed\n");
+	return result;
+}
+
+// Writes a mesh in the binary format and loads it again
+scene::IAnimatedMesh* writeAndReadBinaryMesh(IrrlichtDevice* device, scene::IMesh* mesh, const io::path& name)
+{
+	scene::ISceneManager* smgr = device->getSceneManager();
+	scene::IMeshWriter* writer = smgr->createMeshWriter(scene::EMWT_IRR_BINARY_MESH);
+	io::IWriteFile* file = device->getFileSystem()->createAndWriteFile(name);
+	const bool written = writer && file && writer->writeMesh(file, mesh);
+	if (file)
+		file->drop();
+	if (writer)
+		writer->drop();
+	return written ? smgr->getMesh(name) : 0;
+}
+
+// Checks that two meshes have the same buffers
+bool equalMeshBuffers(const scene::IMesh* a, const scene::IMesh* b)
+{
+	if (a->getMeshBufferCount() != b->getMeshBufferCount())
+		return false;
+
+	for (u32 i=0; i<a->getMeshBufferCount(); ++i)
+	{
+		const scene::IMeshBuffer* ba = a->getMeshBuffer(i);
+		const scene::IMeshBuffer* bb = b->getMeshBuffer(i);
+		if (ba->getVertexType() != bb->getVertexType() || ba->getIndexType() != bb->getIndexType() ||
+			ba->getVertexCount() != bb->getVertexCount() || ba->getIndexCount() != bb->getIndexCount() ||
+			ba->getMaterial() != bb->getMaterial())
+			return false;
+
+		const u32 indexSize = ba->getIndexType() == video::EIT_16BIT ? 2 : 4;
+		if (memcmp(ba->getVertices(), bb->getVertices(), ba->getVertexCount() * video::getVertexPitchFromType(ba->getVertexType())) ||
+			memcmp(ba->getIndices(), bb->getIndices(), ba->getIndexCount() * indexSize))
+			return false;
+	}
+	return true;
+}
+
+// Writes static and skinned meshes in the binary format and compares the loaded meshes.
+bool binaryMeshRoundTrip(IrrlichtDevice* device)
+{
+	scene::ISceneManager* smgr = device->getSceneManager();
+	bool result = true;
+
+	// static mesh with a textured material
+	scene::IMesh* sphere = smgr->getGeometryCreator()->createSphereMesh(5.f, 8, 8);
+	video::SMaterial& material = sphere->getMeshBuffer(0)->getMaterial();
+	material.setTexture(0, device->getVideoDriver()->getTexture("../media/wall.bmp"));
+	material.MaterialType = video::EMT_TRANSPARENT_ALPHA_CHANNEL;
+	material.getTextureMatrix(0).setTextureScale(2.f, 3.f);
+	material.Lighting = false;
+	scene::IAnimatedMesh* loaded = writeAndReadBinaryMesh(device, sphere, "results/binarySphere.irrbmesh");
+	result &= loaded && loaded->getMeshType() == scene::EAMT_UNKNOWN && equalMeshBuffers(sphere, loaded->getMesh(0));
+	sphere->drop();
+
+	// skinned mesh with joints and animation
+	scene::IAnimatedMesh* ninja = smgr->getMesh("../media/ninja.b3d");
+	loaded = ninja ? writeAndReadBinaryMesh(device, ninja, "results/binaryNinja.irrbmesh") : 0;
+	result &= loaded && loaded->getMeshType() == scene::EAMT_SKINNED && equalMeshBuffers(ninja, loaded);
+	if (loaded && ninja && loaded->getMeshType() == scene::EAMT_SKINNED)
+	{
+		scene::ISkinnedMesh* a = static_cast<scene::ISkinnedMesh*>(ninja);
+		scene::ISkinnedMesh* b = static_cast<scene::ISkinnedMesh*>(loaded);
+		result &= a->getJointCount() == b->getJointCount() && a->getFrameCount() == b->getFrameCount() &&
+			a->getAnimationSpeed() == b->getAnimationSpeed();
+		for (u32 i=0; i<a->getJointCount() && result; ++i)
+			result &= core::stringc(a->getJointName(i)) == b->getJointName(i);
+
+		// both animate to the same vertices
+		const scene::IMeshBuffer* ba = a->getMesh(10)->getMeshBuffer(0);
+		const scene::IMeshBuffer* bb = b->getMesh(10)->getMeshBuffer(0);
+		for (u32 i=0; i<ba->getVertexCount() && result; ++i)
+			result &= ba->getPosition(i).equals(bb->getPosition(i));
+	}
+
+	// indices past the vertices are rejected
+	scene::SMeshBuffer* buffer = new scene::SMeshBuffer();
+	buffer->Vertices.push_back(video::S3DVertex());
+	buffer->Vertices.push_back(video::S3DVertex());
+	buffer->Vertices.push_back(video::S3DVertex());
+	buffer->Indices.push_back(0);
+	buffer->Indices.push_back(1);
+	buffer->Indices.push_back(3);
+	scene::SMesh* broken = new scene::SMesh();
+	broken->addMeshBuffer(buffer);
+	buffer->drop();
+	result &= writeAndReadBinaryMesh(device, broken, "results/brokenIndices.irrbmesh") == 0;
+	broken->drop();
+
+	// writing fails when the file is full
+	c8 data[256];
+	io::IWriteFile* file = device->getFileSystem()->createMemoryWriteFile(data, sizeof(data), "full.irrbmesh");
+	scene::IMeshWriter* writer = smgr->createMeshWriter(scene::EMWT_IRR_BINARY_MESH);
+	result &= ninja && writer && file && !writer->writeMesh(file, ninja);
+	if (writer)
+		writer->drop();
+	if (file)
+		file->drop();
+
+	// not a binary mesh
+	result &= smgr->getMesh("../media/missing.irrbmesh") == 0;
+
+	if (!result)
+		logTestString("binaryMeshRoundTrip failed\n");
+	return result;
+}
+
+// Loads an obj file from memory
+scene::IAnimatedMesh* loadObj(scene::ISceneManager* smgr, const c8* text, const io::path& name)
+{
+	io::IReadFile* file = smgr->getFileSystem()->createMemoryReadFile(text, (long)strlen(text), name);
+	scene::IAnimatedMesh* mesh = smgr->getMesh(file);
+	file->drop();
+	return mesh;
+}
+
+// Checks that face corners share vertices exactly when their (v, vt, vn) indices are equal.
+bool objFaceIndices(IrrlichtDevice* device)
+{
+	scene::ISceneManager* smgr = device->getSceneManager();
+
+	const c8* quads =
+		"v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+		"vt 0 0\nvt 1 1\n"
+		"vn 0 0 1\n"
+		"f 1/1/1 2/1/1 3/2/1 4/2/1\n"	// 4 vertices, 2 triangles
+		"f 1/1/1 3/2/1 -1/2/1\n"		// relative index, all corners known
+		"f 1//1\t2//1   3//1\r\n"		// no texture coordinates, so 3 new vertices
+		"f 1/1/1 1/1/1 2/1/1\n";		// degenerated
+	scene::IAnimatedMesh* mesh = loadObj(smgr, quads, "objFaceIndices.obj");
+	bool result = mesh && mesh->getMesh(0)->getMeshBufferCount() == 1;
+	if (result)
+	{
+		const scene::IMeshBuffer* mb = mesh->getMesh(0)->getMeshBuffer(0);
+		result &= mb->getVertexCount() == 7 && mb->getIndexCount() == 12;
+		// handedness is changed for positions and texture coordinates
+		result &= mb->getPosition(2).equals(core::vector3df(-1.f, 1.f, 0.f));
+		result &= mb->getTCoords(2).equals(core::vector2df(1.f, 0.f));
+		result &= mb->getTCoords(4).equals(core::vector2df(0.f, 0.f));
+		result &= mb->getNormal(4).equals(core::vector3df(0.f, 0.f, 1.f));
+		// the relative face repeats the second triangle
+		const u16* indices = (const u16*)mb->getIndices();
+		result &= mb->getIndexType() == video::EIT_16BIT;
+		result &= result && indices[6] == 3 && indices[7] == 2 && indices[8] == 0;
+		result &= result && indices[9] == 6 && indices[10] == 5 && indices[11] == 4;
+	}
+
+	// invalid vertex indices fail, but don't leave anything behind for the next file
+	result &= loadObj(smgr, "v 0 0 0\nf 1 2 3\n", "objFaceIndicesInvalid.obj") == 0;
+	mesh = loadObj(smgr, "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n", "objFaceIndicesTriangle.obj");
+	result &= mesh && mesh->getMesh(0)->getMeshBufferCount() == 1 &&
+		mesh->getMesh(0)->getMeshBuffer(0)->getVertexCount() == 3;
+
+	if (!result)
+		logTestString("objFaceIndices failed\n");
+	return result;
+}
+
+// Appends a line to a text
+void addLine(core::array<c8>& text, const c8* line, const c8* lineEnd="\n")
+{
+	for (const c8* p = line; *p; ++p)
+		text.push_back(*p);
+	for (const c8* p = lineEnd; *p; ++p)
+		text.push_back(*p);
+}
+
+// Loads a text mesh on the loading thread only and split into chunks, the results must not differ
+bool equalChunkedLoad(scene::ISceneManager* smgr, const core::array<c8>& text, const io::path& name)
+{
+	scene::IAnimatedMesh* meshes[2];
+	for (u32 i=0; i<2; ++i)
+	{
+		smgr->getParameters()->setAttribute(scene::MESH_LOADER_PARSE_THREADS, i ? 4 : 1);
+		io::IReadFile* file = smgr->getFileSystem()->createMemoryReadFile(text.const_pointer(), (long)text.size(),
+			io::path(i ? "chunked_" : "serial_") + name);
+		meshes[i] = smgr->getMesh(file);
+		file->drop();
+	}
+	smgr->getParameters()->setAttribute(scene::MESH_LOADER_PARSE_THREADS, 0);
+
+	return meshes[0] && meshes[1] && equalMeshBuffers(meshes[0]->getMesh(0), meshes[1]->getMesh(0));
+}
+
+// Checks that big obj and ply files are loaded the same way when parsed in chunks.
+bool chunkedTextMeshes(IrrlichtDevice* device)
+{
+	scene::ISceneManager* smgr = device->getSceneManager();
+	const s32 size = 130;
+	c8 line[128];
+
+	// rows of vertices followed by their faces, half of them with relative indices
+	core::array<c8> obj;
+	addLine(obj, "vn 0 0 1");
+	for (s32 y=0; y<size; ++y)
+	{
+		if (y % 10 == 0)
+		{
+			sprintf(line, "g group%d", y % 3);
+			addLine(obj, line);
+			addLine(obj, y % 20 ? "usemtl a" : "usemtl b");
+		}
+		for (s32 x=0; x<size; ++x)
+		{
+			sprintf(line, "v %d.%d %d %d.25", x, y % 7, y, (x * y) % 11);
+			addLine(obj, line);
+			sprintf(line, "vt 0.%03d 0.%03d", x * 8, y * 8);
+			addLine(obj, line);
+		}
+		for (s32 x=1; y>0 && x<size; ++x)
+		{
+			const s32 a = y * size + x + 1;
+			if (y % 2)
+				sprintf(line, "f %d/%d/1 %d/%d/1 %d/%d/1 %d/%d/1", a-size-1, a-size-1, a-size, a-size, a, a, a-1, a-1);
+			else
+				sprintf(line, "f %d/%d %d/%d/-1 %d//-1", x-2*size-1, x-2*size-1, x-2*size, x-2*size, x-size);
+			addLine(obj, line);
+		}
+	}
+	// big enough for 4 chunks
+	bool result = obj.size() > 1024 * 1024 && equalChunkedLoad(smgr, obj, "chunks.obj");
+
+	// crlf line ends, vertex colors and an element which is skipped
+	core::array<c8> ply;
+	sprintf(line, "ply\r\nformat ascii 1.0\r\nelement vertex %d", size * size);
+	addLine(ply, line, "\r\n");
+	addLine(ply, "property float x\r\nproperty float y\r\nproperty float z\r\nproperty uchar red", "\r\n");
+	addLine(ply, "element skipped 2\r\nproperty int value", "\r\n");
+	sprintf(line, "element face %d", (size-1) * (size-1));
+	addLine(ply, line, "\r\n");
+	addLine(ply, "property list uchar int vertex_indices\r\nend_header", "\r\n");
+	for (s32 i=0; i<size*size; ++i)
+	{
+		sprintf(line, "%d.5 %d %d.125 %d", i % size, i / size, (i * 7) % 13, i % 256);
+		addLine(ply, line, "\r\n");
+	}
+	addLine(ply, "1\r\n2", "\r\n");
+	for (s32 y=1; y<size; ++y)
+	{
+		for (s32 x=1; x<size; ++x)
+		{
+			const s32 a = y * size + x;
+			sprintf(line, "4 %d %d %d %d", a-size-1, a-size, a, a-1);
+			addLine(ply, line, "\r\n");
+		}
+	}
+	result &= ply.size() > 512 * 1024 && equalChunkedLoad(smgr, ply, "chunks.ply");
+
+	if (!result)
+		logTestString("chunkedTextMeshes failed\n");
+	return result;
+}
+
+// Appends a little endian value to binary data
+void addBytes(core::array<c8>& data, u32 value, u32 size)
+{
+	for (u32 i=0; i<size; ++i)
+		data.push_back((c8)(value >> (i * 8)));
+}
+
+void addFloat(core::array<c8>& data, f32 value)
+{
+	u32 bits;
+	memcpy(&bits, &value, 4);
+	addBytes(data, bits, 4);
+}
+
+// Writes a mesh and loads it again without keeping it in the mesh cache, drop the result.
+scene::IAnimatedMesh* writeAndReload(IrrlichtDevice* device, scene::IMesh* mesh,
+	scene::EMESH_WRITER_TYPE type, s32 flags, const io::path& name)
+{
+	scene::ISceneManager* smgr = device->getSceneManager();
+	scene::IMeshWriter* writer = smgr->createMeshWriter(type);
+	io::IWriteFile* file = device->getFileSystem()->createAndWriteFile(name);
+	const bool written = writer && file && writer->writeMesh(file, mesh, flags);
+	if (file)
+		file->drop();
+	if (writer)
+		writer->drop();
+
+	scene::IAnimatedMesh* loaded = written ? smgr->getMesh(name) : 0;
+	if (loaded)
+	{
+		loaded->grab();
+		smgr->getMeshCache()->removeMesh(loaded);
+	}
+	return loaded;
+}
+
+// Checks that the block readers of binary ply and stl files match the other paths.
+bool binaryPlyAndStl(IrrlichtDevice* device)
+{
+	scene::ISceneManager* smgr = device->getSceneManager();
+	const s32 size = 40;
+	c8 line[128];
+
+	// the same vertices and faces as ascii and binary ply, with properties
+	// which are skipped and faces too big for the block reader
+	core::array<c8> ascii;
+	core::array<c8> binary;
+	const c8* header[] = { "ply", "format binary_little_endian 1.0", "element vertex %d",
+		"property float x", "property short skipped", "property float y", "property float z",
+		"property float nx", "property float ny", "property float nz",
+		"property uchar red", "property uchar green", "property uchar blue",
+		"element face %d", "property list uchar int vertex_indices", "end_header", 0 };
+	for (u32 i=0; header[i]; ++i)
+	{
+		sprintf(line, header[i], i == 2 ? size * size : size - 1 + 2);
+		addLine(binary, line);
+		addLine(ascii, i == 1 ? "format ascii 1.0" : line);
+	}
+	for (s32 i=0; i<size*size; ++i)
+	{
+		const f32 x = (f32)(i % size) + 0.5f;
+		const f32 z = (f32)((i * 7) % 13) * 0.125f;
+		sprintf(line, "%g %d %d %g 0 1 0 %d %d 255", x, i, i / size, z, i % 256, (i * 3) % 256);
+		addLine(ascii, line);
+		addFloat(binary, x);
+		addBytes(binary, (u32)i, 2);
+		addFloat(binary, (f32)(i / size));
+		addFloat(binary, z);
+		addFloat(binary, 0.f);
+		addFloat(binary, 1.f);
+		addFloat(binary, 0.f);
+		addBytes(binary, (u32)(i % 256), 1);
+		addBytes(binary, (u32)((i * 3) % 256), 1);
+		addBytes(binary, 255, 1);
+	}
+	// a strip of quads, a polygon with more corners than the block reader takes and a triangle
+	for (s32 x=1; x<size; ++x)
+	{
+		sprintf(line, "4 %d %d %d %d", x - 1, x, x + size, x + size - 1);
+		addLine(ascii, line);
+		addBytes(binary, 4, 1);
+		addBytes(binary, (u32)(x - 1), 4);
+		addBytes(binary, (u32)x, 4);
+		addBytes(binary, (u32)(x + size), 4);
+		addBytes(binary, (u32)(x + size - 1), 4);
+	}
+	sprintf(line, "%d", size);
+	addBytes(binary, (u32)size, 1);
+	for (s32 x=0; x<size; ++x)
+	{
+		sprintf(line + strlen(line), " %d", x * size);
+		addBytes(binary, (u32)(x * size), 4);
+	}
+	addLine(ascii, line);
+	addLine(ascii, "3 0 1 2");
+	addBytes(binary, 3, 1);
+	addBytes(binary, 0, 4);
+	addBytes(binary, 1, 4);
+	addBytes(binary, 2, 4);
+
+	io::IReadFile* file = smgr->getFileSystem()->createMemoryReadFile(ascii.const_pointer(), (long)ascii.size(), "asciiLayout.ply");
+	scene::IAnimatedMesh* asciiMesh = smgr->getMesh(file);
+	file->drop();
+	file = smgr->getFileSystem()->createMemoryReadFile(binary.const_pointer(), (long)binary.size(), "binaryLayout.ply");
+	scene::IAnimatedMesh* binaryMesh = smgr->getMesh(file);
+	file->drop();
+	bool result = asciiMesh && binaryMesh && equalMeshBuffers(asciiMesh->getMesh(0), binaryMesh->getMesh(0));
+	result &= result && binaryMesh->getMesh(0)->getMeshBuffer(0)->getIndexCount() == (u32)((size - 1) * 6 + (size - 2) * 3 + 3);
+
+	// binary stl is read in blocks, and can be welded while loading
+	scene::IMesh* sphere = smgr->getGeometryCreator()->createSphereMesh(5.f, 16, 16);
+	scene::IAnimatedMesh* asciiStl = writeAndReload(device, sphere, scene::EMWT_STL, scene::EMWF_NONE, "results/asciiSphere.stl");
+	scene::IAnimatedMesh* binaryStl = writeAndReload(device, sphere, scene::EMWT_STL, scene::EMWF_WRITE_BINARY, "results/binarySphere.stl");
+	smgr->getParameters()->setAttribute(scene::STL_LOADER_WELD_VERTICES, true);
+	scene::IAnimatedMesh* weldedStl = writeAndReload(device, sphere, scene::EMWT_STL, scene::EMWF_WRITE_BINARY, "results/weldedSphere.stl");
+	smgr->getParameters()->setAttribute(scene::STL_LOADER_WELD_VERTICES, false);
+	sphere->drop();
+
+	result &= asciiStl && binaryStl && weldedStl;
+	if (asciiStl && binaryStl && weldedStl)
+	{
+		// ascii numbers are rounded, so only compare the shape
+		const scene::IMeshBuffer* a = asciiStl->getMesh(0)->getMeshBuffer(0);
+		const scene::IMeshBuffer* b = binaryStl->getMesh(0)->getMeshBuffer(0);
+		result &= a->getVertexCount() == b->getVertexCount() && a->getIndexCount() == b->getIndexCount();
+		for (u32 i=0; i<a->getVertexCount() && result; ++i)
+			result &= a->getPosition(i).equals(b->getPosition(i), 0.001f) && a->getNormal(i).equals(b->getNormal(i), 0.001f);
+
+		scene::IMesh* welded = smgr->getMeshManipulator()->createMeshWelded(binaryStl->getMesh(0));
+		result &= welded->getMeshBuffer(0)->getVertexCount() < b->getVertexCount();
+		result &= equalMeshBuffers(welded, weldedStl->getMesh(0));
+		welded->drop();
+	}
+	if (asciiStl)
+		asciiStl->drop();
+	if (binaryStl)
+		binaryStl->drop();
+	if (weldedStl)
+		weldedStl->drop();
+
+	if (!result)
+		logTestString("binaryPlyAndStl failed\n");
+	return result;
+}
+
+} // end anonymous namespace
+
 // Tests mesh loading features and the mesh cache.
 /** This won't test render results. Currently, not all mesh loaders are tested. */
 bool meshLoaders(void)
@@ -29,6 +556,13 @@ bool meshLoaders(void)
 		}
 	}
 
+	result &= asyncLoading(device);
+	result &= meshCacheBudget(device);
+	result &= binaryMeshRoundTrip(device);
+	result &= objFaceIndices(device);
+	result &= chunkedTextMeshes(device);
+	result &= binaryPlyAndStl(device);
+
 	device->closeDevice();
 	device->run();
 	device->drop();
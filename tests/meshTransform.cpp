@@ -10,9 +10,246 @@ using namespace video;
 using namespace io;
 using namespace gui;
 
+namespace
+{
+
+// Welds a cube split into separate triangles and a big grid with 32 bit indices.
+bool meshWelding()
+{
+	IrrlichtDevice* device = createDevice(EDT_NULL);
+	assert_log(device);
+	if (!device)
+		return false;
+	IMeshManipulator* manipulator = device->getSceneManager()->getMeshManipulator();
+	const IGeometryCreator* geometry = device->getSceneManager()->getGeometryCreator();
+
+	IMesh* cube = geometry->createCubeMesh();
+	IMesh* unique = manipulator->createMeshUniquePrimitives(cube);
+	IMesh* welded = manipulator->createMeshWelded(unique);
+	bool result = unique->getMeshBuffer(0)->getVertexCount() == 36 &&
+		welded->getMeshBuffer(0)->getVertexCount() == cube->getMeshBuffer(0)->getVertexCount() &&
+		welded->getMeshBuffer(0)->getIndexCount() == 36;
+	welded->drop();
+	unique->drop();
+	cube->drop();
+
+	// separate triangles of a grid with more vertices than 16 bit indices
+	// reach, slightly moved copies and a triangle which collapses
+	const u32 size = 300;
+	SMesh grid;
+	CDynamicMeshBuffer* buffer = new CDynamicMeshBuffer(EVT_STANDARD, EIT_32BIT);
+	grid.addMeshBuffer(buffer);
+	buffer->drop();
+	IVertexBuffer& vertices = buffer->getVertexBuffer();
+	IIndexBuffer& indices = buffer->getIndexBuffer();
+	const S3DVertex corner(0.f, 0.f, 0.f, 0.f, 1.f, 0.f, SColor(255, 255, 255, 255), 0.f, 0.f);
+	for (u32 y=1; y<size; ++y)
+	{
+		for (u32 x=1; x<size; ++x)
+		{
+			const f32 offset = (x + y) % 2 ? 0.f : ROUNDING_ERROR_f32 * 0.5f;
+			S3DVertex v(corner);
+			v.Pos.set((f32)x + offset, 0.f, (f32)y);
+			vertices.push_back(v);
+			v.Pos.set((f32)x - 1.f, 0.f, (f32)y - offset);
+			vertices.push_back(v);
+			v.Pos.set((f32)x - 1.f, 0.f, (f32)y - 1.f);
+			vertices.push_back(v);
+			v.Pos.set((f32)x - 1.f, 0.f, (f32)y - 1.f);
+			vertices.push_back(v);
+			v.Pos.set((f32)x + offset, 0.f, (f32)y - 1.f);
+			vertices.push_back(v);
+			v.Pos.set((f32)x, 0.f, (f32)y);
+			vertices.push_back(v);
+		}
+	}
+	vertices.push_back(corner);
+	vertices.push_back(corner);
+	vertices.push_back(corner);
+	for (u32 i=0; i<vertices.size(); ++i)
+		indices.push_back(i);
+
+	welded = manipulator->createMeshWelded(&grid);
+	const IMeshBuffer* weldedBuffer = welded->getMeshBuffer(0);
+	result &= weldedBuffer->getVertexCount() == size * size &&
+		weldedBuffer->getIndexCount() == (size-1) * (size-1) * 6 &&
+		weldedBuffer->getIndexType() == EIT_32BIT;
+	// each position once
+	for (u32 i=1; i<weldedBuffer->getVertexCount() && result; ++i)
+		result &= !weldedBuffer->getPosition(i).equals(weldedBuffer->getPosition(i-1));
+	welded->drop();
+	device->drop();
+
+	if (!result)
+		logTestString("meshWelding failed\n");
+	return result;
+}
+
+// Optimizes two stacked grids with 32 bit indices, the lower one drawn first.
+bool meshOptimizing()
+{
+	IrrlichtDevice* device = createDevice(EDT_NULL);
+	assert_log(device);
+	if (!device)
+		return false;
+	IMeshManipulator* manipulator = device->getSceneManager()->getMeshManipulator();
+
+	const u32 size = 200;
+	SMesh grids;
+	CDynamicMeshBuffer* buffer = new CDynamicMeshBuffer(EVT_STANDARD, EIT_32BIT);
+	grids.addMeshBuffer(buffer);
+	buffer->drop();
+	IVertexBuffer& vertices = buffer->getVertexBuffer();
+	IIndexBuffer& indices = buffer->getIndexBuffer();
+	for (u32 level=0; level<2; ++level)
+	{
+		const u32 first = vertices.size();
+		for (u32 z=0; z<size; ++z)
+		{
+			for (u32 x=0; x<size; ++x)
+				vertices.push_back(S3DVertex((f32)x, (f32)level, (f32)z, 0.f, 1.f, 0.f, SColor(255, 255, 255, 255), 0.f, 0.f));
+		}
+		// rows of quads facing up
+		for (u32 z=0; z+1<size; ++z)
+		{
+			for (u32 x=0; x+1<size; ++x)
+			{
+				const u32 i = first + z*size + x;
+				indices.push_back(i);
+				indices.push_back(i+size);
+				indices.push_back(i+1);
+				indices.push_back(i+size);
+				indices.push_back(i+size+1);
+				indices.push_back(i+1);
+			}
+		}
+	}
+
+	SMeshOptimizationReport report;
+	IMesh* optimized = manipulator->createOptimizedMesh(&grids, EMOF_DEFAULT, &report);
+	bool result = optimized->getMeshBufferCount() == 1 &&
+		optimized->getMeshBuffer(0)->getIndexType() == EIT_32BIT &&
+		optimized->getMeshBuffer(0)->getVertexCount() == vertices.size() &&
+		optimized->getMeshBuffer(0)->getIndexCount() == indices.size() &&
+		report.AcmrAfter < report.AcmrBefore &&
+		equals(report.OverdrawBefore, 2.f, 0.01f) &&
+		report.OverdrawAfter < 1.01f;
+	optimized->drop();
+
+	// split into buffers with 16 bit indices
+	optimized = manipulator->createOptimizedMesh(&grids, EMOF_DEFAULT | EMOF_SPLIT_BUFFERS);
+	u32 indexCount = 0;
+	for (u32 i=0; i<optimized->getMeshBufferCount(); ++i)
+	{
+		result &= optimized->getMeshBuffer(i)->getIndexType() == EIT_16BIT;
+		indexCount += optimized->getMeshBuffer(i)->getIndexCount();
+	}
+	result &= optimized->getMeshBufferCount() > 1 && indexCount == indices.size();
+	optimized->drop();
+
+	// merge buffers with the same material
+	IMesh* cube = device->getSceneManager()->getGeometryCreator()->createCubeMesh();
+	SMesh cubes;
+	cubes.addMeshBuffer(cube->getMeshBuffer(0));
+	cubes.addMeshBuffer(cube->getMeshBuffer(0));
+	optimized = manipulator->createOptimizedMesh(&cubes, EMOF_DEFAULT | EMOF_MERGE_BUFFERS);
+	result &= optimized->getMeshBufferCount() == 1 &&
+		optimized->getMeshBuffer(0)->getIndexCount() == 72;
+	optimized->drop();
+	cube->drop();
+	device->drop();
+
+	if (!result)
+		logTestString("meshOptimizing failed\n");
+	return result;
+}
+
+// Quantizes a sphere with and without tangents, draws it and decodes it again.
+bool meshQuantizing()
+{
+	bool result = sizeof(S3DVertexQuantized) == 20 && sizeof(S3DVertexQuantizedTangents) == 28;
+
+	IrrlichtDevice* device = createDevice(EDT_NULL);
+	assert_log(device);
+	if (!device)
+		return false;
+	IVideoDriver* driver = device->getVideoDriver();
+	IMeshManipulator* manipulator = device->getSceneManager()->getMeshManipulator();
+
+	IMesh* sphere = device->getSceneManager()->getGeometryCreator()->createSphereMesh(5.f, 16, 16);
+	IMesh* tangents = manipulator->createMeshWithTangents(sphere);
+	SMesh spheres;
+	spheres.addMeshBuffer(sphere->getMeshBuffer(0));
+	spheres.addMeshBuffer(tangents->getMeshBuffer(0));
+	spheres.recalculateBoundingBox();
+	IMesh* quantized = manipulator->createMeshQuantized(&spheres);
+	result &= quantized->getMeshBuffer(0)->getVertexType() == EVT_QUANTIZED &&
+		quantized->getMeshBuffer(1)->getVertexType() == EVT_QUANTIZED_TANGENTS &&
+		quantized->getBoundingBox().getExtent().equals(sphere->getBoundingBox().getExtent(), 0.001f);
+
+	driver->beginScene(ECBF_COLOR | ECBF_DEPTH, SColor(255, 0, 0, 0));
+	driver->drawMeshBuffer(quantized->getMeshBuffer(0));
+	driver->drawMeshBuffer(quantized->getMeshBuffer(1));
+	driver->endScene();
+	result &= driver->getPrimitiveCountDrawn() == 2 * sphere->getMeshBuffer(0)->getPrimitiveCount();
+
+	// positions within a step of 10/65535, directions within about 0.01 degrees
+	IMesh* decoded = manipulator->createMeshWithTangents(quantized, false, false, false, false);
+	const S3DVertexTangents* original = (const S3DVertexTangents*)tangents->getMeshBuffer(0)->getVertices();
+	for (u32 b=0; b<2; ++b)
+	{
+		const S3DVertexTangents* v = (const S3DVertexTangents*)decoded->getMeshBuffer(b)->getVertices();
+		for (u32 i=0; i<decoded->getMeshBuffer(b)->getVertexCount(); ++i)
+		{
+			result &= v[i].Pos.equals(original[i].Pos, 0.0002f) &&
+				v[i].Normal.equals(original[i].Normal, 0.0002f) &&
+				v[i].TCoords.equals(original[i].TCoords, 0.0001f) &&
+				v[i].Color == original[i].Color;
+			// zero tangents at the poles can't be encoded
+			if (b == 1 && original[i].Tangent.getLength() > 0.5f)
+			{
+				result &= v[i].Tangent.equals(original[i].Tangent, 0.0002f) &&
+					v[i].Binormal.equals(original[i].Binormal, 0.0002f);
+			}
+		}
+	}
+	decoded->drop();
+
+	// values changed through the accessors are encoded again
+	IMeshBuffer* buffer = quantized->getMeshBuffer(1);
+	const vector3df position = buffer->getPosition(2);
+	const vector3df normal = buffer->getNormal(2);
+	const vector2df tcoords = buffer->getTCoords(2);
+	buffer->getPosition(1) = position;
+	buffer->getNormal(1) = normal;
+	buffer->getTCoords(1) = tcoords;
+	result &= buffer->getPosition(1).equals(position, 0.0002f) && buffer->getTCoords(1).equals(tcoords, 0.0001f);
+	buffer->getPosition(3) += vector3df(0.5f, 0.f, 0.f);
+	buffer->setDirty();
+	const IMeshBuffer* constBuffer = buffer;
+	result &= constBuffer->getPosition(1).equals(position, 0.0002f) &&
+		constBuffer->getNormal(1).equals(normal, 0.0002f) &&
+		constBuffer->getTCoords(1).equals(tcoords, 0.0001f) &&
+		constBuffer->getPosition(3).equals(tangents->getMeshBuffer(0)->getPosition(3) + vector3df(0.5f, 0.f, 0.f), 0.0002f);
+	quantized->drop();
+	tangents->drop();
+	sphere->drop();
+	device->drop();
+
+	if (!result)
+		logTestString("meshQuantizing failed\n");
+	return result;
+}
+
+} // end anonymous namespace
+
 // Tests mesh transformations via mesh manipulator.
 bool meshTransform(void)
 {
+	const bool welding = meshWelding();
+	const bool optimizing = meshOptimizing();
+	const bool quantizing = meshQuantizing();
+
 	// Use EDT_BURNINGSVIDEO since it is not dependent on (e.g.) OpenGL driver versions.
 	IrrlichtDevice *device = createDevice(EDT_BURNINGSVIDEO, dimension2d<u32>(160, 120), 32);
 	assert_log(device);
@@ -84,5 +321,5 @@ bool meshTransform(void)
 	device->run();
 	device->drop();
 
-	return result;
+	return result && welding && optimizing && quantizing;
 }
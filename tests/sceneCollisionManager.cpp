@@ -3,6 +3,12 @@
 
 #include "testUtils.h"
 
+#if defined(_IRR_WINDOWS_API_)
+#include <windows.h> // For CreateThread()
+#elif defined(_IRR_POSIX_API_)
+#include <pthread.h>
+#endif
+
 using namespace irr;
 using namespace core;
 using namespace scene;
@@ -439,6 +445,848 @@ static bool compareGetSceneNodeFromRayBBWithBBIntersectsWithLine(IrrlichtDevice
 }
 
 
+// Compare the hits of the bounding volume hierarchy selector with the ones of the plain selector
+static bool compareBVHTriangleSelector(IrrlichtDevice * device,
+				ISceneManager * smgr,
+				ISceneCollisionManager * collMgr)
+{
+	IMesh* mesh = smgr->getGeometryCreator()->createSphereMesh(10.f, 32, 32);
+	IMeshSceneNode* node = smgr->addMeshSceneNode(mesh, 0, -1,
+		vector3df(5, -3, 20), vector3df(30, 45, 10), vector3df(1.f, 2.f, 0.5f));
+	node->updateAbsolutePosition();
+
+	ITriangleSelector* plain = smgr->createTriangleSelector(mesh, node);
+	ITriangleSelector* bvh = smgr->createBVHTriangleSelector(mesh, node);
+	mesh->drop();
+
+	const core::matrix4& mat = node->getAbsoluteTransformation();
+	const IMeshBuffer* mb = node->getMesh()->getMeshBuffer(0);
+	const u16* indices = mb->getIndices();
+
+	bool result = true;
+	u32 hits = 0;
+	for (u32 i=0; i+2<mb->getIndexCount() && result; i+=3*7)
+	{
+		// aim at the centroid of a triangle, and beside the sphere
+		vector3df target = (mb->getPosition(indices[i]) + mb->getPosition(indices[i+1]) + mb->getPosition(indices[i+2])) / 3.f;
+		mat.transformVect(target);
+		const vector3df offset((f32)(i%13) - 6.f, 60.f, (f32)(i%7) - 3.f);
+
+		for (u32 k=0; k<2; ++k)
+		{
+			const line3df ray(target + offset, k ? target + vector3df(40.f, -60.f, 0.f) : target - offset);
+
+			SCollisionHit hitPlain;
+			SCollisionHit hitBVH;
+			const bool foundPlain = collMgr->getCollisionPoint(hitPlain, ray, plain);
+			const bool foundBVH = collMgr->getCollisionPoint(hitBVH, ray, bvh);
+
+			if (foundPlain != foundBVH ||
+				(foundPlain && !hitPlain.Intersection.equals(hitBVH.Intersection, 0.01f)))
+			{
+				logTestString("compareBVHTriangleSelector: different results for ray %u/%u.\n", i, k);
+				result = false;
+				break;
+			}
+			if (foundBVH && (hitBVH.Node != node || hitBVH.TriangleSelector != bvh))
+			{
+				logTestString("compareBVHTriangleSelector: wrong hit information.\n");
+				result = false;
+				break;
+			}
+			hits += foundBVH ? 1 : 0;
+		}
+	}
+
+	if (result && hits == 0)
+	{
+		logTestString("compareBVHTriangleSelector: no hits.\n");
+		result = false;
+	}
+
+	// box queries have to find the same triangles
+	const aabbox3df box(vector3df(0, -10, 10), vector3df(10, 5, 25));
+	array<triangle3df> trianglesPlain(plain->getTriangleCount());
+	array<triangle3df> trianglesBVH(bvh->getTriangleCount());
+	s32 countPlain = 0;
+	s32 countBVH = 0;
+	plain->getTriangles(trianglesPlain.pointer(), plain->getTriangleCount(), countPlain, box);
+	bvh->getTriangles(trianglesBVH.pointer(), bvh->getTriangleCount(), countBVH, box);
+
+	if (countBVH == 0 || countBVH > countPlain)
+	{
+		logTestString("compareBVHTriangleSelector: unexpected box query result %d %d.\n", countBVH, countPlain);
+		result = false;
+	}
+
+	plain->drop();
+	bvh->drop();
+
+	assert_log(result);
+
+	smgr->clear();
+
+	return result;
+}
+
+
+// Quantized meshes have to collide like the float meshes they were made from, also after the BVH selector refits a frame
+static bool testQuantizedMeshCollision(IrrlichtDevice * device,
+				ISceneManager * smgr,
+				ISceneCollisionManager * collMgr)
+{
+	IMeshManipulator* manipulator = smgr->getMeshManipulator();
+	SAnimatedMesh* floatMesh = new SAnimatedMesh();
+	SAnimatedMesh* quantizedMesh = new SAnimatedMesh();
+	for (u32 f=0; f<2; ++f)
+	{
+		IMesh* sphere = smgr->getGeometryCreator()->createSphereMesh(10.f, 32, 32);
+		if (f)
+		{
+			// the second frame moves and flattens the sphere
+			matrix4 m;
+			m.setTranslation(vector3df(3.f, 1.f, 0.f));
+			m.setScale(vector3df(1.f, 0.5f, 1.f));
+			manipulator->transform(sphere, m);
+		}
+		IMesh* quantized = manipulator->createMeshQuantized(sphere);
+		floatMesh->addMesh(sphere);
+		quantizedMesh->addMesh(quantized);
+		sphere->drop();
+		quantized->drop();
+	}
+	floatMesh->recalculateBoundingBox();
+	quantizedMesh->recalculateBoundingBox();
+
+	IAnimatedMeshSceneNode* floatNode = smgr->addAnimatedMeshSceneNode(floatMesh, 0, -1, vector3df(0, 0, 30));
+	IAnimatedMeshSceneNode* quantizedNode = smgr->addAnimatedMeshSceneNode(quantizedMesh, 0, -1, vector3df(0, 0, 30));
+	floatNode->updateAbsolutePosition();
+	quantizedNode->updateAbsolutePosition();
+
+	// the octree selector doesn't follow the frames, so it only takes part in the first one
+	ITriangleSelector* reference = smgr->createTriangleSelector(floatNode);
+	ITriangleSelector* selectors[] = {
+		smgr->createTriangleSelector(quantizedNode),
+		smgr->createBVHTriangleSelector(quantizedNode),
+		smgr->createOctreeTriangleSelector(quantizedMesh->getMesh(0), quantizedNode, 32) };
+	floatMesh->drop();
+	quantizedMesh->drop();
+
+	bool result = true;
+	u32 hits = 0;
+	for (s32 frame=0; frame<2 && result; ++frame)
+	{
+		floatNode->setCurrentFrame((f32)frame);
+		quantizedNode->setCurrentFrame((f32)frame);
+
+		// the rays pass beside the vertices and away from the silhouette
+		for (s32 x=-6; x<=6 && result; x+=3)
+		{
+			for (s32 z=-6; z<=6 && result; z+=3)
+			{
+				const vector3df start(x + 0.5f, 40.f, 30.25f + z);
+				const line3df ray(start, start - vector3df(0.f, 80.f, 0.f));
+				SCollisionHit hitReference;
+				const bool foundReference = collMgr->getCollisionPoint(hitReference, ray, reference);
+				hits += foundReference ? 1 : 0;
+
+				for (u32 k=0; k<(frame ? 2u : 3u); ++k)
+				{
+					SCollisionHit hit;
+					const bool found = collMgr->getCollisionPoint(hit, ray, selectors[k]);
+					if (found != foundReference ||
+						(found && !hit.Intersection.equals(hitReference.Intersection, 0.01f)))
+					{
+						logTestString("testQuantizedMeshCollision: different results of selector %u in frame %d.\n", k, frame);
+						result = false;
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	if (result && hits == 0)
+	{
+		logTestString("testQuantizedMeshCollision: no hits.\n");
+		result = false;
+	}
+
+	reference->drop();
+	for (u32 k=0; k<3; ++k)
+		selectors[k]->drop();
+
+	assert_log(result);
+
+	smgr->clear();
+
+	return result;
+}
+
+
+// Sets a frame and compares the hits of two selectors of the animated node on a grid of rays
+static bool compareAnimatedFrameHits(ISceneCollisionManager * collMgr, IAnimatedMeshSceneNode* node,
+				s32 frame, ITriangleSelector* plain, ITriangleSelector* bvh, u32& hits)
+{
+	node->setCurrentFrame((f32)frame);
+	const aabbox3df box = node->getTransformedBoundingBox();
+
+	for (u32 y=0; y<12; ++y)
+	{
+		for (u32 x=0; x<12; ++x)
+		{
+			const vector3df target(
+				box.MinEdge.X + (box.MaxEdge.X - box.MinEdge.X) * (x + 0.5f) / 12.f,
+				box.MinEdge.Y + (box.MaxEdge.Y - box.MinEdge.Y) * (y + 0.5f) / 12.f,
+				box.getCenter().Z);
+			const line3df ray(target - vector3df(0, 0, 100), target + vector3df(0, 0, 100));
+
+			SCollisionHit hitPlain;
+			SCollisionHit hitBVH;
+			const bool foundPlain = collMgr->getCollisionPoint(hitPlain, ray, plain);
+			const bool foundBVH = collMgr->getCollisionPoint(hitBVH, ray, bvh);
+
+			if (foundPlain != foundBVH ||
+				(foundPlain && !hitPlain.Intersection.equals(hitBVH.Intersection, 0.01f)))
+			{
+				logTestString("compareAnimatedBVHTriangleSelector: different results in frame %d.\n", frame);
+				return false;
+			}
+			hits += foundBVH ? 1 : 0;
+		}
+	}
+
+	return true;
+}
+
+
+// The refitted hierarchy of an animated node has to find the same hits as the plain selector
+static bool compareAnimatedBVHTriangleSelector(IrrlichtDevice * device,
+				ISceneManager * smgr,
+				ISceneCollisionManager * collMgr)
+{
+	IAnimatedMesh* mesh = smgr->getMesh("../media/sydney.md2");
+	if (!mesh)
+	{
+		logTestString("compareAnimatedBVHTriangleSelector: can't load mesh.\n");
+		return false;
+	}
+
+	IAnimatedMeshSceneNode* node = smgr->addAnimatedMeshSceneNode(mesh, 0, -1,
+		vector3df(0, 0, 50), vector3df(0, 60, 0));
+	node->updateAbsolutePosition();
+
+	ITriangleSelector* plain = smgr->createTriangleSelector(node);
+	ITriangleSelector* bvh = smgr->createBVHTriangleSelector(node);
+
+	bool result = true;
+	u32 hits = 0;
+	const s32 frames[] = { 0, 40, 75, 140, 190 };
+	for (u32 f=0; f<sizeof(frames)/sizeof(frames[0]) && result; ++f)
+		result = compareAnimatedFrameHits(collMgr, node, frames[f], plain, bvh, hits);
+
+	// Other meshes on the node, with fewer and then more triangles, need a new hierarchy
+	IAnimatedMesh* gun = smgr->getMesh("../media/gun.md2");
+	IAnimatedMesh* swapped[] = { gun, mesh };
+	for (u32 m=0; m<2 && result && gun; ++m)
+	{
+		node->setMesh(swapped[m]);
+		node->setCurrentFrame(0.f);
+
+		ITriangleSelector* swappedPlain = smgr->createTriangleSelector(node);
+		result = compareAnimatedFrameHits(collMgr, node, 20, swappedPlain, bvh, hits);
+		swappedPlain->drop();
+	}
+
+	if (result && hits == 0)
+	{
+		logTestString("compareAnimatedBVHTriangleSelector: no hits.\n");
+		result = false;
+	}
+
+	plain->drop();
+	bvh->drop();
+
+	assert_log(result);
+
+	smgr->clear();
+
+	return result;
+}
+
+
+// Batched queries have to give the same results as single ones
+static bool compareBatchedCollisionPoints(IrrlichtDevice * device,
+				ISceneManager * smgr,
+				ISceneCollisionManager * collMgr)
+{
+	IMesh* mesh = smgr->getGeometryCreator()->createSphereMesh(10.f, 24, 24);
+	IMeshSceneNode* sphere = smgr->addMeshSceneNode(mesh, 0, -1,
+		vector3df(0, 0, 30), vector3df(0, 30, 0), vector3df(1.5f, 1.f, 1.f));
+	ISceneNode* cube = smgr->addCubeSceneNode(10, 0, -1, vector3df(8, 0, 15));
+	sphere->updateAbsolutePosition();
+	cube->updateAbsolutePosition();
+
+	IMetaTriangleSelector* meta = smgr->createMetaTriangleSelector();
+	ITriangleSelector* bvh = smgr->createBVHTriangleSelector(mesh, sphere);
+	meta->addTriangleSelector(bvh);
+	ITriangleSelector* selector = smgr->createTriangleSelectorFromBoundingBox(cube);
+	meta->addTriangleSelector(selector);
+	selector->drop();
+	mesh->drop();
+
+	// a fan of rays, some of them hitting the cube in front of the sphere, some missing both
+	// enough of them that the collision manager splits the batch between threads
+	const u32 rayCount = 1201;
+	array<line3df> rays(rayCount);
+	for (u32 i=0; i<rayCount; ++i)
+	{
+		const f32 x = -30.f + 0.05f * i;
+		rays.push_back(line3df(vector3df(0, 1, -10), vector3df(x, (f32)(i%5) - 2.f, 60)));
+	}
+
+	array<SCollisionHit> hits(rayCount);
+	array<bool> found(rayCount);
+	hits.set_used(rayCount);
+	found.set_used(rayCount);
+
+	bool result = true;
+	ITriangleSelector* selectors[] = { bvh, meta };
+	for (u32 s=0; s<2 && result; ++s)
+	{
+		const u32 hitCount = collMgr->getCollisionPoints(hits.pointer(), found.pointer(),
+			rays.const_pointer(), rayCount, selectors[s]);
+
+		u32 expectedCount = 0;
+		for (u32 i=0; i<rayCount; ++i)
+		{
+			SCollisionHit single;
+			const bool singleFound = collMgr->getCollisionPoint(single, rays[i], selectors[s]);
+			expectedCount += singleFound ? 1 : 0;
+
+			if (singleFound != found[i] ||
+				(singleFound && (single.Node != hits[i].Node || !single.Intersection.equals(hits[i].Intersection, 0.01f))))
+			{
+				logTestString("compareBatchedCollisionPoints: different result for ray %u of selector %u.\n", i, s);
+				result = false;
+				break;
+			}
+		}
+
+		if (result && (hitCount != expectedCount || hitCount == 0 || hitCount == rayCount))
+		{
+			logTestString("compareBatchedCollisionPoints: unexpected hit count %u.\n", hitCount);
+			result = false;
+		}
+	}
+
+	bvh->drop();
+	meta->drop();
+
+	assert_log(result);
+
+	smgr->clear();
+
+	return result;
+}
+
+
+// Finds the nearest hit of all selectors of a meta selector one by one
+static bool getNearestChildHit(SCollisionHit& hitResult, const line3df& ray, const IMetaTriangleSelector* meta)
+{
+	bool found = false;
+	f32 nearest = FLT_MAX;
+	for (u32 i=0; i<meta->getSelectorCount(); ++i)
+	{
+		SCollisionHit hit;
+		if (meta->getSelector(i)->getCollisionPoint(hit, ray) && hit.Intersection.getDistanceFromSQ(ray.start) < nearest)
+		{
+			nearest = hit.Intersection.getDistanceFromSQ(ray.start);
+			hitResult = hit;
+			found = true;
+		}
+	}
+	return found;
+}
+
+
+// Culling by bounds in a meta selector must not change the results, also after moving and removing nodes
+static bool compareMetaTriangleSelectorBounds(IrrlichtDevice * device,
+				ISceneManager * smgr,
+				ISceneCollisionManager * collMgr)
+{
+	IMetaTriangleSelector* meta = smgr->createMetaTriangleSelector();
+	array<IMeshSceneNode*> nodes;
+	for (s32 x=0; x<12; ++x)
+	{
+		for (s32 z=0; z<12; ++z)
+		{
+			IMeshSceneNode* cube = smgr->addCubeSceneNode(4.f, 0, -1, vector3df(x * 10.f, (f32)((x+z)%3), z * 10.f));
+			cube->updateAbsolutePosition();
+			ITriangleSelector* selector = smgr->createTriangleSelector(cube->getMesh(), cube);
+			meta->addTriangleSelector(selector);
+			selector->drop();
+			nodes.push_back(cube);
+		}
+	}
+
+	bool result = true;
+	for (u32 pass=0; pass<3 && result; ++pass)
+	{
+		if (pass == 1)
+		{
+			// move some nodes a bit and some far, the culling has to follow them
+			for (u32 i=0; i<nodes.size(); i+=5)
+			{
+				nodes[i]->setPosition(nodes[i]->getPosition() + (i%2 ? vector3df(0.5f, 0, 0) : vector3df(3.f, 0, 37.f)));
+				nodes[i]->updateAbsolutePosition();
+			}
+		}
+		else if (pass == 2)
+		{
+			for (u32 i=0; i<nodes.size(); i+=7)
+				meta->removeTriangleSelector(meta->getSelector(i));
+		}
+
+		u32 hits = 0;
+		for (u32 i=0; i<60 && result; ++i)
+		{
+			const line3df ray(vector3df(-5.f + i * 2.f, 20.f, -10.f), vector3df(120.f - i * 2.f, (f32)(i%4) - 1.f, 130.f));
+
+			SCollisionHit hitMeta;
+			SCollisionHit hitChild;
+			const bool foundMeta = collMgr->getCollisionPoint(hitMeta, ray, meta);
+			const bool foundChild = getNearestChildHit(hitChild, ray, meta);
+			if (foundMeta != foundChild ||
+				(foundMeta && (hitMeta.Node != hitChild.Node || !hitMeta.Intersection.equals(hitChild.Intersection, 0.01f))))
+			{
+				logTestString("compareMetaTriangleSelectorBounds: different results for ray %u in pass %u.\n", i, pass);
+				result = false;
+			}
+			hits += foundMeta ? 1 : 0;
+		}
+
+		if (result && hits == 0)
+		{
+			logTestString("compareMetaTriangleSelectorBounds: no hits in pass %u.\n", pass);
+			result = false;
+		}
+
+		// nodes are not rotated, so box queries find exactly the same triangles
+		array<triangle3df> triangles;
+		triangles.set_used(meta->getTriangleCount());
+		for (u32 i=0; i<10 && result; ++i)
+		{
+			const aabbox3df box(vector3df(i * 11.f, -2.f, i * 7.f), vector3df(i * 11.f + 15.f, 2.f, i * 7.f + 25.f));
+
+			s32 countMeta = 0;
+			meta->getTriangles(triangles.pointer(), meta->getTriangleCount(), countMeta, box);
+
+			s32 countChildren = 0;
+			for (u32 s=0; s<meta->getSelectorCount(); ++s)
+			{
+				s32 count = 0;
+				meta->getSelector(s)->getTriangles(triangles.pointer(), meta->getTriangleCount(), count, box);
+				countChildren += count;
+			}
+
+			if (countMeta != countChildren)
+			{
+				logTestString("compareMetaTriangleSelectorBounds: box %u finds %d instead of %d triangles in pass %u.\n",
+					i, countMeta, countChildren, pass);
+				result = false;
+			}
+		}
+	}
+
+	meta->drop();
+
+	assert_log(result);
+
+	smgr->clear();
+
+	return result;
+}
+
+
+namespace
+{
+	// Queries run by each thread of testConcurrentQueries
+	struct SConcurrentQueries
+	{
+		enum { RAY_COUNT = 16, BOX_COUNT = 8, MOVE_COUNT = 8 };
+
+		ISceneCollisionManager* CollMgr;
+		ITriangleSelector* Selector;
+		line3df Rays[RAY_COUNT];
+		aabbox3df Boxes[BOX_COUNT];
+		vector3df Starts[MOVE_COUNT];
+
+		// results of a single thread to compare with
+		bool RayFound[RAY_COUNT];
+		vector3df RayHits[RAY_COUNT];
+		s32 BoxTriangleCounts[BOX_COUNT];
+		vector3df MoveResults[MOVE_COUNT];
+	};
+
+	struct SConcurrentThread
+	{
+		const SConcurrentQueries* Queries;
+		u32 Iterations;
+		u32 Offset;
+		bool Result;
+	};
+
+	// offset rotates the order of the queries, so threads don't run the same one at the same time
+	void runQueries(const SConcurrentQueries& q, u32 offset, bool RayFound[], vector3df RayHits[],
+		s32 BoxTriangleCounts[], vector3df MoveResults[])
+	{
+		for (u32 n=0; n<SConcurrentQueries::RAY_COUNT; ++n)
+		{
+			const u32 i = (n + offset) % SConcurrentQueries::RAY_COUNT;
+			SCollisionHit hit;
+			RayFound[i] = q.CollMgr->getCollisionPoint(hit, q.Rays[i], q.Selector);
+			RayHits[i] = hit.Intersection;
+		}
+
+		array<triangle3df> triangles(q.Selector->getTriangleCount());
+		for (u32 n=0; n<SConcurrentQueries::BOX_COUNT; ++n)
+		{
+			const u32 i = (n + offset) % SConcurrentQueries::BOX_COUNT;
+			q.Selector->getTriangles(triangles.pointer(), q.Selector->getTriangleCount(), BoxTriangleCounts[i], q.Boxes[i]);
+		}
+
+		for (u32 n=0; n<SConcurrentQueries::MOVE_COUNT; ++n)
+		{
+			const u32 i = (n + offset) % SConcurrentQueries::MOVE_COUNT;
+			triangle3df triOut;
+			vector3df hitPosition;
+			bool falling;
+			ISceneNode* hitNode;
+			MoveResults[i] = q.CollMgr->getCollisionResultPosition(q.Selector, q.Starts[i],
+				vector3df(2, 4, 2), vector3df(0, 0, 15), triOut, hitPosition, falling, hitNode,
+				0.0005f, vector3df(0, -1.f, 0));
+		}
+	}
+
+#if defined(_IRR_WINDOWS_API_)
+	DWORD WINAPI concurrentQueryThread(LPVOID data)
+#else
+	void* concurrentQueryThread(void* data)
+#endif
+	{
+		SConcurrentThread& thread = *(SConcurrentThread*)data;
+		const SConcurrentQueries& q = *thread.Queries;
+
+		bool rayFound[SConcurrentQueries::RAY_COUNT];
+		vector3df rayHits[SConcurrentQueries::RAY_COUNT];
+		s32 boxTriangleCounts[SConcurrentQueries::BOX_COUNT];
+		vector3df moveResults[SConcurrentQueries::MOVE_COUNT];
+
+		thread.Result = true;
+		for (u32 n=0; n<thread.Iterations; ++n)
+		{
+			runQueries(q, thread.Offset + n, rayFound, rayHits, boxTriangleCounts, moveResults);
+
+			for (u32 i=0; i<SConcurrentQueries::RAY_COUNT; ++i)
+				thread.Result &= rayFound[i] == q.RayFound[i] && rayHits[i] == q.RayHits[i];
+			for (u32 i=0; i<SConcurrentQueries::BOX_COUNT; ++i)
+				thread.Result &= boxTriangleCounts[i] == q.BoxTriangleCounts[i];
+			for (u32 i=0; i<SConcurrentQueries::MOVE_COUNT; ++i)
+				thread.Result &= moveResults[i] == q.MoveResults[i];
+		}
+		return 0;
+	}
+}
+
+// Run ray, box and ellipsoid queries from several threads against the same selectors
+static bool testConcurrentQueries(IrrlichtDevice * device,
+				ISceneManager * smgr,
+				ISceneCollisionManager * collMgr)
+{
+	IMesh* sphereMesh = smgr->getGeometryCreator()->createSphereMesh(10.f, 24, 24);
+	IMeshSceneNode* sphere = smgr->addMeshSceneNode(sphereMesh, 0, -1, vector3df(0, 0, 30));
+	IMesh* planeMesh = smgr->getGeometryCreator()->createHillPlaneMesh(dimension2df(10, 10),
+		dimension2du(12, 12), 0, 5.f, dimension2df(2, 2), dimension2df(1, 1));
+	IMeshSceneNode* plane = smgr->addMeshSceneNode(planeMesh, 0, -1, vector3df(0, -15, 20));
+	ISceneNode* cube = smgr->addCubeSceneNode(10, 0, -1, vector3df(-20, 0, 20), vector3df(0, 30, 0));
+	smgr->getRootSceneNode()->updateAbsolutePosition();
+	sphere->updateAbsolutePosition();
+	plane->updateAbsolutePosition();
+	cube->updateAbsolutePosition();
+
+	IMetaTriangleSelector* meta = smgr->createMetaTriangleSelector();
+	ITriangleSelector* selector = smgr->createBVHTriangleSelector(sphereMesh, sphere);
+	meta->addTriangleSelector(selector);
+	selector->drop();
+	selector = smgr->createOctreeTriangleSelector(planeMesh, plane, 16);
+	meta->addTriangleSelector(selector);
+	selector->drop();
+	selector = smgr->createTriangleSelector(planeMesh, plane);
+	meta->addTriangleSelector(selector);
+	selector->drop();
+	selector = smgr->createTriangleSelectorFromBoundingBox(cube);
+	meta->addTriangleSelector(selector);
+	selector->drop();
+	sphereMesh->drop();
+	planeMesh->drop();
+
+	SConcurrentQueries queries;
+	queries.CollMgr = collMgr;
+	queries.Selector = meta;
+	for (u32 i=0; i<SConcurrentQueries::RAY_COUNT; ++i)
+		queries.Rays[i] = line3df(vector3df(0, 5, -20), vector3df(-40.f + 5.f * i, -20.f + (f32)(i % 4) * 8.f, 60));
+	for (u32 i=0; i<SConcurrentQueries::BOX_COUNT; ++i)
+		queries.Boxes[i] = aabbox3df(vector3df(-25.f + 6.f * i, -15, 15), vector3df(-15.f + 6.f * i, 5, 30));
+	for (u32 i=0; i<SConcurrentQueries::MOVE_COUNT; ++i)
+		queries.Starts[i] = vector3df(-24.f + 6.f * i, -2, 0);
+
+	runQueries(queries, 0, queries.RayFound, queries.RayHits, queries.BoxTriangleCounts, queries.MoveResults);
+
+	bool result = true;
+	u32 rayHits = 0;
+	for (u32 i=0; i<SConcurrentQueries::RAY_COUNT; ++i)
+		rayHits += queries.RayFound[i] ? 1 : 0;
+	if (rayHits == 0)
+	{
+		logTestString("testConcurrentQueries: rays don't hit anything.\n");
+		result = false;
+	}
+
+	const u32 threadCount = 8;
+	SConcurrentThread threads[threadCount];
+	for (u32 i=0; i<threadCount; ++i)
+	{
+		threads[i].Queries = &queries;
+		threads[i].Iterations = 200;
+		threads[i].Offset = i;
+		threads[i].Result = false;
+	}
+
+#if defined(_IRR_WINDOWS_API_)
+	HANDLE handles[threadCount];
+	for (u32 i=0; i<threadCount; ++i)
+		handles[i] = CreateThread(0, 0, concurrentQueryThread, &threads[i], 0, 0);
+	for (u32 i=0; i<threadCount; ++i)
+	{
+		if (handles[i])
+		{
+			WaitForSingleObject(handles[i], INFINITE);
+			CloseHandle(handles[i]);
+		}
+		else
+			concurrentQueryThread(&threads[i]);
+	}
+#elif defined(_IRR_POSIX_API_)
+	pthread_t handles[threadCount];
+	bool started[threadCount];
+	for (u32 i=0; i<threadCount; ++i)
+		started[i] = pthread_create(&handles[i], 0, concurrentQueryThread, &threads[i]) == 0;
+	for (u32 i=0; i<threadCount; ++i)
+	{
+		if (started[i])
+			pthread_join(handles[i], 0);
+		else
+			concurrentQueryThread(&threads[i]);
+	}
+#else
+	for (u32 i=0; i<threadCount; ++i)
+		concurrentQueryThread(&threads[i]);
+#endif
+
+	for (u32 i=0; i<threadCount; ++i)
+	{
+		if (!threads[i].Result)
+		{
+			logTestString("testConcurrentQueries: thread %u got different results.\n", i);
+			result = false;
+		}
+	}
+
+	meta->drop();
+
+	assert_log(result);
+
+	smgr->clear();
+
+	return result;
+}
+
+
+// Writes the acceleration data of a selector into memory
+static bool writeAccelerationData(IrrlichtDevice * device, const ITriangleSelector* selector, array<u8>& outData)
+{
+	outData.set_used(1024*1024);
+	io::IWriteFile* file = device->getFileSystem()->createMemoryWriteFile(outData.pointer(), outData.size(), "selector.bin");
+	const bool written = selector->writeAccelerationData(file);
+	outData.set_used(written ? file->getPos() : 0);
+	file->drop();
+	return written;
+}
+
+static bool isSameData(const array<u8>& a, const array<u8>& b)
+{
+	return a.size() == b.size() && (a.empty() || !memcmp(a.const_pointer(), b.const_pointer(), a.size()));
+}
+
+// Copies BVH data and lets the second child of the root share the children of the first one
+static bool makeSharedChildrenData(const array<u8>& data, array<u8>& shared)
+{
+	// header of 9 u32, the nodes are a box followed by Index and Count
+	const u32 headerSize = 9 * sizeof(u32);
+	if (data.size() < headerSize)
+		return false;
+	u32 nodeSize, nodeCount;
+	memcpy(&nodeSize, &data[6 * sizeof(u32)], sizeof(u32));
+	memcpy(&nodeCount, &data[7 * sizeof(u32)], sizeof(u32));
+	if (nodeCount < 3 || data.size() < headerSize + nodeCount * nodeSize)
+		return false;
+
+	shared = data;
+	u32 index[3], count[3];
+	for (u32 i=0; i<3; ++i)
+	{
+		memcpy(&index[i], &shared[headerSize + i * nodeSize + sizeof(aabbox3df)], sizeof(u32));
+		memcpy(&count[i], &shared[headerSize + i * nodeSize + sizeof(aabbox3df) + sizeof(u32)], sizeof(u32));
+	}
+	if (count[0] || index[0] != 1 || count[1] || count[2])
+		return false;
+	memcpy(&shared[headerSize + 2 * nodeSize + sizeof(aabbox3df)], &index[1], sizeof(u32));
+	return true;
+}
+
+enum ESelectorKind
+{
+	ESK_OCTREE,
+	ESK_OCTREE_OTHER_SPLIT,
+	ESK_BVH
+};
+
+static ITriangleSelector* createSelector(IrrlichtDevice * device, ESelectorKind kind, IMesh* mesh,
+	const array<u8>* data, u32 dataSize)
+{
+	ISceneManager* smgr = device->getSceneManager();
+	io::IReadFile* file = data ? device->getFileSystem()->createMemoryReadFile(data->const_pointer(), dataSize, "selector.bin") : 0;
+	ITriangleSelector* selector = 0;
+	switch (kind)
+	{
+	case ESK_OCTREE:
+		selector = smgr->createOctreeTriangleSelector(mesh, 0, 16, file);
+		break;
+	case ESK_OCTREE_OTHER_SPLIT:
+		selector = smgr->createOctreeTriangleSelector(mesh, 0, 64, file);
+		break;
+	case ESK_BVH:
+		selector = smgr->createBVHTriangleSelector(mesh, 0, false, 4, file);
+		break;
+	}
+	if (file)
+		file->drop();
+	return selector;
+}
+
+// Selectors created from saved acceleration data must work like newly built ones,
+// and data which doesn't fit the mesh has to be ignored.
+static bool testAccelerationData(IrrlichtDevice * device,
+				ISceneManager * smgr,
+				ISceneCollisionManager * collMgr)
+{
+	IMesh* mesh = smgr->getGeometryCreator()->createSphereMesh(10.f, 32, 32);
+	IMesh* otherMesh = smgr->getGeometryCreator()->createSphereMesh(12.f, 32, 32);
+
+	const ESelectorKind kinds[] = { ESK_OCTREE, ESK_BVH };
+
+	bool result = true;
+	for (u32 i=0; i<2 && result; ++i)
+	{
+		const ESelectorKind kind = kinds[i];
+		ITriangleSelector* built = createSelector(device, kind, mesh, 0, 0);
+		array<u8> data;
+		if (!writeAccelerationData(device, built, data) || data.empty())
+		{
+			logTestString("testAccelerationData: no data written by selector %u.\n", kind);
+			result = false;
+			built->drop();
+			break;
+		}
+
+		// loaded selector writes the same tree again and finds the same triangles
+		ITriangleSelector* loaded = createSelector(device, kind, mesh, &data, data.size());
+		array<u8> loadedData;
+		writeAccelerationData(device, loaded, loadedData);
+		if (!isSameData(loadedData, data))
+		{
+			logTestString("testAccelerationData: loaded tree differs for selector %u.\n", kind);
+			result = false;
+		}
+
+		const aabbox3df box(vector3df(0, -10, 0), vector3df(10, 5, 12));
+		array<triangle3df> trianglesBuilt(built->getTriangleCount());
+		array<triangle3df> trianglesLoaded(built->getTriangleCount());
+		s32 countBuilt = 0;
+		s32 countLoaded = 0;
+		built->getTriangles(trianglesBuilt.pointer(), built->getTriangleCount(), countBuilt, box);
+		loaded->getTriangles(trianglesLoaded.pointer(), built->getTriangleCount(), countLoaded, box);
+		if (countBuilt == 0 || countBuilt != countLoaded ||
+			memcmp(trianglesBuilt.pointer(), trianglesLoaded.pointer(), countBuilt*sizeof(triangle3df)))
+		{
+			logTestString("testAccelerationData: box query differs for selector %u.\n", kind);
+			result = false;
+		}
+
+		const line3df ray(vector3df(3, 40, 2), vector3df(-1, -40, 1));
+		SCollisionHit hitBuilt;
+		SCollisionHit hitLoaded;
+		if (!collMgr->getCollisionPoint(hitBuilt, ray, built) || !collMgr->getCollisionPoint(hitLoaded, ray, loaded) ||
+			!hitBuilt.Intersection.equals(hitLoaded.Intersection))
+		{
+			logTestString("testAccelerationData: ray query differs for selector %u.\n", kind);
+			result = false;
+		}
+		loaded->drop();
+		built->drop();
+
+		// a hierarchy reaching nodes twice could bypass the depth limit
+		array<u8> sharedData;
+		if (kind == ESK_BVH && !makeSharedChildrenData(data, sharedData))
+		{
+			logTestString("testAccelerationData: unexpected layout of BVH data.\n");
+			result = false;
+		}
+
+		// data for other triangles, other split settings or broken data is ignored
+		for (u32 k=0; k<4 && result; ++k)
+		{
+			if (k == 3 && kind != ESK_BVH)
+				break;
+			IMesh* testMesh = k == 0 ? otherMesh : mesh;
+			const ESelectorKind testKind = k == 1 ? (kind == ESK_OCTREE ? ESK_OCTREE_OTHER_SPLIT : ESK_OCTREE) : kind;
+			const array<u8>& testData = k == 3 ? sharedData : data;
+			const u32 dataSize = k == 2 ? data.size() - 8 : testData.size();
+
+			ITriangleSelector* expected = createSelector(device, testKind, testMesh, 0, 0);
+			ITriangleSelector* rejected = createSelector(device, testKind, testMesh, &testData, dataSize);
+			array<u8> expectedData;
+			array<u8> rejectedData;
+			writeAccelerationData(device, expected, expectedData);
+			writeAccelerationData(device, rejected, rejectedData);
+			if (expectedData.empty() || !isSameData(expectedData, rejectedData))
+			{
+				logTestString("testAccelerationData: unfitting data %u was used by selector %u.\n", k, kind);
+				result = false;
+			}
+			expected->drop();
+			rejected->drop();
+		}
+	}
+
+	mesh->drop();
+	otherMesh->drop();
+
+	return result;
+}
+
+
 /** Test functionality of the sceneCollisionManager */
 bool sceneCollisionManager(void)
 {
@@ -464,6 +1312,20 @@ bool sceneCollisionManager(void)
 
 	result &= compareGetSceneNodeFromRayBBWithBBIntersectsWithLine(device, smgr, collMgr);
 
+	result &= compareBVHTriangleSelector(device, smgr, collMgr);
+
+	result &= compareAnimatedBVHTriangleSelector(device, smgr, collMgr);
+
+	result &= testQuantizedMeshCollision(device, smgr, collMgr);
+
+	result &= compareBatchedCollisionPoints(device, smgr, collMgr);
+
+	result &= compareMetaTriangleSelectorBounds(device, smgr, collMgr);
+
+	result &= testConcurrentQueries(device, smgr, collMgr);
+
+	result &= testAccelerationData(device, smgr, collMgr);
+
 	device->closeDevice();
 	device->run();
 	device->drop();
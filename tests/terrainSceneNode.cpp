@@ -117,12 +117,178 @@ bool terrainGaps()
 	return result;
 }
 
+// Nearest hit of a line with a list of triangles, tested one by one
+bool getNearestTriangleHit(const array<triangle3df>& triangles, const line3df& line, vector3df& outIntersection)
+{
+	const vector3df lineVect = line.getVector().normalize();
+	const f32 rayLength = line.getLengthSQ();
+	f32 nearest = FLT_MAX;
+	for (u32 i=0; i<triangles.size(); ++i)
+	{
+		vector3df intersection;
+		if (triangles[i].getIntersectionWithLine(line.start, lineVect, intersection))
+		{
+			const f32 distance = intersection.getDistanceFromSQ(line.start);
+			if (distance < rayLength && intersection.getDistanceFromSQ(line.end) < rayLength && distance < nearest)
+			{
+				nearest = distance;
+				outIntersection = intersection;
+			}
+		}
+	}
+	return nearest < FLT_MAX;
+}
+
+// the selector creates the triangles of the terrain on the fly, they have to match the node's own
+bool terrainSelector()
+{
+	IrrlichtDevice* device = createDevice(video::EDT_NULL, dimension2d<u32>(160, 120));
+	if (!device)
+		return true;
+
+	scene::ISceneManager* smgr = device->getSceneManager();
+
+	bool result = true;
+	for (u32 test=0; test<3 && result; ++test)
+	{
+		scene::ITerrainSceneNode* terrain = smgr->addTerrainSceneNode(
+			"../media/terrain-heightmap.bmp", 0, -1, vector3df(-100.f, -20.f, 50.f),
+			test == 0 ? vector3df(0.f, 0.f, 0.f) : vector3df(10.f, 20.f, 5.f), vector3df(4.f, 0.5f, 3.f),
+			video::SColor(255,255,255,255), 5, scene::ETPS_17);
+
+		// patches with less detail next to ones with more
+		s32 lod = (s32)test;
+		if (test == 2)
+		{
+			for (s32 x=0; x<15; ++x)
+				for (s32 z=0; z<15; ++z)
+					terrain->setLODOfPatch(x, z, (x*3 + z) % 4);
+			lod = -1;
+		}
+
+		scene::ITriangleSelector* selector = smgr->createTerrainTriangleSelector(terrain, lod);
+
+		array<triangle3df> triangles(selector->getTriangleCount());
+		triangles.set_used(selector->getTriangleCount());
+		s32 count = 0;
+		selector->getTriangles(triangles.pointer(), triangles.size(), count, 0);
+
+		array<triangle3df> expected;
+		array<u32> indices;
+		const video::S3DVertex2TCoords* vertices = (const video::S3DVertex2TCoords*)terrain->getRenderBuffer()->getVertices();
+		for (s32 x=0; x<15; ++x)
+		{
+			for (s32 z=0; z<15; ++z)
+			{
+				const s32 indexCount = terrain->getIndicesForPatch(indices, x, z, lod);
+				for (s32 i=0; i+2<indexCount; i+=3)
+					expected.push_back(triangle3df(vertices[indices[i]].Pos, vertices[indices[i+1]].Pos, vertices[indices[i+2]].Pos));
+			}
+		}
+
+		if ((u32)count != expected.size())
+		{
+			logTestString("terrainSelector: %d triangles instead of %u in test %u.\n", count, expected.size(), test);
+			result = false;
+			break;
+		}
+		for (u32 i=0; i<expected.size(); ++i)
+		{
+			if (!(triangles[i] == expected[i]))
+			{
+				logTestString("terrainSelector: triangle %u differs in test %u.\n", i, test);
+				result = false;
+				break;
+			}
+		}
+
+		// rays from above the terrain down into it, some of them too short to reach it
+		const aabbox3df& box = terrain->getBoundingBox();
+		const vector3df extent = box.getExtent();
+		u32 hits = 0;
+		for (u32 i=0; i<100 && result; ++i)
+		{
+			const vector3df start(box.MinEdge.X + extent.X * ((i*37)%101) / 100.f, box.MaxEdge.Y + 50.f,
+				box.MinEdge.Z + extent.Z * ((i*53)%103) / 102.f);
+			vector3df end(box.MinEdge.X + extent.X * ((i*71)%97) / 96.f, box.MinEdge.Y - 20.f + (i%7) * 10.f,
+				box.MinEdge.Z + extent.Z * ((i*13)%89) / 88.f);
+			if (i%3 == 0)
+				end = start + (end - start) * 0.3f;
+			const line3df ray(start, end);
+
+			scene::SCollisionHit hit;
+			vector3df intersection;
+			const bool found = selector->getCollisionPoint(hit, ray);
+			if (found != getNearestTriangleHit(triangles, ray, intersection) ||
+				(found && (!hit.Intersection.equals(intersection, 0.01f) || hit.Node != terrain)))
+			{
+				logTestString("terrainSelector: different hit for ray %u in test %u.\n", i, test);
+				result = false;
+			}
+			hits += found ? 1 : 0;
+		}
+
+		if (result && (hits == 0 || hits == 100))
+		{
+			logTestString("terrainSelector: unexpected hit count %u in test %u.\n", hits, test);
+			result = false;
+		}
+
+		// box queries have to return at least all triangles with a corner in the box
+		array<triangle3df> boxTriangles(triangles.size());
+		boxTriangles.set_used(triangles.size());
+		for (u32 i=0; i<20 && result; ++i)
+		{
+			const vector3df center(box.MinEdge.X + extent.X * ((i*37)%101) / 100.f, box.MinEdge.Y + extent.Y * ((i*7)%11) / 10.f,
+				box.MinEdge.Z + extent.Z * ((i*53)%103) / 102.f);
+			const aabbox3df query(center - vector3df(5.f + i), center + vector3df(5.f + i));
+
+			s32 boxCount = 0;
+			selector->getTriangles(boxTriangles.pointer(), triangles.size(), boxCount, query);
+
+			u32 inside = 0;
+			for (u32 t=0; t<triangles.size(); ++t)
+			{
+				if (query.isPointInside(triangles[t].pointA) || query.isPointInside(triangles[t].pointB) ||
+					query.isPointInside(triangles[t].pointC))
+					++inside;
+			}
+
+			u32 found = 0;
+			for (s32 t=0; t<boxCount; ++t)
+			{
+				if (query.isPointInside(boxTriangles[t].pointA) || query.isPointInside(boxTriangles[t].pointB) ||
+					query.isPointInside(boxTriangles[t].pointC))
+					++found;
+			}
+
+			if (found != inside || boxCount > (s32)triangles.size() / 10)
+			{
+				logTestString("terrainSelector: box %u returned %d triangles, %u of %u with corners inside in test %u.\n",
+					i, boxCount, found, inside, test);
+				result = false;
+			}
+		}
+
+		selector->drop();
+		terrain->remove();
+	}
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	assert_log(result);
+	return result;
+}
+
 }
 
 bool terrainSceneNode()
 {
 	bool result = terrainRecalc();
 	result &= terrainGaps();
+	result &= terrainSelector();
 	return result;
 }
 
@@ -18,7 +18,8 @@ void usage(const char* name)
 	std::cerr << "Usage: " << name << " [options] <srcFile> <destFile>" << std::endl;
 	std::cerr << "  where options are" << std::endl;
 	std::cerr << " --createTangents: convert to tangents mesh is possible." << std::endl;
-	std::cerr << " --format=[irrmesh|collada|stl|obj|ply]: Choose target format" << std::endl;
+	std::cerr << " --optimize: reorder triangles and vertices for rendering, merge meshbuffers with the same material and split large ones." << std::endl;
+	std::cerr << " --format=[irrmesh|irrbmesh|collada|stl|obj|ply|b3d]: Choose target format" << std::endl;
 }
 
 int main(int argc, char* argv[])
@@ -38,6 +39,7 @@ int main(int argc, char* argv[])
 	scene::EMESH_WRITER_TYPE type = EMWT_IRR_MESH;
 	u32 i=1;
 	bool createTangents=false;
+	bool optimize=false;
 	while (argv[i][0]=='-')
 	{
 		core::stringc format = argv[i];
@@ -54,12 +56,19 @@ int main(int argc, char* argv[])
 					type = EMWT_OBJ;
 				else if (format=="ply")
 					type = EMWT_PLY;
+				else if (format=="b3d")
+					type = EMWT_B3D;
+				else if (format=="irrbmesh")
+					type = EMWT_IRR_BINARY_MESH;
 				else
 					type = EMWT_IRR_MESH;
 			}
 			else
 			if (format =="--createTangents")
 				createTangents=true;
+			else
+			if (format =="--optimize")
+				optimize=true;
 		}
 		else
 		if (format=="--")
@@ -81,26 +90,49 @@ int main(int argc, char* argv[])
 		return 1;
 	}
 
-	createTangents = createTangents && (type==EMWT_IRR_MESH);
+	createTangents = createTangents && (type==EMWT_IRR_MESH || type==EMWT_IRR_BINARY_MESH);
 	std::cout << "Converting " << argv[srcmesh] << " to " << argv[destmesh] << std::endl;
-	IMesh* mesh = device->getSceneManager()->getMesh(argv[srcmesh])->getMesh(0);
-	if (!mesh)
+	IAnimatedMesh* animatedMesh = device->getSceneManager()->getMesh(argv[srcmesh]);
+	if (!animatedMesh)
 	{
 		std::cerr << "Could not load " << argv[srcmesh] << std::endl;
 		return 1;
 	}
+	// the binary format keeps the joints and animation of skinned meshes
+	IMesh* mesh = animatedMesh;
+	if (type != EMWT_IRR_BINARY_MESH || animatedMesh->getMeshType() != EAMT_SKINNED)
+		mesh = animatedMesh->getMesh(0);
+	mesh->grab();
 	if (createTangents)
 	{
 		IMesh* tmp = device->getSceneManager()->getMeshManipulator()->createMeshWithTangents(mesh);
 		mesh->drop();
 		mesh=tmp;
 	}
+	if (optimize)
+	{
+		// joints refer to the vertices of the meshbuffers
+		if (type == EMWT_IRR_BINARY_MESH && animatedMesh->getMeshType() == EAMT_SKINNED)
+			std::cerr << "Skinned meshes are written without optimization." << std::endl;
+		else
+		{
+			SMeshOptimizationReport report;
+			IMesh* tmp = device->getSceneManager()->getMeshManipulator()->createOptimizedMesh(mesh,
+				EMOF_DEFAULT | EMOF_MERGE_BUFFERS | EMOF_SPLIT_BUFFERS, &report);
+			std::cout << "Meshbuffers: " << mesh->getMeshBufferCount() << " -> " << tmp->getMeshBufferCount() << std::endl;
+			std::cout << "ACMR: " << report.AcmrBefore << " -> " << report.AcmrAfter << std::endl;
+			std::cout << "Overdraw: " << report.OverdrawBefore << " -> " << report.OverdrawAfter << std::endl;
+			mesh->drop();
+			mesh=tmp;
+		}
+	}
 	IMeshWriter* mw = device->getSceneManager()->createMeshWriter(type);
 	IWriteFile* file = device->getFileSystem()->createAndWriteFile(argv[destmesh]);
 	mw->writeMesh(file, mesh);
 
 	file->drop();
 	mw->drop();
+	mesh->drop();
 	device->drop();
 
 	return 0;